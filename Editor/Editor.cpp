@@ -755,6 +755,30 @@ void EditorComponent::Update(float dt)
 
 	save_text_alpha = std::max(0.0f, save_text_alpha - std::min(dt, 0.033f)); // after saving, dt can become huge
 
+	if (save_async != nullptr)
+	{
+		if (save_async->IsFinished())
+		{
+			if (save_async->success.load())
+			{
+				PostSaveText("Scene saved: ", save_async_filename);
+			}
+			else
+			{
+				PostSaveText("Error! Could not save scene: ", save_async_filename);
+				wi::helper::messageBox("Could not create " + save_async_filename + "!");
+			}
+			save_async.reset();
+		}
+		else
+		{
+			// Only the on-screen status is updated while saving, the backlog is posted to when it's finished:
+			save_text_message = "Saving scene (" + std::to_string(int(save_async->progress.load() * 100)) + "%): ";
+			save_text_filename = save_async_filename;
+			save_text_alpha = 1;
+		}
+	}
+
 	bool clear_selected = false;
 	if (wi::input::Press(wi::input::KEYBOARD_BUTTON_ESCAPE))
 	{
@@ -3604,24 +3628,31 @@ void EditorComponent::Save(const std::string& filename)
 	{
 		const bool dump_to_header = optionsWnd.generalWnd.saveModeComboBox.GetSelected() == 2;
 
-		wi::Archive archive = dump_to_header ? wi::Archive() : wi::Archive(filename, false);
-		if (archive.IsOpen())
+		if (save_async != nullptr)
 		{
-			Scene& scene = GetCurrentScene();
+			// Only one scene save can be in flight:
+			save_async->Wait();
+		}
+
+		Scene& scene = GetCurrentScene();
 
-			wi::resourcemanager::Mode embed_mode = (wi::resourcemanager::Mode)optionsWnd.generalWnd.saveModeComboBox.GetItemUserData(optionsWnd.generalWnd.saveModeComboBox.GetSelected());
-			wi::resourcemanager::SetMode(embed_mode);
+		wi::resourcemanager::Mode embed_mode = (wi::resourcemanager::Mode)optionsWnd.generalWnd.saveModeComboBox.GetItemUserData(optionsWnd.generalWnd.saveModeComboBox.GetSelected());
+		wi::resourcemanager::SetMode(embed_mode);
 
+		if (dump_to_header)
+		{
+			wi::Archive archive;
+			archive.SetCompressionEnabled(optionsWnd.generalWnd.saveCompressionCheckBox.GetCheck());
 			scene.Serialize(archive);
-
-			if (dump_to_header)
-			{
-				archive.SaveHeaderFile(filename, wi::helper::RemoveExtension(wi::helper::GetFileNameFromPath(filename)));
-			}
+			archive.SaveHeaderFile(filename, wi::helper::RemoveExtension(wi::helper::GetFileNameFromPath(filename)));
 		}
 		else
 		{
-			wi::helper::messageBox("Could not create " + filename + "!");
+			// The scene file is written in the background, the save text will be posted when it's finished:
+			save_async = scene.SerializeAsync(filename, optionsWnd.generalWnd.saveCompressionCheckBox.GetCheck());
+			save_async_filename = filename;
+			GetCurrentEditorScene().path = filename;
+			RefreshSceneList();
 			return;
 		}
 	}
@@ -140,6 +140,9 @@ public:
 	wi::Color save_text_color = wi::Color::White();
 	void PostSaveText(const std::string& message, const std::string& filename = "", float time_seconds = 4);
 
+	std::shared_ptr<wi::scene::Scene::AsyncSerialization> save_async; // in-flight background scene save
+	std::string save_async_filename;
+
 	std::string last_script_path;
 
 	struct EditorScene
@@ -210,6 +210,15 @@ void GeneralWindow::Create(EditorComponent* _editor)
 		});
 	AddWidget(&saveModeComboBox);
 
+	saveCompressionCheckBox.Create("Compress scene: ");
+	saveCompressionCheckBox.SetTooltip("Save the scene with block compression. This makes the file smaller, and it will be decompressed in parallel when it is loaded.");
+	saveCompressionCheckBox.SetCheck(editor->main->config.GetSection("options").GetBool("save_compressed"));
+	saveCompressionCheckBox.OnClick([=](wi::gui::EventArgs args) {
+		editor->main->config.GetSection("options").Set("save_compressed", args.bValue);
+		editor->main->config.Commit();
+		});
+	AddWidget(&saveCompressionCheckBox);
+
 
 	transformToolOpacitySlider.Create(0, 1, 1, 100, "Transform Tool Opacity: ");
 	transformToolOpacitySlider.SetTooltip("You can control the transparency of the object placement tool");
@@ -733,6 +742,8 @@ void GeneralWindow::ResizeLayout()
 	y += saveModeComboBox.GetSize().y;
 	y += padding;
 
+	add_right(saveCompressionCheckBox);
+
 	themeCombo.SetPos(XMFLOAT2(x_off, y));
 	themeCombo.SetSize(XMFLOAT2(width - x_off - themeCombo.GetScale().y - 1, themeCombo.GetScale().y));
 	y += themeCombo.GetSize().y;
@@ -175,6 +175,19 @@ void MeshWindow::Create(EditorComponent* _editor)
 		});
 	AddWidget(&quantizeCheckBox);
 
+	derivedDataCheckBox.Create("Save Derived Data: ");
+	derivedDataCheckBox.SetTooltip("Save the BVH and position format with the mesh, so they don't need to be recomputed when loading.\nThis makes loading faster at the cost of larger file size.\nThe saved data is discarded when loading if the geometry changed.");
+	derivedDataCheckBox.SetSize(XMFLOAT2(hei, hei));
+	derivedDataCheckBox.SetPos(XMFLOAT2(x, y += step));
+	derivedDataCheckBox.OnClick([&](wi::gui::EventArgs args) {
+		MeshComponent* mesh = editor->GetCurrentScene().meshes.GetComponent(entity);
+		if (mesh != nullptr)
+		{
+			mesh->SetDerivedDataSerialized(args.bValue);
+		}
+	});
+	AddWidget(&derivedDataCheckBox);
+
 	impostorCreateButton.Create("Create Impostor");
 	impostorCreateButton.SetTooltip("Create an impostor image of the mesh. The mesh will be replaced by this image when far away, to render faster.");
 	impostorCreateButton.SetSize(XMFLOAT2(wid, hei));
@@ -944,6 +957,7 @@ void MeshWindow::SetEntity(Entity entity, int subset)
 		doubleSidedShadowCheckBox.SetCheck(mesh->IsDoubleSidedShadow());
 		bvhCheckBox.SetCheck(mesh->bvh.IsValid());
 		quantizeCheckBox.SetCheck(mesh->IsQuantizedPositionsDisabled());
+		derivedDataCheckBox.SetCheck(mesh->IsDerivedDataSerialized());
 
 		const ImpostorComponent* impostor = scene.impostors.GetComponent(entity);
 		if (impostor != nullptr)
@@ -1035,6 +1049,7 @@ void MeshWindow::ResizeLayout()
 	add_right(doubleSidedShadowCheckBox);
 	add_right(bvhCheckBox);
 	add_right(quantizeCheckBox);
+	add_right(derivedDataCheckBox);
 	add_fullwidth(impostorCreateButton);
 	add(impostorDistanceSlider);
 	add(tessellationFactorSlider);
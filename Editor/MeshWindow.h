@@ -19,6 +19,7 @@ public:
 	wi::gui::CheckBox doubleSidedShadowCheckBox;
 	wi::gui::CheckBox bvhCheckBox;
 	wi::gui::CheckBox quantizeCheckBox;
+	wi::gui::CheckBox derivedDataCheckBox;
 	wi::gui::Button impostorCreateButton;
 	wi::gui::Slider impostorDistanceSlider;
 	wi::gui::Slider tessellationFactorSlider;
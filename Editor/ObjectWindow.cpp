@@ -418,6 +418,24 @@ void ObjectWindow::Create(EditorComponent* _editor)
 		});
 	AddWidget(&notVisibleInReflectionsCheckBox);
 
+	occluderCheckBox.Create("Occluder: ");
+	occluderCheckBox.SetTooltip("Always use the object as occluder for software occlusion culling.\nLarge objects on screen are selected automatically, this is useful for walls and buildings that are thin or far.");
+	occluderCheckBox.SetSize(XMFLOAT2(hei, hei));
+	occluderCheckBox.SetPos(XMFLOAT2(x, y += step));
+	occluderCheckBox.SetCheck(false);
+	occluderCheckBox.OnClick([&](wi::gui::EventArgs args) {
+		wi::scene::Scene& scene = editor->GetCurrentScene();
+		for (auto& x : editor->translator.selected)
+		{
+			ObjectComponent* object = scene.objects.GetComponent(x.entity);
+			if (object != nullptr)
+			{
+				object->SetOccluder(args.bValue);
+			}
+		}
+		});
+	AddWidget(&occluderCheckBox);
+
 	ditherSlider.Create(0, 1, 0, 1000, "Transparency: ");
 	ditherSlider.SetTooltip("Adjust transparency of the object. Opaque materials will use dithered transparency in this case!");
 	ditherSlider.SetSize(XMFLOAT2(wid, hei));
@@ -729,6 +747,7 @@ void ObjectWindow::SetEntity(Entity entity)
 		foregroundCheckBox.SetCheck(object->IsForeground());
 		notVisibleInMainCameraCheckBox.SetCheck(object->IsNotVisibleInMainCamera());
 		notVisibleInReflectionsCheckBox.SetCheck(object->IsNotVisibleInReflections());
+		occluderCheckBox.SetCheck(object->IsOccluder());
 		navmeshCheckBox.SetCheck(object->filterMask & wi::enums::FILTER_NAVIGATION_MESH);
 		cascadeMaskSlider.SetValue((float)object->cascadeMask);
 		ditherSlider.SetValue(object->GetTransparency());
@@ -807,6 +826,7 @@ void ObjectWindow::ResizeLayout()
 	add_right(foregroundCheckBox);
 	add_right(notVisibleInMainCameraCheckBox);
 	add_right(notVisibleInReflectionsCheckBox);
+	add_right(occluderCheckBox);
 	add_right(navmeshCheckBox);
 	add(ditherSlider);
 	add(cascadeMaskSlider);
@@ -17,6 +17,7 @@ public:
 	wi::gui::CheckBox foregroundCheckBox;
 	wi::gui::CheckBox notVisibleInMainCameraCheckBox;
 	wi::gui::CheckBox notVisibleInReflectionsCheckBox;
+	wi::gui::CheckBox occluderCheckBox;
 	wi::gui::Slider ditherSlider;
 	wi::gui::Slider cascadeMaskSlider;
 	wi::gui::Slider lodSlider;
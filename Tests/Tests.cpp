@@ -1,4 +1,6 @@
 #include "stdafx.h"
+#include "Utility/basis_universal/encoder/basisu_comp.h"
+#include <iostream>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -25,6 +27,24 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	STREAMINGTEST,
+	TRANSCODINGTEST,
+	INTERSECTIONTEST,
+	MESHRAYTEST,
+	RAYBATCHTEST,
+	HEADLESSUPDATETEST,
+	FIXEDSIMULATIONTEST,
+	SPATIALHASHTEST,
+	FRUSTUMCULLINGTEST,
+	HIERARCHICALCULLINGTEST,
+	SOFTWAREOCCLUSIONTEST,
+	RADIXSORTTEST,
+	DELTASERIALIZATIONTEST,
+	COMPRESSIONTEST,
+	ASYNCSERIALIZATIONTEST,
+	TEXTUREBAKERTEST,
+	RESOURCEBUDGETTEST,
+	PACKAGETEST,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -157,6 +177,24 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Texture streaming", STREAMINGTEST);
+	testSelector.AddItem("KTX2 transcoding", TRANSCODINGTEST);
+	testSelector.AddItem("Object BVH queries", INTERSECTIONTEST);
+	testSelector.AddItem("Mesh BVH ray queries", MESHRAYTEST);
+	testSelector.AddItem("Batched ray queries", RAYBATCHTEST);
+	testSelector.AddItem("Headless scene update", HEADLESSUPDATETEST);
+	testSelector.AddItem("Fixed rate simulation", FIXEDSIMULATIONTEST);
+	testSelector.AddItem("Spatial hash queries", SPATIALHASHTEST);
+	testSelector.AddItem("SIMD frustum culling", FRUSTUMCULLINGTEST);
+	testSelector.AddItem("Hierarchical frustum culling", HIERARCHICALCULLINGTEST);
+	testSelector.AddItem("Software occlusion culling", SOFTWAREOCCLUSIONTEST);
+	testSelector.AddItem("Render batch radix sort", RADIXSORTTEST);
+	testSelector.AddItem("Scene delta serialization", DELTASERIALIZATIONTEST);
+	testSelector.AddItem("Compression", COMPRESSIONTEST);
+	testSelector.AddItem("Background scene save", ASYNCSERIALIZATIONTEST);
+	testSelector.AddItem("Texture baker", TEXTUREBAKERTEST);
+	testSelector.AddItem("Resource memory budget", RESOURCEBUDGETTEST);
+	testSelector.AddItem("Package files", PACKAGETEST);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -416,6 +454,78 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case STREAMINGTEST:
+			RunStreamingTest();
+			break;
+
+		case TRANSCODINGTEST:
+			RunTranscodingTest();
+			break;
+
+		case INTERSECTIONTEST:
+			RunIntersectionTest();
+			break;
+
+		case MESHRAYTEST:
+			RunMeshRayTest();
+			break;
+
+		case RAYBATCHTEST:
+			RunRayBatchTest();
+			break;
+
+		case HEADLESSUPDATETEST:
+			RunHeadlessUpdateTest();
+			break;
+
+		case FIXEDSIMULATIONTEST:
+			RunFixedSimulationTest();
+			break;
+
+		case SPATIALHASHTEST:
+			RunSpatialHashTest();
+			break;
+
+		case FRUSTUMCULLINGTEST:
+			RunFrustumCullingTest();
+			break;
+
+		case HIERARCHICALCULLINGTEST:
+			RunHierarchicalCullingTest();
+			break;
+
+		case SOFTWAREOCCLUSIONTEST:
+			RunSoftwareOcclusionTest();
+			break;
+
+		case RADIXSORTTEST:
+			RunRadixSortTest();
+			break;
+
+		case DELTASERIALIZATIONTEST:
+			RunDeltaSerializationTest();
+			break;
+
+		case COMPRESSIONTEST:
+			RunCompressionTest();
+			break;
+
+		case ASYNCSERIALIZATIONTEST:
+			RunAsyncSerializationTest();
+			break;
+
+		case TEXTUREBAKERTEST:
+			RunTextureBakerTest();
+			break;
+
+		case RESOURCEBUDGETTEST:
+			RunResourceBudgetTest();
+			break;
+
+		case PACKAGETEST:
+			RunPackageTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -620,6 +730,28 @@ void TestsRenderer::Update(float dt)
     RenderPath3D::Update(dt);
 }
 
+void TestsRenderer::ShowTestResult(const std::string& text)
+{
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(text);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+static int failed_test_checks = 0;
+bool TestsRenderer::TestCheck(bool condition, const std::string& description)
+{
+	if (!condition)
+	{
+		failed_test_checks++;
+		wi::backlog::post("Test check failed: " + description, wi::backlog::LogLevel::Error);
+	}
+	return condition;
+}
+
 void TestsRenderer::RunJobSystemTest()
 {
 	wi::Timer timer;
@@ -1254,3 +1386,1796 @@ void TestsRenderer::ContainerTest()
 	font.params.size = 24;
 	this->AddFont(&font);
 }
+
+void TestsRenderer::RunStreamingTest()
+{
+	using namespace wi::resourcemanager;
+
+	// Simulated streaming textures, the streaming scheduler is independent of the GPU:
+	const size_t count = 10000;
+	wi::vector<StreamingTexture> textures(count);
+	wi::vector<uint32_t> target_mips(count);
+	wi::random::RNG rng(42);
+	for (size_t i = 0; i < count; ++i)
+	{
+		StreamingTexture& texture = textures[i];
+		texture.desc.width = 1u << rng.next_uint(8u, 13u);
+		texture.desc.height = texture.desc.width;
+		texture.desc.format = wi::graphics::Format::BC1_UNORM;
+		texture.desc.mip_levels = wi::graphics::GetMipCount(texture.desc.width, texture.desc.height);
+		texture.tail_mip = ComputeStreamingTailMip(texture.desc, 128);
+		texture.requested_resolution = rng.next_uint(0u, texture.desc.width);
+		texture.last_request_frame = rng.next_uint(0u, 100u);
+	}
+
+	size_t full_memory = 0;
+	size_t requested_memory = 0;
+	size_t tail_memory = 0;
+	for (auto& texture : textures)
+	{
+		full_memory += ComputeStreamingMemory(texture.desc, 0);
+		requested_memory += ComputeStreamingMemory(texture.desc, ComputeStreamingRequestedMip(texture));
+		tail_memory += ComputeStreamingMemory(texture.desc, texture.tail_mip);
+	}
+
+	std::string ss = "Texture streaming scheduler test for " + std::to_string(count) + " textures:\n";
+	ss += "\nAll mips: " + std::to_string(full_memory >> 20) + " MB";
+	ss += "\nRequested mips: " + std::to_string(requested_memory >> 20) + " MB";
+	ss += "\nMip tails: " + std::to_string(tail_memory >> 20) + " MB\n";
+	TestCheck(tail_memory <= requested_memory && requested_memory <= full_memory, "streaming memory of tails, requested and all mips must be in increasing order");
+
+	wi::Timer timer;
+	const size_t budgets[] = { 0, 64ull << 20, 256ull << 20, requested_memory, full_memory };
+	for (size_t budget : budgets)
+	{
+		timer.record();
+		size_t usage = ComputeStreamingTargets(textures.data(), count, budget, target_mips.data());
+		const double time = timer.elapsed_milliseconds();
+
+		size_t satisfied = 0;
+		size_t resident_memory = 0;
+		bool valid_mips = true;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t requested_mip = ComputeStreamingRequestedMip(textures[i]);
+			if (target_mips[i] <= requested_mip)
+			{
+				satisfied++;
+			}
+			// The tail is always resident, and the resolution is never higher than requested:
+			valid_mips &= target_mips[i] <= textures[i].tail_mip && target_mips[i] >= requested_mip;
+			resident_memory += ComputeStreamingMemory(textures[i].desc, target_mips[i]);
+		}
+		TestCheck(valid_mips, "streaming target mips must be between the requested mip and the tail mip");
+		TestCheck(usage == resident_memory, "streaming usage must be the memory of the target mips");
+		TestCheck(usage <= std::max(budget, tail_memory), "streaming usage must fit into the budget, unless the tails don't fit");
+		TestCheck(budget < requested_memory || (satisfied == count && usage == requested_memory), "every request must be satisfied when the budget is enough");
+		ss += "\nBudget " + std::to_string(budget >> 20) + " MB: usage = " + std::to_string(usage >> 20) + " MB, satisfied requests = " + std::to_string(satisfied) + ", time = " + std::to_string(time) + " ms";
+	}
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunTranscodingTest()
+{
+	// Texture arrays are encoded to ETC1S and UASTC (with Zstandard supercompression) KTX2 files in memory, then they are loaded by the resource manager
+	//	For reference, the same file is also transcoded serially with the Basis Universal transcoder directly
+	const uint32_t resolution = 2048;
+	const uint32_t layers = 4;
+
+	basisu::basisu_encoder_init(false, false);
+	basisu::job_pool jpool(std::max(1u, std::thread::hardware_concurrency()));
+
+	wi::random::RNG rng(7);
+	wi::vector<basisu::image> images(layers);
+	for (uint32_t layer = 0; layer < layers; ++layer)
+	{
+		basisu::image& image = images[layer];
+		image.resize(resolution, resolution);
+		for (uint32_t y = 0; y < resolution; ++y)
+		{
+			for (uint32_t x = 0; x < resolution; ++x)
+			{
+				const uint32_t noise = rng.next_uint(0u, 32u);
+				image(x, y).set(uint8_t((x >> 3) + noise), uint8_t((y >> 3) + noise), uint8_t(((x ^ y) >> 2) + layer * 64), 255);
+			}
+		}
+	}
+
+	std::string ss = "KTX2 transcoding test, " + std::to_string(resolution) + "x" + std::to_string(resolution) + " texture array with " + std::to_string(layers) + " slices and full mip chain:\n";
+	ss += "Job system threads: " + std::to_string(wi::jobsystem::GetThreadCount()) + "\n";
+
+	wi::Timer timer;
+	for (int uastc = 0; uastc < 2; ++uastc)
+	{
+		const std::string format_name = uastc ? "UASTC + Zstandard" : "ETC1S";
+
+		basisu::basis_compressor_params params;
+		for (auto& image : images)
+		{
+			params.m_source_images.push_back(image);
+		}
+		params.m_tex_type = basist::cBASISTexType2DArray;
+		params.m_create_ktx2_file = true;
+		params.m_uastc = uastc != 0;
+		params.m_ktx2_uastc_supercompression = basist::KTX2_SS_ZSTANDARD;
+		params.m_mip_gen = true;
+		params.m_compression_level = 0;
+		params.m_pack_uastc_flags = basisu::cPackUASTCLevelFastest;
+		params.m_multithreading = true;
+		params.m_pJob_pool = &jpool;
+		params.m_status_output = false;
+		basisu::basis_compressor compressor;
+		if (!TestCheck(compressor.init(params) && compressor.process() == basisu::basis_compressor::cECSuccess, format_name + " encoding of the transcoding test"))
+		{
+			ss += "\n" + format_name + ": encoding failed\n";
+			continue;
+		}
+		const auto& file = compressor.get_output_ktx2_file();
+		ss += "\n" + format_name + " (" + wi::helper::GetMemorySizeText(file.size()) + "):";
+
+		timer.record();
+		basist::ktx2_transcoder transcoder;
+		if (transcoder.init(file.data(), (uint32_t)file.size()) && transcoder.start_transcoding())
+		{
+			wi::vector<uint8_t> output;
+			for (uint32_t layer = 0; layer < transcoder.get_layers(); ++layer)
+			{
+				for (uint32_t mip = 0; mip < transcoder.get_levels(); ++mip)
+				{
+					basist::ktx2_image_level_info level_info;
+					transcoder.get_image_level_info(level_info, mip, layer, 0);
+					output.resize(level_info.m_total_blocks * 8);
+					transcoder.transcode_image_level(mip, layer, 0, output.data(), level_info.m_total_blocks, basist::transcoder_texture_format::cTFBC1_RGB);
+				}
+			}
+			ss += "\n\tserial transcoding to BC1: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+		}
+
+		const wi::resourcemanager::Flags load_flags[] = {
+			wi::resourcemanager::Flags::IMPORT_BLOCK_COMPRESSED,
+			wi::resourcemanager::Flags::NONE,
+		};
+		for (auto flags : load_flags)
+		{
+			const bool compressed = flags == wi::resourcemanager::Flags::IMPORT_BLOCK_COMPRESSED;
+			timer.record();
+			wi::Resource resource = wi::resourcemanager::Load("transcoding_test_" + std::to_string(uastc) + std::to_string(compressed) + ".ktx2", flags, file.data(), file.size());
+			const double time = timer.elapsed_milliseconds();
+			const std::string load_name = format_name + " resourcemanager::Load to " + std::string(compressed ? "BC1" : "RGBA8");
+			if (TestCheck(resource.IsValid(), load_name + " must succeed"))
+			{
+				// Every slice and mip must be transcoded, into the requested format:
+				const wi::graphics::TextureDesc& desc = resource.GetTexture().desc;
+				TestCheck(desc.width == resolution && desc.height == resolution && desc.array_size == layers, load_name + " must keep the dimensions and slices");
+				TestCheck(desc.mip_levels == wi::graphics::GetMipCount(resolution, resolution), load_name + " must have the full mip chain");
+				TestCheck(wi::graphics::IsFormatBlockCompressed(desc.format) == compressed, load_name + " must be in the requested format");
+			}
+			ss += "\n\tresourcemanager::Load to " + std::string(compressed ? "BC1" : "RGBA8") + ": " + (resource.IsValid() ? std::to_string(time) + " ms" : "FAILED");
+		}
+		ss += "\n";
+	}
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunIntersectionTest()
+{
+	using namespace wi::primitive;
+
+	// The same broadphase that Scene::Intersects() uses for objects, measured without the mesh tests:
+	const uint32_t object_count = 100000;
+	const uint32_t ray_count = 10000;
+	wi::vector<AABB> aabbs(object_count);
+	wi::vector<Ray> rays(ray_count);
+	wi::random::RNG rng(42);
+	for (auto& aabb : aabbs)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(-500, 500), rng.next_float(0, 50), rng.next_float(-500, 500));
+		const float radius = rng.next_float(0.5f, 3);
+		aabb = AABB(XMFLOAT3(center.x - radius, center.y - radius, center.z - radius), XMFLOAT3(center.x + radius, center.y + radius, center.z + radius));
+	}
+	for (auto& ray : rays)
+	{
+		const XMFLOAT3 origin = XMFLOAT3(rng.next_float(-500, 500), 100, rng.next_float(-500, 500));
+		const XMFLOAT3 direction = XMFLOAT3(rng.next_float(-1, 1), -1, rng.next_float(-1, 1));
+		ray = Ray(XMLoadFloat3(&origin), XMVector3Normalize(XMLoadFloat3(&direction)));
+	}
+
+	std::string ss = "Object BVH test for " + std::to_string(object_count) + " objects and " + std::to_string(ray_count) + " rays:\n";
+
+	wi::Timer timer;
+	wi::BVH bvh;
+	bvh.Build(aabbs.data(), object_count);
+	ss += "\nBuild: " + std::to_string(timer.elapsed_milliseconds()) + " ms, SAH cost = " + std::to_string(bvh.build_cost);
+
+	timer.record();
+	bvh.Refit(aabbs.data());
+	ss += "\nRefit: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	size_t hits_linear = 0;
+	timer.record();
+	for (auto& ray : rays)
+	{
+		for (auto& aabb : aabbs)
+		{
+			if (ray.intersects(aabb))
+			{
+				hits_linear++;
+			}
+		}
+	}
+	const double time_linear = timer.elapsed_seconds();
+	ss += "\nLinear: " + std::to_string(hits_linear) + " hits, " + std::to_string(int(ray_count / time_linear)) + " queries/sec";
+
+	size_t hits_bvh = 0;
+	timer.record();
+	for (auto& ray : rays)
+	{
+		bvh.Intersects(ray, 0, [&](uint32_t index) {
+			if (ray.intersects(aabbs[index]))
+			{
+				hits_bvh++;
+			}
+		});
+	}
+	const double time_bvh = timer.elapsed_seconds();
+	ss += "\nBVH: " + std::to_string(hits_bvh) + " hits, " + std::to_string(int(ray_count / time_bvh)) + " queries/sec";
+	ss += hits_linear == hits_bvh ? "\n\nResults match" : "\n\nResults MISMATCH";
+	TestCheck(hits_linear == hits_bvh, "object BVH ray hits must match the linear test");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunMeshRayTest()
+{
+	using namespace wi::primitive;
+
+	// Sponza-sized procedural mesh: a wavy floor and randomly placed triangles above it, 262144 triangles in total
+	const uint32_t grid = 256;
+	const uint32_t triangle_count = 262144;
+	wi::vector<XMFLOAT3> positions;
+	wi::vector<uint32_t> indices;
+	wi::random::RNG rng(42);
+	for (uint32_t y = 0; y <= grid; ++y)
+	{
+		for (uint32_t x = 0; x <= grid; ++x)
+		{
+			positions.push_back(XMFLOAT3(x * 0.5f, std::sin(x * 0.1f) * std::cos(y * 0.13f) * 4, y * 0.5f));
+		}
+	}
+	for (uint32_t y = 0; y < grid; ++y)
+	{
+		for (uint32_t x = 0; x < grid; ++x)
+		{
+			const uint32_t i = y * (grid + 1) + x;
+			indices.insert(indices.end(), { i, i + grid + 1, i + 1, i + 1, i + grid + 1, i + grid + 2 });
+		}
+	}
+	while (indices.size() / 3 < triangle_count)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(0, 128), rng.next_float(0, 30), rng.next_float(0, 128));
+		const uint32_t base = (uint32_t)positions.size();
+		for (int i = 0; i < 3; ++i)
+		{
+			positions.push_back(XMFLOAT3(center.x + rng.next_float(-1, 1), center.y + rng.next_float(-1, 1), center.z + rng.next_float(-1, 1)));
+		}
+		indices.insert(indices.end(), { base, base + 1, base + 2 });
+	}
+	wi::vector<AABB> aabbs(triangle_count);
+	for (uint32_t i = 0; i < triangle_count; ++i)
+	{
+		const XMFLOAT3& p0 = positions[indices[i * 3 + 0]];
+		const XMFLOAT3& p1 = positions[indices[i * 3 + 1]];
+		const XMFLOAT3& p2 = positions[indices[i * 3 + 2]];
+		aabbs[i] = AABB(wi::math::Min(p0, wi::math::Min(p1, p2)), wi::math::Max(p0, wi::math::Max(p1, p2)));
+	}
+
+	const uint32_t ray_count = 100000;
+	wi::vector<Ray> rays(ray_count);
+	for (auto& ray : rays)
+	{
+		const XMFLOAT3 origin = XMFLOAT3(rng.next_float(0, 128), rng.next_float(5, 40), rng.next_float(0, 128));
+		const XMFLOAT3 direction = XMFLOAT3(rng.next_float(-1, 1), rng.next_float(-1, 0.2f), rng.next_float(-1, 1));
+		ray = Ray(XMLoadFloat3(&origin), XMVector3Normalize(XMLoadFloat3(&direction)));
+	}
+
+	std::string ss = "Mesh BVH test for " + std::to_string(triangle_count) + " triangles and " + std::to_string(ray_count) + " closest hit rays:\n";
+
+	wi::Timer timer;
+	wi::BVH bvh;
+	bvh.Build(aabbs.data(), triangle_count);
+	ss += "\nBuild: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+	timer.record();
+	bvh.BuildWide();
+	ss += "\nBuildWide: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	uint32_t hits_per_mode[2] = {};
+	wi::vector<float> closest_per_mode[2];
+	for (int wide = 0; wide < 2; ++wide)
+	{
+		uint32_t hits = 0;
+		closest_per_mode[wide].resize(ray_count);
+		timer.record();
+		for (uint32_t ray_index = 0; ray_index < ray_count; ++ray_index)
+		{
+			const Ray& ray = rays[ray_index];
+			const XMVECTOR origin = XMLoadFloat3(&ray.origin);
+			const XMVECTOR direction = XMLoadFloat3(&ray.direction);
+			float closest = std::numeric_limits<float>::max();
+			auto intersect_triangle = [&](uint32_t triangleIndex) {
+				float distance;
+				XMFLOAT2 bary;
+				if (wi::math::RayTriangleIntersects(
+					origin,
+					direction,
+					XMLoadFloat3(&positions[indices[triangleIndex * 3 + 0]]),
+					XMLoadFloat3(&positions[indices[triangleIndex * 3 + 1]]),
+					XMLoadFloat3(&positions[indices[triangleIndex * 3 + 2]]),
+					distance,
+					bary
+				))
+				{
+					closest = std::min(closest, distance);
+				}
+			};
+			if (wide)
+			{
+				bvh.IntersectsWide(ray, intersect_triangle);
+			}
+			else
+			{
+				bvh.Intersects(ray, 0, intersect_triangle);
+			}
+			if (closest < std::numeric_limits<float>::max())
+			{
+				hits++;
+			}
+			closest_per_mode[wide][ray_index] = closest;
+		}
+		const double time = timer.elapsed_seconds();
+		hits_per_mode[wide] = hits;
+		ss += "\n" + std::string(wide ? "BVH4: " : "BVH2: ") + std::to_string(hits) + " hits, " + std::to_string(int(ray_count / time)) + " rays/sec";
+	}
+
+	TestCheck(hits_per_mode[0] == hits_per_mode[1], "BVH2 and BVH4 mesh ray hit counts must match");
+	TestCheck(closest_per_mode[0] == closest_per_mode[1], "BVH2 and BVH4 mesh rays must find the same closest hits");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunRayBatchTest()
+{
+	using namespace wi::primitive;
+
+	// Separate scene with 4096 cubes, simulating line of sight and ground probe queries of many AI agents:
+	Scene scene;
+	Entity cubeentity = scene.Entity_CreateCube("cube");
+	for (int x = 0; x < 64; ++x)
+	{
+		for (int z = 0; z < 64; ++z)
+		{
+			Entity entity = scene.Entity_Duplicate(cubeentity);
+			TransformComponent* transform = scene.transforms.GetComponent(entity);
+			transform->Translate(XMFLOAT3(x * 4.0f, (x * 7 + z * 13) % 5 * 1.0f, z * 4.0f));
+		}
+	}
+	scene.Entity_Remove(cubeentity);
+	scene.Update(0);
+
+	const size_t ray_count = 100000;
+	wi::vector<Ray> rays(ray_count);
+	wi::random::RNG rng(42);
+	for (size_t i = 0; i < ray_count; ++i)
+	{
+		const XMFLOAT3 origin = XMFLOAT3(rng.next_float(0, 256), rng.next_float(1, 10), rng.next_float(0, 256));
+		XMFLOAT3 direction = XMFLOAT3(rng.next_float(-1, 1), rng.next_float(-0.2f, 0.2f), rng.next_float(-1, 1));
+		if (i % 2)
+		{
+			direction = XMFLOAT3(0, -1, 0); // ground probe
+		}
+		rays[i] = Ray(XMLoadFloat3(&origin), XMVector3Normalize(XMLoadFloat3(&direction)), 0, 100);
+	}
+
+	std::string ss = "Ray query test for " + std::to_string(scene.objects.GetCount()) + " objects and " + std::to_string(ray_count) + " rays:\n";
+	ss += "wi::jobsystem has " + std::to_string(wi::jobsystem::GetThreadCount()) + " threads\n";
+
+	wi::vector<Scene::RayIntersectionResult> results(ray_count);
+	wi::Timer timer;
+	for (size_t i = 0; i < ray_count; ++i)
+	{
+		results[i] = scene.Intersects(rays[i]);
+	}
+	const double time_single = timer.elapsed_seconds();
+	ss += "\nIntersects(): " + std::to_string(int(ray_count / time_single)) + " rays/sec";
+
+	wi::vector<Scene::RayIntersectionResult> results_batch(ray_count);
+	timer.record();
+	scene.IntersectsBatch(rays.data(), results_batch.data(), ray_count);
+	const double time_batch = timer.elapsed_seconds();
+	ss += "\nIntersectsBatch(): " + std::to_string(int(ray_count / time_batch)) + " rays/sec";
+
+	size_t hits = 0;
+	size_t mismatches = 0;
+	for (size_t i = 0; i < ray_count; ++i)
+	{
+		if (results[i].entity != INVALID_ENTITY)
+		{
+			hits++;
+		}
+		if (results[i].entity != results_batch[i].entity || results[i].distance != results_batch[i].distance)
+		{
+			mismatches++;
+		}
+	}
+	ss += "\n\nHits: " + std::to_string(hits) + ", mismatches: " + std::to_string(mismatches);
+	TestCheck(mismatches == 0, "IntersectsBatch() results must match Intersects()");
+
+	ShowTestResult(ss);
+}
+int TestsRenderer::RunHeadlessTests()
+{
+	// Only the systems that are used by scene updates are initialized, there is no window and no graphics device:
+	wi::jobsystem::Initialize();
+	wi::physics::Initialize();
+	assert(wi::graphics::GetDevice() == nullptr);
+
+	failed_test_checks = 0;
+	std::cout << HeadlessUpdateTest() << "\n\n";
+	std::cout << FixedSimulationTest() << "\n\n";
+	std::cout << DeltaSerializationTest() << "\n\n";
+	std::cout << CompressionTest() << "\n\n";
+	std::cout << AsyncSerializationTest() << "\n\n";
+	std::cout << TextureBakerTest() << "\n\n";
+	std::cout << ResourceBudgetTest() << "\n\n";
+	std::cout << PackageTest() << "\n\n";
+
+	std::cout << "Headless tests finished, failed checks: " << failed_test_checks << "\n";
+	return failed_test_checks;
+}
+
+void TestsRenderer::RunHeadlessUpdateTest()
+{
+	ShowTestResult(HeadlessUpdateTest());
+}
+std::string TestsRenderer::HeadlessUpdateTest()
+{
+	// Without graphics device (Tests started with the "headless" argument) only the CPU side of the scene is updated, like on a server without GPU
+	const bool headless = wi::graphics::GetDevice() == nullptr;
+
+	Scene scene;
+
+	// Hierarchy: a rotating parent with children around it
+	Entity parent = scene.Entity_CreateObject("parent");
+	const int child_count = 100;
+	Entity cubeentity = scene.Entity_CreateCube("cube");
+	for (int i = 0; i < child_count; ++i)
+	{
+		Entity entity = scene.Entity_Duplicate(cubeentity);
+		TransformComponent* transform = scene.transforms.GetComponent(entity);
+		const float angle = XM_2PI * i / child_count;
+		transform->Translate(XMFLOAT3(std::cos(angle) * 20, 0, std::sin(angle) * 20));
+		scene.Component_Attach(entity, parent);
+	}
+	scene.Entity_Remove(cubeentity);
+
+	// Physics: a falling box
+	Entity falling = scene.Entity_CreateCube("falling");
+	scene.transforms.GetComponent(falling)->Translate(XMFLOAT3(0, 100, 0));
+	RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(falling);
+	rigidbody.shape = RigidBodyPhysicsComponent::BOX;
+	rigidbody.mass = 1;
+
+	const int frame_count = 120;
+	const float dt = 1.0f / 60.0f;
+	wi::Timer timer;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		scene.transforms.GetComponent(parent)->RotateRollPitchYaw(XMFLOAT3(0, XM_PI * dt, 0));
+		scene.Update(dt);
+	}
+	const double time = timer.elapsed_milliseconds();
+
+	// The CPU side data must be up to date, also without graphics device:
+	size_t hits = 0;
+	for (int i = 0; i < child_count; ++i)
+	{
+		const float angle = XM_2PI * i / child_count;
+		const XMFLOAT3 origin = XMFLOAT3(std::cos(angle) * 40, 0, std::sin(angle) * 40);
+		const XMFLOAT3 direction = XMFLOAT3(-std::cos(angle), 0, -std::sin(angle));
+		if (scene.Intersects(wi::primitive::Ray(origin, direction)).entity != INVALID_ENTITY)
+		{
+			hits++;
+		}
+	}
+	const float falling_height = scene.transforms.GetComponent(falling)->GetPosition().y;
+	TestCheck(hits == child_count, "every ray must hit the rotated hierarchy in the headless update test");
+	TestCheck(!wi::physics::IsEnabled() || falling_height < 100, "the rigid body must fall in the headless update test");
+
+	std::string ss = std::string(headless ? "Headless" : "Graphics device") + " scene update test for " + std::to_string(scene.objects.GetCount()) + " objects:\n";
+	ss += std::to_string(frame_count) + " frames updated in " + std::to_string(time) + " ms\n";
+	ss += "Ray hits on rotated hierarchy: " + std::to_string(hits) + " / " + std::to_string(child_count) + "\n";
+	ss += "Falling box height: 100 -> " + std::to_string(falling_height) + (wi::physics::IsEnabled() ? "" : " (physics is disabled)") + "\n";
+	if (headless)
+	{
+		const bool gpu_untouched = scene.instanceArrayMapped == nullptr && scene.materialArrayMapped == nullptr && scene.geometryArrayMapped == nullptr && scene.skinningDataMapped == nullptr && !scene.instanceUploadBuffer[0].IsValid();
+		TestCheck(gpu_untouched, "no GPU resources must be created by the headless scene update");
+		ss += std::string("GPU resources untouched: ") + (gpu_untouched ? "yes" : "no");
+	}
+	else
+	{
+		ss += "Start the Tests application with the headless argument to run this without graphics device";
+	}
+	return ss;
+}
+
+void TestsRenderer::RunFixedSimulationTest()
+{
+	ShowTestResult(FixedSimulationTest());
+}
+std::string TestsRenderer::FixedSimulationTest()
+{
+	// Server-like setup: simulation ticks at 30 Hz while the update rate varies, this is also run by the headless tests
+	Scene scene;
+	scene.SetSimulationFrameRate(30);
+
+	Entity falling = scene.Entity_CreateCube("falling");
+	scene.transforms.GetComponent(falling)->Translate(XMFLOAT3(0, 100, 0));
+	RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(falling);
+	rigidbody.shape = RigidBodyPhysicsComponent::BOX;
+	rigidbody.mass = 1;
+
+	// Varying frame times, between 144 FPS and 20 FPS:
+	const float frame_times[] = { 1.0f / 144.0f, 1.0f / 60.0f, 1.0f / 20.0f, 1.0f / 90.0f, 1.0f / 30.0f, 1.0f / 144.0f, 1.0f / 45.0f };
+	const int frame_count = 300;
+	float total_time = 0;
+	uint32_t total_steps = 0;
+	uint32_t max_steps = 0;
+	int non_monotonic = 0;
+	float prev_height = scene.transforms.GetComponent(falling)->GetPosition().y;
+	wi::Timer timer;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		const float dt = frame_times[frame % arraysize(frame_times)];
+		total_time += dt;
+		scene.Update(dt);
+		total_steps += scene.GetSimulationStepCount();
+		max_steps = std::max(max_steps, scene.GetSimulationStepCount());
+
+		// The interpolated world matrix must be moving smoothly downwards, regardless of the update rate:
+		const XMFLOAT4X4& world = scene.transforms.GetComponent(falling)->world;
+		const float height = world._42;
+		if (height > prev_height + 0.0001f)
+		{
+			non_monotonic++;
+		}
+		prev_height = height;
+	}
+	const double time = timer.elapsed_milliseconds();
+	const uint32_t expected_steps = uint32_t(total_time * 30);
+
+	// The longest frame is 1.5 steps, so no time is dropped, and the step count can only differ from the expected by rounding:
+	TestCheck(std::abs(int(total_steps) - int(expected_steps)) <= 1, "the fixed simulation must run 30 steps per second of update time");
+	TestCheck(max_steps <= 2, "the fixed simulation must not run more steps in one update than the frame time requires");
+	TestCheck(non_monotonic == 0, "the interpolated height of the falling body must not increase");
+
+	std::string ss = "Fixed rate simulation test at 30 Hz with varying update rate:\n";
+	ss += std::to_string(frame_count) + " updates (" + std::to_string(total_time) + " seconds) in " + std::to_string(time) + " ms\n";
+	ss += "Simulation steps: " + std::to_string(total_steps) + " (expected: " + std::to_string(expected_steps) + "), max steps in one update: " + std::to_string(max_steps) + "\n";
+	ss += "Interpolated height: 100 -> " + std::to_string(prev_height) + (wi::physics::IsEnabled() ? "" : " (physics is disabled)") + "\n";
+	ss += "Non-monotonic interpolated frames: " + std::to_string(non_monotonic);
+	return ss;
+}
+
+void TestsRenderer::RunSpatialHashTest()
+{
+	// 50K agents walking on a plane, they are updated and queried in parallel every frame:
+	const uint32_t agent_count = 50000;
+	const int frame_count = 60;
+	const float dt = 1.0f / 60.0f;
+	wi::random::RNG rng(42);
+	wi::vector<XMFLOAT3> positions(agent_count);
+	wi::vector<XMFLOAT3> velocities(agent_count);
+	wi::vector<wi::primitive::AABB> aabbs(agent_count);
+	for (uint32_t i = 0; i < agent_count; ++i)
+	{
+		positions[i] = XMFLOAT3(rng.next_float(-250, 250), rng.next_float(0, 10), rng.next_float(-250, 250));
+		velocities[i] = XMFLOAT3(rng.next_float(-5, 5), 0, rng.next_float(-5, 5));
+	}
+
+	wi::SpatialHash spatial_hash;
+	spatial_hash.SetCellSize(4);
+	spatial_hash.Resize(0, agent_count);
+
+	double update_time = 0;
+	double commit_time = 0;
+	double query_time = 0;
+	std::atomic<uint64_t> neighbour_count{ 0 };
+	wi::Timer timer;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		wi::jobsystem::context ctx;
+
+		timer.record();
+		wi::jobsystem::Dispatch(ctx, agent_count, 256, [&](wi::jobsystem::JobArgs args) {
+			XMFLOAT3& position = positions[args.jobIndex];
+			const XMFLOAT3& velocity = velocities[args.jobIndex];
+			position.x += velocity.x * dt;
+			position.z += velocity.z * dt;
+			aabbs[args.jobIndex].createFromHalfWidth(position, XMFLOAT3(0.5f, 0.5f, 0.5f));
+			spatial_hash.Set(0, args.jobIndex, wi::ecs::Entity(args.jobIndex + 1), aabbs[args.jobIndex]);
+		});
+		wi::jobsystem::Wait(ctx);
+		update_time += timer.elapsed_milliseconds();
+
+		timer.record();
+		spatial_hash.Commit();
+		commit_time += timer.elapsed_milliseconds();
+
+		// Every agent looks for its neighbours:
+		timer.record();
+		wi::jobsystem::Dispatch(ctx, agent_count, 256, [&](wi::jobsystem::JobArgs args) {
+			wi::vector<wi::ecs::Entity> neighbours;
+			spatial_hash.Query(wi::primitive::Sphere(positions[args.jobIndex], 5), neighbours);
+			neighbour_count.fetch_add(neighbours.size());
+		});
+		wi::jobsystem::Wait(ctx);
+		query_time += timer.elapsed_milliseconds();
+	}
+
+	// Results are validated against brute force:
+	int mismatches = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(-250, 250), 5, rng.next_float(-250, 250));
+		const wi::primitive::Sphere sphere(center, rng.next_float(1, 20));
+		wi::vector<wi::ecs::Entity> result;
+		spatial_hash.Query(sphere, result);
+		std::sort(result.begin(), result.end());
+		wi::vector<wi::ecs::Entity> expected;
+		for (uint32_t j = 0; j < agent_count; ++j)
+		{
+			if (sphere.intersects(aabbs[j]))
+			{
+				expected.push_back(wi::ecs::Entity(j + 1));
+			}
+		}
+		if (result != expected)
+		{
+			mismatches++;
+		}
+
+		const uint32_t k = 8;
+		result.clear();
+		spatial_hash.QueryNearest(center, k, result);
+		wi::vector<float> distances(agent_count);
+		for (uint32_t j = 0; j < agent_count; ++j)
+		{
+			distances[j] = wi::math::DistanceSquared(center, wi::math::Clamp(center, aabbs[j]._min, aabbs[j]._max));
+		}
+		std::nth_element(distances.begin(), distances.begin() + (k - 1), distances.end());
+		if (result.size() != k || std::abs(distances[k - 1] - wi::math::DistanceSquared(center, wi::math::Clamp(center, aabbs[result.back() - 1]._min, aabbs[result.back() - 1]._max))) > 0.001f)
+		{
+			mismatches++;
+		}
+	}
+
+	std::string ss = "Spatial hash test for " + std::to_string(agent_count) + " moving entities (averages of " + std::to_string(frame_count) + " frames):\n";
+	ss += "Parallel update: " + std::to_string(update_time / frame_count) + " ms\n";
+	ss += "Rehash of entities that changed cells: " + std::to_string(commit_time / frame_count) + " ms\n";
+	ss += "Parallel radius queries (one per entity): " + std::to_string(query_time / frame_count) + " ms, average neighbours: " + std::to_string(neighbour_count.load() / (uint64_t(agent_count) * frame_count)) + "\n";
+	ss += "Occupied cells: " + std::to_string(spatial_hash.cells.size()) + "\n";
+	ss += "Mismatches against brute force: " + std::to_string(mismatches);
+	TestCheck(mismatches == 0, "spatial hash queries must match brute force");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunFrustumCullingTest()
+{
+	// 1M random boxes around the camera, some of them are empty and some are on a different layer:
+	const uint32_t box_count = 1000000;
+	wi::random::RNG rng(42);
+	wi::vector<wi::primitive::AABB> aabbs(box_count);
+	for (uint32_t i = 0; i < box_count; ++i)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(-500, 500), rng.next_float(-50, 50), rng.next_float(-500, 500));
+		const XMFLOAT3 halfwidth = XMFLOAT3(rng.next_float(0.1f, 3), rng.next_float(0.1f, 3), rng.next_float(0.1f, 3));
+		aabbs[i].createFromHalfWidth(center, halfwidth);
+		aabbs[i].layerMask = (i % 7) == 0 ? 2 : 1;
+		if ((i % 1000) == 0)
+		{
+			aabbs[i] = wi::primitive::AABB();
+		}
+	}
+	wi::primitive::AABBStream stream;
+	stream.set(aabbs.data(), aabbs.size());
+
+	wi::primitive::Frustum frustum;
+	const XMMATRIX V = XMMatrixLookToLH(XMVectorSet(0, 10, 0, 1), XMVectorSet(0.3f, -0.1f, 1, 0), XMVectorSet(0, 1, 0, 0));
+	const XMMATRIX P = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 800);
+	frustum.Create(V * P);
+	const uint32_t layerMask = 1;
+
+	// Both methods are run single threaded a few times, the best time is kept:
+	const int iterations = 5;
+	wi::vector<uint32_t> visible_before;
+	wi::vector<uint32_t> visible_after(box_count);
+	uint32_t visible_after_count = 0;
+	double time_before = std::numeric_limits<double>::max();
+	double time_after = std::numeric_limits<double>::max();
+	wi::Timer timer;
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		timer.record();
+		visible_before.clear();
+		for (uint32_t i = 0; i < box_count; ++i)
+		{
+			if ((aabbs[i].layerMask & layerMask) && frustum.CheckBoxFast(aabbs[i]))
+			{
+				visible_before.push_back(i);
+			}
+		}
+		time_before = std::min(time_before, timer.elapsed_milliseconds());
+
+		timer.record();
+		visible_after_count = 0;
+		for (uint32_t offset = 0; offset < box_count; offset += 64)
+		{
+			visible_after_count += frustum.CheckBoxes(stream, offset, std::min(64u, box_count - offset), layerMask, visible_after.data() + visible_after_count);
+		}
+		time_after = std::min(time_after, timer.elapsed_milliseconds());
+	}
+
+	bool same = visible_before.size() == visible_after_count;
+	for (uint32_t i = 0; same && i < visible_after_count; ++i)
+	{
+		same = visible_before[i] == visible_after[i];
+	}
+
+	std::string ss = "Frustum culling test for " + std::to_string(box_count) + " AABBs (single thread, best of " + std::to_string(iterations) + "):\n";
+	ss += "Frustum::CheckBoxFast() per AABB: " + std::to_string(time_before) + " ms\n";
+	ss += "Frustum::CheckBoxes() with SoA stream: " + std::to_string(time_after) + " ms\n";
+	ss += "Visible: " + std::to_string(visible_after_count) + ", results are " + (same ? "identical" : "DIFFERENT");
+	TestCheck(same, "Frustum::CheckBoxes() results must match Frustum::CheckBoxFast()");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunHierarchicalCullingTest()
+{
+	// 500K random boxes in a large world, some of them are empty and some are on a different layer:
+	const uint32_t box_count = 500000;
+	wi::random::RNG rng(42);
+	wi::vector<wi::primitive::AABB> aabbs(box_count);
+	for (uint32_t i = 0; i < box_count; ++i)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(-4000, 4000), rng.next_float(-50, 50), rng.next_float(-4000, 4000));
+		const XMFLOAT3 halfwidth = XMFLOAT3(rng.next_float(0.1f, 3), rng.next_float(0.1f, 3), rng.next_float(0.1f, 3));
+		aabbs[i].createFromHalfWidth(center, halfwidth);
+		aabbs[i].layerMask = (i % 7) == 0 ? 2 : 1;
+		if ((i % 1000) == 0)
+		{
+			aabbs[i] = wi::primitive::AABB();
+		}
+	}
+	wi::primitive::AABBStream stream;
+	stream.set(aabbs.data(), aabbs.size());
+	wi::BVH bvh;
+	bvh.Build(aabbs.data(), box_count);
+	bvh.BuildWide();
+
+	wi::primitive::Frustum frustum;
+	const XMMATRIX V = XMMatrixLookToLH(XMVectorSet(0, 10, 0, 1), XMVectorSet(0.3f, -0.1f, 1, 0), XMVectorSet(0, 1, 0, 0));
+	const XMMATRIX P = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000);
+	frustum.Create(V * P);
+	const uint32_t layerMask = 1;
+
+	// Both methods are run single threaded a few times, the best time is kept:
+	const int iterations = 5;
+	wi::vector<uint32_t> visible_flat(box_count);
+	uint32_t visible_flat_count = 0;
+	wi::vector<uint32_t> visible_hierarchical;
+	uint32_t inside_count = 0;
+	double time_flat = std::numeric_limits<double>::max();
+	double time_hierarchical = std::numeric_limits<double>::max();
+	wi::Timer timer;
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		timer.record();
+		visible_flat_count = 0;
+		for (uint32_t offset = 0; offset < box_count; offset += 64)
+		{
+			visible_flat_count += frustum.CheckBoxes(stream, offset, std::min(64u, box_count - offset), layerMask, visible_flat.data() + visible_flat_count);
+		}
+		time_flat = std::min(time_flat, timer.elapsed_milliseconds());
+
+		timer.record();
+		visible_hierarchical.clear();
+		inside_count = 0;
+		bvh.CullFrustum(frustum, [&](uint32_t offset, uint32_t count, bool inside) {
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t index = bvh.leaf_indices[offset + i];
+				const wi::primitive::AABB& aabb = aabbs[index];
+				if ((aabb.layerMask & layerMask) && (inside ? aabb.IsValid() : frustum.CheckBoxFast(aabb)))
+				{
+					visible_hierarchical.push_back(index);
+				}
+			}
+			if (inside)
+			{
+				inside_count += count;
+			}
+		});
+		time_hierarchical = std::min(time_hierarchical, timer.elapsed_milliseconds());
+	}
+
+	// The BVH reports objects in leaf order, so the results are compared after sorting:
+	std::sort(visible_hierarchical.begin(), visible_hierarchical.end());
+	bool same = visible_hierarchical.size() == visible_flat_count;
+	for (uint32_t i = 0; same && i < visible_flat_count; ++i)
+	{
+		same = visible_hierarchical[i] == visible_flat[i];
+	}
+
+	std::string ss = "Hierarchical frustum culling test for " + std::to_string(box_count) + " AABBs (single thread, best of " + std::to_string(iterations) + "):\n";
+	ss += "Frustum::CheckBoxes() for every AABB: " + std::to_string(time_flat) + " ms\n";
+	ss += "BVH::CullFrustum(): " + std::to_string(time_hierarchical) + " ms\n";
+	ss += "Accepted without testing (fully inside subtrees): " + std::to_string(inside_count) + "\n";
+	ss += "Visible: " + std::to_string(visible_flat_count) + ", results are " + (same ? "identical" : "DIFFERENT");
+	TestCheck(same, "BVH::CullFrustum() results must match Frustum::CheckBoxes()");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunSoftwareOcclusionTest()
+{
+	// Two tilted walls occlude random boxes in front of the camera. The exact result is known for a single convex occluder:
+	//	a box is hidden if the rays from the eye to all of its corners hit the same wall before they reach the corner
+	struct Wall
+	{
+		XMFLOAT3 center;
+		float angle;
+		float half_width;
+		float half_height;
+	};
+	const Wall walls[] = {
+		{ XMFLOAT3(-25, 0, 60), XM_PI / 6, 20, 15 },
+		{ XMFLOAT3(35, 5, 90), -XM_PI / 9, 20, 20 },
+	};
+	// The walls are subdivided into grids, so the rasterizer processes a realistic amount of triangles with shared edges:
+	const uint32_t wall_subdivision = 32;
+	wi::vector<XMFLOAT3> wall_positions;
+	wi::vector<uint32_t> wall_indices;
+	for (uint32_t y = 0; y <= wall_subdivision; ++y)
+	{
+		for (uint32_t x = 0; x <= wall_subdivision; ++x)
+		{
+			wall_positions.push_back(XMFLOAT3(float(x) / wall_subdivision * 2 - 1, 1 - float(y) / wall_subdivision * 2, 0));
+			if (x < wall_subdivision && y < wall_subdivision)
+			{
+				const uint32_t i = x + y * (wall_subdivision + 1);
+				const uint32_t row = wall_subdivision + 1;
+				wall_indices.push_back(i);
+				wall_indices.push_back(i + 1);
+				wall_indices.push_back(i + row);
+				wall_indices.push_back(i + row);
+				wall_indices.push_back(i + 1);
+				wall_indices.push_back(i + row + 1);
+			}
+		}
+	}
+
+	const XMVECTOR eye = XMVectorSet(0, 0, 0, 1);
+	const XMMATRIX V = XMMatrixLookToLH(eye, XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	const XMMATRIX P = XMMatrixPerspectiveFovLH(XM_PIDIV2 * 2 / 3, 16.0f / 9.0f, 1000, 0.1f); // reversed Z, like CameraComponent
+
+	const uint32_t box_count = 100000;
+	wi::random::RNG rng(42);
+	wi::vector<wi::primitive::AABB> aabbs(box_count);
+	for (uint32_t i = 0; i < box_count; ++i)
+	{
+		const XMFLOAT3 center = XMFLOAT3(rng.next_float(-150, 150), rng.next_float(-60, 60), rng.next_float(5, 300));
+		const XMFLOAT3 halfwidth = XMFLOAT3(rng.next_float(0.2f, 4), rng.next_float(0.2f, 4), rng.next_float(0.2f, 4));
+		aabbs[i].createFromHalfWidth(center, halfwidth);
+	}
+
+	// Reference result:
+	wi::vector<uint8_t> hidden(box_count, 0);
+	uint32_t hidden_count = 0;
+	for (auto& wall : walls)
+	{
+		const XMMATRIX W = XMMatrixRotationY(wall.angle) * XMMatrixTranslationFromVector(XMLoadFloat3(&wall.center));
+		const XMMATRIX W_inverse = XMMatrixInverse(nullptr, W);
+		const XMVECTOR origin = XMVector3Transform(eye, W_inverse);
+		const float origin_z = XMVectorGetZ(origin);
+		for (uint32_t i = 0; i < box_count; ++i)
+		{
+			bool occluded = true;
+			for (int j = 0; j < 8 && occluded; ++j)
+			{
+				const XMFLOAT3 corner = aabbs[i].corner(j);
+				const XMVECTOR target = XMVector3Transform(XMLoadFloat3(&corner), W_inverse);
+				const float target_z = XMVectorGetZ(target);
+				if ((origin_z > 0) == (target_z > 0) || target_z == 0)
+				{
+					occluded = false; // the corner is not behind the wall
+					break;
+				}
+				const XMVECTOR hit = XMVectorLerp(origin, target, origin_z / (origin_z - target_z));
+				occluded = std::abs(XMVectorGetX(hit)) <= wall.half_width && std::abs(XMVectorGetY(hit)) <= wall.half_height;
+			}
+			if (occluded && !hidden[i])
+			{
+				hidden[i] = 1;
+				hidden_count++;
+			}
+		}
+	}
+
+	// Software occlusion, the best time of a few iterations is kept:
+	const int iterations = 5;
+	wi::OcclusionBuffer buffer;
+	wi::vector<uint8_t> culled(box_count, 0);
+	double time_rasterize = std::numeric_limits<double>::max();
+	double time_test = std::numeric_limits<double>::max();
+	wi::Timer timer;
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		timer.record();
+		buffer.Begin(256, 144, V * P);
+		for (auto& wall : walls)
+		{
+			const XMMATRIX W = XMMatrixScaling(wall.half_width, wall.half_height, 1) * XMMatrixRotationY(wall.angle) * XMMatrixTranslationFromVector(XMLoadFloat3(&wall.center));
+			buffer.AddOccluder(wall_positions.data(), (uint32_t)wall_positions.size(), wall_indices.data(), (uint32_t)wall_indices.size(), W);
+		}
+		buffer.Rasterize();
+		time_rasterize = std::min(time_rasterize, timer.elapsed_milliseconds());
+
+		timer.record();
+		for (uint32_t i = 0; i < box_count; ++i)
+		{
+			culled[i] = buffer.IsVisible(aabbs[i]) ? 0 : 1;
+		}
+		time_test = std::min(time_test, timer.elapsed_milliseconds());
+	}
+
+	uint32_t culled_count = 0;
+	uint32_t incorrect_count = 0;
+	for (uint32_t i = 0; i < box_count; ++i)
+	{
+		culled_count += culled[i];
+		incorrect_count += culled[i] && !hidden[i] ? 1 : 0;
+	}
+
+	std::string ss = "Software occlusion culling test for " + std::to_string(box_count) + " AABBs, " + std::to_string(buffer.width) + "x" + std::to_string(buffer.height) + " depth buffer (best of " + std::to_string(iterations) + "):\n";
+	ss += "Occluder rasterization (" + std::to_string(buffer.GetTriangleCount()) + " triangles): " + std::to_string(time_rasterize) + " ms\n";
+	ss += "OcclusionBuffer::IsVisible() for every AABB (single thread): " + std::to_string(time_test) + " ms\n";
+	ss += "Hidden: " + std::to_string(hidden_count) + ", culled: " + std::to_string(culled_count) + " (" + std::to_string(hidden_count > 0 ? culled_count * 100 / hidden_count : 100) + "% of hidden)\n";
+	ss += "Incorrectly culled: " + std::to_string(incorrect_count);
+	TestCheck(incorrect_count == 0, "software occlusion must not cull visible AABBs");
+	TestCheck(hidden_count == 0 || culled_count > 0, "software occlusion must cull some of the hidden AABBs");
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunRadixSortTest()
+{
+	// The render queue of the renderer is sorted with radix sort, this compares it with std::sort by the same keys:
+	using wi::renderer::RenderBatch;
+	using wi::renderer::RenderQueue;
+
+	std::string ss = "Render queue sorting test (best of 5):\n";
+	wi::random::RNG rng(42);
+	RenderQueue queue;
+	for (uint32_t batch_count : { 1000u, 10000u, 100000u })
+	{
+		wi::vector<RenderBatch> source(batch_count);
+		for (uint32_t i = 0; i < batch_count; ++i)
+		{
+			source[i].Create(rng.next_uint(0u, 1999u), i, rng.next_float(0, 1000), rng.next_uint(0u, 15u) << 28u);
+		}
+
+		for (bool transparent : { false, true })
+		{
+			wi::vector<RenderBatch> batches_std;
+			double time_std = std::numeric_limits<double>::max();
+			double time_radix = std::numeric_limits<double>::max();
+			wi::Timer timer;
+			for (int iteration = 0; iteration < 5; ++iteration)
+			{
+				batches_std = source;
+				timer.record();
+				if (transparent)
+				{
+					std::sort(batches_std.begin(), batches_std.end(), std::greater<RenderBatch>());
+				}
+				else
+				{
+					std::sort(batches_std.begin(), batches_std.end(), std::less<RenderBatch>());
+				}
+				time_std = std::min(time_std, timer.elapsed_milliseconds());
+
+				queue.batches = source;
+				timer.record();
+				if (transparent)
+				{
+					queue.sort_transparent();
+				}
+				else
+				{
+					queue.sort_opaque();
+				}
+				time_radix = std::min(time_radix, timer.elapsed_milliseconds());
+			}
+
+			bool same = true;
+			bool back_to_front = true;
+			for (uint32_t i = 0; i < batch_count; ++i)
+			{
+				const RenderBatch& a = batches_std[i];
+				const RenderBatch& b = queue.batches[i];
+				same &= transparent ? a.GetTransparentSortKey() == b.GetTransparentSortKey() : a.GetOpaqueSortKey() == b.GetOpaqueSortKey();
+				if (transparent && i > 0)
+				{
+					back_to_front &= queue.batches[i - 1].GetDistance() >= b.GetDistance();
+				}
+			}
+			const std::string name = std::to_string(batch_count) + (transparent ? " transparent" : " opaque") + " batches";
+			TestCheck(same, name + " must be in the same order as with std::sort");
+			TestCheck(back_to_front, name + " must be sorted back to front");
+
+			ss += name + ": std::sort: " + std::to_string(time_std) + " ms, RenderQueue: " + std::to_string(time_radix) + " ms\n";
+		}
+	}
+
+	ShowTestResult(ss);
+}
+
+void TestsRenderer::RunDeltaSerializationTest()
+{
+	ShowTestResult(DeltaSerializationTest());
+}
+std::string TestsRenderer::DeltaSerializationTest()
+{
+	// Replication round trip: the client loads the same baseline as the server, then the server only sends deltas
+	Scene server;
+	const int entity_count = 1000;
+	wi::vector<Entity> entities(entity_count);
+	for (int i = 0; i < entity_count; ++i)
+	{
+		entities[i] = server.Entity_CreateObject("object" + std::to_string(i));
+		server.transforms.GetComponent(entities[i])->Translate(XMFLOAT3(float(i), 0, 0));
+	}
+
+	Scene client;
+	{
+		wi::Archive archive;
+		server.Serialize(archive);
+		archive.SetReadModeAndResetPos(true);
+		client.Serialize(archive);
+	}
+
+	// Returns the number of named entities whose components differ between the server and the client:
+	auto count_mismatches = [&]() {
+		size_t mismatches = 0;
+		for (auto& it : server.componentLibrary.entries)
+		{
+			auto client_it = client.componentLibrary.entries.find(it.first);
+			if (client_it == client.componentLibrary.entries.end() || client_it->second.component_manager->GetCount() != it.second.component_manager->GetCount())
+			{
+				mismatches++;
+			}
+		}
+		for (size_t i = 0; i < server.names.GetCount(); ++i)
+		{
+			const TransformComponent* transform = server.transforms.GetComponent(server.names.GetEntity(i));
+			const Entity client_entity = client.Entity_FindByName(server.names[i].name);
+			const TransformComponent* client_transform = client.transforms.GetComponent(client_entity);
+			if (transform == nullptr || client_transform == nullptr ||
+				std::memcmp(&transform->translation_local, &client_transform->translation_local, sizeof(XMFLOAT3)) != 0 ||
+				std::memcmp(&transform->rotation_local, &client_transform->rotation_local, sizeof(XMFLOAT4)) != 0 ||
+				std::memcmp(&transform->scale_local, &client_transform->scale_local, sizeof(XMFLOAT3)) != 0)
+			{
+				mismatches++;
+			}
+		}
+		return mismatches;
+	};
+	Scene::Snapshot server_baseline;
+	Scene::Snapshot client_baseline;
+	auto create_baselines = [&]() {
+		server.CreateSnapshot(server_baseline);
+		client.CreateSnapshot(client_baseline);
+	};
+	// Sends the delta from the server to the client, returns its size:
+	auto send_delta = [&](const wi::unordered_set<Entity>* changed_entities) {
+		wi::Archive archive;
+		server.SerializeDelta(server_baseline, archive, changed_entities);
+		const size_t size = archive.GetPos();
+		archive.SetReadModeAndResetPos(true);
+		client.ApplyDelta(client_baseline, archive);
+		return size;
+	};
+
+	std::string ss = "Scene delta serialization test for " + std::to_string(entity_count) + " objects:\n";
+	TestCheck(count_mismatches() == 0, "the client must match the server after loading the baseline");
+
+	// Modified, renamed, removed and added components:
+	create_baselines();
+	for (int i = 0; i < 10; ++i)
+	{
+		server.transforms.GetComponent(entities[i])->Translate(XMFLOAT3(0, 1, 0));
+	}
+	server.names.GetComponent(entities[20])->name = "renamed";
+	server.Entity_Remove(entities[500]);
+	const Entity added = server.Entity_CreateObject("added");
+	server.transforms.GetComponent(added)->Translate(XMFLOAT3(1, 2, 3));
+	wi::Timer timer;
+	size_t delta_size = send_delta(nullptr);
+	const double time = timer.elapsed_milliseconds();
+	const size_t mismatches = count_mismatches();
+	TestCheck(mismatches == 0, "the client must match the server after applying the delta");
+	TestCheck(client.Entity_FindByName("object500") == INVALID_ENTITY, "the removed entity must be removed by the delta");
+	TestCheck(client.Entity_FindByName("renamed") != INVALID_ENTITY && client.Entity_FindByName("added") != INVALID_ENTITY, "the renamed and added entities must be created by the delta");
+	ss += "Delta with 10 moved, 1 renamed, 1 removed and 1 added object: " + std::to_string(delta_size) + " bytes, " + std::to_string(time) + " ms, mismatches: " + std::to_string(mismatches) + "\n";
+
+	// Without changes, the delta contains no component managers:
+	create_baselines();
+	{
+		wi::Archive archive;
+		server.SerializeDelta(server_baseline, archive);
+		archive.SetReadModeAndResetPos(true);
+		bool has_next = true;
+		archive >> has_next;
+		TestCheck(!has_next, "the delta of an unchanged scene must be empty");
+	}
+
+	// Only the listed entities are compared, the others are considered unchanged:
+	create_baselines();
+	wi::unordered_set<Entity> changed_entities;
+	changed_entities.insert(entities[1]);
+	server.transforms.GetComponent(entities[1])->Translate(XMFLOAT3(0, 0, 1));
+	server.transforms.GetComponent(entities[2])->Translate(XMFLOAT3(0, 0, 1));
+	delta_size = send_delta(&changed_entities);
+	const TransformComponent* client_listed = client.transforms.GetComponent(client.Entity_FindByName("object1"));
+	const TransformComponent* client_unlisted = client.transforms.GetComponent(client.Entity_FindByName("object2"));
+	TestCheck(client_listed != nullptr && client_listed->translation_local.z == 1, "the listed changed entity must be sent in the delta");
+	TestCheck(client_unlisted != nullptr && client_unlisted->translation_local.z == 0, "entities that are not listed as changed must not be compared");
+	ss += "Delta with changed entity list: " + std::to_string(delta_size) + " bytes\n";
+
+	// A delta against a different baseline is rejected without modifying the scene:
+	create_baselines();
+	server.Entity_Remove(entities[4]);
+	client_baseline = {};
+	send_delta(nullptr);
+	TestCheck(client.Entity_FindByName("object4") != INVALID_ENTITY, "a delta against a different baseline must not be applied");
+	ss += "Delta against a different baseline was rejected";
+
+	return ss;
+}
+
+void TestsRenderer::RunCompressionTest()
+{
+	ShowTestResult(CompressionTest());
+}
+std::string TestsRenderer::CompressionTest()
+{
+	std::string ss = "Compression round trip test:\n";
+
+	// Block codec, the inputs must come back unchanged:
+	wi::random::RNG rng(42);
+	auto round_trip = [&](const std::string& name, const wi::vector<uint8_t>& data, bool must_compress) {
+		wi::vector<uint8_t> compressed;
+		const bool smaller = wi::helper::Compress(data.data(), data.size(), compressed);
+		wi::vector<uint8_t> decompressed(data.size());
+		const bool success = wi::helper::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+		TestCheck(compressed.size() <= wi::helper::CompressBound(data.size()), name + " must not be compressed larger than CompressBound()");
+		TestCheck(success && decompressed == data, name + " must be decompressed unchanged");
+		TestCheck(!must_compress || smaller, name + " must be compressed smaller");
+		ss += name + ": " + std::to_string(data.size()) + " -> " + std::to_string(compressed.size()) + " bytes\n";
+		return compressed;
+	};
+	wi::vector<uint8_t> data;
+	round_trip("Empty", data, false);
+	data.resize(100000);
+	for (auto& x : data)
+	{
+		x = uint8_t(rng.next_uint(0u, 255u));
+	}
+	round_trip("Incompressible", data, false);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = "repetitive"[i % 10];
+	}
+	round_trip("Highly repetitive", data, true);
+	// Longer than an archive compression block and the match distance limit, with partly random repetitions:
+	data.resize(1024 * 1024);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = rng.next_uint(0u, 7u) == 0 ? uint8_t(rng.next_uint(0u, 255u)) : (i < 100000 ? uint8_t(i / 100) : data[i - 40000]);
+	}
+	wi::vector<uint8_t> compressed = round_trip("Larger than block", data, true);
+
+	// Corrupted compressed data must be rejected instead of being decoded out of bounds:
+	wi::vector<uint8_t> decompressed(data.size());
+	TestCheck(!wi::helper::Decompress(compressed.data(), compressed.size() / 2, decompressed.data(), decompressed.size()), "truncated compressed data must be rejected");
+	TestCheck(!wi::helper::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1), "compressed data must be rejected if the output is too small");
+
+	// Compressed archive, which is written in blocks and decompressed in parallel:
+	const std::string filename = wi::helper::GetTempDirectoryPath() + "/wi_compression_test.wiscene";
+	const size_t value_count = 200000; // several compression blocks
+	{
+		wi::Archive archive;
+		archive.SetCompressionEnabled(true);
+		archive << std::string("compressed archive");
+		for (size_t i = 0; i < value_count; ++i)
+		{
+			archive << uint64_t(i % 1000);
+		}
+		archive << data;
+		archive.SaveFile(filename);
+	}
+	wi::vector<uint8_t> filedata;
+	wi::helper::FileRead(filename, filedata);
+	auto check_archive = [&](wi::Archive& archive, const std::string& name) {
+		bool success = archive.IsOpen() && archive.IsCompressionEnabled();
+		std::string text;
+		archive >> text;
+		success &= text == "compressed archive";
+		for (size_t i = 0; success && i < value_count; ++i)
+		{
+			uint64_t value = 0;
+			archive >> value;
+			success &= value == i % 1000;
+		}
+		wi::vector<uint8_t> read_data;
+		archive >> read_data;
+		success &= read_data == data;
+		TestCheck(success, name + " must read back the written data");
+	};
+	{
+		wi::Archive archive(filename);
+		check_archive(archive, "Compressed archive from file");
+	}
+	{
+		wi::Archive archive(filedata.data(), filedata.size());
+		check_archive(archive, "Compressed archive from memory");
+	}
+	ss += "Compressed archive: " + std::to_string(filedata.size()) + " bytes in file\n";
+
+	// Truncated compressed archive must be rejected:
+	{
+		wi::Archive archive(filedata.data(), filedata.size() / 2);
+		TestCheck(!archive.IsCompressionEnabled(), "truncated compressed archive must be rejected");
+	}
+	std::remove(filename.c_str());
+
+	return ss;
+}
+
+void TestsRenderer::RunAsyncSerializationTest()
+{
+	ShowTestResult(AsyncSerializationTest());
+}
+std::string TestsRenderer::AsyncSerializationTest()
+{
+	// The scene is modified while it's saved in the background, the file must contain the state from when the save was requested
+	Scene scene;
+	const int entity_count = 10000;
+	wi::vector<Entity> entities(entity_count);
+	for (int i = 0; i < entity_count; ++i)
+	{
+		entities[i] = scene.Entity_CreateObject("object" + std::to_string(i));
+		scene.transforms.GetComponent(entities[i])->Translate(XMFLOAT3(float(i), 0, 0));
+	}
+	Entity terrain_entity = CreateEntity();
+	wi::terrain::Terrain& terrain = scene.terrains.Create(terrain_entity);
+	std::shared_ptr<wi::terrain::PerlinModifier> modifier = std::make_shared<wi::terrain::PerlinModifier>();
+	modifier->weight = 0.5f;
+	terrain.modifiers.push_back(modifier);
+
+	const std::string filename = wi::helper::GetTempDirectoryPath() + "/wi_async_save_test.wiscene";
+	wi::Timer timer;
+	auto save = scene.SerializeAsync(filename);
+	const double time_request = timer.elapsed_milliseconds();
+
+	// Moving, adding and removing entities and changing the terrain on this thread until the save is finished:
+	int modification_count = 0;
+	do
+	{
+		for (int i = 0; i < 100; ++i)
+		{
+			scene.transforms.GetComponent(entities[(modification_count * 100 + i) % entity_count])->Translate(XMFLOAT3(0, 1, 0));
+		}
+		scene.Entity_CreateObject("added");
+		if (modification_count < entity_count)
+		{
+			scene.Entity_Remove(entities[entity_count - 1 - modification_count]);
+			entities[entity_count - 1 - modification_count] = scene.Entity_CreateObject("added");
+		}
+		modifier->weight = 0.9f;
+		modification_count++;
+	} while (!save->IsFinished());
+	save->Wait();
+	const double time_save = timer.elapsed_milliseconds();
+	TestCheck(save->success.load(), "the background save must write the file");
+
+	Scene loaded;
+	{
+		wi::Archive archive(filename);
+		if (archive.IsOpen())
+		{
+			loaded.Serialize(archive);
+		}
+	}
+	std::remove(filename.c_str());
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < loaded.names.GetCount(); ++i)
+	{
+		const std::string& name = loaded.names[i].name;
+		const TransformComponent* transform = loaded.transforms.GetComponent(loaded.names.GetEntity(i));
+		if (name.compare(0, 6, "object") != 0 || transform == nullptr || transform->translation_local.x != float(std::stoi(name.substr(6))) || transform->translation_local.y != 0)
+		{
+			mismatches++;
+		}
+	}
+	TestCheck(loaded.names.GetCount() == entity_count && mismatches == 0, "the saved scene must contain the entities from when the save was requested");
+	TestCheck(loaded.terrains.GetCount() == 1 && loaded.terrains[0].modifiers.size() == 1 && loaded.terrains[0].modifiers[0]->weight == 0.5f, "the saved terrain must not see the modifications made during the save");
+
+	std::string ss = "Background scene save test for " + std::to_string(entity_count) + " objects:\n";
+	ss += "SerializeAsync() returned after " + std::to_string(time_request) + " ms, the file was written after " + std::to_string(time_save) + " ms\n";
+	ss += "Modifications during the save: " + std::to_string(modification_count) + "\n";
+	ss += "Loaded entities: " + std::to_string(loaded.names.GetCount()) + ", mismatches: " + std::to_string(mismatches);
+	return ss;
+}
+
+void TestsRenderer::RunTextureBakerTest()
+{
+	ShowTestResult(TextureBakerTest());
+}
+std::string TestsRenderer::TextureBakerTest()
+{
+	std::string ss = "Texture baker test:\n";
+
+	// Reference decoders written from the format specifications, independent of the encoders:
+	auto unpack565 = [](uint16_t packed, int color[3]) {
+		const int r = (packed >> 11) & 31;
+		const int g = (packed >> 5) & 63;
+		const int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	};
+	auto decode_color = [&](const uint8_t* block, uint8_t rgba[64]) {
+		const uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+		const uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+		int palette[4][4] = {};
+		unpack565(c0, palette[0]);
+		unpack565(c1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			if (c0 > c1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+		for (int i = 0; i < 16; ++i)
+		{
+			const int index = (indices >> (i * 2)) & 3;
+			for (int c = 0; c < 3; ++c)
+			{
+				rgba[i * 4 + c] = uint8_t(palette[index][c]);
+			}
+			rgba[i * 4 + 3] = (c0 <= c1 && index == 3) ? 0 : 255;
+		}
+	};
+	auto decode_alpha = [](const uint8_t* block, uint8_t* rgba, int channel) {
+		const int e0 = block[0];
+		const int e1 = block[1];
+		int palette[8] = { e0, e1 };
+		if (e0 > e1)
+		{
+			for (int i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = ((7 - i) * e0 + i * e1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+			{
+				palette[i + 1] = ((5 - i) * e0 + i * e1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i)
+		{
+			indices |= uint64_t(block[2 + i]) << (i * 8);
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			rgba[i * 4 + channel] = uint8_t(palette[(indices >> (i * 3)) & 7]);
+		}
+	};
+	auto decode_bc7 = [](const uint8_t* block, uint8_t rgba[64]) {
+		uint32_t position = 0;
+		auto read = [&](uint32_t bits) {
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bits; ++i, ++position)
+			{
+				value |= uint32_t((block[position >> 3] >> (position & 7)) & 1) << i;
+			}
+			return value;
+		};
+		if (read(7) != (1u << 6))
+			return false; // only mode 6 is decoded
+		int endpoints[2][4];
+		for (int c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = int(read(7)) << 1;
+			endpoints[1][c] = int(read(7)) << 1;
+		}
+		const uint32_t pbit0 = read(1);
+		const uint32_t pbit1 = read(1);
+		static constexpr int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (int i = 0; i < 16; ++i)
+		{
+			const int index = int(read(i == 0 ? 3 : 4));
+			for (int c = 0; c < 4; ++c)
+			{
+				const int a = endpoints[0][c] | pbit0;
+				const int b = endpoints[1][c] | pbit1;
+				rgba[i * 4 + c] = uint8_t(((64 - weights[index]) * a + weights[index] * b + 32) >> 6);
+			}
+		}
+		return true;
+	};
+
+	// Known blocks, the decoded texels must stay within the error bound of the format for every channel it stores:
+	struct TestBlock
+	{
+		std::string name;
+		uint8_t rgba[64];
+	};
+	wi::vector<TestBlock> blocks(3);
+	blocks[0].name = "solid color";
+	blocks[1].name = "two color gradient";
+	blocks[2].name = "alpha edge";
+	for (int i = 0; i < 16; ++i)
+	{
+		const int x = i % 4;
+		const uint8_t solid[4] = { 200, 100, 50, 255 };
+		const uint8_t gradient[4] = { uint8_t(255 - x * 85), uint8_t(x * 85), 64, uint8_t(255 - x * 85) };
+		const uint8_t edge[4] = { uint8_t(x < 2 ? 0 : 255), 128, 32, uint8_t(x < 2 ? 0 : 255) };
+		std::memcpy(blocks[0].rgba + i * 4, solid, 4);
+		std::memcpy(blocks[1].rgba + i * 4, gradient, 4);
+		std::memcpy(blocks[2].rgba + i * 4, edge, 4);
+	}
+	struct Codec
+	{
+		std::string name;
+		void (*encode)(const uint8_t*, uint8_t*);
+		int channels[4]; // error bound per channel, or -1 if the channel is not stored
+	};
+	const Codec codecs[] = {
+		{ "BC1", wi::texturebaker::EncodeBC1, { 8, 4, 8, -1 } },
+		{ "BC3", wi::texturebaker::EncodeBC3, { 8, 4, 8, 2 } },
+		{ "BC4", wi::texturebaker::EncodeBC4, { 2, -1, -1, -1 } },
+		{ "BC5", wi::texturebaker::EncodeBC5, { 2, 2, -1, -1 } },
+		{ "BC7", wi::texturebaker::EncodeBC7, { 4, 4, 4, 4 } },
+	};
+	for (auto& codec : codecs)
+	{
+		ss += codec.name + " max error:";
+		for (auto& test : blocks)
+		{
+			uint8_t block[16] = {};
+			codec.encode(test.rgba, block);
+			uint8_t decoded[64] = {};
+			bool decodable = true;
+			if (codec.name == "BC1")
+			{
+				decode_color(block, decoded);
+			}
+			else if (codec.name == "BC3")
+			{
+				decode_color(block + 8, decoded);
+				decode_alpha(block, decoded, 3);
+			}
+			else if (codec.name == "BC4")
+			{
+				decode_alpha(block, decoded, 0);
+			}
+			else if (codec.name == "BC5")
+			{
+				decode_alpha(block, decoded, 0);
+				decode_alpha(block + 8, decoded, 1);
+			}
+			else
+			{
+				decodable = decode_bc7(block, decoded);
+			}
+			int max_error = 0;
+			bool within_bounds = decodable;
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					if (codec.channels[c] < 0)
+						continue;
+					const int error = std::abs(int(decoded[i * 4 + c]) - int(test.rgba[i * 4 + c]));
+					max_error = std::max(max_error, error);
+					within_bounds &= error <= codec.channels[c];
+				}
+			}
+			TestCheck(within_bounds, codec.name + " " + test.name + " block must decode within the error bound");
+			ss += " " + test.name + ": " + std::to_string(max_error) + ";";
+		}
+		ss += "\n";
+	}
+
+	// Mip chain dimensions and content:
+	auto make_texture = [](uint32_t width, uint32_t height, wi::graphics::Format format, wi::vector<uint8_t>& data) {
+		wi::graphics::TextureDesc desc;
+		desc.width = width;
+		desc.height = height;
+		desc.format = format;
+		data.resize(size_t(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				// checkerboard in red, solid green, horizontal stripes in blue:
+				uint8_t* texel = data.data() + (size_t(y) * width + x) * 4;
+				texel[0] = ((x + y) % 2) ? 255 : 0;
+				texel[1] = 100;
+				texel[2] = (y % 2) ? 200 : 0;
+				texel[3] = 255;
+			}
+		}
+		return desc;
+	};
+	wi::vector<uint8_t> src;
+	wi::graphics::TextureDesc src_desc = make_texture(16, 4, wi::graphics::Format::R8G8B8A8_UNORM, src);
+	wi::vector<uint8_t> mips;
+	wi::graphics::TextureDesc mips_desc;
+	bool success = wi::texturebaker::GenerateMips(src, src_desc, mips, mips_desc);
+	TestCheck(success && mips_desc.mip_levels == 5 && mips.size() == (16 * 4 + 8 * 2 + 4 * 1 + 2 * 1 + 1 * 1) * 4, "full mip chain of 16x4 texture must have 5 mips: 16x4, 8x2, 4x1, 2x1, 1x1");
+	bool content_valid = success;
+	size_t offset = 0;
+	for (uint32_t mip = 0; success && mip < mips_desc.mip_levels; ++mip)
+	{
+		const uint32_t width = std::max(1u, 16u >> mip);
+		const uint32_t height = std::max(1u, 4u >> mip);
+		for (uint32_t i = 0; mip > 0 && i < width * height; ++i)
+		{
+			const uint8_t* texel = mips.data() + offset + i * 4;
+			content_valid &= std::abs(int(texel[0]) - 128) <= 1; // checkerboard averages to gray
+			content_valid &= texel[1] == 100;
+			content_valid &= std::abs(int(texel[2]) - 100) <= 1;
+			content_valid &= texel[3] == 255;
+		}
+		offset += size_t(width) * height * 4;
+	}
+	TestCheck(content_valid, "mips must be the average of the source texels");
+	ss += "16x4 full chain: " + std::to_string(mips_desc.mip_levels) + " mips, " + std::to_string(mips.size()) + " bytes\n";
+
+	wi::texturebaker::MipGenParams params;
+	params.min_dimension = 4;
+	success = wi::texturebaker::GenerateMips(src, src_desc, mips, mips_desc, params);
+	TestCheck(success && mips_desc.mip_levels == 1 && mips == src, "mip chain must stop before a dimension goes below the minimum dimension");
+	src_desc = make_texture(16, 8, wi::graphics::Format::R8G8B8A8_UNORM, src);
+	success = wi::texturebaker::GenerateMips(src, src_desc, mips, mips_desc, params);
+	TestCheck(success && mips_desc.mip_levels == 2, "16x8 texture with minimum dimension of 4 must have 2 mips: 16x8, 8x4");
+	params = {};
+	params.mip_levels = 3;
+	success = wi::texturebaker::GenerateMips(src, src_desc, mips, mips_desc, params);
+	TestCheck(success && mips_desc.mip_levels == 3 && mips.size() == (16 * 8 + 8 * 4 + 4 * 2) * 4, "requested mip count must be respected");
+
+	// sRGB texels are averaged in linear space, the checkerboard of black and white is brighter than 128:
+	src_desc = make_texture(2, 2, wi::graphics::Format::R8G8B8A8_UNORM_SRGB, src);
+	success = wi::texturebaker::GenerateMips(src, src_desc, mips, mips_desc);
+	TestCheck(success && mips_desc.mip_levels == 2 && std::abs(int(mips[16]) - 188) <= 1, "sRGB mips must be filtered in linear space");
+	ss += "sRGB checkerboard average: " + std::to_string(success && mips.size() > 16 ? int(mips[16]) : 0);
+	return ss;
+}
+
+void TestsRenderer::RunResourceBudgetTest()
+{
+	ShowTestResult(ResourceBudgetTest());
+}
+std::string TestsRenderer::ResourceBudgetTest()
+{
+	// Scripts are loaded from memory, so this works without files and graphics device
+	//	The memory of the resources that exist before the test is the baseline of the budgets
+	const size_t prev_budget = wi::resourcemanager::GetMemoryBudget();
+	const bool prev_retain = wi::resourcemanager::IsRetainCacheEnabled();
+	wi::resourcemanager::SetRetainCacheEnabled(false);
+	auto get_total = [] {
+		const wi::resourcemanager::MemoryUsage usage = wi::resourcemanager::GetMemoryUsage();
+		return usage.total.cpu_bytes + usage.total.gpu_bytes;
+	};
+	const wi::resourcemanager::MemoryUsage base_usage = wi::resourcemanager::GetMemoryUsage();
+	const size_t base = base_usage.total.cpu_bytes + base_usage.total.gpu_bytes;
+
+	const size_t script_size = 1000;
+	auto load_script = [&](const std::string& name) {
+		const std::string script(script_size, name.back()); // different content for every script, so they are not aliased
+		return wi::resourcemanager::Load("wi_resource_budget_test_" + name + ".lua", wi::resourcemanager::Flags::NONE, (const uint8_t*)script.data(), script.size());
+	};
+	auto contains = [](const std::string& name) {
+		return wi::resourcemanager::Contains("wi_resource_budget_test_" + name + ".lua");
+	};
+
+	// Usage statistics:
+	wi::Resource a = load_script("a");
+	wi::Resource b = load_script("b");
+	wi::Resource c = load_script("c");
+	const wi::resourcemanager::MemoryUsage usage = wi::resourcemanager::GetMemoryUsage();
+	const size_t script_type = size_t(wi::resourcemanager::DataType::SCRIPT);
+	TestCheck(a.IsValid() && b.IsValid() && c.IsValid(), "scripts must be loaded from memory");
+	TestCheck(a.GetCPUMemoryUsage() == script_size && a.GetGPUMemoryUsage() == 0, "script memory must be the size of the script");
+	TestCheck(usage.total.count == base_usage.total.count + 3 && usage.total.cpu_bytes == base_usage.total.cpu_bytes + 3 * script_size, "total memory usage must include the loaded scripts");
+	TestCheck(usage.types[script_type].count == base_usage.types[script_type].count + 3, "script memory usage must be counted by type");
+	TestCheck(usage.retained.count == base_usage.retained.count, "resources must not be retained while the retain cache is disabled");
+
+	// The retain cache keeps released resources while they fit into the budget, and releases the least recently loaded first:
+	a = {};
+	b = {};
+	c = {};
+	TestCheck(!contains("a") && !contains("b") && !contains("c"), "released resources must be unloaded while the retain cache is disabled");
+	wi::resourcemanager::SetRetainCacheEnabled(true);
+	wi::resourcemanager::SetMemoryBudget(base + 3 * script_size);
+	load_script("a");
+	load_script("b");
+	load_script("c");
+	wi::resourcemanager::UpdateRetainCache();
+	TestCheck(contains("a") && contains("b") && contains("c"), "retained resources must be kept while they fit into the budget");
+	TestCheck(wi::resourcemanager::GetMemoryUsage().retained.count == base_usage.retained.count + 3, "released resources must be counted as retained");
+
+	wi::resourcemanager::SetMemoryBudget(base + 2 * script_size);
+	wi::resourcemanager::UpdateRetainCache();
+	TestCheck(!contains("a") && contains("b") && contains("c"), "the least recently loaded resource must be released first when the budget is exceeded");
+
+	// There is no file for the name, so the script can only come back from the retain cache:
+	b = wi::resourcemanager::Load("wi_resource_budget_test_b.lua");
+	TestCheck(b.IsValid() && b.GetScript() == std::string(script_size, 'b'), "retained resource must be returned by Load()");
+	b = {};
+	wi::resourcemanager::SetMemoryBudget(base + script_size);
+	wi::resourcemanager::UpdateRetainCache();
+	TestCheck(contains("b") && !contains("c"), "loading a retained resource again must make it the most recently loaded");
+
+	// After unloading, the running total must not include the released resources, otherwise the new ones would be evicted:
+	wi::resourcemanager::ClearRetainCache();
+	TestCheck(!contains("b") && get_total() == base, "clearing the retain cache must unload the resources that are not in use");
+	wi::resourcemanager::SetMemoryBudget(base + 2 * script_size);
+	load_script("d");
+	load_script("e");
+	wi::resourcemanager::UpdateRetainCache();
+	TestCheck(contains("d") && contains("e"), "the memory total must be correct after resources were unloaded");
+
+	std::string ss = "Resource memory budget test:\n";
+	ss += "Baseline: " + std::to_string(base_usage.total.count) + " resources, " + std::to_string(base) + " bytes\n";
+	ss += "With 3 scripts: " + std::to_string(usage.total.count) + " resources, " + std::to_string(usage.total.cpu_bytes + usage.total.gpu_bytes) + " bytes";
+
+	wi::resourcemanager::SetRetainCacheEnabled(prev_retain);
+	wi::resourcemanager::ClearRetainCache();
+	wi::resourcemanager::SetMemoryBudget(prev_budget);
+	return ss;
+}
+
+void TestsRenderer::RunPackageTest()
+{
+	ShowTestResult(PackageTest());
+}
+std::string TestsRenderer::PackageTest()
+{
+	// Files are packed, then the originals are removed, so they can only be read from the mounted package:
+	const std::string temp = wi::helper::GetTempDirectoryPath() + "/";
+	const std::string rootdir = temp + "wi_package_test/";
+	const std::string mountpoint = temp + "wi_package_test_mount/";
+	const std::string package_filename = temp + "wi_package_test.wipkg";
+	wi::helper::DirectoryCreate(rootdir + "subdirectory");
+
+	struct File
+	{
+		std::string path;
+		wi::vector<uint8_t> data;
+	};
+	wi::vector<File> files(3);
+	files[0].path = "text.txt"; // compressible
+	for (int i = 0; i < 1000; ++i)
+	{
+		const std::string line = "line " + std::to_string(i % 10) + "\n";
+		files[0].data.insert(files[0].data.end(), line.begin(), line.end());
+	}
+	files[1].path = "subdirectory/random.bin"; // incompressible, stored uncompressed
+	wi::random::RNG rng(7);
+	files[1].data.resize(10000);
+	for (auto& x : files[1].data)
+	{
+		x = uint8_t(rng.next_uint(0u, 255u));
+	}
+	files[2].path = "subdirectory/small.dat"; // too small to be compressed
+	files[2].data = { 1, 2, 3 };
+
+	wi::vector<std::string> filenames;
+	for (auto& file : files)
+	{
+		filenames.push_back(rootdir + file.path);
+		wi::helper::FileWrite(filenames.back(), file.data.data(), file.data.size());
+	}
+	const bool created = wi::helper::PackageCreate(package_filename, rootdir, filenames);
+	TestCheck(created, "package must be created");
+	for (auto& filename : filenames)
+	{
+		std::remove(filename.c_str());
+	}
+	TestCheck(!wi::helper::PackageCreate(temp + "wi_package_test_outside.wipkg", rootdir, { package_filename }), "files outside of the root directory must be rejected");
+
+	const bool mounted = wi::helper::PackageMount(package_filename, mountpoint);
+	TestCheck(mounted, "package must be mounted");
+	size_t package_size = 0;
+	for (auto& file : files)
+	{
+		wi::vector<uint8_t> data;
+		const bool exists = wi::helper::FileExists(mountpoint + file.path);
+		const bool read = wi::helper::FileRead(mountpoint + file.path, data);
+		TestCheck(exists && read && data == file.data, file.path + " must be read back unchanged from the package");
+		package_size += file.data.size();
+	}
+	const uint8_t* view_data = nullptr;
+	size_t view_size = 0;
+	TestCheck(wi::helper::PackageFileView(mountpoint + files[1].path, view_data, view_size) && view_size == files[1].data.size() && std::memcmp(view_data, files[1].data.data(), view_size) == 0, "uncompressed file must be viewed in place");
+	TestCheck(!wi::helper::PackageFileView(mountpoint + files[0].path, view_data, view_size), "compressed file must not be viewed in place");
+
+	// Missing entries:
+	wi::vector<uint8_t> data;
+	TestCheck(!wi::helper::FileExists(mountpoint + "missing.txt") && !wi::helper::FileRead(mountpoint + "missing.txt", data), "missing file must not be found in the package");
+	TestCheck(!wi::helper::FileExists(mountpoint + "Text.txt"), "package paths must be case sensitive");
+	TestCheck(!wi::helper::FileExists(rootdir + files[0].path), "package contents must only be found in the mount point");
+
+	// Corrupted packages must be rejected when they are mounted:
+	wi::vector<uint8_t> package_data;
+	wi::helper::FileRead(package_filename, package_data);
+	const std::string corrupt_filename = temp + "wi_package_test_corrupt.wipkg";
+	const std::string corrupt_mountpoint = temp + "wi_package_test_corrupt_mount/";
+	auto mount_corrupted = [&](const wi::vector<uint8_t>& corrupted) {
+		wi::helper::FileWrite(corrupt_filename, corrupted.data(), corrupted.size());
+		const bool result = wi::helper::PackageMount(corrupt_filename, corrupt_mountpoint);
+		wi::helper::PackageUnmount(corrupt_filename);
+		return result;
+	};
+	wi::vector<uint8_t> corrupted = package_data;
+	corrupted[0] ^= 0xFF; // magic
+	TestCheck(!mount_corrupted(corrupted), "package with invalid header must be rejected");
+	corrupted = package_data;
+	corrupted[23] = 0x7F; // most significant byte of the entries offset
+	TestCheck(!mount_corrupted(corrupted), "package with out of bounds entries must be rejected");
+	corrupted = package_data;
+	corrupted.resize(corrupted.size() / 2);
+	TestCheck(!mount_corrupted(corrupted), "truncated package must be rejected");
+	corrupted.resize(8);
+	TestCheck(!mount_corrupted(corrupted), "package smaller than the header must be rejected");
+	std::remove(corrupt_filename.c_str());
+
+	wi::helper::PackageUnmount(package_filename);
+	TestCheck(!wi::helper::FileExists(mountpoint + files[0].path), "unmounted package contents must not be found");
+	std::remove(package_filename.c_str());
+
+	std::string ss = "Package test:\n";
+	ss += std::to_string(files.size()) + " files, " + std::to_string(package_size) + " bytes packed to " + std::to_string(package_data.size()) + " bytes";
+	return ss;
+}
@@ -10,11 +10,47 @@ public:
 	void Update(float dt) override;
 	void ResizeLayout() override;
 
+	// Shows the result text of a test in the middle of the screen
+	void ShowTestResult(const std::string& text);
+	// Reports an error if a correctness check of a test fails, returns the condition
+	static bool TestCheck(bool condition, const std::string& description);
+
+	// Runs the tests that don't need a graphics device without creating one, returns the number of failed checks
+	//	The application does this instead of opening a window when it's started with the "headless" argument
+	static int RunHeadlessTests();
+	// Tests that also work without graphics device, they return the result text:
+	static std::string HeadlessUpdateTest();
+	static std::string FixedSimulationTest();
+	static std::string DeltaSerializationTest();
+	static std::string CompressionTest();
+	static std::string AsyncSerializationTest();
+	static std::string TextureBakerTest();
+	static std::string ResourceBudgetTest();
+	static std::string PackageTest();
+
 	void RunJobSystemTest();
 	void RunFontTest();
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void RunStreamingTest();
+	void RunTranscodingTest();
+	void RunIntersectionTest();
+	void RunMeshRayTest();
+	void RunRayBatchTest();
+	void RunHeadlessUpdateTest();
+	void RunFixedSimulationTest();
+	void RunSpatialHashTest();
+	void RunFrustumCullingTest();
+	void RunHierarchicalCullingTest();
+	void RunSoftwareOcclusionTest();
+	void RunRadixSortTest();
+	void RunDeltaSerializationTest();
+	void RunCompressionTest();
+	void RunAsyncSerializationTest();
+	void RunTextureBakerTest();
+	void RunResourceBudgetTest();
+	void RunPackageTest();
 };
 
 class Tests : public wi::Application
@@ -68,6 +68,12 @@ int main(int argc, char *argv[])
 
     wi::arguments::Parse(argc, argv);
 
+    if (wi::arguments::HasArgument("headless"))
+    {
+        // The tests that don't need a graphics device are run without window, the result is the number of failed checks:
+        return TestsRenderer::RunHeadlessTests();
+    }
+
     sdl2::sdlsystem_ptr_t system = sdl2::make_sdlsystem(SDL_INIT_EVERYTHING | SDL_INIT_EVENTS);
     if (!system) {
         throw sdl2::SDLError("Error creating SDL2 system");
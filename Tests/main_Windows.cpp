@@ -33,6 +33,12 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
 	wi::arguments::Parse(lpCmdLine); // if you wish to use command line arguments, here is a good place to parse them...
 
+    if (wi::arguments::HasArgument("headless"))
+    {
+        // The tests that don't need a graphics device are run without window, the result is the number of failed checks:
+        return TestsRenderer::RunHeadlessTests();
+    }
+
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadStringW(hInstance, IDC_WICKEDENGINETESTS, szWindowClass, MAX_LOADSTRING);
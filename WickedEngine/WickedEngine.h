@@ -41,6 +41,7 @@
 #include "wiXInput.h"
 #include "wiSDLInput.h"
 #include "wiTextureHelper.h"
+#include "wiTextureBaker.h"
 #include "wiRandom.h"
 #include "wiColor.h"
 #include "wiPhysics.h"
@@ -59,6 +60,8 @@
 #include "wiArguments.h"
 #include "wiGPUBVH.h"
 #include "wiGPUSortLib.h"
+#include "wiRadixSort.h"
+#include "wiRenderQueue.h"
 #include "wiJobSystem.h"
 #include "wiNetwork.h"
 #include "wiEventHandler.h"
@@ -0,0 +1,97 @@
+#include "WickedEngine.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+
+int main(int argc, char* argv[])
+{
+	std::cout << "[Wicked Engine Offline Packager]\n";
+	std::cout << "Usage: offlinepackager [arguments] package.wipkg directories or files...\n";
+	std::cout << "Available command arguments:\n";
+	std::cout << "\tnocompress : \tStore all files uncompressed, so all of them can be accessed without copying\n";
+	std::cout << "\tpagealign : \tAlign uncompressed files to 4 KB instead of 16 bytes\n";
+	std::cout << "Directories are included recursively, except .wipkg files. The paths are stored relative to the directory of the package file, which must contain all input files\n";
+	std::cout << "Command arguments used: ";
+
+	wi::arguments::Parse(argc, argv);
+
+	wi::helper::PackageParams params;
+
+	if (wi::arguments::HasArgument("nocompress"))
+	{
+		params.compress = false;
+		std::cout << "nocompress ";
+	}
+
+	if (wi::arguments::HasArgument("pagealign"))
+	{
+		params.alignment = 4096;
+		std::cout << "pagealign ";
+	}
+
+	std::cout << "\n";
+
+	std::string packagename;
+	wi::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (packagename.empty() && wi::helper::toUpper(wi::helper::GetExtensionFromFileName(arg)) == "WIPKG")
+		{
+			packagename = arg;
+		}
+		else if (std::filesystem::is_directory(arg))
+		{
+			for (auto& entry : std::filesystem::recursive_directory_iterator(arg))
+			{
+				if (entry.is_regular_file())
+				{
+					files.push_back(entry.path().generic_u8string());
+				}
+			}
+		}
+		else if (std::filesystem::is_regular_file(arg))
+		{
+			files.push_back(arg);
+		}
+	}
+	if (packagename.empty())
+	{
+		std::cout << "No package file (.wipkg) was specified\n";
+		return 0;
+	}
+
+	// Packages are never included, the output package is truncated before the inputs are read, and it can be inside an input directory:
+	files.erase(std::remove_if(files.begin(), files.end(), [](const std::string& file) {
+		return wi::helper::toUpper(wi::helper::GetExtensionFromFileName(file)) == "WIPKG";
+	}), files.end());
+
+	if (files.empty())
+	{
+		std::cout << "No input files were specified\n";
+		return 0;
+	}
+
+	wi::Timer timer;
+
+	std::string rootdir = packagename;
+	wi::helper::MakePathAbsolute(rootdir);
+	rootdir = wi::helper::GetDirectoryFromPath(rootdir);
+
+	bool success = wi::helper::PackageCreate(packagename, rootdir, files, params);
+	if (success)
+	{
+		std::cout << "package created: " << packagename << " (" << files.size() << " files, " << wi::helper::GetMemorySizeText(std::filesystem::file_size(packagename)) << ")\n";
+	}
+	else
+	{
+		std::cerr << "package creation FAILED: " << packagename << "\n";
+	}
+
+	std::cout << "[Wicked Engine Offline Packager] Finished in " << std::setprecision(4) << timer.elapsed_seconds() << " seconds\n";
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include "WickedEngine.h"
+#include "Utility/stb_image.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+
+using namespace wi::graphics;
+
+int main(int argc, char* argv[])
+{
+	std::cout << "[Wicked Engine Offline Texture Baker]\n";
+	std::cout << "Usage: offlinetexturebaker [arguments] image files...\n";
+	std::cout << "Available command arguments:\n";
+	std::cout << "\tbc1 : \t\tCompress to BC1 format (RGB)\n";
+	std::cout << "\tbc3 : \t\tCompress to BC3 format (RGBA)\n";
+	std::cout << "\tbc4 : \t\tCompress to BC4 format (R)\n";
+	std::cout << "\tbc5 : \t\tCompress to BC5 format (RG)\n";
+	std::cout << "\tbc7 : \t\tCompress to BC7 format (RGBA)\n";
+	std::cout << "\tsrgb : \t\tImages contain sRGB color, mips are filtered in linear space\n";
+	std::cout << "\tnormalmap : \tImages are normal maps, mips will be renormalized\n";
+	std::cout << "\tkaiser : \tUse Kaiser filter instead of box filter for mip generation\n";
+	std::cout << "\tnomips : \tDon't generate mips\n";
+	std::cout << "The results are written next to the source images in DDS format\n";
+	std::cout << "Command arguments used: ";
+
+	wi::arguments::Parse(argc, argv);
+
+	wi::texturebaker::BakeParams params;
+
+	const std::pair<const char*, Format> formats[] = {
+		{ "bc1", Format::BC1_UNORM },
+		{ "bc3", Format::BC3_UNORM },
+		{ "bc4", Format::BC4_UNORM },
+		{ "bc5", Format::BC5_UNORM },
+		{ "bc7", Format::BC7_UNORM },
+	};
+	for (auto& x : formats)
+	{
+		if (wi::arguments::HasArgument(x.first))
+		{
+			params.format = x.second;
+			std::cout << x.first << " ";
+		}
+	}
+
+	if (wi::arguments::HasArgument("srgb"))
+	{
+		params.mipgen.srgb = true;
+		std::cout << "srgb ";
+	}
+
+	if (wi::arguments::HasArgument("normalmap"))
+	{
+		params.mipgen.normalmap = true;
+		std::cout << "normalmap ";
+	}
+
+	if (wi::arguments::HasArgument("kaiser"))
+	{
+		params.mipgen.filter = wi::texturebaker::MipFilter::KAISER;
+		std::cout << "kaiser ";
+	}
+
+	if (wi::arguments::HasArgument("nomips"))
+	{
+		params.generate_mips = false;
+		std::cout << "nomips ";
+	}
+
+	std::cout << "\n";
+
+	wi::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (wi::helper::FileExists(arg))
+		{
+			files.push_back(arg);
+		}
+	}
+	if (files.empty())
+	{
+		std::cout << "No image files were specified\n";
+		return 0;
+	}
+
+	wi::jobsystem::Initialize();
+
+	wi::Timer timer;
+	int errors = 0;
+
+	// Files are processed one by one, the baking of each file is parallelized by the job system:
+	for (auto& filename : files)
+	{
+		wi::vector<uint8_t> filedata;
+		if (!wi::helper::FileRead(filename, filedata))
+		{
+			std::cerr << "file read FAILED: " << filename << "\n";
+			errors++;
+			continue;
+		}
+
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		uint8_t* rgba = stbi_load_from_memory(filedata.data(), (int)filedata.size(), &width, &height, &channels, 4);
+		if (rgba == nullptr)
+		{
+			std::cerr << "image load FAILED: " << filename << "\n";
+			errors++;
+			continue;
+		}
+
+		TextureDesc desc;
+		desc.width = uint32_t(width);
+		desc.height = uint32_t(height);
+		desc.format = params.mipgen.srgb ? Format::R8G8B8A8_UNORM_SRGB : Format::R8G8B8A8_UNORM;
+		wi::vector<uint8_t> texturedata(rgba, rgba + size_t(width) * size_t(height) * 4);
+		stbi_image_free(rgba);
+
+		const std::string outputname = wi::helper::ReplaceExtension(filename, "dds");
+		wi::vector<uint8_t> outputdata;
+		if (wi::helper::saveTextureToMemoryFile(texturedata, desc, "dds", outputdata, params) && wi::helper::FileWrite(outputname, outputdata.data(), outputdata.size()))
+		{
+			std::cout << "texture baked: " << outputname << "\n";
+		}
+		else
+		{
+			std::cerr << "texture bake FAILED: " << filename << "\n";
+			errors++;
+		}
+	}
+
+	std::cout << "[Wicked Engine Offline Texture Baker] Finished in " << std::setprecision(4) << timer.elapsed_seconds() << " seconds with " << errors << " errors\n";
+
+	wi::jobsystem::ShutDown();
+
+	return errors;
+}
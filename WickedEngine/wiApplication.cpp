@@ -15,6 +15,7 @@
 #include "wiFont.h"
 #include "wiImage.h"
 #include "wiEventHandler.h"
+#include "wiResourceManager.h"
 
 #ifdef PLATFORM_PS5
 #include "wiGraphicsDevice_PS5.h"
@@ -173,6 +174,10 @@ namespace wi
 		// Wake up the events that need to be executed on the main thread, in thread safe manner:
 		wi::eventhandler::FireEvent(wi::eventhandler::EVENT_THREAD_SAFE_POINT, 0);
 
+		// Streaming textures are swapped and released resources are destroyed here, when they are not used by rendering:
+		wi::resourcemanager::UpdateStreamingResources();
+		wi::resourcemanager::UpdateRetainCache();
+
 		fadeManager.Update(deltaTime);
 
 		if (GetActivePath() != nullptr)
@@ -1,16 +1,81 @@
 #include "wiArchive.h"
 #include "wiHelper.h"
+#include "wiJobSystem.h"
+#include "wiBacklog.h"
+
+#include <atomic>
+#include <thread>
 
 namespace wi
 {
 
 	// this should always be only INCREMENTED and only if a new serialization is implemeted somewhere!
-	static constexpr uint64_t __archiveVersion = 90;
+	static constexpr uint64_t __archiveVersion = 92;
 	// this is the version number of which below the archive is not compatible with the current version
 	static constexpr uint64_t __archiveVersionBarrier = 22;
 
 	// version history is logged in ArchiveVersionHistory.txt file!
 
+	// Block compressed archive layout (all values are uint64_t):
+	//	magic | uncompressed size | block size | block count | block count * compressed block size | block data...
+	//	The uncompressed data is a regular archive, starting with the version number
+	static constexpr uint64_t __archiveCompressedMagic = 0x315A4C4843524957ull; // "WIRCHLZ1"
+	static constexpr uint64_t __archiveCompressionBlockSize = 256ull * 1024ull;
+	static constexpr uint64_t __archiveBlockStoredFlag = 1ull << 63ull; // block size flag for blocks that are stored without compression
+
+	struct Archive::DecompressionState
+	{
+		enum BLOCK_STATE
+		{
+			BLOCK_PENDING,
+			BLOCK_WORKING,
+			BLOCK_FINISHED,
+		};
+		struct Block
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+			bool stored = false;
+		};
+		wi::vector<uint8_t> filedata; // owns the compressed data
+		const uint8_t* src = nullptr;
+		wi::vector<uint8_t> data; // uncompressed data
+		uint64_t block_size = 0;
+		wi::vector<Block> blocks;
+		std::unique_ptr<std::atomic<uint32_t>[]> block_states;
+		wi::jobsystem::context ctx;
+
+		// Decompress the block if nobody started it yet
+		void TryDecompress(size_t index)
+		{
+			uint32_t expected = BLOCK_PENDING;
+			if (!block_states[index].compare_exchange_strong(expected, BLOCK_WORKING))
+				return;
+			const Block& block = blocks[index];
+			const uint64_t dst_offset = index * block_size;
+			const uint64_t dst_size = std::min(block_size, data.size() - dst_offset);
+			if (block.stored)
+			{
+				std::memcpy(data.data() + dst_offset, src + block.offset, dst_size);
+			}
+			else if (!wi::helper::Decompress(src + block.offset, block.size, data.data() + dst_offset, dst_size))
+			{
+				wi::backlog::post("wi::Archive block decompression failed, the archive is corrupted! (block " + std::to_string(index) + ")", wi::backlog::LogLevel::Error);
+				std::memset(data.data() + dst_offset, 0, dst_size);
+			}
+			block_states[index].store(BLOCK_FINISHED);
+		}
+		// Decompress the block on this thread or wait for it if it is being decompressed by a job
+		void Finish(size_t index)
+		{
+			TryDecompress(index);
+			while (block_states[index].load() != BLOCK_FINISHED)
+			{
+				std::this_thread::yield();
+			}
+		}
+	};
+
 	Archive::Archive()
 	{
 		CreateEmpty();
@@ -26,6 +91,7 @@ namespace wi
 				if (wi::helper::FileRead(fileName, DATA))
 				{
 					data_ptr = DATA.data();
+					OpenCompressed(DATA.data(), DATA.size(), std::move(DATA));
 					(*this) >> version;
 					if (version < __archiveVersionBarrier)
 					{
@@ -46,12 +112,164 @@ namespace wi
 		}
 	}
 
-	Archive::Archive(const uint8_t* data)
+	Archive::Archive(const uint8_t* data, size_t size)
 	{
 		data_ptr = data;
+		OpenCompressed(data, size, {});
 		SetReadModeAndResetPos(true);
 	}
 
+	bool Archive::OpenCompressed(const uint8_t* data, size_t size, wi::vector<uint8_t>&& filedata)
+	{
+		const uint64_t* header = (const uint64_t*)data;
+		if (size < sizeof(uint64_t) * 4 || header[0] != __archiveCompressedMagic)
+			return false;
+
+		const uint64_t uncompressed_size = header[1];
+		const uint64_t block_size = header[2];
+		const uint64_t block_count = header[3];
+		const uint64_t header_size = sizeof(uint64_t) * (4 + block_count);
+		if (block_size == 0 || block_count > size / sizeof(uint64_t) || block_count != (uncompressed_size + block_size - 1) / block_size || header_size > size)
+		{
+			wi::backlog::post("wi::Archive compressed header is invalid!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		std::shared_ptr<DecompressionState> state = std::make_shared<DecompressionState>();
+		state->block_size = block_size;
+		state->blocks.resize(block_count);
+		uint64_t offset = header_size;
+		for (uint64_t i = 0; i < block_count; ++i)
+		{
+			DecompressionState::Block& block = state->blocks[i];
+			block.stored = (header[4 + i] & __archiveBlockStoredFlag) != 0;
+			block.size = header[4 + i] & ~__archiveBlockStoredFlag;
+			block.offset = offset;
+			offset += block.size;
+		}
+		if (offset > size)
+		{
+			wi::backlog::post("wi::Archive compressed data is truncated!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+		if (filedata.empty())
+		{
+			// The background jobs can outlive the caller's data, so they work from a copy:
+			state->filedata.assign(data, data + offset);
+		}
+		else
+		{
+			state->filedata = std::move(filedata);
+		}
+		state->src = state->filedata.data();
+		state->data.resize(uncompressed_size);
+		state->block_states = std::make_unique<std::atomic<uint32_t>[]>(block_count);
+
+		decompression = state;
+		compressed = true;
+		data_ptr = state->data.data();
+		data_available = 0;
+		DATA.clear();
+
+		if (wi::jobsystem::GetThreadCount() > 0)
+		{
+			// The blocks are decompressed in order by the job system, while the reader
+			//	can already consume the finished blocks. If the reader requires a block that
+			//	wasn't picked up by a job yet, it will decompress it on its own thread
+			wi::jobsystem::Dispatch(state->ctx, (uint32_t)block_count, 1, [state](wi::jobsystem::JobArgs args) {
+				state->TryDecompress(args.jobIndex);
+			});
+		}
+		return true;
+	}
+
+	void Archive::WaitDecompression(size_t offset)
+	{
+		if (decompression == nullptr)
+			return;
+		DecompressionState& state = *decompression;
+		const size_t block_count = state.blocks.size();
+		if (block_count == 0)
+			return;
+		assert(offset <= state.data.size());
+
+		const size_t first = std::min(pos / state.block_size, block_count - 1);
+		const size_t last = std::min((offset - 1) / state.block_size, block_count - 1);
+		for (size_t i = first; i <= last; ++i)
+		{
+			state.Finish(i);
+		}
+
+		// Advance the contiguous readable region, so subsequent reads don't need to check block states:
+		size_t block = data_available / state.block_size;
+		while (block < block_count && state.block_states[block].load() == DecompressionState::BLOCK_FINISHED)
+		{
+			block++;
+		}
+		data_available = std::min(block * state.block_size, state.data.size());
+	}
+
+	void Archive::CreateCompressedData(wi::vector<uint8_t>& dest) const
+	{
+		const uint64_t uncompressed_size = pos;
+		const uint64_t block_size = __archiveCompressionBlockSize;
+		const uint64_t block_count = (uncompressed_size + block_size - 1) / block_size;
+
+		wi::vector<wi::vector<uint8_t>> blocks(block_count);
+		wi::vector<uint64_t> header(4 + block_count);
+		header[0] = __archiveCompressedMagic;
+		header[1] = uncompressed_size;
+		header[2] = block_size;
+		header[3] = block_count;
+
+		auto compress_block = [&](size_t index) {
+			const uint64_t offset = index * block_size;
+			const uint64_t size = std::min(block_size, uncompressed_size - offset);
+			if (wi::helper::Compress(data_ptr + offset, size, blocks[index]))
+			{
+				header[4 + index] = blocks[index].size();
+			}
+			else
+			{
+				// Data is not compressible, store it as is:
+				blocks[index].resize(size);
+				std::memcpy(blocks[index].data(), data_ptr + offset, size);
+				header[4 + index] = size | __archiveBlockStoredFlag;
+			}
+		};
+
+		if (wi::jobsystem::GetThreadCount() > 0)
+		{
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)block_count, 1, [&](wi::jobsystem::JobArgs args) {
+				compress_block(args.jobIndex);
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+		else
+		{
+			for (size_t i = 0; i < block_count; ++i)
+			{
+				compress_block(i);
+			}
+		}
+
+		size_t total_size = header.size() * sizeof(uint64_t);
+		for (auto& x : blocks)
+		{
+			total_size += x.size();
+		}
+		dest.resize(total_size);
+		uint8_t* dst = dest.data();
+		std::memcpy(dst, header.data(), header.size() * sizeof(uint64_t));
+		dst += header.size() * sizeof(uint64_t);
+		for (auto& x : blocks)
+		{
+			std::memcpy(dst, x.data(), x.size());
+			dst += x.size();
+		}
+	}
+
 	void Archive::CreateEmpty()
 	{
 		version = __archiveVersion;
@@ -62,6 +280,17 @@ namespace wi
 
 	void Archive::SetReadModeAndResetPos(bool isReadMode)
 	{
+		if (!isReadMode && decompression != nullptr)
+		{
+			// Switching a compressed archive to write mode, the whole data must be available:
+			pos = 0;
+			WaitDecompression(decompression->data.size());
+			DATA = decompression->data;
+			data_ptr = DATA.data();
+			decompression.reset();
+			data_available = ~0ull;
+		}
+
 		readMode = isReadMode;
 		pos = 0;
 
@@ -82,15 +311,29 @@ namespace wi
 			SaveFile(fileName);
 		}
 		DATA.clear();
+		decompression.reset();
+		data_available = ~0ull;
 	}
 
 	bool Archive::SaveFile(const std::string& fileName)
 	{
+		if (compressed)
+		{
+			wi::vector<uint8_t> compressed_data;
+			CreateCompressedData(compressed_data);
+			return wi::helper::FileWrite(fileName, compressed_data.data(), compressed_data.size());
+		}
 		return wi::helper::FileWrite(fileName, data_ptr, pos);
 	}
 
 	bool Archive::SaveHeaderFile(const std::string& fileName, const std::string& dataName)
 	{
+		if (compressed)
+		{
+			wi::vector<uint8_t> compressed_data;
+			CreateCompressedData(compressed_data);
+			return wi::helper::Bin2H(compressed_data.data(), compressed_data.size(), fileName, dataName.c_str());
+		}
 		return wi::helper::Bin2H(data_ptr, pos, fileName, dataName.c_str());
 	}
 
@@ -5,6 +5,7 @@
 #include "wiColor.h"
 
 #include <string>
+#include <memory>
 
 namespace wi
 {
@@ -24,7 +25,19 @@ namespace wi
 		std::string fileName; // save to this file on closing if not empty
 		std::string directory; // the directory part from the fileName
 
+		bool compressed = false; // if true, the archive is saved in block compressed format (it is also set when a compressed archive was opened)
+		size_t data_available = ~0ull; // the data is readable until this offset without waiting for block decompression
+		struct DecompressionState;
+		std::shared_ptr<DecompressionState> decompression; // only valid when reading a compressed archive
+
 		void CreateEmpty(); // creates new archive in write mode
+		// If the data is a block compressed archive, starts decompressing it and returns true
+		//	If filedata is empty, the compressed data is copied, so the decompression doesn't depend on the lifetime of the source
+		bool OpenCompressed(const uint8_t* data, size_t size, wi::vector<uint8_t>&& filedata);
+		// Blocks until data is decompressed until the specified offset
+		void WaitDecompression(size_t offset);
+		// Creates the block compressed representation of the archive
+		void CreateCompressedData(wi::vector<uint8_t>& dest) const;
 
 	public:
 		// Create empty arhive for writing
@@ -36,7 +49,13 @@ namespace wi
 		//	If readMode == false, the file will be written when the archive is destroyed or Close() is called
 		Archive(const std::string& fileName, bool readMode = true);
 		// Creates a memory mapped archive in read mode
-		Archive(const uint8_t* data);
+		//	It can also be a block compressed archive, in which case it will be decompressed into memory
+		//	size : the size of the data in bytes
+		Archive(const uint8_t* data, size_t size);
+		// Creates a memory mapped archive in read mode, without knowing the size of the data
+		//	Truncated compressed data can't be detected this way, use the overload that takes the size instead
+		[[deprecated("Use Archive(const uint8_t* data, size_t size) instead")]]
+		Archive(const uint8_t* data) : Archive(data, ~0ull) {}
 		~Archive() { Close(); }
 
 		Archive& operator=(const Archive&) = default;
@@ -61,6 +80,11 @@ namespace wi
 		// Write the archive contents into a C++ header file
 		//	dataName : it will be the name of the byte data array in the header, that can be memory mapped
 		bool SaveHeaderFile(const std::string& fileName, const std::string& dataName);
+		// Enable block compression for the archive when it is saved with SaveFile(), SaveHeaderFile() or Close()
+		//	The blocks will be decompressed in parallel when the archive is opened for reading
+		void SetCompressionEnabled(bool value) { compressed = value; }
+		// Returns true if compression is enabled, or the archive was opened from compressed data
+		constexpr bool IsCompressionEnabled() const { return compressed; }
 		// If the archive was opened from a file, this will return the file's directory
 		const std::string& GetSourceDirectory() const;
 		// If the archive was opened from a file, this will return the file's name
@@ -92,6 +116,38 @@ namespace wi
 			pos = jump_pos;
 		}
 
+		// Writes raw bytes to the archive without any size or type information
+		//	This is only meant for trivially copyable data with fixed layout, that will be read back with ReadRaw()
+		void WriteRaw(const void* data, size_t size)
+		{
+			assert(!readMode);
+			assert(!DATA.empty());
+			if (size == 0)
+				return;
+			const size_t _right = pos + size;
+			if (_right > DATA.size())
+			{
+				DATA.resize(_right * 2);
+				data_ptr = DATA.data();
+			}
+			std::memcpy(DATA.data() + pos, data, size);
+			pos = _right;
+		}
+		// Reads raw bytes that were written by WriteRaw()
+		void ReadRaw(void* data, size_t size)
+		{
+			assert(readMode);
+			assert(data_ptr != nullptr);
+			if (size == 0)
+				return;
+			if (pos + size > data_available)
+			{
+				WaitDecompression(pos + size);
+			}
+			std::memcpy(data, data_ptr + pos, size);
+			pos += size;
+		}
+
 		// It could be templated but we have to be extremely careful of different datasizes on different platforms
 		// because serialized data should be interchangeable!
 		// So providing exact copy operations for exact types enforces platform agnosticism
@@ -407,6 +463,10 @@ namespace wi
 		{
 			assert(readMode);
 			assert(data_ptr != nullptr);
+			if (pos + sizeof(data) > data_available)
+			{
+				WaitDecompression(pos + sizeof(data));
+			}
 			data = *(const T*)(data_ptr + pos);
 			pos += (size_t)(sizeof(data));
 		}
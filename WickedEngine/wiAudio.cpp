@@ -1120,10 +1120,10 @@ namespace wi::audio
 		if (sound != nullptr && sound->IsValid())
 		{
 			auto soundinternal = to_internal(sound);
+			info.channel_count = soundinternal->wfx.nChannels;
 			info.samples = (const short*)soundinternal->audioData.data();
-			info.sample_count = soundinternal->audioData.size() / sizeof(short);
+			info.sample_count = soundinternal->audioData.size() / (info.channel_count * sizeof(short));
 			info.sample_rate = soundinternal->wfx.nSamplesPerSec;
-			info.channel_count = soundinternal->wfx.nChannels;
 		}
 		return info;
 	}
@@ -1,11 +1,16 @@
 #pragma once
 #include "CommonInclude.h"
 #include "wiPrimitive.h"
+#include "wiJobSystem.h"
+#include "wiArchive.h"
+
+#include <atomic>
 
 namespace wi
 {
 	// Simple fast update BVH
 	//	https://jacco.ompf2.com/2022/04/13/how-to-build-a-bvh-part-1-basics/
+	//	https://jacco.ompf2.com/2022/04/21/how-to-build-a-bvh-part-3-quick-builds/
 	struct BVH
 	{
 		struct Node
@@ -22,16 +27,56 @@ namespace wi
 		uint32_t* leaf_indices = nullptr;
 		uint32_t leaf_count = 0;
 
+		// Optional 4-wide layout collapsed from the binary tree by BuildWide()
+		//	Child bounds are stored in SoA layout, so all four children are tested with one SIMD instruction per component
+		struct WideNode
+		{
+			XMFLOAT4A min_x;
+			XMFLOAT4A min_y;
+			XMFLOAT4A min_z;
+			XMFLOAT4A max_x;
+			XMFLOAT4A max_y;
+			XMFLOAT4A max_z;
+			uint32_t child[4];	// leaf: offset into leaf_indices, otherwise: index of wide node, ~0u: empty slot
+			uint32_t count[4];	// leaf: number of leaf indices, otherwise: 0
+			uint32_t source[4];	// index of binary node that the child was collapsed from, used by Refit()
+		};
+		wi::vector<WideNode> wide_nodes;
+
+		// The nodes are serialized as raw memory, so they must not contain padding:
+		static_assert(sizeof(Node) == sizeof(wi::primitive::AABB) + sizeof(uint32_t) * 3);
+		static_assert(sizeof(WideNode) == sizeof(XMFLOAT4A) * 6 + sizeof(uint32_t) * 12);
+
+		// Surface area heuristic cost of the tree, relative to the root node's surface area:
+		float cost = 0;			// current cost, updated by Build() and Refit()
+		float build_cost = 0;	// cost right after the last Build()
+
+		static constexpr uint32_t BIN_COUNT = 8;					// split candidates per axis for the binned SAH
+		static constexpr uint32_t MAX_LEAF_SIZE = 8;				// nodes above this size will be always split if possible
+		static constexpr uint32_t PARALLEL_BUILD_THRESHOLD = 4096;	// subtrees above this size will be built by separate jobs
+
 		constexpr bool IsValid() const { return nodes != nullptr; }
 
+		// Returns true if the tree quality degraded so much by Refit() that a Build() is likely faster overall
+		//	ratio: the allowed cost increase compared to the last Build()
+		constexpr bool IsRebuildRecommended(float ratio = 1.5f) const { return cost > build_cost * ratio; }
+
 		void Build(const wi::primitive::AABB* aabbs, uint32_t aabb_count)
 		{
 			node_count = 0;
+			wide_nodes.clear();
 			if (aabb_count == 0)
+			{
+				nodes = nullptr;
+				leaf_indices = nullptr;
+				leaf_count = 0;
+				cost = 0;
+				build_cost = 0;
 				return;
+			}
 
 			const uint32_t node_capacity = aabb_count * 2 - 1;
-			allocation.reserve(
+			allocation.resize(
 				sizeof(Node) * node_capacity +
 				sizeof(uint32_t) * aabb_count
 			);
@@ -39,7 +84,7 @@ namespace wi
 			leaf_indices = (uint32_t*)(nodes + node_capacity);
 			leaf_count = aabb_count;
 
-			Node& node = nodes[node_count++];
+			Node& node = nodes[0];
 			node = {};
 			node.count = aabb_count;
 			for (uint32_t i = 0; i < aabb_count; ++i)
@@ -47,31 +92,136 @@ namespace wi
 				node.aabb = wi::primitive::AABB::Merge(node.aabb, aabbs[i]);
 				leaf_indices[i] = i;
 			}
-			Subdivide(0, aabbs);
+
+			// Large inputs are subdivided in parallel, the job system is only used if it has worker threads:
+			std::atomic<uint32_t> node_allocator{ 1u };
+			if (aabb_count > PARALLEL_BUILD_THRESHOLD && wi::jobsystem::GetThreadCount() > 1)
+			{
+				wi::jobsystem::context ctx;
+				Subdivide(0, aabbs, node_allocator, &ctx);
+				wi::jobsystem::Wait(ctx);
+			}
+			else
+			{
+				Subdivide(0, aabbs, node_allocator, nullptr);
+			}
+			node_count = node_allocator.load();
+
+			cost = ComputeCost();
+			build_cost = cost;
 		}
 
-		void Subdivide(uint32_t nodeIndex, const wi::primitive::AABB* leaf_aabb_data)
+		void Subdivide(uint32_t nodeIndex, const wi::primitive::AABB* leaf_aabb_data, std::atomic<uint32_t>& node_allocator, wi::jobsystem::context* ctx)
 		{
 			Node& node = nodes[nodeIndex];
 			if (node.count <= 2)
 				return;
 
-			XMFLOAT3 extent = node.aabb.getHalfWidth();
-			XMFLOAT3 min = node.aabb.getMin();
-			int axis = 0;
-			if (extent.y > extent.x) axis = 1;
-			if (extent.z > ((float*)&extent)[axis]) axis = 2;
-			float splitPos = ((float*)&min)[axis] + ((float*)&extent)[axis] * 0.5f;
+			// Bounds of the leaf centers, the bins are distributed within this:
+			XMVECTOR center_min = XMVectorReplicate(std::numeric_limits<float>::max());
+			XMVECTOR center_max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[node.offset + i]];
+				const XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&aabb._min), XMLoadFloat3(&aabb._max)), 0.5f);
+				center_min = XMVectorMin(center_min, center);
+				center_max = XMVectorMax(center_max, center);
+			}
+			XMFLOAT3 bounds_min;
+			XMFLOAT3 bounds_max;
+			XMStoreFloat3(&bounds_min, center_min);
+			XMStoreFloat3(&bounds_max, center_max);
+			const XMVECTOR bin_scale = XMVectorDivide(XMVectorReplicate(float(BIN_COUNT)), XMVectorSubtract(center_max, center_min));
+			XMFLOAT3 scale;
+			XMStoreFloat3(&scale, bin_scale);
+
+			// Binned SAH, all axes are binned in one pass:
+			struct Bin
+			{
+				XMVECTOR _min = XMVectorReplicate(std::numeric_limits<float>::max());
+				XMVECTOR _max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+				uint32_t count = 0;
+			} bins[3][BIN_COUNT];
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[node.offset + i]];
+				const XMVECTOR aabb_min = XMLoadFloat3(&aabb._min);
+				const XMVECTOR aabb_max = XMLoadFloat3(&aabb._max);
+				XMFLOAT3 center;
+				XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(aabb_min, aabb_max), 0.5f));
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					Bin& bin = bins[axis][GetBinIndex(((const float*)&center)[axis], ((const float*)&bounds_min)[axis], ((const float*)&scale)[axis])];
+					bin._min = XMVectorMin(bin._min, aabb_min);
+					bin._max = XMVectorMax(bin._max, aabb_max);
+					bin.count++;
+				}
+			}
+
+			// Find the cheapest split plane between bins, sweeping from both sides to get the area and count of both halves:
+			float best_cost = std::numeric_limits<float>::max();
+			int best_axis = -1;
+			uint32_t best_bin = 0;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (((const float*)&bounds_min)[axis] >= ((const float*)&bounds_max)[axis])
+					continue;
+
+				float left_area[BIN_COUNT - 1];
+				float right_area[BIN_COUNT - 1];
+				uint32_t left_count[BIN_COUNT - 1];
+				uint32_t right_count[BIN_COUNT - 1];
+				Bin left_box;
+				Bin right_box;
+				for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+				{
+					const Bin& left_bin = bins[axis][i];
+					left_box.count += left_bin.count;
+					left_box._min = XMVectorMin(left_box._min, left_bin._min);
+					left_box._max = XMVectorMax(left_box._max, left_bin._max);
+					left_count[i] = left_box.count;
+					left_area[i] = GetSurfaceArea(left_box._min, left_box._max);
+
+					const Bin& right_bin = bins[axis][BIN_COUNT - 1 - i];
+					right_box.count += right_bin.count;
+					right_box._min = XMVectorMin(right_box._min, right_bin._min);
+					right_box._max = XMVectorMax(right_box._max, right_bin._max);
+					right_count[BIN_COUNT - 2 - i] = right_box.count;
+					right_area[BIN_COUNT - 2 - i] = GetSurfaceArea(right_box._min, right_box._max);
+				}
+				for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+				{
+					if (left_count[i] == 0 || right_count[i] == 0)
+						continue;
+					const float split_cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+					if (split_cost < best_cost)
+					{
+						best_cost = split_cost;
+						best_axis = axis;
+						best_bin = i;
+					}
+				}
+			}
+
+			// All leaf centers are in the same position, they can't be separated:
+			if (best_axis < 0)
+				return;
+
+			// Splitting is not worth it if it costs more than intersecting all leaves of the node:
+			if (node.count <= MAX_LEAF_SIZE && best_cost >= node.count * GetSurfaceArea(node.aabb))
+				return;
 
 			// in-place partition
+			const float split_min = ((const float*)&bounds_min)[best_axis];
+			const float split_scale = ((const float*)&scale)[best_axis];
 			int i = node.offset;
 			int j = i + node.count - 1;
 			while (i <= j)
 			{
-				XMFLOAT3 center = leaf_aabb_data[leaf_indices[i]].getCenter();
-				float value = ((float*)&center)[axis];
+				const wi::primitive::AABB& aabb = leaf_aabb_data[leaf_indices[i]];
+				const float value = (((const float*)&aabb._min)[best_axis] + ((const float*)&aabb._max)[best_axis]) * 0.5f;
 
-				if (value < splitPos)
+				if (GetBinIndex(value, split_min, split_scale) <= best_bin)
 				{
 					i++;
 				}
@@ -87,8 +237,8 @@ namespace wi
 				return;
 
 			// create child nodes
-			uint32_t left_child_index = node_count++;
-			uint32_t right_child_index = node_count++;
+			uint32_t left_child_index = node_allocator.fetch_add(2u);
+			uint32_t right_child_index = left_child_index + 1;
 			node.left = left_child_index;
 			nodes[left_child_index] = {};
 			nodes[left_child_index].offset = node.offset;
@@ -100,9 +250,18 @@ namespace wi
 			UpdateNodeBounds(left_child_index, leaf_aabb_data);
 			UpdateNodeBounds(right_child_index, leaf_aabb_data);
 
-			// recurse
-			Subdivide(left_child_index, leaf_aabb_data);
-			Subdivide(right_child_index, leaf_aabb_data);
+			// recurse, large subtrees are given to other threads:
+			if (ctx != nullptr && nodes[left_child_index].count > PARALLEL_BUILD_THRESHOLD)
+			{
+				wi::jobsystem::Execute(*ctx, [=, &node_allocator](wi::jobsystem::JobArgs args) {
+					Subdivide(left_child_index, leaf_aabb_data, node_allocator, ctx);
+				});
+			}
+			else
+			{
+				Subdivide(left_child_index, leaf_aabb_data, node_allocator, ctx);
+			}
+			Subdivide(right_child_index, leaf_aabb_data, node_allocator, ctx);
 		}
 
 		void UpdateNodeBounds(uint32_t nodeIndex, const wi::primitive::AABB* leaf_aabb_data)
@@ -117,6 +276,258 @@ namespace wi
 			}
 		}
 
+		// Updates the bounds of all nodes without changing the tree structure
+		//	The aabbs must be the same count and order as they were for Build()
+		//	This is much faster than Build(), but the tree quality degrades if the aabbs move far from their original positions
+		//	The cost is updated, so IsRebuildRecommended() can be checked after this
+		void Refit(const wi::primitive::AABB* aabbs)
+		{
+			if (node_count == 0)
+				return;
+
+			// Child nodes are always allocated after their parent, so reverse order is bottom-up:
+			float cost_sum = 0;
+			for (uint32_t i = node_count; i > 0; --i)
+			{
+				const uint32_t nodeIndex = i - 1;
+				Node& node = nodes[nodeIndex];
+				if (node.isLeaf())
+				{
+					UpdateNodeBounds(nodeIndex, aabbs);
+					cost_sum += node.count * GetSurfaceArea(node.aabb);
+				}
+				else
+				{
+					node.aabb = wi::primitive::AABB::Merge(nodes[node.left].aabb, nodes[node.left + 1].aabb);
+					cost_sum += GetSurfaceArea(node.aabb);
+				}
+			}
+			const float root_area = GetSurfaceArea(nodes[0].aabb);
+			cost = root_area > 0 ? cost_sum / root_area : 0;
+
+			for (WideNode& wide_node : wide_nodes)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					if (wide_node.child[i] != ~0u)
+					{
+						SetWideChildBounds(wide_node, i, nodes[wide_node.source[i]].aabb);
+					}
+				}
+			}
+		}
+
+		// Collapses the binary tree into the 4-wide layout, this must be called after Build()
+		//	The wide layout is kept up to date by Refit(), and it is used by IntersectsWide()
+		void BuildWide()
+		{
+			wide_nodes.clear();
+			if (node_count == 0)
+				return;
+			wide_nodes.reserve(node_count / 2 + 1);
+			CollapseWide(0);
+		}
+
+		// Writes or reads the built tree as raw memory, so loading doesn't need to Build() again
+		//	The tree is validated on reading, if the node layouts don't match or the indices are out of range, then the tree will be empty after reading,
+		//	and the owner should Build() it again
+		void Serialize(wi::Archive& archive)
+		{
+			if (archive.IsReadMode())
+			{
+				uint32_t node_size = 0;
+				uint32_t wide_node_size = 0;
+				uint32_t in_node_count = 0;
+				uint32_t in_leaf_count = 0;
+				uint32_t wide_node_count = 0;
+				float in_cost = 0;
+				float in_build_cost = 0;
+				archive >> node_size;
+				archive >> wide_node_size;
+				archive >> in_node_count;
+				archive >> in_leaf_count;
+				archive >> wide_node_count;
+				archive >> in_cost;
+				archive >> in_build_cost;
+
+				const size_t data_size = sizeof(Node) * in_node_count + sizeof(uint32_t) * in_leaf_count + sizeof(WideNode) * wide_node_count;
+				*this = {};
+				if (node_size != sizeof(Node) || wide_node_size != sizeof(WideNode) || in_node_count == 0 || in_leaf_count == 0)
+				{
+					archive.Jump(archive.GetPos() + data_size);
+					return;
+				}
+
+				allocation.resize(sizeof(Node) * in_node_count + sizeof(uint32_t) * in_leaf_count);
+				nodes = (Node*)allocation.data();
+				node_count = in_node_count;
+				leaf_indices = (uint32_t*)(nodes + node_count);
+				leaf_count = in_leaf_count;
+				archive.ReadRaw(nodes, sizeof(Node) * node_count);
+				archive.ReadRaw(leaf_indices, sizeof(uint32_t) * leaf_count);
+				wide_nodes.resize(wide_node_count);
+				archive.ReadRaw(wide_nodes.data(), sizeof(WideNode) * wide_node_count);
+
+				if (!IsStructureValid())
+				{
+					*this = {};
+					return;
+				}
+				cost = in_cost;
+				build_cost = in_build_cost; // the refit heuristic compares against this, so it must survive the reset above
+			}
+			else
+			{
+				archive << uint32_t(sizeof(Node));
+				archive << uint32_t(sizeof(WideNode));
+				archive << node_count;
+				archive << leaf_count;
+				archive << uint32_t(wide_nodes.size());
+				archive << cost;
+				archive << build_cost;
+				archive.WriteRaw(nodes, sizeof(Node) * node_count);
+				archive.WriteRaw(leaf_indices, sizeof(uint32_t) * leaf_count);
+				archive.WriteRaw(wide_nodes.data(), sizeof(WideNode) * wide_nodes.size());
+			}
+		}
+
+		// Returns true if all node and leaf indices are in range, so the tree can be traversed and refitted safely
+		//	Children must be allocated after their parents, as Build() and BuildWide() do, so the traversal can't loop
+		bool IsStructureValid() const
+		{
+			for (uint32_t i = 0; i < node_count; ++i)
+			{
+				const Node& node = nodes[i];
+				if (node.isLeaf())
+				{
+					if (uint64_t(node.offset) + node.count > leaf_count)
+						return false;
+				}
+				else if (node.left <= i || uint64_t(node.left) + 1 >= node_count)
+				{
+					return false;
+				}
+			}
+			for (uint32_t i = 0; i < leaf_count; ++i)
+			{
+				if (leaf_indices[i] >= leaf_count)
+					return false;
+			}
+			for (size_t i = 0; i < wide_nodes.size(); ++i)
+			{
+				const WideNode& wide_node = wide_nodes[i];
+				for (int j = 0; j < 4; ++j)
+				{
+					if (wide_node.child[j] == ~0u)
+						continue;
+					if (wide_node.source[j] >= node_count)
+						return false;
+					if (wide_node.count[j] > 0)
+					{
+						if (uint64_t(wide_node.child[j]) + wide_node.count[j] > leaf_count)
+							return false;
+					}
+					else if (wide_node.child[j] <= i || wide_node.child[j] >= wide_nodes.size())
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		uint32_t CollapseWide(uint32_t nodeIndex)
+		{
+			// Binary nodes are opened until there are four children, always the one with the largest surface area:
+			uint32_t children[4] = { nodeIndex };
+			uint32_t child_count = 1;
+			while (child_count < 4)
+			{
+				int open = -1;
+				float open_area = -1;
+				for (uint32_t i = 0; i < child_count; ++i)
+				{
+					const Node& node = nodes[children[i]];
+					if (node.isLeaf())
+						continue;
+					const float area = GetSurfaceArea(node.aabb);
+					if (area > open_area)
+					{
+						open_area = area;
+						open = int(i);
+					}
+				}
+				if (open < 0)
+					break;
+				const uint32_t left = nodes[children[open]].left;
+				children[open] = left;
+				children[child_count++] = left + 1;
+			}
+
+			const uint32_t wideIndex = (uint32_t)wide_nodes.size();
+			wide_nodes.emplace_back();
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				if (i >= child_count)
+				{
+					WideNode& wide_node = wide_nodes[wideIndex];
+					SetWideChildBounds(wide_node, i, wi::primitive::AABB());
+					wide_node.child[i] = ~0u;
+					wide_node.count[i] = 0;
+					wide_node.source[i] = ~0u;
+					continue;
+				}
+				const Node& node = nodes[children[i]];
+				const uint32_t child = node.isLeaf() ? node.offset : CollapseWide(children[i]);
+				WideNode& wide_node = wide_nodes[wideIndex]; // after recursion, because wide_nodes can be reallocated
+				SetWideChildBounds(wide_node, i, node.aabb);
+				wide_node.child[i] = child;
+				wide_node.count[i] = node.count;
+				wide_node.source[i] = children[i];
+			}
+			return wideIndex;
+		}
+
+		static void SetWideChildBounds(WideNode& wide_node, int i, const wi::primitive::AABB& aabb)
+		{
+			(&wide_node.min_x.x)[i] = aabb._min.x;
+			(&wide_node.min_y.x)[i] = aabb._min.y;
+			(&wide_node.min_z.x)[i] = aabb._min.z;
+			(&wide_node.max_x.x)[i] = aabb._max.x;
+			(&wide_node.max_y.x)[i] = aabb._max.y;
+			(&wide_node.max_z.x)[i] = aabb._max.z;
+		}
+
+		// Computes the surface area heuristic cost of the whole tree
+		float ComputeCost() const
+		{
+			if (node_count == 0)
+				return 0;
+			float cost_sum = 0;
+			for (uint32_t i = 0; i < node_count; ++i)
+			{
+				const Node& node = nodes[i];
+				cost_sum += (node.isLeaf() ? node.count : 1) * GetSurfaceArea(node.aabb);
+			}
+			const float root_area = GetSurfaceArea(nodes[0].aabb);
+			return root_area > 0 ? cost_sum / root_area : 0;
+		}
+
+		static constexpr uint32_t GetBinIndex(float value, float bounds_min, float scale)
+		{
+			return std::min(BIN_COUNT - 1, uint32_t(std::max(0.0f, (value - bounds_min) * scale)));
+		}
+		static float GetSurfaceArea(const XMVECTOR& _min, const XMVECTOR& _max)
+		{
+			// Half surface area, the constant factor doesn't matter for the heuristic:
+			const XMVECTOR extent = XMVectorMax(XMVectorSubtract(_max, _min), XMVectorZero());
+			return XMVectorGetX(XMVector3Dot(extent, XMVectorSwizzle<1, 2, 0, 3>(extent)));
+		}
+		static float GetSurfaceArea(const wi::primitive::AABB& aabb)
+		{
+			return GetSurfaceArea(XMLoadFloat3(&aabb._min), XMLoadFloat3(&aabb._max));
+		}
+
 		template <typename T>
 		void Intersects(
 			const T& primitive,
@@ -140,5 +551,297 @@ namespace wi
 				Intersects(primitive, node.left + 1, callback);
 			}
 		}
+
+		// Same as Intersects(), but traverses the 4-wide layout if BuildWide() was used, otherwise the binary tree
+		//	Supported primitives: Ray, Sphere, AABB, Frustum
+		template <typename T>
+		void IntersectsWide(
+			const T& primitive,
+			const std::function<void(uint32_t index)>& callback
+		) const
+		{
+			if (wide_nodes.empty())
+			{
+				if (IsValid())
+				{
+					Intersects(primitive, 0, callback);
+				}
+				return;
+			}
+			IntersectsWide(PrepareWide(primitive), 0, callback);
+		}
+
+		// Hierarchical frustum culling, subtrees outside the frustum are skipped
+		//	callback(offset, count, inside) receives ranges of leaf_indices:
+		//		inside == true: the whole subtree is inside the frustum, it is reported at once without descending into it
+		//		inside == false: a leaf node that intersects the frustum, its leaves still need to be tested one by one
+		void CullFrustum(
+			const wi::primitive::Frustum& frustum,
+			const std::function<void(uint32_t offset, uint32_t count, bool inside)>& callback
+		) const
+		{
+			if (!IsValid())
+				return;
+			if (wide_nodes.empty())
+			{
+				CullFrustum(frustum, 0, callback);
+				return;
+			}
+			CullFrustum(PrepareWide(frustum), 0, callback);
+		}
+		// Returns the range of leaf_indices that is covered by a subtree of the binary tree:
+		//	(the left child starts where its parent does and the right child ends where its parent does)
+		void GetSubtreeRange(uint32_t nodeIndex, uint32_t& offset, uint32_t& count) const
+		{
+			offset = nodes[nodeIndex].offset;
+			while (!nodes[nodeIndex].isLeaf())
+			{
+				nodeIndex = nodes[nodeIndex].left + 1;
+			}
+			count = nodes[nodeIndex].offset + nodes[nodeIndex].count - offset;
+		}
+
+		// Primitives are converted to SIMD friendly form once per query:
+		struct WideRay
+		{
+			XMVECTOR origin[3];
+			XMVECTOR direction_inverse[3];
+			XMVECTOR TMin;
+			XMVECTOR TMax;
+		};
+		struct WideSphere
+		{
+			XMVECTOR center[3];
+			XMVECTOR radiusSq;
+		};
+		struct WideAABB
+		{
+			XMVECTOR _min[3];
+			XMVECTOR _max[3];
+		};
+		struct WideFrustum
+		{
+			XMVECTOR planes[6][4]; // xyzw of each plane replicated
+		};
+		static WideRay PrepareWide(const wi::primitive::Ray& ray)
+		{
+			WideRay ret;
+			ret.origin[0] = XMVectorReplicate(ray.origin.x);
+			ret.origin[1] = XMVectorReplicate(ray.origin.y);
+			ret.origin[2] = XMVectorReplicate(ray.origin.z);
+			ret.direction_inverse[0] = XMVectorReplicate(ray.direction_inverse.x);
+			ret.direction_inverse[1] = XMVectorReplicate(ray.direction_inverse.y);
+			ret.direction_inverse[2] = XMVectorReplicate(ray.direction_inverse.z);
+			ret.TMin = XMVectorReplicate(ray.TMin);
+			ret.TMax = XMVectorReplicate(ray.TMax);
+			return ret;
+		}
+		static WideSphere PrepareWide(const wi::primitive::Sphere& sphere)
+		{
+			WideSphere ret;
+			ret.center[0] = XMVectorReplicate(sphere.center.x);
+			ret.center[1] = XMVectorReplicate(sphere.center.y);
+			ret.center[2] = XMVectorReplicate(sphere.center.z);
+			ret.radiusSq = XMVectorReplicate(sphere.radius * sphere.radius);
+			return ret;
+		}
+		static WideAABB PrepareWide(const wi::primitive::AABB& aabb)
+		{
+			WideAABB ret;
+			ret._min[0] = XMVectorReplicate(aabb._min.x);
+			ret._min[1] = XMVectorReplicate(aabb._min.y);
+			ret._min[2] = XMVectorReplicate(aabb._min.z);
+			ret._max[0] = XMVectorReplicate(aabb._max.x);
+			ret._max[1] = XMVectorReplicate(aabb._max.y);
+			ret._max[2] = XMVectorReplicate(aabb._max.z);
+			return ret;
+		}
+		static WideFrustum PrepareWide(const wi::primitive::Frustum& frustum)
+		{
+			WideFrustum ret;
+			for (int i = 0; i < 6; ++i)
+			{
+				const XMVECTOR plane = XMLoadFloat4(&frustum.planes[i]);
+				ret.planes[i][0] = XMVectorSplatX(plane);
+				ret.planes[i][1] = XMVectorSplatY(plane);
+				ret.planes[i][2] = XMVectorSplatZ(plane);
+				ret.planes[i][3] = XMVectorSplatW(plane);
+			}
+			return ret;
+		}
+
+		// Tests all four children of a wide node and returns the intersecting ones in a bitmask:
+		static uint32_t IntersectsWide4(const WideNode& node, const WideRay& ray)
+		{
+			const XMVECTOR min_x = XMLoadFloat4A(&node.min_x);
+			const XMVECTOR max_x = XMLoadFloat4A(&node.max_x);
+			const XMVECTOR tx1 = XMVectorMultiply(XMVectorSubtract(min_x, ray.origin[0]), ray.direction_inverse[0]);
+			const XMVECTOR tx2 = XMVectorMultiply(XMVectorSubtract(max_x, ray.origin[0]), ray.direction_inverse[0]);
+			const XMVECTOR ty1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.min_y), ray.origin[1]), ray.direction_inverse[1]);
+			const XMVECTOR ty2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.max_y), ray.origin[1]), ray.direction_inverse[1]);
+			const XMVECTOR tz1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.min_z), ray.origin[2]), ray.direction_inverse[2]);
+			const XMVECTOR tz2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4A(&node.max_z), ray.origin[2]), ray.direction_inverse[2]);
+			XMVECTOR tmin = XMVectorMax(ray.TMin, XMVectorMin(tx1, tx2));
+			XMVECTOR tmax = XMVectorMin(ray.TMax, XMVectorMax(tx1, tx2));
+			tmin = XMVectorMax(tmin, XMVectorMin(ty1, ty2));
+			tmax = XMVectorMin(tmax, XMVectorMax(ty1, ty2));
+			tmin = XMVectorMax(tmin, XMVectorMin(tz1, tz2));
+			tmax = XMVectorMin(tmax, XMVectorMax(tz1, tz2));
+			// empty slots and invalid bounds would pass the slab test, because their min and max are swapped:
+			const XMVECTOR valid = XMVectorLessOrEqual(min_x, max_x);
+			return GetWideMask(XMVectorAndInt(XMVectorGreaterOrEqual(tmax, tmin), valid));
+		}
+		static uint32_t IntersectsWide4(const WideNode& node, const WideSphere& sphere)
+		{
+			const XMVECTOR zero = XMVectorZero();
+			const XMVECTOR dx = XMVectorMax(XMVectorMax(XMVectorSubtract(XMLoadFloat4A(&node.min_x), sphere.center[0]), XMVectorSubtract(sphere.center[0], XMLoadFloat4A(&node.max_x))), zero);
+			const XMVECTOR dy = XMVectorMax(XMVectorMax(XMVectorSubtract(XMLoadFloat4A(&node.min_y), sphere.center[1]), XMVectorSubtract(sphere.center[1], XMLoadFloat4A(&node.max_y))), zero);
+			const XMVECTOR dz = XMVectorMax(XMVectorMax(XMVectorSubtract(XMLoadFloat4A(&node.min_z), sphere.center[2]), XMVectorSubtract(sphere.center[2], XMLoadFloat4A(&node.max_z))), zero);
+			const XMVECTOR distSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz)));
+			return GetWideMask(XMVectorLessOrEqual(distSq, sphere.radiusSq));
+		}
+		static uint32_t IntersectsWide4(const WideNode& node, const WideAABB& aabb)
+		{
+			XMVECTOR overlap = XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_x), aabb._max[0]), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_x), aabb._min[0]));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_y), aabb._max[1]), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_y), aabb._min[1])));
+			overlap = XMVectorAndInt(overlap, XMVectorAndInt(XMVectorLessOrEqual(XMLoadFloat4A(&node.min_z), aabb._max[2]), XMVectorGreaterOrEqual(XMLoadFloat4A(&node.max_z), aabb._min[2])));
+			return GetWideMask(overlap);
+		}
+		static uint32_t IntersectsWide4(const WideNode& node, const WideFrustum& frustum)
+		{
+			const XMVECTOR min_x = XMLoadFloat4A(&node.min_x);
+			const XMVECTOR min_y = XMLoadFloat4A(&node.min_y);
+			const XMVECTOR min_z = XMLoadFloat4A(&node.min_z);
+			const XMVECTOR max_x = XMLoadFloat4A(&node.max_x);
+			const XMVECTOR max_y = XMLoadFloat4A(&node.max_y);
+			const XMVECTOR max_z = XMLoadFloat4A(&node.max_z);
+			const XMVECTOR zero = XMVectorZero();
+			XMVECTOR inside = XMVectorLessOrEqual(min_x, max_x);
+			for (int i = 0; i < 6; ++i)
+			{
+				// the box corner that is the furthest along the plane normal:
+				const XMVECTOR x = XMVectorSelect(max_x, min_x, XMVectorLess(frustum.planes[i][0], zero));
+				const XMVECTOR y = XMVectorSelect(max_y, min_y, XMVectorLess(frustum.planes[i][1], zero));
+				const XMVECTOR z = XMVectorSelect(max_z, min_z, XMVectorLess(frustum.planes[i][2], zero));
+				const XMVECTOR dist = XMVectorMultiplyAdd(frustum.planes[i][0], x, XMVectorMultiplyAdd(frustum.planes[i][1], y, XMVectorMultiplyAdd(frustum.planes[i][2], z, frustum.planes[i][3])));
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(dist, zero));
+			}
+			return GetWideMask(inside);
+		}
+		// Tests all four children of a wide node against a frustum, returns the intersecting ones and the fully inside ones in bitmasks:
+		static uint32_t CullWide4(const WideNode& node, const WideFrustum& frustum, uint32_t& inside_mask)
+		{
+			const XMVECTOR min_x = XMLoadFloat4A(&node.min_x);
+			const XMVECTOR min_y = XMLoadFloat4A(&node.min_y);
+			const XMVECTOR min_z = XMLoadFloat4A(&node.min_z);
+			const XMVECTOR max_x = XMLoadFloat4A(&node.max_x);
+			const XMVECTOR max_y = XMLoadFloat4A(&node.max_y);
+			const XMVECTOR max_z = XMLoadFloat4A(&node.max_z);
+			const XMVECTOR zero = XMVectorZero();
+			XMVECTOR intersects = XMVectorLessOrEqual(min_x, max_x);
+			XMVECTOR inside = intersects;
+			for (int i = 0; i < 6; ++i)
+			{
+				// the box corner that is the furthest along the plane normal decides if the box is outside,
+				//	the opposite corner decides if the box is inside:
+				const XMVECTOR negative_x = XMVectorLess(frustum.planes[i][0], zero);
+				const XMVECTOR negative_y = XMVectorLess(frustum.planes[i][1], zero);
+				const XMVECTOR negative_z = XMVectorLess(frustum.planes[i][2], zero);
+				const XMVECTOR far_dist = XMVectorMultiplyAdd(frustum.planes[i][0], XMVectorSelect(max_x, min_x, negative_x), XMVectorMultiplyAdd(frustum.planes[i][1], XMVectorSelect(max_y, min_y, negative_y), XMVectorMultiplyAdd(frustum.planes[i][2], XMVectorSelect(max_z, min_z, negative_z), frustum.planes[i][3])));
+				const XMVECTOR near_dist = XMVectorMultiplyAdd(frustum.planes[i][0], XMVectorSelect(min_x, max_x, negative_x), XMVectorMultiplyAdd(frustum.planes[i][1], XMVectorSelect(min_y, max_y, negative_y), XMVectorMultiplyAdd(frustum.planes[i][2], XMVectorSelect(min_z, max_z, negative_z), frustum.planes[i][3])));
+				intersects = XMVectorAndInt(intersects, XMVectorGreaterOrEqual(far_dist, zero));
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(near_dist, zero));
+			}
+			inside_mask = GetWideMask(inside);
+			return GetWideMask(intersects);
+		}
+		static uint32_t GetWideMask(const XMVECTOR& comparison)
+		{
+			uint32_t lanes[4];
+			XMStoreInt4(lanes, comparison);
+			return (lanes[0] & 1u) | (lanes[1] & 2u) | (lanes[2] & 4u) | (lanes[3] & 8u);
+		}
+
+		template <typename T>
+		void IntersectsWide(
+			const T& wide_primitive,
+			uint32_t wideIndex,
+			const std::function<void(uint32_t index)>& callback
+		) const
+		{
+			const WideNode& node = wide_nodes[wideIndex];
+			const uint32_t mask = IntersectsWide4(node, wide_primitive);
+			for (int i = 0; i < 4; ++i)
+			{
+				if ((mask & (1u << i)) == 0 || node.child[i] == ~0u)
+					continue;
+				if (node.count[i] > 0)
+				{
+					for (uint32_t j = 0; j < node.count[i]; ++j)
+					{
+						callback(leaf_indices[node.child[i] + j]);
+					}
+				}
+				else
+				{
+					IntersectsWide(wide_primitive, node.child[i], callback);
+				}
+			}
+		}
+
+		void CullFrustum(
+			const wi::primitive::Frustum& frustum,
+			uint32_t nodeIndex,
+			const std::function<void(uint32_t offset, uint32_t count, bool inside)>& callback
+		) const
+		{
+			const Node& node = nodes[nodeIndex];
+			const wi::primitive::Frustum::BoxFrustumIntersect result = frustum.CheckBox(node.aabb);
+			if (result == wi::primitive::Frustum::BOX_FRUSTUM_OUTSIDE)
+				return;
+			if (result == wi::primitive::Frustum::BOX_FRUSTUM_INSIDE)
+			{
+				uint32_t offset, count;
+				GetSubtreeRange(nodeIndex, offset, count);
+				callback(offset, count, true);
+				return;
+			}
+			if (node.isLeaf())
+			{
+				callback(node.offset, node.count, false);
+				return;
+			}
+			CullFrustum(frustum, node.left, callback);
+			CullFrustum(frustum, node.left + 1, callback);
+		}
+		void CullFrustum(
+			const WideFrustum& frustum,
+			uint32_t wideIndex,
+			const std::function<void(uint32_t offset, uint32_t count, bool inside)>& callback
+		) const
+		{
+			const WideNode& node = wide_nodes[wideIndex];
+			uint32_t inside_mask = 0;
+			const uint32_t mask = CullWide4(node, frustum, inside_mask);
+			for (int i = 0; i < 4; ++i)
+			{
+				if ((mask & (1u << i)) == 0 || node.child[i] == ~0u)
+					continue;
+				if (node.count[i] > 0)
+				{
+					callback(node.child[i], node.count[i], (inside_mask & (1u << i)) != 0);
+				}
+				else if (inside_mask & (1u << i))
+				{
+					uint32_t offset, count;
+					GetSubtreeRange(node.source[i], offset, count);
+					callback(offset, count, true);
+				}
+				else
+				{
+					CullFrustum(frustum, node.child[i], callback);
+				}
+			}
+		}
 	};
 }
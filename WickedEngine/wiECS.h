@@ -34,8 +34,14 @@ namespace wi::ecs
 		wi::jobsystem::context ctx; // allow components to spawn serialization subtasks
 		wi::unordered_map<uint64_t, Entity> remap;
 		bool allow_remap = true;
+		// When allow_write_remap is true, entities are written with their value from this table instead of the runtime entity value
+		//	Entities that are not in the table yet will be assigned the next free value (table size + 1)
+		//	This is used to write entities in a session independent form, such as for delta serialization
+		wi::unordered_map<Entity, uint64_t> write_remap;
+		bool allow_write_remap = false;
 		uint64_t version = 0; // The ComponentLibrary serialization will modify this by the registered component's version number
 		wi::unordered_set<std::string> resource_registration; // register for resource manager serialization
+		std::atomic<float>* progress = nullptr; // if set, the ComponentLibrary serialization will report its progress here in [0, 1] range
 
 		~EntitySerializer()
 		{
@@ -90,7 +96,24 @@ namespace wi::ecs
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 #endif // __GNUC__ && !__SCE__
 
-			archive << entity;
+			if (entity != INVALID_ENTITY && seri.allow_write_remap)
+			{
+				auto it = seri.write_remap.find(entity);
+				if (it == seri.write_remap.end())
+				{
+					const uint64_t mem = seri.write_remap.size() + 1;
+					seri.write_remap[entity] = mem;
+					archive << mem;
+				}
+				else
+				{
+					archive << it->second;
+				}
+			}
+			else
+			{
+				archive << entity;
+			}
 
 #if defined(__GNUC__) && !defined(__SCE__)
 #pragma GCC diagnostic pop
@@ -117,6 +140,7 @@ namespace wi::ecs
 		virtual size_t GetCount() const = 0;
 		virtual Entity GetEntity(size_t index) const = 0;
 		virtual const wi::vector<Entity>& GetEntityArray() const = 0;
+		virtual std::unique_ptr<ComponentManager_Interface> Clone() const = 0;
 	};
 
 	// The ComponentManager is a container that stores components and matches them with entities
@@ -183,6 +207,14 @@ namespace wi::ecs
 			Merge((ComponentManager<Component>&)other);
 		}
 
+		// Create a new component manager of the same type with a deep copy of the contents of this
+		inline std::unique_ptr<ComponentManager_Interface> Clone() const
+		{
+			auto clone = std::make_unique<ComponentManager<Component>>();
+			clone->Copy(*this);
+			return clone;
+		}
+
 		// Read/Write everything to an archive depending on the archive state
 		inline void Serialize(wi::Archive& archive, EntitySerializer& seri)
 		{
@@ -223,6 +255,7 @@ namespace wi::ecs
 		}
 
 		//Read one single component onto an archive, make sure entity are serialized first
+		//	If the entity already has this component when reading, it will be overwritten
 		inline void Component_Serialize(Entity entity, wi::Archive& archive, EntitySerializer& seri)
 		{
 			if(archive.IsReadMode())
@@ -231,8 +264,16 @@ namespace wi::ecs
 				archive >> component_exists;
 				if (component_exists)
 				{
-					auto& component = this->Create(entity);
-					component.Serialize(archive, seri);
+					Component* component = this->GetComponent(entity);
+					if (component == nullptr)
+					{
+						component = &this->Create(entity);
+					}
+					else
+					{
+						*component = Component(); // deserialization always starts from default state
+					}
+					component->Serialize(archive, seri);
 				}
 			}
 			else
@@ -499,6 +540,15 @@ namespace wi::ecs
 			}
 			else
 			{
+				size_t total_count = 0;
+				size_t written_count = 0;
+				if (seri.progress != nullptr)
+				{
+					for (auto& it : entries)
+					{
+						total_count += it.second.component_manager->GetCount();
+					}
+				}
 				for(auto& it : entries)
 				{
 					archive << true;
@@ -508,6 +558,11 @@ namespace wi::ecs
 					seri.version = it.second.version;
 					it.second.component_manager->Serialize(archive, seri);
 					archive.PatchUnknownJumpPosition(offset); // ...to here, if this component manager was not registered
+					if (seri.progress != nullptr && total_count > 0)
+					{
+						written_count += it.second.component_manager->GetCount();
+						seri.progress->store(float(written_count) / float(total_count));
+					}
 				}
 				archive << false;
 			}
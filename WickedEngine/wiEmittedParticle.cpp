@@ -329,7 +329,13 @@ namespace wi
 	void EmittedParticleSystem::UpdateCPU(const TransformComponent& transform, float dt)
 	{
 		this->dt = dt;
-		CreateSelfBuffers();
+
+		// Particles are simulated on the GPU, without graphics device only the CPU state is updated:
+		GraphicsDevice* device = wi::graphics::GetDevice();
+		if (device != nullptr)
+		{
+			CreateSelfBuffers();
+		}
 
 		if (IsPaused() || dt == 0)
 			return;
@@ -349,8 +355,11 @@ namespace wi
 		std::swap(aliveList[0], aliveList[1]);
 
 		// Read back statistics (with GPU delay):
-		const uint32_t oldest_stat_index = wi::graphics::GetDevice()->GetBufferIndex();
-		memcpy(&statistics, statisticsReadbackBuffer[oldest_stat_index].mapped_data, sizeof(statistics));
+		if (device != nullptr)
+		{
+			const uint32_t oldest_stat_index = device->GetBufferIndex();
+			memcpy(&statistics, statisticsReadbackBuffer[oldest_stat_index].mapped_data, sizeof(statistics));
+		}
 	}
 	void EmittedParticleSystem::Burst(int num)
 	{
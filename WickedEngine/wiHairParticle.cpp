@@ -294,6 +294,9 @@ namespace wi
 			CreateFromMesh(mesh);
 		}
 
+		if (wi::graphics::GetDevice() == nullptr)
+			return;
+
 		if ((_flags & REBUILD_BUFFERS) || !constantBuffer.IsValid() || GetParticleCount() != simulation_view.size / sizeof(PatchSimulationData))
 		{
 			CreateRenderData();
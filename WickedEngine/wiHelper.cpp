@@ -3,6 +3,7 @@
 #include "wiBacklog.h"
 #include "wiEventHandler.h"
 #include "wiMath.h"
+#include "wiTextureBaker.h"
 
 #include "Utility/lodepng.h"
 #include "Utility/dds_write.h"
@@ -21,6 +22,8 @@
 #include <vector>
 #include <iostream>
 #include <cstdlib>
+#include <mutex>
+#include <atomic>
 
 #if defined(_WIN32)
 #include <direct.h>
@@ -41,6 +44,10 @@
 #elif defined(PLATFORM_PS5)
 #else
 #include "Utility/portable-file-dialogs.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif // _WIN32
 
 namespace wi::helper
@@ -157,6 +164,15 @@ namespace wi::helper
 		device->SubmitCommandLists();
 		device->WaitForGPU();
 
+		return saveStagingTextureToMemory(stagingTex, texturedata);
+	}
+
+	bool saveStagingTextureToMemory(const wi::graphics::Texture& stagingTex, wi::vector<uint8_t>& texturedata)
+	{
+		using namespace wi::graphics;
+
+		const TextureDesc& desc = stagingTex.GetDesc();
+
 		texturedata.clear();
 
 		if (stagingTex.mapped_data != nullptr)
@@ -833,6 +849,17 @@ namespace wi::helper
 		return false;
 	}
 
+	bool saveTextureToMemoryFile(const wi::vector<uint8_t>& texturedata, const wi::graphics::TextureDesc& desc, const std::string& fileExtension, wi::vector<uint8_t>& filedata, const wi::texturebaker::BakeParams& params)
+	{
+		wi::vector<uint8_t> baked;
+		wi::graphics::TextureDesc baked_desc;
+		if (wi::texturebaker::Bake(texturedata, desc, baked, baked_desc, params))
+		{
+			return saveTextureToMemoryFile(baked, baked_desc, fileExtension, filedata);
+		}
+		return false;
+	}
+
 	bool saveTextureToFile(const wi::vector<uint8_t>& texturedata, const wi::graphics::TextureDesc& desc, const std::string& fileName)
 	{
 		using namespace wi::graphics;
@@ -1009,9 +1036,411 @@ namespace wi::helper
 		std::filesystem::create_directories(ToNativeString(path));
 	}
 
+	namespace package
+	{
+		// Package file layout:
+		//	Header
+		//	File contents (uncompressed entries are aligned to PackageParams::alignment)
+		//	Entries, sorted by path hash
+		//	Path strings (relative to the package root, not null terminated)
+		static constexpr uint32_t MAGIC = 0x4B504957; // "WIPK"
+		static constexpr uint32_t VERSION = 1;
+
+		struct Header
+		{
+			uint32_t magic = MAGIC;
+			uint32_t version = VERSION;
+			uint32_t entry_count = 0;
+			uint32_t reserved = 0;
+			uint64_t entries_offset = 0;
+			uint64_t paths_offset = 0;
+			uint64_t paths_size = 0;
+		};
+		static_assert(sizeof(Header) == 40);
+
+		enum ENTRY_FLAGS
+		{
+			ENTRY_COMPRESSED = 1 << 0,
+		};
+		struct Entry
+		{
+			uint64_t hash = 0;
+			uint64_t offset = 0;
+			uint64_t size = 0;			// size of the original file
+			uint64_t stored_size = 0;	// size of the data in the package, different from size if compressed
+			uint32_t path_offset = 0;
+			uint32_t path_length = 0;
+			uint32_t flags = 0;
+			uint32_t reserved = 0;
+		};
+		static_assert(sizeof(Entry) == 48);
+
+		struct Package
+		{
+			std::string filename;
+			std::string mountpoint; // absolute, generic, ends with '/'
+			uint64_t timestamp = 0;
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+			const Entry* entries = nullptr;
+			uint32_t entry_count = 0;
+			const char* paths = nullptr;
+#if defined(PLATFORM_WINDOWS_DESKTOP) || defined(PLATFORM_LINUX)
+			void* mapping = nullptr;
+#else
+			wi::vector<uint8_t> filedata; // fallback when memory mapping is not implemented
+#endif // PLATFORM_WINDOWS_DESKTOP || PLATFORM_LINUX
+
+			~Package()
+			{
+#if defined(PLATFORM_WINDOWS_DESKTOP)
+				if (mapping != nullptr)
+				{
+					UnmapViewOfFile(mapping);
+				}
+#elif defined(PLATFORM_LINUX)
+				if (mapping != nullptr)
+				{
+					munmap(mapping, size);
+				}
+#endif // PLATFORM_WINDOWS_DESKTOP
+			}
+
+			const Entry* Find(const std::string& path, uint64_t hash) const
+			{
+				const Entry* end = entries + entry_count;
+				const Entry* it = std::lower_bound(entries, end, hash, [](const Entry& entry, uint64_t hash) {
+					return entry.hash < hash;
+				});
+				for (; it != end && it->hash == hash; ++it)
+				{
+					if (path.length() == it->path_length && path.compare(0, path.length(), paths + it->path_offset, it->path_length) == 0)
+					{
+						return it;
+					}
+				}
+				return nullptr;
+			}
+		};
+
+		static std::mutex locker;
+		static wi::vector<std::shared_ptr<Package>> packages; // the last mounted package has priority
+		static std::atomic<uint32_t> package_count{ 0 };
+
+		// Converts a path to absolute and generic form, this doesn't access the file system
+		static std::string NormalizePath(const std::string& path)
+		{
+			std::string filepath = path;
+			std::replace(filepath.begin(), filepath.end(), '\\', '/');
+			std::filesystem::path fspath = ToNativeString(filepath);
+			return std::filesystem::absolute(fspath).lexically_normal().generic_u8string();
+		}
+
+		static uint64_t PathHash(const char* path, size_t length)
+		{
+			return data_hash(path, length);
+		}
+
+		struct Lookup
+		{
+			std::shared_ptr<Package> package; // keeps the package mapped while the entry is in use
+			const Entry* entry = nullptr;
+		};
+		static Lookup Find(const std::string& fileName)
+		{
+			Lookup lookup;
+			if (package_count.load() == 0 || fileName.empty())
+			{
+				return lookup;
+			}
+			const std::string path = NormalizePath(fileName);
+
+			std::scoped_lock lock(locker);
+			for (auto it = packages.rbegin(); it != packages.rend(); ++it)
+			{
+				const Package& pkg = **it;
+				if (path.length() <= pkg.mountpoint.length() || path.compare(0, pkg.mountpoint.length(), pkg.mountpoint) != 0)
+				{
+					continue;
+				}
+				const std::string relative = path.substr(pkg.mountpoint.length());
+				const Entry* entry = pkg.Find(relative, PathHash(relative.c_str(), relative.length()));
+				if (entry != nullptr)
+				{
+					lookup.package = *it;
+					lookup.entry = entry;
+					return lookup;
+				}
+			}
+			return lookup;
+		}
+
+		template<typename T>
+		static void WritePadding(std::ofstream& file, uint64_t& offset, T alignment)
+		{
+			const uint64_t aligned = wi::graphics::AlignTo(offset, uint64_t(alignment));
+			static const char zeros[4096] = {};
+			while (offset < aligned)
+			{
+				const uint64_t count = std::min(aligned - offset, uint64_t(sizeof(zeros)));
+				file.write(zeros, (std::streamsize)count);
+				offset += count;
+			}
+		}
+	}
+
+	bool PackageCreate(const std::string& packageFileName, const std::string& rootdir, const wi::vector<std::string>& fileNames, const PackageParams& params)
+	{
+		std::string root = package::NormalizePath(rootdir);
+		if (!root.empty() && root.back() != '/')
+		{
+			root += '/';
+		}
+
+		struct Item
+		{
+			std::string fileName;
+			std::string path;
+			package::Entry entry;
+		};
+		wi::vector<Item> items;
+		items.reserve(fileNames.size());
+		for (auto& fileName : fileNames)
+		{
+			const std::string path = package::NormalizePath(fileName);
+			if (path.length() <= root.length() || path.compare(0, root.length(), root) != 0)
+			{
+				wi::backlog::post("PackageCreate: file is not inside the package root directory: " + fileName, wi::backlog::LogLevel::Error);
+				return false;
+			}
+			Item& item = items.emplace_back();
+			item.fileName = fileName;
+			item.path = path.substr(root.length());
+			item.entry.hash = package::PathHash(item.path.c_str(), item.path.length());
+		}
+		std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+			return a.entry.hash < b.entry.hash || (a.entry.hash == b.entry.hash && a.path < b.path);
+		});
+		items.erase(std::unique(items.begin(), items.end(), [](const Item& a, const Item& b) {
+			return a.path == b.path;
+		}), items.end());
+
+		std::ofstream file(ToNativeString(packageFileName), std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			wi::backlog::post("PackageCreate: couldn't open file for writing: " + packageFileName, wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		package::Header header;
+		header.entry_count = (uint32_t)items.size();
+		file.write((const char*)&header, sizeof(header));
+		uint64_t offset = sizeof(header);
+
+		// The file contents are streamed into the package one by one, so the whole content doesn't need to fit in memory:
+		wi::vector<uint8_t> filedata;
+		wi::vector<uint8_t> compressed;
+		std::string paths;
+		for (auto& item : items)
+		{
+			filedata.clear();
+			if (!FileRead(item.fileName, filedata))
+			{
+				wi::backlog::post("PackageCreate: couldn't read file: " + item.fileName, wi::backlog::LogLevel::Error);
+				return false;
+			}
+			item.entry.size = filedata.size();
+			item.entry.path_offset = (uint32_t)paths.length();
+			item.entry.path_length = (uint32_t)item.path.length();
+			paths += item.path;
+
+			if (params.compress && !filedata.empty() && Compress(filedata.data(), filedata.size(), compressed))
+			{
+				item.entry.flags |= package::ENTRY_COMPRESSED;
+				item.entry.offset = offset;
+				item.entry.stored_size = compressed.size();
+				file.write((const char*)compressed.data(), (std::streamsize)compressed.size());
+			}
+			else
+			{
+				package::WritePadding(file, offset, std::max(1u, params.alignment));
+				item.entry.offset = offset;
+				item.entry.stored_size = filedata.size();
+				file.write((const char*)filedata.data(), (std::streamsize)filedata.size());
+			}
+			offset += item.entry.stored_size;
+		}
+
+		package::WritePadding(file, offset, alignof(package::Entry));
+		header.entries_offset = offset;
+		for (auto& item : items)
+		{
+			file.write((const char*)&item.entry, sizeof(item.entry));
+			offset += sizeof(item.entry);
+		}
+		header.paths_offset = offset;
+		header.paths_size = paths.length();
+		file.write(paths.data(), (std::streamsize)paths.length());
+
+		file.seekp(0);
+		file.write((const char*)&header, sizeof(header));
+		file.close();
+		return !file.fail();
+	}
+
+	bool PackageMount(const std::string& packageFileName, const std::string& mountpoint)
+	{
+		auto pkg = std::make_shared<package::Package>();
+		pkg->filename = package::NormalizePath(packageFileName);
+		pkg->mountpoint = package::NormalizePath(mountpoint.empty() ? GetDirectoryFromPath(pkg->filename) : mountpoint);
+		if (!pkg->mountpoint.empty() && pkg->mountpoint.back() != '/')
+		{
+			pkg->mountpoint += '/';
+		}
+
+#if defined(PLATFORM_WINDOWS_DESKTOP)
+		HANDLE filehandle = CreateFileW(ToNativeString(packageFileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (filehandle != INVALID_HANDLE_VALUE)
+		{
+			LARGE_INTEGER filesize = {};
+			GetFileSizeEx(filehandle, &filesize);
+			HANDLE mappinghandle = CreateFileMappingW(filehandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mappinghandle != nullptr)
+			{
+				pkg->mapping = MapViewOfFile(mappinghandle, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mappinghandle); // the view keeps the mapping alive
+			}
+			CloseHandle(filehandle);
+			if (pkg->mapping != nullptr)
+			{
+				pkg->data = (const uint8_t*)pkg->mapping;
+				pkg->size = (size_t)filesize.QuadPart;
+			}
+		}
+#elif defined(PLATFORM_LINUX)
+		int fd = open(pkg->filename.c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			struct stat st = {};
+			if (fstat(fd, &st) == 0 && st.st_size > 0)
+			{
+				void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapping != MAP_FAILED)
+				{
+					pkg->mapping = mapping;
+					pkg->data = (const uint8_t*)mapping;
+					pkg->size = (size_t)st.st_size;
+				}
+			}
+			close(fd); // the mapping remains valid
+		}
+#else
+		if (FileRead(packageFileName, pkg->filedata))
+		{
+			pkg->data = pkg->filedata.data();
+			pkg->size = pkg->filedata.size();
+		}
+#endif // PLATFORM_WINDOWS_DESKTOP
+
+		if (pkg->data == nullptr)
+		{
+			wi::backlog::post("PackageMount: couldn't open package: " + packageFileName, wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		// Validate everything up front, so lookups don't need to do bounds checking:
+		bool valid = pkg->size >= sizeof(package::Header);
+		if (valid)
+		{
+			const package::Header& header = *(const package::Header*)pkg->data;
+			valid = header.magic == package::MAGIC && header.version == package::VERSION &&
+				header.entries_offset % alignof(package::Entry) == 0 &&
+				header.entries_offset + uint64_t(header.entry_count) * sizeof(package::Entry) <= header.paths_offset &&
+				header.paths_offset + header.paths_size <= pkg->size;
+			if (valid)
+			{
+				pkg->entries = (const package::Entry*)(pkg->data + header.entries_offset);
+				pkg->entry_count = header.entry_count;
+				pkg->paths = (const char*)(pkg->data + header.paths_offset);
+				for (uint32_t i = 0; i < pkg->entry_count && valid; ++i)
+				{
+					const package::Entry& entry = pkg->entries[i];
+					valid = entry.offset + entry.stored_size <= header.entries_offset &&
+						uint64_t(entry.path_offset) + entry.path_length <= header.paths_size &&
+						((entry.flags & package::ENTRY_COMPRESSED) || entry.stored_size == entry.size) &&
+						(i == 0 || pkg->entries[i - 1].hash <= entry.hash);
+				}
+			}
+		}
+		if (!valid)
+		{
+			wi::backlog::post("PackageMount: invalid package file: " + packageFileName, wi::backlog::LogLevel::Error);
+			return false;
+		}
+		pkg->timestamp = FileTimestamp(packageFileName);
+
+		std::scoped_lock lock(package::locker);
+		for (auto it = package::packages.begin(); it != package::packages.end(); ++it)
+		{
+			if ((*it)->filename == pkg->filename)
+			{
+				package::packages.erase(it); // remount
+				break;
+			}
+		}
+		package::packages.push_back(pkg);
+		package::package_count.store((uint32_t)package::packages.size());
+		return true;
+	}
+
+	void PackageUnmount(const std::string& packageFileName)
+	{
+		const std::string filename = package::NormalizePath(packageFileName);
+		std::scoped_lock lock(package::locker);
+		for (auto it = package::packages.begin(); it != package::packages.end(); ++it)
+		{
+			if ((*it)->filename == filename)
+			{
+				package::packages.erase(it);
+				break;
+			}
+		}
+		package::package_count.store((uint32_t)package::packages.size());
+	}
+
+	bool PackageFileView(const std::string& fileName, const uint8_t*& data, size_t& size)
+	{
+		package::Lookup lookup = package::Find(fileName);
+		if (lookup.entry == nullptr || (lookup.entry->flags & package::ENTRY_COMPRESSED))
+		{
+			return false;
+		}
+		data = lookup.package->data + lookup.entry->offset;
+		size = (size_t)lookup.entry->size;
+		return true;
+	}
+
 	template<template<typename T, typename A> typename vector_interface>
 	bool FileRead_Impl(const std::string& fileName, vector_interface<uint8_t, std::allocator<uint8_t>>& data)
 	{
+		package::Lookup lookup = package::Find(fileName);
+		if (lookup.entry != nullptr)
+		{
+			const uint8_t* src = lookup.package->data + lookup.entry->offset;
+			data.resize((size_t)lookup.entry->size);
+			if (lookup.entry->flags & package::ENTRY_COMPRESSED)
+			{
+				if (Decompress(src, (size_t)lookup.entry->stored_size, data.data(), data.size()))
+				{
+					return true;
+				}
+				wi::backlog::post("Package file is corrupted: " + fileName, wi::backlog::LogLevel::Error);
+				return false;
+			}
+			std::memcpy(data.data(), src, data.size());
+			return true;
+		}
+
 #ifndef PLATFORM_UWP
 #if defined(PLATFORM_LINUX) || defined(PLATFORM_PS5)
 		std::string filepath = fileName;
@@ -1172,6 +1601,11 @@ namespace wi::helper
 
 	bool FileExists(const std::string& fileName)
 	{
+		if (package::Find(fileName).entry != nullptr)
+		{
+			return true;
+		}
+
 #ifndef PLATFORM_UWP
 		bool exists = std::filesystem::exists(ToNativeString(fileName));
 		return exists;
@@ -1220,6 +1654,11 @@ namespace wi::helper
 
 	uint64_t FileTimestamp(const std::string& fileName)
 	{
+		package::Lookup lookup = package::Find(fileName);
+		if (lookup.entry != nullptr)
+		{
+			return lookup.package->timestamp;
+		}
 		auto tim = std::filesystem::last_write_time(ToNativeString(fileName));
 		return std::chrono::duration_cast<std::chrono::duration<uint64_t>>(tim.time_since_epoch()).count();
 	}
@@ -1702,4 +2141,286 @@ namespace wi::helper
 		}
 		return ss.str();
 	}
+
+	// LZ4 block format: each sequence is a token (4 bits literal length, 4 bits match length),
+	//	optional literal length bytes, literals, 16-bit match offset, optional match length bytes
+	namespace lz
+	{
+		static constexpr size_t MINMATCH = 4;
+		static constexpr size_t LASTLITERALS = 5; // the last 5 bytes are always literals
+		static constexpr size_t MFLIMIT = 12; // the last match must start at least 12 bytes before the end
+		static constexpr size_t MAX_DISTANCE = 65535;
+		static constexpr uint32_t HASH_LOG = 14;
+
+		inline uint32_t read32(const uint8_t* ptr)
+		{
+			uint32_t value;
+			std::memcpy(&value, ptr, sizeof(value));
+			return value;
+		}
+		inline uint32_t hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HASH_LOG);
+		}
+		inline uint8_t* write_length(uint8_t* op, size_t length)
+		{
+			while (length >= 255)
+			{
+				*op++ = 255;
+				length -= 255;
+			}
+			*op++ = (uint8_t)length;
+			return op;
+		}
+		inline uint8_t* write_literals(uint8_t* op, uint8_t* token, const uint8_t* anchor, size_t literal_length)
+		{
+			if (literal_length >= 15)
+			{
+				*token = 15 << 4;
+				op = write_length(op, literal_length - 15);
+			}
+			else
+			{
+				*token = uint8_t(literal_length << 4);
+			}
+			std::memcpy(op, anchor, literal_length);
+			return op + literal_length;
+		}
+	}
+
+	size_t CompressBound(size_t src_size)
+	{
+		return src_size + src_size / 255 + 16;
+	}
+
+	bool Compress(const uint8_t* src_data, size_t src_size, wi::vector<uint8_t>& dst_data)
+	{
+		dst_data.resize(CompressBound(src_size));
+		uint8_t* op = dst_data.data();
+
+		const uint8_t* ip = src_data;
+		const uint8_t* anchor = src_data;
+		const uint8_t* iend = src_data + src_size;
+
+		if (src_size > lz::MFLIMIT)
+		{
+			const uint8_t* mflimit = iend - lz::MFLIMIT;
+			const uint8_t* matchlimit = iend - lz::LASTLITERALS;
+
+			// Hash table stores the most recent position of each 4-byte sequence:
+			std::unique_ptr<uint32_t[]> table = std::make_unique<uint32_t[]>(1u << lz::HASH_LOG);
+
+			ip++;
+			while (ip < mflimit)
+			{
+				const uint32_t sequence = lz::read32(ip);
+				const uint32_t h = lz::hash(sequence);
+				const uint8_t* ref = src_data + table[h];
+				table[h] = uint32_t(ip - src_data);
+
+				if (size_t(ip - ref) > lz::MAX_DISTANCE || lz::read32(ref) != sequence)
+				{
+					// No match, skip faster through data that doesn't compress well:
+					ip += 1 + ((ip - anchor) >> 6);
+					continue;
+				}
+
+				// Extend the match backwards:
+				while (ip > anchor && ref > src_data && ip[-1] == ref[-1])
+				{
+					ip--;
+					ref--;
+				}
+
+				// Extend the match forward:
+				size_t match_length = lz::MINMATCH;
+				while (ip + match_length < matchlimit && ip[match_length] == ref[match_length])
+				{
+					match_length++;
+				}
+
+				uint8_t* token = op++;
+				op = lz::write_literals(op, token, anchor, size_t(ip - anchor));
+
+				const uint16_t offset = uint16_t(ip - ref);
+				*op++ = uint8_t(offset & 0xFF);
+				*op++ = uint8_t(offset >> 8);
+
+				const size_t match_code = match_length - lz::MINMATCH;
+				if (match_code >= 15)
+				{
+					*token |= 15;
+					op = lz::write_length(op, match_code - 15);
+				}
+				else
+				{
+					*token |= uint8_t(match_code);
+				}
+
+				ip += match_length;
+				anchor = ip;
+				if (ip < mflimit)
+				{
+					// Register a position inside the match to find repetitions sooner:
+					table[lz::hash(lz::read32(ip - 2))] = uint32_t(ip - 2 - src_data);
+				}
+			}
+		}
+
+		// The remaining bytes are written as a last literal run:
+		uint8_t* token = op++;
+		op = lz::write_literals(op, token, anchor, size_t(iend - anchor));
+
+		const size_t compressed_size = size_t(op - dst_data.data());
+		dst_data.resize(compressed_size);
+		return compressed_size < src_size;
+	}
+
+	bool Decompress(const uint8_t* src_data, size_t src_size, uint8_t* dst_data, size_t dst_size)
+	{
+		const uint8_t* ip = src_data;
+		const uint8_t* iend = src_data + src_size;
+		uint8_t* op = dst_data;
+		uint8_t* oend = dst_data + dst_size;
+
+		while (ip < iend)
+		{
+			const uint8_t token = *ip++;
+
+			size_t literal_length = token >> 4;
+			if (literal_length == 15)
+			{
+				uint8_t b;
+				do
+				{
+					if (ip >= iend)
+						return false;
+					b = *ip++;
+					literal_length += b;
+				} while (b == 255);
+			}
+			if (literal_length > size_t(iend - ip) || literal_length > size_t(oend - op))
+				return false;
+			std::memcpy(op, ip, literal_length);
+			op += literal_length;
+			ip += literal_length;
+
+			if (ip >= iend)
+				break; // last sequence only contains literals
+
+			if (iend - ip < 2)
+				return false;
+			const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+			ip += 2;
+			if (offset == 0 || offset > size_t(op - dst_data))
+				return false;
+
+			size_t match_length = token & 15;
+			if (match_length == 15)
+			{
+				uint8_t b;
+				do
+				{
+					if (ip >= iend)
+						return false;
+					b = *ip++;
+					match_length += b;
+				} while (b == 255);
+			}
+			match_length += lz::MINMATCH;
+			if (match_length > size_t(oend - op))
+				return false;
+
+			const uint8_t* match = op - offset;
+			if (offset >= match_length)
+			{
+				std::memcpy(op, match, match_length);
+				op += match_length;
+			}
+			else
+			{
+				// Overlapping match: the copyable region doubles with every step
+				while (match_length > 0)
+				{
+					const size_t chunk = std::min(match_length, size_t(op - match));
+					std::memcpy(op, match, chunk);
+					op += chunk;
+					match_length -= chunk;
+				}
+			}
+		}
+
+		return op == oend;
+	}
+
+	uint64_t data_hash(const void* data, size_t size, uint64_t seed)
+	{
+		static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+		static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+		static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ull;
+		static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+		static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+		auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+		auto read64 = [](const uint8_t* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+		auto read32 = [](const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; };
+		auto round = [&](uint64_t acc, uint64_t input) { return rotl(acc + input * PRIME2, 31) * PRIME1; };
+		auto merge = [&](uint64_t acc, uint64_t val) { return (acc ^ round(0, val)) * PRIME1 + PRIME4; };
+
+		const uint8_t* p = (const uint8_t*)data;
+		const uint8_t* const end = p + size;
+		uint64_t h;
+
+		if (size >= 32)
+		{
+			uint64_t v1 = seed + PRIME1 + PRIME2;
+			uint64_t v2 = seed + PRIME2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - PRIME1;
+			const uint8_t* const limit = end - 32;
+			do
+			{
+				v1 = round(v1, read64(p)); p += 8;
+				v2 = round(v2, read64(p)); p += 8;
+				v3 = round(v3, read64(p)); p += 8;
+				v4 = round(v4, read64(p)); p += 8;
+			} while (p <= limit);
+			h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+			h = merge(h, v1);
+			h = merge(h, v2);
+			h = merge(h, v3);
+			h = merge(h, v4);
+		}
+		else
+		{
+			h = seed + PRIME5;
+		}
+
+		h += (uint64_t)size;
+
+		while (p + 8 <= end)
+		{
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * PRIME1 + PRIME4;
+			p += 8;
+		}
+		if (p + 4 <= end)
+		{
+			h ^= (uint64_t)read32(p) * PRIME1;
+			h = rotl(h, 23) * PRIME2 + PRIME3;
+			p += 4;
+		}
+		while (p < end)
+		{
+			h ^= (*p) * PRIME5;
+			h = rotl(h, 11) * PRIME1;
+			p++;
+		}
+
+		h ^= h >> 33;
+		h *= PRIME2;
+		h ^= h >> 29;
+		h *= PRIME3;
+		h ^= h >> 32;
+		return h;
+	}
 }
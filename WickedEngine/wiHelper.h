@@ -13,6 +13,11 @@ namespace std
 }
 #endif // WI_VECTOR_TYPE
 
+namespace wi::texturebaker
+{
+	struct BakeParams;
+}
+
 namespace wi::helper
 {
 	template <class T>
@@ -38,6 +43,9 @@ namespace wi::helper
 		return hash;
 	}
 
+	// 64-bit hash of arbitrary data (xxHash64), usable as content hash
+	uint64_t data_hash(const void* data, size_t size, uint64_t seed = 0);
+
 	std::string toUpper(const std::string& s);
 
 	std::string toLower(const std::string& s);
@@ -50,12 +58,20 @@ namespace wi::helper
 	// Save raw pixel data from the texture to memory
 	bool saveTextureToMemory(const wi::graphics::Texture& texture, wi::vector<uint8_t>& texturedata);
 
+	// Save raw pixel data from a READBACK texture that was already copied to and finished on the GPU
+	//	The data layout is the same as with saveTextureToMemory()
+	bool saveStagingTextureToMemory(const wi::graphics::Texture& stagingTex, wi::vector<uint8_t>& texturedata);
+
 	// Save texture to memory as a file format
 	bool saveTextureToMemoryFile(const wi::graphics::Texture& texture, const std::string& fileExtension, wi::vector<uint8_t>& filedata);
 
 	// Save raw texture data to memory as file format
 	bool saveTextureToMemoryFile(const wi::vector<uint8_t>& textureData, const wi::graphics::TextureDesc& desc, const std::string& fileExtension, wi::vector<uint8_t>& filedata);
 
+	// Save raw texture data to memory as file format, after mip generation and block compression on the CPU
+	//	This doesn't need a graphics device, so it can be used for headless asset baking
+	bool saveTextureToMemoryFile(const wi::vector<uint8_t>& textureData, const wi::graphics::TextureDesc& desc, const std::string& fileExtension, wi::vector<uint8_t>& filedata, const wi::texturebaker::BakeParams& params);
+
 	// Save texture to file format
 	bool saveTextureToFile(const wi::graphics::Texture& texture, const std::string& fileName);
 
@@ -100,6 +116,30 @@ namespace wi::helper
 
 	uint64_t FileTimestamp(const std::string& fileName);
 
+	// Package files contain many files in one file with a path index, which reduces file system overhead
+	//	When a package is mounted, FileRead(), FileExists(), FileTimestamp() and wi::resourcemanager::Load() will look into it first
+	//	The package is memory mapped, uncompressed files can be accessed without copying with PackageFileView()
+	//	Paths in the package are case sensitive and relative to the package root directory
+	struct PackageParams
+	{
+		bool compress = true;		// files are compressed when it makes them smaller
+		uint32_t alignment = 16;	// uncompressed files are aligned to this in the package
+	};
+
+	// Writes the files into a package file, the files must be inside the rootdir directory
+	bool PackageCreate(const std::string& packageFileName, const std::string& rootdir, const wi::vector<std::string>& fileNames, const PackageParams& params = {});
+
+	// Mounts a package, the contents will be found as if they were in the mountpoint directory
+	//	mountpoint : if empty, the directory of the package file is used
+	//	The most recently mounted package has priority when multiple packages contain the same file
+	bool PackageMount(const std::string& packageFileName, const std::string& mountpoint = "");
+
+	// Unmounts a package, the file views that were returned from it will be invalid
+	void PackageUnmount(const std::string& packageFileName);
+
+	// Returns a view directly into the memory of a mounted package, only if the file was not compressed in the package
+	bool PackageFileView(const std::string& fileName, const uint8_t*& data, size_t& size);
+
 	std::string GetTempDirectoryPath();
 	std::string GetCacheDirectoryPath();
 	std::string GetCurrentPath();
@@ -170,4 +210,17 @@ namespace wi::helper
 
 	// Returns a good looking memory size string as either bytes, KB, MB or GB
 	std::string GetMemorySizeText(size_t sizeInBytes);
+
+	// Returns the worst case compressed size of the input data for Compress()
+	size_t CompressBound(size_t src_size);
+
+	// Compresses data with a fast LZ-family block codec (LZ4 block format compatible)
+	//	dst_data will be resized to the compressed size
+	//	returns false if the data could not be made smaller, in which case it is better to store it uncompressed
+	bool Compress(const uint8_t* src_data, size_t src_size, wi::vector<uint8_t>& dst_data);
+
+	// Decompresses a block of data that was created by Compress()
+	//	dst_size must be the exact size of the original data
+	//	returns false if the compressed data is corrupt
+	bool Decompress(const uint8_t* src_data, size_t src_size, uint8_t* dst_data, size_t dst_size);
 };
@@ -18,6 +18,7 @@
 #include "wiInput_BindLua.h"
 #include "wiSpriteFont_BindLua.h"
 #include "wiBacklog_BindLua.h"
+#include "wiResourceManager_BindLua.h"
 #include "wiNetwork_BindLua.h"
 #include "wiPrimitive_BindLua.h"
 #include "wiPhysics_BindLua.h"
@@ -198,6 +199,7 @@ namespace wi::lua
 		Input_BindLua::Bind();
 		SpriteFont_BindLua::Bind();
 		backlog::Bind();
+		resourcemanager::Bind();
 		Network_BindLua::Bind();
 		primitive::Bind();
 		Physics_BindLua::Bind();
@@ -275,8 +277,10 @@ namespace wi::lua
 		lua_register(lua_internal().m_luaState, name, function);
 	}
 
+	static double delta_time = 0;
 	void SetDeltaTime(double dt)
 	{
+		delta_time = dt;
 		lua_getglobal(lua_internal().m_luaState, "setDeltaTime");
 		SSetDouble(lua_internal().m_luaState, dt);
 		if(lua_pcall(lua_internal().m_luaState, 1, LUA_MULTRET, 0) != LUA_OK)
@@ -284,6 +288,10 @@ namespace wi::lua
 			PostErrorMsg();
 		}
 	}
+	double GetDeltaTime()
+	{
+		return delta_time;
+	}
 
 	inline void SignalHelper(lua_State* L, const char* str)
 	{
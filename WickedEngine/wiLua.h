@@ -37,6 +37,8 @@ namespace wi::lua
 
 	//set delta time to use with lua
 	void SetDeltaTime(double dt);
+	//get the delta time that was last set with SetDeltaTime()
+	double GetDeltaTime();
 	//update lua scripts which are waiting for a fixed game tick
 	void FixedUpdate();
 	//update lua scripts which are waiting for a game tick
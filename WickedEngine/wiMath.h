@@ -330,6 +330,24 @@ namespace wi::math
 	// Returns an element of a precomputed halton sequence. Specify which iteration to get with idx >= 0
 	const XMFLOAT4& GetHaltonSequence(int idx);
 
+	// Expands a 10-bit integer into 30 bits by inserting 2 zeros after each bit
+	constexpr uint32_t expandBits(uint32_t v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+	// Calculates a 30-bit Morton code for the given 3D point located within the unit cube [0,1]
+	inline uint32_t morton3D(const XMFLOAT3& pos)
+	{
+		const uint32_t xx = expandBits((uint32_t)std::min(std::max(pos.x * 1024, 0.0f), 1023.0f));
+		const uint32_t yy = expandBits((uint32_t)std::min(std::max(pos.y * 1024, 0.0f), 1023.0f));
+		const uint32_t zz = expandBits((uint32_t)std::min(std::max(pos.z * 1024, 0.0f), 1023.0f));
+		return xx * 4 + yy * 2 + zz;
+	}
+
 	inline uint32_t CompressNormal(const XMFLOAT3& normal)
 	{
 		uint32_t retval = 0;
@@ -0,0 +1,318 @@
+#include "wiOcclusionBuffer.h"
+#include "wiJobSystem.h"
+
+#include <algorithm>
+
+using namespace wi::primitive;
+
+namespace wi
+{
+	void OcclusionBuffer::Begin(uint32_t width, uint32_t height, const XMMATRIX& viewProjection)
+	{
+		this->width = std::max(1u, (width + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+		this->height = std::max(1u, (height + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+		block_count_x = this->width / BLOCK_SIZE;
+		block_count_y = this->height / BLOCK_SIZE;
+		tile_count_x = (this->width + TILE_WIDTH - 1) / TILE_WIDTH;
+		tile_count_y = (this->height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+		XMStoreFloat4x4(&this->viewProjection, viewProjection);
+
+		depth.resize(this->width * this->height);
+		std::fill(depth.begin(), depth.end(), 0.0f);
+		blocks.resize(block_count_x * block_count_y);
+		std::fill(blocks.begin(), blocks.end(), 0.0f);
+		triangles.clear();
+		tile_bins.resize(tile_count_x * tile_count_y);
+		for (auto& bin : tile_bins)
+		{
+			bin.clear();
+		}
+	}
+
+	void OcclusionBuffer::AddOccluder(const XMFLOAT3* positions, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const XMMATRIX& world)
+	{
+		const XMMATRIX M = world * XMLoadFloat4x4(&viewProjection);
+		clip_positions.resize(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; ++i)
+		{
+			XMStoreFloat4(&clip_positions[i], XMVector3Transform(XMLoadFloat3(&positions[i]), M));
+		}
+
+		for (uint32_t i = 0; i + 2 < index_count; i += 3)
+		{
+			const XMFLOAT4 v[3] = {
+				clip_positions[indices[i + 0]],
+				clip_positions[indices[i + 1]],
+				clip_positions[indices[i + 2]],
+			};
+
+			// Distances to the near plane, which is z == w with reversed Z (behind the camera w < z too):
+			const float d[3] = {
+				v[0].w - v[0].z,
+				v[1].w - v[1].z,
+				v[2].w - v[2].z,
+			};
+			if (d[0] >= 0 && d[1] >= 0 && d[2] >= 0)
+			{
+				AddTriangle(v[0], v[1], v[2]);
+				continue;
+			}
+			if (d[0] < 0 && d[1] < 0 && d[2] < 0)
+				continue;
+
+			// Clip the triangle by the near plane, this results in a polygon of 3 or 4 vertices:
+			XMFLOAT4 polygon[4];
+			uint32_t polygon_count = 0;
+			for (int j = 0; j < 3; ++j)
+			{
+				const int k = (j + 1) % 3;
+				if (d[j] >= 0)
+				{
+					polygon[polygon_count++] = v[j];
+				}
+				if ((d[j] >= 0) != (d[k] >= 0))
+				{
+					const float t = d[j] / (d[j] - d[k]);
+					XMStoreFloat4(&polygon[polygon_count++], XMVectorLerp(XMLoadFloat4(&v[j]), XMLoadFloat4(&v[k]), t));
+				}
+			}
+			for (uint32_t j = 2; j < polygon_count; ++j)
+			{
+				AddTriangle(polygon[0], polygon[j - 1], polygon[j]);
+			}
+		}
+	}
+
+	void OcclusionBuffer::AddTriangle(const XMFLOAT4& c0, const XMFLOAT4& c1, const XMFLOAT4& c2)
+	{
+		auto project = [&](const XMFLOAT4& c) {
+			const float rcp = 1.0f / c.w;
+			return XMFLOAT3(
+				(c.x * rcp * 0.5f + 0.5f) * width,
+				(0.5f - c.y * rcp * 0.5f) * height,
+				c.z * rcp
+			);
+		};
+		Triangle triangle;
+		triangle.p0 = project(c0);
+		triangle.p1 = project(c1);
+		triangle.p2 = project(c2);
+
+		const float area = (triangle.p1.x - triangle.p0.x) * (triangle.p2.y - triangle.p0.y) - (triangle.p1.y - triangle.p0.y) * (triangle.p2.x - triangle.p0.x);
+		if (std::abs(area) < 1e-6f || !std::isfinite(area))
+			return;
+		if (area < 0)
+		{
+			// Both faces are rasterized, the winding is made consistent for the edge functions:
+			std::swap(triangle.p1, triangle.p2);
+		}
+
+		// Pixels are sampled at their centers, the range of pixel centers that the triangle bounds contain is computed:
+		const float min_x = std::min(triangle.p0.x, std::min(triangle.p1.x, triangle.p2.x));
+		const float min_y = std::min(triangle.p0.y, std::min(triangle.p1.y, triangle.p2.y));
+		const float max_x = std::max(triangle.p0.x, std::max(triangle.p1.x, triangle.p2.x));
+		const float max_y = std::max(triangle.p0.y, std::max(triangle.p1.y, triangle.p2.y));
+		if (max_x < 0.5f || max_y < 0.5f || min_x > width - 0.5f || min_y > height - 0.5f)
+			return;
+		const int px0 = (int)std::ceil(std::max(0.0f, min_x) - 0.5f);
+		const int py0 = (int)std::ceil(std::max(0.0f, min_y) - 0.5f);
+		const int px1 = (int)std::floor(std::min(float(width), max_x) - 0.5f);
+		const int py1 = (int)std::floor(std::min(float(height), max_y) - 0.5f);
+		if (px0 > px1 || py0 > py1)
+			return;
+
+		const uint32_t index = (uint32_t)triangles.size();
+		triangles.push_back(triangle);
+		for (uint32_t tile_y = uint32_t(py0) / TILE_HEIGHT; tile_y <= uint32_t(py1) / TILE_HEIGHT; ++tile_y)
+		{
+			for (uint32_t tile_x = uint32_t(px0) / TILE_WIDTH; tile_x <= uint32_t(px1) / TILE_WIDTH; ++tile_x)
+			{
+				tile_bins[tile_x + tile_y * tile_count_x].push_back(index);
+			}
+		}
+	}
+
+	void OcclusionBuffer::Rasterize()
+	{
+		// Tiles don't share pixels or blocks, so they are processed independently:
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, tile_count_x * tile_count_y, 1, [&](wi::jobsystem::JobArgs args) {
+			RasterizeTile(args.jobIndex % tile_count_x, args.jobIndex / tile_count_x);
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	void OcclusionBuffer::RasterizeTile(uint32_t tile_x, uint32_t tile_y)
+	{
+		const int tile_x0 = int(tile_x * TILE_WIDTH);
+		const int tile_y0 = int(tile_y * TILE_HEIGHT);
+		const int tile_x1 = std::min(int(width), tile_x0 + int(TILE_WIDTH));
+		const int tile_y1 = std::min(int(height), tile_y0 + int(TILE_HEIGHT));
+		const XMVECTOR pixel_offsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+		const XMVECTOR four = XMVectorReplicate(4.0f);
+		const XMVECTOR zero = XMVectorZero();
+
+		for (uint32_t index : tile_bins[tile_x + tile_y * tile_count_x])
+		{
+			const Triangle& triangle = triangles[index];
+			const XMFLOAT3& p0 = triangle.p0;
+			const XMFLOAT3& p1 = triangle.p1;
+			const XMFLOAT3& p2 = triangle.p2;
+
+			// Edge functions: e(x, y) = a * x + b * y + c, all three are positive inside the triangle
+			const float a0 = p0.y - p1.y, b0 = p1.x - p0.x, c0 = (p1.y - p0.y) * p0.x - (p1.x - p0.x) * p0.y;
+			const float a1 = p1.y - p2.y, b1 = p2.x - p1.x, c1 = (p2.y - p1.y) * p1.x - (p2.x - p1.x) * p1.y;
+			const float a2 = p2.y - p0.y, b2 = p0.x - p2.x, c2 = (p0.y - p2.y) * p2.x - (p0.x - p2.x) * p2.y;
+
+			// Depth plane: z(x, y) = p0.z + dzdx * (x - p0.x) + dzdy * (y - p0.y)
+			const float e1x = p1.x - p0.x, e1y = p1.y - p0.y, dz1 = p1.z - p0.z;
+			const float e2x = p2.x - p0.x, e2y = p2.y - p0.y, dz2 = p2.z - p0.z;
+			const float area_rcp = 1.0f / (e1x * e2y - e1y * e2x);
+			const float dzdx = (dz1 * e2y - dz2 * e1y) * area_rcp;
+			const float dzdy = (dz2 * e1x - dz1 * e2x) * area_rcp;
+
+			const float min_x = std::min(p0.x, std::min(p1.x, p2.x));
+			const float min_y = std::min(p0.y, std::min(p1.y, p2.y));
+			const float max_x = std::max(p0.x, std::max(p1.x, p2.x));
+			const float max_y = std::max(p0.y, std::max(p1.y, p2.y));
+			const int px0 = std::max(tile_x0, (int)std::ceil(std::max(0.0f, min_x) - 0.5f)) & ~3; // aligned to SIMD width
+			const int py0 = std::max(tile_y0, (int)std::ceil(std::max(0.0f, min_y) - 0.5f));
+			const int px1 = std::min(tile_x1 - 1, (int)std::floor(std::min(float(width), max_x) - 0.5f));
+			const int py1 = std::min(tile_y1 - 1, (int)std::floor(std::min(float(height), max_y) - 0.5f));
+
+			const XMVECTOR A0 = XMVectorReplicate(a0);
+			const XMVECTOR A1 = XMVectorReplicate(a1);
+			const XMVECTOR A2 = XMVectorReplicate(a2);
+			const XMVECTOR DZDX = XMVectorReplicate(dzdx);
+			for (int y = py0; y <= py1; ++y)
+			{
+				const float py = y + 0.5f;
+				const XMVECTOR row0 = XMVectorReplicate(b0 * py + c0);
+				const XMVECTOR row1 = XMVectorReplicate(b1 * py + c1);
+				const XMVECTOR row2 = XMVectorReplicate(b2 * py + c2);
+				const XMVECTOR row_depth = XMVectorReplicate(p0.z + dzdy * (py - p0.y) - dzdx * p0.x);
+				XMVECTOR px = XMVectorAdd(XMVectorReplicate(float(px0)), pixel_offsets);
+				float* row = depth.data() + y * width;
+				for (int x = px0; x <= px1; x += 4)
+				{
+					// Four pixels are tested and written at once, the written depth is the closest of the occluders:
+					const XMVECTOR e0 = XMVectorMultiplyAdd(A0, px, row0);
+					const XMVECTOR e1 = XMVectorMultiplyAdd(A1, px, row1);
+					const XMVECTOR e2 = XMVectorMultiplyAdd(A2, px, row2);
+					const XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero), XMVectorAndInt(XMVectorGreaterOrEqual(e1, zero), XMVectorGreaterOrEqual(e2, zero)));
+					const XMVECTOR z = XMVectorMultiplyAdd(DZDX, px, row_depth);
+					const XMVECTOR d = XMLoadFloat4((const XMFLOAT4*)(row + x));
+					XMStoreFloat4((XMFLOAT4*)(row + x), XMVectorSelect(d, XMVectorMax(d, z), inside));
+					px = XMVectorAdd(px, four);
+				}
+			}
+		}
+
+		// Build the hierarchical level of the tile, the blocks store the farthest depth of their pixels:
+		for (int block_y = tile_y0 / int(BLOCK_SIZE); block_y < tile_y1 / int(BLOCK_SIZE); ++block_y)
+		{
+			for (int block_x = tile_x0 / int(BLOCK_SIZE); block_x < tile_x1 / int(BLOCK_SIZE); ++block_x)
+			{
+				XMVECTOR farthest = XMVectorReplicate(std::numeric_limits<float>::max());
+				for (uint32_t y = 0; y < BLOCK_SIZE; ++y)
+				{
+					const float* row = depth.data() + (block_y * BLOCK_SIZE + y) * width + block_x * BLOCK_SIZE;
+					farthest = XMVectorMin(farthest, XMVectorMin(XMLoadFloat4((const XMFLOAT4*)row), XMLoadFloat4((const XMFLOAT4*)(row + 4))));
+				}
+				farthest = XMVectorMin(farthest, XMVectorSwizzle<2, 3, 0, 1>(farthest));
+				farthest = XMVectorMin(farthest, XMVectorSwizzle<1, 0, 3, 2>(farthest));
+				blocks[block_x + block_y * block_count_x] = XMVectorGetX(farthest);
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const AABB& aabb) const
+	{
+		if (width == 0 || height == 0 || triangles.empty() || !aabb.IsValid())
+			return true;
+
+		// The screen rectangle and closest depth of the box is computed from its projected corners
+		//	The eight corners are transformed in two batches of four, in SoA layout:
+		const XMVECTOR corner_x = XMVectorSet(aabb._min.x, aabb._max.x, aabb._min.x, aabb._max.x);
+		const XMVECTOR corner_y = XMVectorSet(aabb._min.y, aabb._min.y, aabb._max.y, aabb._max.y);
+		const XMVECTOR corner_z[] = { XMVectorReplicate(aabb._min.z), XMVectorReplicate(aabb._max.z) };
+		const XMVECTOR half = XMVectorReplicate(0.5f);
+		const XMVECTOR screen_width = XMVectorReplicate(float(width));
+		const XMVECTOR screen_height = XMVectorReplicate(float(height));
+		XMVECTOR screen_min_x = XMVectorReplicate(std::numeric_limits<float>::max());
+		XMVECTOR screen_min_y = screen_min_x;
+		XMVECTOR screen_max_x = XMVectorReplicate(std::numeric_limits<float>::lowest());
+		XMVECTOR screen_max_y = screen_max_x;
+		XMVECTOR screen_closest = XMVectorZero();
+		for (auto& z : corner_z)
+		{
+			auto transform = [&](int column) {
+				return XMVectorMultiplyAdd(corner_x, XMVectorReplicate(viewProjection.m[0][column]),
+					XMVectorMultiplyAdd(corner_y, XMVectorReplicate(viewProjection.m[1][column]),
+						XMVectorMultiplyAdd(z, XMVectorReplicate(viewProjection.m[2][column]), XMVectorReplicate(viewProjection.m[3][column]))));
+			};
+			const XMVECTOR clip_x = transform(0);
+			const XMVECTOR clip_y = transform(1);
+			const XMVECTOR clip_z = transform(2);
+			const XMVECTOR clip_w = transform(3);
+			if (!XMVector4LessOrEqual(clip_z, clip_w) || !XMVector4Greater(clip_w, XMVectorZero()))
+				return true; // intersects near plane or behind camera
+			const XMVECTOR rcp = XMVectorReciprocal(clip_w);
+			const XMVECTOR x = XMVectorMultiply(XMVectorMultiplyAdd(XMVectorMultiply(clip_x, rcp), half, half), screen_width);
+			const XMVECTOR y = XMVectorMultiply(XMVectorNegativeMultiplySubtract(XMVectorMultiply(clip_y, rcp), half, half), screen_height);
+			screen_min_x = XMVectorMin(screen_min_x, x);
+			screen_min_y = XMVectorMin(screen_min_y, y);
+			screen_max_x = XMVectorMax(screen_max_x, x);
+			screen_max_y = XMVectorMax(screen_max_y, y);
+			screen_closest = XMVectorMax(screen_closest, XMVectorMultiply(clip_z, rcp));
+		}
+		// Horizontal reduction of the four lanes:
+		auto reduce_min = [](XMVECTOR v) {
+			v = XMVectorMin(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+			return XMVectorGetX(XMVectorMin(v, XMVectorSwizzle<1, 0, 3, 2>(v)));
+		};
+		auto reduce_max = [](XMVECTOR v) {
+			v = XMVectorMax(v, XMVectorSwizzle<2, 3, 0, 1>(v));
+			return XMVectorGetX(XMVectorMax(v, XMVectorSwizzle<1, 0, 3, 2>(v)));
+		};
+		const float min_x = reduce_min(screen_min_x);
+		const float min_y = reduce_min(screen_min_y);
+		const float max_x = reduce_max(screen_max_x);
+		const float max_y = reduce_max(screen_max_y);
+		const float closest = reduce_max(screen_closest);
+		if (max_x < 0 || max_y < 0 || min_x >= width || min_y >= height)
+			return true;
+
+		// Every pixel that the rectangle touches must be covered by a closer occluder
+		//	Occluders are sampled at pixel centers, so they can cover up to one pixel more than their real silhouette,
+		//	this is compensated by extending the rectangle by one pixel:
+		const int px0 = (int)std::max(0.0f, min_x - 1);
+		const int py0 = (int)std::max(0.0f, min_y - 1);
+		const int px1 = (int)std::min(float(width - 1), max_x + 1);
+		const int py1 = (int)std::min(float(height - 1), max_y + 1);
+		for (int block_y = py0 / int(BLOCK_SIZE); block_y <= py1 / int(BLOCK_SIZE); ++block_y)
+		{
+			for (int block_x = px0 / int(BLOCK_SIZE); block_x <= px1 / int(BLOCK_SIZE); ++block_x)
+			{
+				if (blocks[block_x + block_y * block_count_x] > closest)
+					continue; // the whole block is closer than the box
+
+				// Partially covered block, the pixels that the rectangle touches are tested:
+				const int x0 = std::max(px0, block_x * int(BLOCK_SIZE));
+				const int y0 = std::max(py0, block_y * int(BLOCK_SIZE));
+				const int x1 = std::min(px1, block_x * int(BLOCK_SIZE) + int(BLOCK_SIZE) - 1);
+				const int y1 = std::min(py1, block_y * int(BLOCK_SIZE) + int(BLOCK_SIZE) - 1);
+				for (int y = y0; y <= y1; ++y)
+				{
+					const float* row = depth.data() + y * width;
+					for (int x = x0; x <= x1; ++x)
+					{
+						if (row[x] <= closest)
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiPrimitive.h"
+#include "wiVector.h"
+
+namespace wi
+{
+	// Coarse software depth buffer for CPU occlusion culling
+	//	Occluder triangles are rasterized with SIMD into a low resolution depth buffer, screen tiles are rasterized in parallel
+	//	A hierarchical level stores the farthest depth of every 8x8 pixel block, so most bounding boxes are tested with a few reads
+	//	Depth is stored in reversed Z convention (1: near, 0: far or empty), so the view projection must be reversed Z too, like in CameraComponent
+	//	Usage: Begin(), AddOccluder() for every occluder (not thread safe), Rasterize(), then IsVisible() can be called from multiple threads
+	struct OcclusionBuffer
+	{
+		static constexpr uint32_t BLOCK_SIZE = 8;	// pixel size of the hierarchical level blocks
+		static constexpr uint32_t TILE_WIDTH = 64;	// pixel size of the tiles that are rasterized in parallel
+		static constexpr uint32_t TILE_HEIGHT = 32;
+
+		// Screen space triangle after clipping and projection:
+		struct Triangle
+		{
+			XMFLOAT3 p0, p1, p2; // pixel x, pixel y, depth
+		};
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t block_count_x = 0;
+		uint32_t block_count_y = 0;
+		uint32_t tile_count_x = 0;
+		uint32_t tile_count_y = 0;
+		XMFLOAT4X4 viewProjection = wi::math::IDENTITY_MATRIX;
+		wi::vector<float> depth;	// per pixel depth
+		wi::vector<float> blocks;	// farthest depth of each pixel block
+		wi::vector<Triangle> triangles;
+		wi::vector<wi::vector<uint32_t>> tile_bins; // triangle indices per tile
+		wi::vector<XMFLOAT4> clip_positions; // scratch for AddOccluder()
+
+		// Clears the buffer, width and height are rounded up to multiples of BLOCK_SIZE
+		void Begin(uint32_t width, uint32_t height, const XMMATRIX& viewProjection);
+		// Adds an indexed triangle list as occluder, positions are transformed by the world matrix
+		//	Triangles are clipped by the near plane, both faces are rasterized
+		void AddOccluder(const XMFLOAT3* positions, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const XMMATRIX& world);
+		// Rasterizes the occluder triangles in parallel tiles, then builds the hierarchical level
+		void Rasterize();
+
+		// Returns false if the box is completely hidden behind the rasterized occluders
+		//	Boxes that intersect the near plane or are outside the screen are reported as visible
+		bool IsVisible(const wi::primitive::AABB& aabb) const;
+
+		uint32_t GetTriangleCount() const { return (uint32_t)triangles.size(); }
+
+		void AddTriangle(const XMFLOAT4& c0, const XMFLOAT4& c1, const XMFLOAT4& c2);
+		void RasterizeTile(uint32_t tile_x, uint32_t tile_y);
+	};
+}
@@ -189,6 +189,10 @@ namespace wi::primitive
 		bool intersection = frustum.Intersects(bb);
 		return intersection;
 	}
+	bool AABB::intersects(const Frustum& frustum) const
+	{
+		return frustum.CheckBoxFast(*this);
+	}
 	AABB AABB::operator* (float a)
 	{
 		XMFLOAT3 min = getMin();
@@ -231,6 +235,42 @@ namespace wi::primitive
 		}
 	}
 
+	void AABBStream::resize(size_t count)
+	{
+		const size_t padded_count = (count + 3) & ~size_t(3);
+		min_x.resize(padded_count, std::numeric_limits<float>::max());
+		min_y.resize(padded_count, std::numeric_limits<float>::max());
+		min_z.resize(padded_count, std::numeric_limits<float>::max());
+		max_x.resize(padded_count, std::numeric_limits<float>::lowest());
+		max_y.resize(padded_count, std::numeric_limits<float>::lowest());
+		max_z.resize(padded_count, std::numeric_limits<float>::lowest());
+		layerMask.resize(padded_count, 0);
+		for (size_t i = count; i < std::min(this->count, padded_count); ++i)
+		{
+			set(i, AABB());
+			layerMask[i] = 0;
+		}
+		this->count = count;
+	}
+	void AABBStream::set(size_t index, const AABB& aabb)
+	{
+		min_x[index] = aabb._min.x;
+		min_y[index] = aabb._min.y;
+		min_z[index] = aabb._min.z;
+		max_x[index] = aabb._max.x;
+		max_y[index] = aabb._max.y;
+		max_z[index] = aabb._max.z;
+		layerMask[index] = aabb.layerMask;
+	}
+	void AABBStream::set(const AABB* aabbs, size_t count)
+	{
+		resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			set(i, aabbs[i]);
+		}
+	}
+
 
 
 
@@ -859,6 +899,68 @@ namespace wi::primitive
 		return true;
 	}
 
+	uint32_t Frustum::CheckBoxes(const AABBStream& boxes, uint32_t offset, uint32_t count, uint32_t layerMask, uint32_t* result) const
+	{
+		assert((offset % 4) == 0);
+		assert(offset + count <= boxes.size());
+
+		// The planes are splatted once, and the box corner that is furthest along each plane normal is selected per plane
+		//	up front, because the plane signs are the same for all boxes:
+		XMVECTOR plane_x[6];
+		XMVECTOR plane_y[6];
+		XMVECTOR plane_z[6];
+		XMVECTOR plane_w[6];
+		const float* corner_x[6];
+		const float* corner_y[6];
+		const float* corner_z[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			plane_x[p] = XMVectorReplicate(planes[p].x);
+			plane_y[p] = XMVectorReplicate(planes[p].y);
+			plane_z[p] = XMVectorReplicate(planes[p].z);
+			plane_w[p] = XMVectorReplicate(planes[p].w);
+			corner_x[p] = planes[p].x < 0 ? boxes.min_x.data() : boxes.max_x.data();
+			corner_y[p] = planes[p].y < 0 ? boxes.min_y.data() : boxes.max_y.data();
+			corner_z[p] = planes[p].z < 0 ? boxes.min_z.data() : boxes.max_z.data();
+		}
+		const XMVECTOR layer = XMVectorReplicateInt(layerMask);
+		const XMVECTOR zero = XMVectorZero();
+
+		uint32_t visible_count = 0;
+		const uint32_t end = offset + count;
+		for (uint32_t i = offset; i < end; i += 4)
+		{
+			// Empty boxes are culled like in CheckBoxFast(), padding boxes are culled by their zero layerMask:
+			XMVECTOR visible = XMVectorAndInt(
+				XMVectorLessOrEqual(XMLoadFloat4((const XMFLOAT4*)(boxes.min_x.data() + i)), XMLoadFloat4((const XMFLOAT4*)(boxes.max_x.data() + i))),
+				XMVectorAndInt(
+					XMVectorLessOrEqual(XMLoadFloat4((const XMFLOAT4*)(boxes.min_y.data() + i)), XMLoadFloat4((const XMFLOAT4*)(boxes.max_y.data() + i))),
+					XMVectorLessOrEqual(XMLoadFloat4((const XMFLOAT4*)(boxes.min_z.data() + i)), XMLoadFloat4((const XMFLOAT4*)(boxes.max_z.data() + i)))
+				)
+			);
+			visible = XMVectorAndCInt(visible, XMVectorEqualInt(XMVectorAndInt(XMLoadInt4((const uint32_t*)(boxes.layerMask.data() + i)), layer), zero));
+
+			for (int p = 0; p < 6; ++p)
+			{
+				XMVECTOR dist = XMVectorMultiplyAdd(plane_x[p], XMLoadFloat4((const XMFLOAT4*)(corner_x[p] + i)), plane_w[p]);
+				dist = XMVectorMultiplyAdd(plane_y[p], XMLoadFloat4((const XMFLOAT4*)(corner_y[p] + i)), dist);
+				dist = XMVectorMultiplyAdd(plane_z[p], XMLoadFloat4((const XMFLOAT4*)(corner_z[p] + i)), dist);
+				visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(dist, zero));
+			}
+
+			// Branchless compaction, the index is always written but only kept when visible:
+			uint32_t mask[4];
+			XMStoreInt4(mask, visible);
+			const uint32_t lanes = std::min(4u, end - i);
+			for (uint32_t lane = 0; lane < lanes; ++lane)
+			{
+				result[visible_count] = i + lane;
+				visible_count += mask[lane] & 1u;
+			}
+		}
+		return visible_count;
+	}
+
 	const XMFLOAT4& Frustum::getNearPlane() const { return planes[0]; }
 	const XMFLOAT4& Frustum::getFarPlane() const { return planes[1]; }
 	const XMFLOAT4& Frustum::getLeftPlane() const { return planes[2]; }
@@ -14,6 +14,7 @@ namespace wi::primitive
 	struct AABB;
 	struct Capsule;
 	struct Plane;
+	struct Frustum;
 
 	struct AABB
 	{
@@ -48,6 +49,7 @@ namespace wi::primitive
 		bool intersects(const Ray& ray) const;
 		bool intersects(const Sphere& sphere) const;
 		bool intersects(const BoundingFrustum& frustum) const;
+		bool intersects(const Frustum& frustum) const;
 		AABB operator* (float a);
 		static AABB Merge(const AABB& a, const AABB& b);
 
@@ -78,6 +80,28 @@ namespace wi::primitive
 
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
+
+	// AABBs in structure of arrays layout for SIMD processing of four boxes at once:
+	//	The arrays are padded to a multiple of 4 with empty boxes that have zero layerMask
+	struct AABBStream
+	{
+		wi::vector<float> min_x;
+		wi::vector<float> min_y;
+		wi::vector<float> min_z;
+		wi::vector<float> max_x;
+		wi::vector<float> max_y;
+		wi::vector<float> max_z;
+		wi::vector<uint32_t> layerMask;
+		size_t count = 0;
+
+		// Resizes the stream, new boxes are empty:
+		void resize(size_t count);
+		// Writes a box, it is thread safe for different indices:
+		void set(size_t index, const AABB& aabb);
+		// Resizes the stream and copies all boxes:
+		void set(const AABB* aabbs, size_t count);
+		constexpr size_t size() const { return count; }
+	};
 	struct Sphere
 	{
 		XMFLOAT3 center;
@@ -216,6 +240,11 @@ namespace wi::primitive
 		};
 		BoxFrustumIntersect CheckBox(const AABB& box) const;
 		bool CheckBoxFast(const AABB& box) const;
+		// Tests the boxes of an AABBStream in the range [offset, offset + count) like CheckBoxFast(), four boxes at a time
+		//	The indices of visible boxes with matching layerMask are written to result, which must have room for count indices
+		//	offset must be a multiple of 4
+		//	returns the number of visible boxes
+		uint32_t CheckBoxes(const AABBStream& boxes, uint32_t offset, uint32_t count, uint32_t layerMask, uint32_t* result) const;
 
 		const XMFLOAT4& getNearPlane() const;
 		const XMFLOAT4& getFarPlane() const;
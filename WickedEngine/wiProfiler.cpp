@@ -9,6 +9,7 @@
 #include "wiBacklog.h"
 #include "wiRenderer.h"
 #include "wiEventHandler.h"
+#include "wiResourceManager.h"
 
 #if __has_include("Superluminal/PerformanceAPI_capi.h")
 #include "Superluminal/PerformanceAPI_capi.h"
@@ -389,6 +390,40 @@ namespace wi::profiler
 			x.second.total_time = 0;
 		}
 
+		// Print resource memory usage:
+		{
+			const wi::resourcemanager::MemoryUsage resource_memory = wi::resourcemanager::GetMemoryUsage();
+			auto print_stats = [&](const char* name, const wi::resourcemanager::MemoryStats& stats) {
+				ss << name << " (" << stats.count << "x): CPU: " << std::fixed << double(stats.cpu_bytes) / (1024.0 * 1024.0) << " MB, GPU: " << std::fixed << double(stats.gpu_bytes) / (1024.0 * 1024.0) << " MB" << std::endl;
+			};
+			static const char* type_names[] = {
+				"\tImages",
+				"\tSounds",
+				"\tScripts",
+				"\tVideos",
+				"\tFont styles",
+			};
+			static_assert(arraysize(type_names) == size_t(wi::resourcemanager::DataType::COUNT));
+			ss << std::endl;
+			print_stats("Resources", resource_memory.total);
+			for (size_t i = 0; i < arraysize(type_names); ++i)
+			{
+				if (resource_memory.types[i].count > 0)
+				{
+					print_stats(type_names[i], resource_memory.types[i]);
+				}
+			}
+			if (resource_memory.total.filedata_bytes > 0)
+			{
+				ss << "\tFile data: " << std::fixed << double(resource_memory.total.filedata_bytes) / (1024.0 * 1024.0) << " MB" << std::endl;
+			}
+			if (resource_memory.retained.count > 0)
+			{
+				print_stats("\tRetain cache", resource_memory.retained);
+			}
+			ss << "\tBudget: " << std::fixed << double(wi::resourcemanager::GetMemoryBudget()) / (1024.0 * 1024.0) << " MB" << std::endl;
+		}
+
 		wi::font::Params params = wi::font::Params(x, y + graph_size.y + graph_padding_y, wi::font::WIFONTSIZE_DEFAULT - 4, wi::font::WIFALIGN_LEFT, wi::font::WIFALIGN_TOP, text_color);
 
 		// Background:
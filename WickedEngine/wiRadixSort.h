@@ -0,0 +1,135 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiVector.h"
+#include "wiJobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wi
+{
+	// LSD radix sort of items by 64-bit keys, with 8-bit digits
+	//	items		: array of items to sort in place, the result is ordered by ascending key
+	//	count		: number of items
+	//	scratch		: reusable buffer, it is resized to the item count
+	//	get_key		: function that returns the uint64_t key of an item, it is called multiple times for each item, so it should be cheap
+	//	The sort is stable. Digits that are the same for every key are skipped, so keys using only part of their 64 bits are sorted faster
+	//	Very large arrays are sorted with multiple threads of the job system
+	template<typename T, typename F>
+	void RadixSort(T* items, size_t count, wi::vector<T>& scratch, F get_key)
+	{
+		static constexpr size_t INSERTION_SORT_THRESHOLD = 64;	// smaller arrays are sorted with insertion sort
+		static constexpr size_t PARALLEL_THRESHOLD = 65536;		// larger arrays are sorted in parallel
+		static constexpr size_t PARALLEL_CHUNK_SIZE = 16384;	// items per job in the parallel sort
+		static constexpr uint32_t DIGIT_COUNT = 8;
+		static constexpr uint32_t BUCKET_COUNT = 256;
+
+		if (count < 2)
+			return;
+		if (count <= INSERTION_SORT_THRESHOLD)
+		{
+			for (size_t i = 1; i < count; ++i)
+			{
+				T item = std::move(items[i]);
+				const uint64_t key = get_key(item);
+				size_t j = i;
+				for (; j > 0 && key < get_key(items[j - 1]); --j)
+				{
+					items[j] = std::move(items[j - 1]);
+				}
+				items[j] = std::move(item);
+			}
+			return;
+		}
+
+		// Histograms of every digit are computed in one pass:
+		uint32_t histograms[DIGIT_COUNT][BUCKET_COUNT];
+		std::memset(histograms, 0, sizeof(histograms));
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = get_key(items[i]);
+			for (uint32_t digit = 0; digit < DIGIT_COUNT; ++digit)
+			{
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(count);
+		T* src = items;
+		T* dst = scratch.data();
+
+		const uint32_t chunk_count = count >= PARALLEL_THRESHOLD && wi::jobsystem::GetThreadCount() > 1 ? uint32_t((count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE) : 1;
+		wi::vector<uint32_t> chunk_offsets(chunk_count > 1 ? chunk_count * BUCKET_COUNT : 0);
+
+		for (uint32_t digit = 0; digit < DIGIT_COUNT; ++digit)
+		{
+			const uint32_t shift = digit * 8;
+			const uint32_t* histogram = histograms[digit];
+			if (histogram[(get_key(src[0]) >> shift) & 0xFF] == count)
+				continue; // every key has the same digit here, the pass would not change the order
+
+			if (chunk_count == 1)
+			{
+				uint32_t offsets[BUCKET_COUNT];
+				uint32_t offset = 0;
+				for (uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+				{
+					offsets[bucket] = offset;
+					offset += histogram[bucket];
+				}
+				for (size_t i = 0; i < count; ++i)
+				{
+					const uint32_t bucket = (get_key(src[i]) >> shift) & 0xFF;
+					dst[offsets[bucket]++] = std::move(src[i]);
+				}
+			}
+			else
+			{
+				// Every chunk counts its own digits, then the chunks write into their own ranges of each bucket in order, so the sort remains stable:
+				wi::jobsystem::context ctx;
+				wi::jobsystem::Dispatch(ctx, chunk_count, 1, [&](wi::jobsystem::JobArgs args) {
+					uint32_t* chunk_histogram = chunk_offsets.data() + args.jobIndex * BUCKET_COUNT;
+					std::memset(chunk_histogram, 0, sizeof(uint32_t) * BUCKET_COUNT);
+					const size_t begin = args.jobIndex * PARALLEL_CHUNK_SIZE;
+					const size_t end = std::min(count, begin + PARALLEL_CHUNK_SIZE);
+					for (size_t i = begin; i < end; ++i)
+					{
+						chunk_histogram[(get_key(src[i]) >> shift) & 0xFF]++;
+					}
+				});
+				wi::jobsystem::Wait(ctx);
+
+				uint32_t offset = 0;
+				for (uint32_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+				{
+					for (uint32_t chunk = 0; chunk < chunk_count; ++chunk)
+					{
+						uint32_t& chunk_offset = chunk_offsets[chunk * BUCKET_COUNT + bucket];
+						const uint32_t chunk_bucket_count = chunk_offset;
+						chunk_offset = offset;
+						offset += chunk_bucket_count;
+					}
+				}
+
+				wi::jobsystem::Dispatch(ctx, chunk_count, 1, [&](wi::jobsystem::JobArgs args) {
+					uint32_t* offsets = chunk_offsets.data() + args.jobIndex * BUCKET_COUNT;
+					const size_t begin = args.jobIndex * PARALLEL_CHUNK_SIZE;
+					const size_t end = std::min(count, begin + PARALLEL_CHUNK_SIZE);
+					for (size_t i = begin; i < end; ++i)
+					{
+						const uint32_t bucket = (get_key(src[i]) >> shift) & 0xFF;
+						dst[offsets[bucket]++] = std::move(src[i]);
+					}
+				});
+				wi::jobsystem::Wait(ctx);
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != items)
+		{
+			// Odd number of passes were made, the result is in the scratch buffer:
+			std::move(src, src + count, items);
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiMath.h"
+#include "wiVector.h"
+#include "wiRadixSort.h"
+
+// The render queue of the renderer, it is in a header so that the sorting can be tested and benchmarked outside of it
+namespace wi::renderer
+{
+	// Direct reference to a renderable instance:
+	struct RenderBatch
+	{
+		uint32_t meshIndex;
+		uint32_t instanceIndex;
+		uint16_t distance;
+		uint16_t camera_mask;
+		uint32_t sort_bits; // an additional bitmask for sorting only, it should be used to reduce pipeline changes
+
+		inline void Create(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint32_t sort_bits, uint16_t camera_mask = 0xFFFF)
+		{
+			this->meshIndex = meshIndex;
+			this->instanceIndex = instanceIndex;
+			this->distance = XMConvertFloatToHalf(distance);
+			this->sort_bits = sort_bits;
+			this->camera_mask = camera_mask;
+		}
+
+		inline float GetDistance() const
+		{
+			return XMConvertHalfToFloat(HALF(distance));
+		}
+		constexpr uint32_t GetMeshIndex() const
+		{
+			return meshIndex;
+		}
+		constexpr uint32_t GetInstanceIndex() const
+		{
+			return instanceIndex;
+		}
+
+		// opaque sorting
+		//	Priority is set to mesh index to have more instancing
+		//	distance is second priority (front to back Z-buffering)
+		constexpr uint64_t GetOpaqueSortKey() const
+		{
+			// The order of members is important here, it means the sort priority (low to high)!
+			return uint64_t(distance) | (uint64_t(meshIndex & 0xFFFF) << 16ull) | (uint64_t(sort_bits) << 32ull);
+		}
+		constexpr bool operator<(const RenderBatch& other) const
+		{
+			return GetOpaqueSortKey() < other.GetOpaqueSortKey();
+		}
+		// transparent sorting
+		//	Priority is distance for correct alpha blending (back to front rendering)
+		//	mesh index is second priority for instancing
+		constexpr uint64_t GetTransparentSortKey() const
+		{
+			// The order of members is important here, it means the sort priority (low to high)!
+			return uint64_t(meshIndex & 0xFFFF) | (uint64_t(sort_bits) << 16ull) | (uint64_t(distance) << 48ull);
+		}
+		constexpr bool operator>(const RenderBatch& other) const
+		{
+			return GetTransparentSortKey() > other.GetTransparentSortKey();
+		}
+	};
+	static_assert(sizeof(RenderBatch) == 16ull);
+
+	// This is a utility that points to a linear array of render batches:
+	struct RenderQueue
+	{
+		wi::vector<RenderBatch> batches;
+		wi::vector<RenderBatch> sort_scratch;
+
+		inline void init()
+		{
+			batches.clear();
+		}
+		inline void add(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint32_t sort_bits, uint16_t camera_mask = 0xFFFF)
+		{
+			batches.emplace_back().Create(meshIndex, instanceIndex, distance, sort_bits, camera_mask);
+		}
+		// The batches are sorted by radix sort of their sort keys, the scratch buffer is kept for the next sort:
+		inline void sort_transparent()
+		{
+			wi::RadixSort(batches.data(), batches.size(), sort_scratch, [](const RenderBatch& batch) {
+				return ~batch.GetTransparentSortKey(); // descending order
+			});
+		}
+		inline void sort_opaque()
+		{
+			wi::RadixSort(batches.data(), batches.size(), sort_scratch, [](const RenderBatch& batch) {
+				return batch.GetOpaqueSortKey();
+			});
+		}
+		inline bool empty() const
+		{
+			return batches.empty();
+		}
+		inline size_t size() const
+		{
+			return batches.size();
+		}
+	};
+}
@@ -13,6 +13,7 @@
 #include "wiGPUSortLib.h"
 #include "wiGPUBVH.h"
 #include "wiJobSystem.h"
+#include "wiRenderQueue.h"
 #include "wiSpinLock.h"
 #include "wiEventHandler.h"
 #include "wiPlatform.h"
@@ -111,6 +112,9 @@ bool variableRateShadingClassificationDebug = false;
 float GameSpeed = 1;
 bool debugLightCulling = false;
 bool occlusionCulling = false;
+bool hierarchicalCulling = true;
+bool softwareOcclusionCulling = false;
+bool textureStreaming = false;
 bool temporalAA = false;
 bool temporalAADEBUG = false;
 uint32_t raytraceBounceCount = 3;
@@ -153,6 +157,16 @@ wi::vector<PaintRadius> paintrads;
 wi::SpinLock deferredMIPGenLock;
 wi::vector<std::pair<Texture, bool>> deferredMIPGens;
 wi::vector<std::pair<Texture, Texture>> deferredBCQueue;
+using TextureReadbackCallback = std::function<void(const wi::vector<uint8_t>& texturedata, const TextureDesc& desc)>;
+wi::vector<std::pair<Texture, TextureReadbackCallback>> deferredReadbacks;
+struct TextureReadback
+{
+	Texture staging;
+	TextureReadbackCallback callback;
+	uint64_t frame = 0;
+};
+wi::vector<TextureReadback> inflightReadbacks;
+wi::jobsystem::context readbackCtx;
 
 static const uint32_t vertexCount_uvsphere = arraysize(UVSPHERE);
 static const uint32_t vertexCount_cone = arraysize(CONE);
@@ -172,126 +186,6 @@ Texture texture_weatherMap;
 // See: https://github.com/turanszkij/WickedEngine/issues/450
 GPUBuffer luminance_dummy;
 
-// Direct reference to a renderable instance:
-struct RenderBatch
-{
-	uint32_t meshIndex;
-	uint32_t instanceIndex;
-	uint16_t distance;
-	uint16_t camera_mask;
-	uint32_t sort_bits; // an additional bitmask for sorting only, it should be used to reduce pipeline changes
-
-	inline void Create(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint32_t sort_bits, uint16_t camera_mask = 0xFFFF)
-	{
-		this->meshIndex = meshIndex;
-		this->instanceIndex = instanceIndex;
-		this->distance = XMConvertFloatToHalf(distance);
-		this->sort_bits = sort_bits;
-		this->camera_mask = camera_mask;
-	}
-
-	inline float GetDistance() const
-	{
-		return XMConvertHalfToFloat(HALF(distance));
-	}
-	constexpr uint32_t GetMeshIndex() const
-	{
-		return meshIndex;
-	}
-	constexpr uint32_t GetInstanceIndex() const
-	{
-		return instanceIndex;
-	}
-
-	// opaque sorting
-	//	Priority is set to mesh index to have more instancing
-	//	distance is second priority (front to back Z-buffering)
-	constexpr bool operator<(const RenderBatch& other) const
-	{
-		union SortKey
-		{
-			struct
-			{
-				// The order of members is important here, it means the sort priority (low to high)!
-				uint64_t distance : 16;
-				uint64_t meshIndex : 16;
-				uint64_t sort_bits : 32;
-			} bits;
-			uint64_t value;
-		};
-		static_assert(sizeof(SortKey) == sizeof(uint64_t));
-		SortKey a = {};
-		a.bits.distance = distance;
-		a.bits.meshIndex = meshIndex;
-		a.bits.sort_bits = sort_bits;
-		SortKey b = {};
-		b.bits.distance = other.distance;
-		b.bits.meshIndex = other.meshIndex;
-		b.bits.sort_bits = other.sort_bits;
-		return a.value < b.value;
-	}
-	// transparent sorting
-	//	Priority is distance for correct alpha blending (back to front rendering)
-	//	mesh index is second priority for instancing
-	constexpr bool operator>(const RenderBatch& other) const
-	{
-		union SortKey
-		{
-			struct
-			{
-				// The order of members is important here, it means the sort priority (low to high)!
-				uint64_t meshIndex : 16;
-				uint64_t sort_bits : 32;
-				uint64_t distance : 16;
-			} bits;
-			uint64_t value;
-		};
-		static_assert(sizeof(SortKey) == sizeof(uint64_t));
-		SortKey a = {};
-		a.bits.distance = distance;
-		a.bits.sort_bits = sort_bits;
-		a.bits.meshIndex = meshIndex;
-		SortKey b = {};
-		b.bits.distance = other.distance;
-		b.bits.sort_bits = other.sort_bits;
-		b.bits.meshIndex = other.meshIndex;
-		return a.value > b.value;
-	}
-};
-static_assert(sizeof(RenderBatch) == 16ull);
-
-// This is a utility that points to a linear array of render batches:
-struct RenderQueue
-{
-	wi::vector<RenderBatch> batches;
-
-	inline void init()
-	{
-		batches.clear();
-	}
-	inline void add(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint32_t sort_bits, uint16_t camera_mask = 0xFFFF)
-	{
-		batches.emplace_back().Create(meshIndex, instanceIndex, distance, sort_bits, camera_mask);
-	}
-	inline void sort_transparent()
-	{
-		std::sort(batches.begin(), batches.end(), std::greater<RenderBatch>());
-	}
-	inline void sort_opaque()
-	{
-		std::sort(batches.begin(), batches.end(), std::less<RenderBatch>());
-	}
-	inline bool empty() const
-	{
-		return batches.empty();
-	}
-	inline size_t size() const
-	{
-		return batches.size();
-	}
-};
-
-
 const Sampler* GetSampler(SAMPLERTYPES id)
 {
 	return &samplers[id];
@@ -2960,6 +2854,30 @@ void RenderImpostors(
 
 void ProcessDeferredTextureRequests(CommandList cmd)
 {
+	GraphicsDevice* device = GetDevice();
+
+	// Readbacks whose GPU frame has surely finished can be processed in the background:
+	for (size_t i = 0; i < inflightReadbacks.size();)
+	{
+		if (device->GetFrameCount() > inflightReadbacks[i].frame + device->GetBufferCount())
+		{
+			TextureReadback readback = std::move(inflightReadbacks[i]);
+			inflightReadbacks[i] = std::move(inflightReadbacks.back());
+			inflightReadbacks.pop_back();
+			wi::jobsystem::Execute(readbackCtx, [readback](wi::jobsystem::JobArgs args) {
+				wi::vector<uint8_t> texturedata;
+				if (wi::helper::saveStagingTextureToMemory(readback.staging, texturedata))
+				{
+					readback.callback(texturedata, readback.staging.GetDesc());
+				}
+			});
+		}
+		else
+		{
+			i++;
+		}
+	}
+
 	deferredMIPGenLock.lock();
 	for (auto& it : deferredMIPGens)
 	{
@@ -2973,9 +2891,185 @@ void ProcessDeferredTextureRequests(CommandList cmd)
 		BlockCompress(it.first, it.second, cmd);
 	}
 	deferredBCQueue.clear();
+	for (auto& it : deferredReadbacks)
+	{
+		const Texture& texture = it.first;
+		TextureReadback readback;
+		TextureDesc staging_desc = texture.desc;
+		staging_desc.usage = Usage::READBACK;
+		staging_desc.layout = ResourceState::COPY_DST;
+		staging_desc.bind_flags = BindFlag::NONE;
+		staging_desc.misc_flags = ResourceMiscFlag::NONE;
+		if (!device->CreateTexture(&staging_desc, nullptr, &readback.staging))
+			continue;
+		{
+			GPUBarrier barriers[] = {
+				GPUBarrier::Image(&texture,texture.desc.layout,ResourceState::COPY_SRC),
+			};
+			device->Barrier(barriers, arraysize(barriers), cmd);
+		}
+		device->CopyResource(&readback.staging, &texture, cmd);
+		{
+			GPUBarrier barriers[] = {
+				GPUBarrier::Image(&texture,ResourceState::COPY_SRC,texture.desc.layout),
+			};
+			device->Barrier(barriers, arraysize(barriers), cmd);
+		}
+		readback.callback = std::move(it.second);
+		readback.frame = device->GetFrameCount();
+		inflightReadbacks.push_back(std::move(readback));
+	}
+	deferredReadbacks.clear();
 	deferredMIPGenLock.unlock();
 }
 
+// Hierarchical culling is used for large scenes when the object BVH is up to date, smaller scenes are faster to cull with flat loops:
+static constexpr size_t hierarchical_culling_min_objects = 1024;
+inline bool IsHierarchicalCullingUsable(const Scene& scene)
+{
+	return
+		hierarchicalCulling &&
+		scene.aabb_objects.size() >= hierarchical_culling_min_objects &&
+		scene.object_bvh.IsValid() &&
+		scene.object_bvh.leaf_count == (uint32_t)scene.aabb_objects.size();
+}
+// Calls callback(objectIndex, inside) for the objects that can intersect the frustum
+//	With hierarchical culling, inside == true means that the object is in a subtree that is fully inside the frustum,
+//	so only the layerMask and validity of its AABB needs to be checked. Otherwise all objects are reported with inside == false
+template<typename F>
+inline void ForEachObjectInFrustum(const Scene& scene, const Frustum& frustum, F callback)
+{
+	if (IsHierarchicalCullingUsable(scene))
+	{
+		const wi::BVH& bvh = scene.object_bvh;
+		bvh.CullFrustum(frustum, [&](uint32_t offset, uint32_t count, bool inside) {
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				callback(bvh.leaf_indices[offset + i], inside);
+			}
+		});
+	}
+	else
+	{
+		for (uint32_t i = 0; i < (uint32_t)scene.aabb_objects.size(); ++i)
+		{
+			callback(i, false);
+		}
+	}
+}
+
+// Software occlusion culling removes the objects from visibleObjects that are hidden behind large occluders, without waiting for GPU queries:
+static constexpr uint32_t software_occlusion_resolution = 256; // width of the depth buffer, height follows the camera aspect ratio
+static constexpr float software_occlusion_occluder_size = 0.1f; // objects are selected as occluders automatically if their radius is larger than this fraction of their distance
+static constexpr uint32_t software_occlusion_max_triangles = 100000;
+inline void SoftwareOcclusionCulling(Visibility& vis)
+{
+	if (vis.visibleObjects.empty())
+		return;
+
+	auto range = wi::profiler::BeginRangeCPU("Software Occlusion Culling");
+	const Scene& scene = *vis.scene;
+	const CameraComponent& camera = *vis.camera;
+
+	// Occluders are opaque objects whose mesh is not deformed on the GPU:
+	vis.occluders.clear();
+	for (uint32_t i = 0; i < (uint32_t)vis.visibleObjects.size(); ++i)
+	{
+		const ObjectComponent& object = scene.objects[vis.visibleObjects[i]];
+		if (!object.IsRenderable() || object.IsForeground() || object.mesh_index >= (uint32_t)scene.meshes.GetCount())
+			continue;
+		if ((object.GetFilterMask() & (FILTER_TRANSPARENT | FILTER_WATER)) || !(object.GetFilterMask() & FILTER_OPAQUE))
+			continue;
+		const MeshComponent& mesh = scene.meshes[object.mesh_index];
+		if (mesh.IsSkinned() || !mesh.morph_targets.empty() || mesh.vertex_positions.empty() || mesh.indices.empty())
+			continue;
+		if (!object.IsOccluder() && object.radius < wi::math::Distance(camera.Eye, object.center) * software_occlusion_occluder_size)
+			continue;
+		vis.occluders.push_back(i);
+	}
+	if (vis.occluders.empty())
+	{
+		wi::profiler::EndRange(range);
+		return;
+	}
+
+	// Flagged occluders are rasterized first, then the largest ones on screen until the triangle budget runs out:
+	auto priority = [&](uint32_t i) {
+		const ObjectComponent& object = scene.objects[vis.visibleObjects[i]];
+		if (object.IsOccluder())
+			return std::numeric_limits<float>::max();
+		return object.radius / std::max(0.001f, wi::math::Distance(camera.Eye, object.center));
+	};
+	std::sort(vis.occluders.begin(), vis.occluders.end(), [&](uint32_t a, uint32_t b) {
+		return priority(a) > priority(b);
+	});
+
+	const uint32_t width = software_occlusion_resolution;
+	const uint32_t height = camera.width > 0 && camera.height > 0 ? uint32_t(width * camera.height / camera.width) : width / 2;
+	vis.occlusion_buffer.Begin(width, height, camera.GetViewProjection());
+	uint32_t triangle_count = 0;
+	for (uint32_t i : vis.occluders)
+	{
+		const uint32_t objectIndex = vis.visibleObjects[i];
+		const ObjectComponent& object = scene.objects[objectIndex];
+		const MeshComponent& mesh = scene.meshes[object.mesh_index];
+
+		// The subsets of a LOD are next to each other in the index buffer, so they are added at once:
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		mesh.GetLODSubsetRange(object.lod, first_subset, last_subset);
+		uint32_t index_start = ~0u;
+		uint32_t index_end = 0;
+		for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+		{
+			const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+			if (subset.indexCount == 0)
+				continue;
+			index_start = std::min(index_start, subset.indexOffset);
+			index_end = std::max(index_end, subset.indexOffset + subset.indexCount);
+		}
+		if (index_start >= index_end)
+			continue;
+		if (triangle_count > 0 && triangle_count + (index_end - index_start) / 3 > software_occlusion_max_triangles)
+			break;
+		triangle_count += (index_end - index_start) / 3;
+
+		vis.occlusion_buffer.AddOccluder(
+			mesh.vertex_positions.data(),
+			(uint32_t)mesh.vertex_positions.size(),
+			mesh.indices.data() + index_start,
+			index_end - index_start,
+			XMLoadFloat4x4(&scene.matrix_objects[objectIndex])
+		);
+	}
+	vis.occlusion_buffer.Rasterize();
+
+	// Test the visible objects in parallel, the occluders themselves are kept:
+	vis.software_occluded.resize(vis.visibleObjects.size());
+	wi::jobsystem::context ctx;
+	wi::jobsystem::Dispatch(ctx, (uint32_t)vis.visibleObjects.size(), 64, [&](wi::jobsystem::JobArgs args) {
+		const AABB& aabb = scene.aabb_objects[vis.visibleObjects[args.jobIndex]];
+		vis.software_occluded[args.jobIndex] = vis.occlusion_buffer.IsVisible(aabb) ? 0 : 1;
+		});
+	wi::jobsystem::Wait(ctx);
+	for (uint32_t i : vis.occluders)
+	{
+		vis.software_occluded[i] = 0;
+	}
+
+	size_t count = 0;
+	for (size_t i = 0; i < vis.visibleObjects.size(); ++i)
+	{
+		if (!vis.software_occluded[i])
+		{
+			vis.visibleObjects[count++] = vis.visibleObjects[i];
+		}
+	}
+	vis.visibleObjects.resize(count);
+
+	wi::profiler::EndRange(range);
+}
+
 void UpdateVisibility(Visibility& vis)
 {
 	// Perform parallel frustum culling and obtain closest reflector:
@@ -2985,12 +3079,12 @@ void UpdateVisibility(Visibility& vis)
 	assert(vis.scene != nullptr); // User must provide a scene!
 	assert(vis.camera != nullptr); // User must provide a camera!
 
-	// The parallel frustum culling is first performed in shared memory, 
+	// The parallel frustum culling is first performed into a local list per group of 64 boxes, 
 	//	then each group writes out it's local list to global memory
-	//	The shared memory approach reduces atomics and helps the list to remain
+	//	The local list approach reduces atomics and helps the list to remain
 	//	more coherent (less randomly organized compared to original order)
+	//	The boxes of a group are tested four at a time by the SIMD culling kernel with the SoA AABB streams of the scene
 	static const uint32_t groupSize = 64;
-	static const size_t sharedmemory_size = (groupSize + 1) * sizeof(uint32_t); // list + counter per group
 
 	// Initialize visible indices:
 	vis.Clear();
@@ -3005,29 +3099,76 @@ void UpdateVisibility(Visibility& vis)
 		vis.flags &= ~Visibility::ALLOW_OCCLUSION_CULLING;
 	}
 
-	if (vis.flags & Visibility::ALLOW_LIGHTS)
+	if (!GetSoftwareOcclusionCullingEnabled() || GetFreezeCullingCameraEnabled())
 	{
-		// Cull lights:
-		vis.visibleLights.resize(vis.scene->aabb_lights.size());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_lights.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
+		vis.flags &= ~Visibility::ALLOW_SOFTWARE_OCCLUSION_CULLING;
+	}
 
-			// Setup stream compaction:
-			uint32_t& group_count = *(uint32_t*)args.sharedmemory;
-			uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
-			if (args.isFirstJobInGroup)
+	// With software occlusion culling, the per object requests are deferred until the hidden objects are removed,
+	//	so GPU occlusion queries are only allocated for the objects that remain visible:
+	const bool deferred_object_requests = (vis.flags & Visibility::ALLOW_SOFTWARE_OCCLUSION_CULLING) && (vis.flags & Visibility::ALLOW_OBJECTS);
+
+	// Planar reflection and occlusion query requests of a visible object:
+	auto object_visible = [&](uint32_t objectIndex) {
+		const AABB& aabb = vis.scene->aabb_objects[objectIndex];
+		const ObjectComponent& object = vis.scene->objects[objectIndex];
+		Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[objectIndex];
+
+		if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occlusion_result.IsOccluded())
+		{
+			// Planar reflection priority request:
+			float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
+			vis.locker.lock();
+			if (dist < vis.closestRefPlane)
 			{
-				group_count = 0; // first thread initializes local counter
+				vis.closestRefPlane = dist;
+				XMVECTOR P = XMLoadFloat3(&object.center);
+				XMVECTOR N = XMVectorSet(0, 1, 0, 0);
+				N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[objectIndex]));
+				N = XMVector3Normalize(N);
+				XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
+				XMStoreFloat4(&vis.reflectionPlane, _refPlane);
+
+				vis.planar_reflection_visible = true;
 			}
+			vis.locker.unlock();
+		}
+
+		if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
+		{
+			if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
+			{
+				if (aabb.intersects(vis.camera->Eye))
+				{
+					// camera is inside the instance, mark it as visible in this frame:
+					occlusion_result.occlusionHistory |= 1;
+				}
+				else
+				{
+					occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
+				}
+			}
+		}
+	};
+
+	if (vis.flags & Visibility::ALLOW_LIGHTS)
+	{
+		// Cull lights:
+		const uint32_t light_count = (uint32_t)vis.scene->aabb_lights_soa.size();
+		assert(light_count == (uint32_t)vis.scene->aabb_lights.size());
+		vis.visibleLights.resize(light_count);
+		wi::jobsystem::Dispatch(ctx, wi::jobsystem::DispatchGroupCount(light_count, groupSize), 1, [&](wi::jobsystem::JobArgs args) {
 
-			const AABB& aabb = vis.scene->aabb_lights[args.jobIndex];
+			// Local stream compaction:
+			const uint32_t group_offset = args.jobIndex * groupSize;
+			uint32_t group_list[groupSize];
+			const uint32_t group_count = vis.frustum.CheckBoxes(vis.scene->aabb_lights_soa, group_offset, std::min(groupSize, light_count - group_offset), vis.layerMask, group_list);
 
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
+			for (uint32_t i = 0; i < group_count; ++i)
 			{
-				// Local stream compaction:
-				//	(also compute light distance for shadow priority sorting)
-				group_list[group_count] = args.jobIndex;
-				const LightComponent& light = vis.scene->lights[args.jobIndex];
-				group_count++;
+				const uint32_t lightIndex = group_list[i];
+				const AABB& aabb = vis.scene->aabb_lights[lightIndex];
+				const LightComponent& light = vis.scene->lights[lightIndex];
 				if (light.IsVolumetricsEnabled())
 				{
 					vis.volumetriclight_request.store(true);
@@ -3046,7 +3187,7 @@ void UpdateVisibility(Visibility& vis)
 			}
 
 			// Global stream compaction:
-			if (args.isLastJobInGroup && group_count > 0)
+			if (group_count > 0)
 			{
 				uint32_t prev_count = vis.light_counter.fetch_add(group_count);
 				for (uint32_t i = 0; i < group_count; ++i)
@@ -3055,106 +3196,115 @@ void UpdateVisibility(Visibility& vis)
 				}
 			}
 
-			}, sharedmemory_size);
+			});
 	}
 
 	if (vis.flags & Visibility::ALLOW_OBJECTS)
 	{
 		// Cull objects:
-		vis.visibleObjects.resize(vis.scene->aabb_objects.size());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_objects.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
-
-			// Setup stream compaction:
-			uint32_t& group_count = *(uint32_t*)args.sharedmemory;
-			uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
-			if (args.isFirstJobInGroup)
-			{
-				group_count = 0; // first thread initializes local counter
-			}
+		const uint32_t object_count = (uint32_t)vis.scene->aabb_objects_soa.size();
+		assert(object_count == (uint32_t)vis.scene->aabb_objects.size());
+		vis.visibleObjects.resize(object_count);
+
+		if (IsHierarchicalCullingUsable(*vis.scene))
+		{
+			// The object BVH is descended first: outside subtrees are skipped, and objects of fully inside subtrees
+			//	are accepted without the frustum test. The found ranges are split to at most groupSize objects,
+			//	then they are processed in parallel with the same stream compaction as the flat culling:
+			const wi::BVH& bvh = vis.scene->object_bvh;
+			vis.culling_ranges.clear();
+			bvh.CullFrustum(vis.frustum, [&](uint32_t offset, uint32_t count, bool inside) {
+				for (uint32_t i = 0; i < count; i += groupSize)
+				{
+					vis.culling_ranges.push_back({ offset + i, std::min(groupSize, count - i), inside });
+				}
+			});
 
-			const AABB& aabb = vis.scene->aabb_objects[args.jobIndex];
+			static const uint32_t rangeGroupSize = 8;
+			static const size_t sharedmemory_size = (rangeGroupSize * groupSize + 1) * sizeof(uint32_t); // list + counter per group
+			wi::jobsystem::Dispatch(ctx, (uint32_t)vis.culling_ranges.size(), rangeGroupSize, [&](wi::jobsystem::JobArgs args) {
 
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
-			{
-				// Local stream compaction:
-				group_list[group_count++] = args.jobIndex;
+				// Setup stream compaction:
+				uint32_t& group_count = *(uint32_t*)args.sharedmemory;
+				uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
+				if (args.isFirstJobInGroup)
+				{
+					group_count = 0; // first thread initializes local counter
+				}
 
-				const ObjectComponent& object = vis.scene->objects[args.jobIndex];
-				Scene::OcclusionResult& occlusion_result = vis.scene->occlusion_results_objects[args.jobIndex];
+				const Visibility::CullingRange& range = vis.culling_ranges[args.jobIndex];
+				for (uint32_t i = 0; i < range.count; ++i)
+				{
+					const uint32_t objectIndex = bvh.leaf_indices[range.offset + i];
+					const AABB& aabb = vis.scene->aabb_objects[objectIndex];
+					if ((aabb.layerMask & vis.layerMask) && (range.inside ? aabb.IsValid() : vis.frustum.CheckBoxFast(aabb)))
+					{
+						// Local stream compaction:
+						group_list[group_count++] = objectIndex;
+						if (!deferred_object_requests)
+						{
+							object_visible(objectIndex);
+						}
+					}
+				}
 
-				if ((vis.flags & Visibility::ALLOW_REQUEST_REFLECTION) && object.IsRequestPlanarReflection() && !occlusion_result.IsOccluded())
+				// Global stream compaction:
+				if (args.isLastJobInGroup && group_count > 0)
 				{
-					// Planar reflection priority request:
-					float dist = wi::math::DistanceEstimated(vis.camera->Eye, object.center);
-					vis.locker.lock();
-					if (dist < vis.closestRefPlane)
+					uint32_t prev_count = vis.object_counter.fetch_add(group_count);
+					for (uint32_t i = 0; i < group_count; ++i)
 					{
-						vis.closestRefPlane = dist;
-						XMVECTOR P = XMLoadFloat3(&object.center);
-						XMVECTOR N = XMVectorSet(0, 1, 0, 0);
-						N = XMVector3TransformNormal(N, XMLoadFloat4x4(&vis.scene->matrix_objects[args.jobIndex]));
-						N = XMVector3Normalize(N);
-						XMVECTOR _refPlane = XMPlaneFromPointNormal(P, N);
-						XMStoreFloat4(&vis.reflectionPlane, _refPlane);
-
-						vis.planar_reflection_visible = true;
+						vis.visibleObjects[prev_count + i] = group_list[i];
 					}
-					vis.locker.unlock();
 				}
 
-				if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
+				}, sharedmemory_size);
+		}
+		else
+		{
+			wi::jobsystem::Dispatch(ctx, wi::jobsystem::DispatchGroupCount(object_count, groupSize), 1, [&](wi::jobsystem::JobArgs args) {
+
+				// Local stream compaction:
+				const uint32_t group_offset = args.jobIndex * groupSize;
+				uint32_t group_list[groupSize];
+				const uint32_t group_count = vis.frustum.CheckBoxes(vis.scene->aabb_objects_soa, group_offset, std::min(groupSize, object_count - group_offset), vis.layerMask, group_list);
+
+				if (!deferred_object_requests)
 				{
-					if (object.IsRenderable() && occlusion_result.occlusionQueries[vis.scene->queryheap_idx] < 0)
+					for (uint32_t i = 0; i < group_count; ++i)
 					{
-						if (aabb.intersects(vis.camera->Eye))
-						{
-							// camera is inside the instance, mark it as visible in this frame:
-							occlusion_result.occlusionHistory |= 1;
-						}
-						else
-						{
-							occlusion_result.occlusionQueries[vis.scene->queryheap_idx] = vis.scene->queryAllocator.fetch_add(1); // allocate new occlusion query from heap
-						}
+						object_visible(group_list[i]);
 					}
 				}
-			}
 
-			// Global stream compaction:
-			if (args.isLastJobInGroup && group_count > 0)
-			{
-				uint32_t prev_count = vis.object_counter.fetch_add(group_count);
-				for (uint32_t i = 0; i < group_count; ++i)
+				// Global stream compaction:
+				if (group_count > 0)
 				{
-					vis.visibleObjects[prev_count + i] = group_list[i];
+					uint32_t prev_count = vis.object_counter.fetch_add(group_count);
+					for (uint32_t i = 0; i < group_count; ++i)
+					{
+						vis.visibleObjects[prev_count + i] = group_list[i];
+					}
 				}
-			}
 
-			}, sharedmemory_size);
+				});
+		}
 	}
 
 	if (vis.flags & Visibility::ALLOW_DECALS)
 	{
-		vis.visibleDecals.resize(vis.scene->aabb_decals.size());
-		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_decals.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
+		const uint32_t decal_count = (uint32_t)vis.scene->aabb_decals_soa.size();
+		assert(decal_count == (uint32_t)vis.scene->aabb_decals.size());
+		vis.visibleDecals.resize(decal_count);
+		wi::jobsystem::Dispatch(ctx, wi::jobsystem::DispatchGroupCount(decal_count, groupSize), 1, [&](wi::jobsystem::JobArgs args) {
 
-			// Setup stream compaction:
-			uint32_t& group_count = *(uint32_t*)args.sharedmemory;
-			uint32_t* group_list = (uint32_t*)args.sharedmemory + 1;
-			if (args.isFirstJobInGroup)
-			{
-				group_count = 0; // first thread initializes local counter
-			}
-
-			const AABB& aabb = vis.scene->aabb_decals[args.jobIndex];
-
-			if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
-			{
-				// Local stream compaction:
-				group_list[group_count++] = args.jobIndex;
-			}
+			// Local stream compaction:
+			const uint32_t group_offset = args.jobIndex * groupSize;
+			uint32_t group_list[groupSize];
+			const uint32_t group_count = vis.frustum.CheckBoxes(vis.scene->aabb_decals_soa, group_offset, std::min(groupSize, decal_count - group_offset), vis.layerMask, group_list);
 
 			// Global stream compaction:
-			if (args.isLastJobInGroup && group_count > 0)
+			if (group_count > 0)
 			{
 				uint32_t prev_count = vis.decal_counter.fetch_add(group_count);
 				for (uint32_t i = 0; i < group_count; ++i)
@@ -3163,21 +3313,19 @@ void UpdateVisibility(Visibility& vis)
 				}
 			}
 
-			}, sharedmemory_size);
+			});
 	}
 
 	if (vis.flags & Visibility::ALLOW_ENVPROBES)
 	{
 		wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
 			// Cull probes:
-			for (size_t i = 0; i < vis.scene->aabb_probes.size(); ++i)
+			const uint32_t probe_count = (uint32_t)vis.scene->aabb_probes_soa.size();
+			assert(probe_count == (uint32_t)vis.scene->aabb_probes.size());
+			vis.visibleEnvProbes.resize(probe_count);
+			if (probe_count > 0)
 			{
-				const AABB& aabb = vis.scene->aabb_probes[i];
-
-				if ((aabb.layerMask & vis.layerMask) && vis.frustum.CheckBoxFast(aabb))
-				{
-					vis.visibleEnvProbes.push_back((uint32_t)i);
-				}
+				vis.visibleEnvProbes.resize(vis.frustum.CheckBoxes(vis.scene->aabb_probes_soa, 0, probe_count, vis.layerMask, vis.visibleEnvProbes.data()));
 			}
 			});
 	}
@@ -3232,6 +3380,18 @@ void UpdateVisibility(Visibility& vis)
 	vis.visibleDecals.resize((size_t)vis.decal_counter.load());
 	vis.visibleLights.resize((size_t)vis.light_counter.load());
 
+	if (vis.flags & Visibility::ALLOW_SOFTWARE_OCCLUSION_CULLING)
+	{
+		SoftwareOcclusionCulling(vis);
+	}
+	if (deferred_object_requests)
+	{
+		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.visibleObjects.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
+			object_visible(vis.visibleObjects[args.jobIndex]);
+			});
+		wi::jobsystem::Wait(ctx);
+	}
+
 	if (vis.scene->weather.IsOceanEnabled())
 	{
 		bool occluded = false;
@@ -5611,8 +5771,7 @@ void DrawShadowmaps(
 
 				renderQueue.init();
 				bool transparentShadowsRequested = false;
-				for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-				{
+				auto add_object = [&](uint32_t i, uint32_t traversed_cascade) {
 					const AABB& aabb = vis.scene->aabb_objects[i];
 					if (aabb.layerMask & vis.layerMask)
 					{
@@ -5629,9 +5788,13 @@ void DrawShadowmaps(
 								}
 							}
 							if (camera_mask == 0)
-								continue;
+								return;
 
-							renderQueue.add(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask);
+							// With hierarchical culling every cascade is traversed separately, the object is only added by the first cascade that contains it:
+							if (traversed_cascade != ~0u && (camera_mask & ((2u << traversed_cascade) - 1)) != (1u << traversed_cascade))
+								return;
+
+							renderQueue.add(object.mesh_index, i, 0, object.sort_bits, camera_mask);
 
 							const uint32_t filterMask = object.GetFilterMask();
 							if (filterMask & FILTER_TRANSPARENT || filterMask & FILTER_WATER)
@@ -5640,6 +5803,22 @@ void DrawShadowmaps(
 							}
 						}
 					}
+				};
+				if (IsHierarchicalCullingUsable(*vis.scene))
+				{
+					for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
+					{
+						ForEachObjectInFrustum(*vis.scene, shcams[cascade].frustum, [&](uint32_t i, bool inside) {
+							add_object(i, cascade);
+						});
+					}
+				}
+				else
+				{
+					for (uint32_t i = 0; i < (uint32_t)vis.scene->aabb_objects.size(); ++i)
+					{
+						add_object(i, ~0u);
+					}
 				}
 
 				if (!renderQueue.empty())
@@ -5714,15 +5893,14 @@ void DrawShadowmaps(
 
 				renderQueue.init();
 				bool transparentShadowsRequested = false;
-				for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-				{
+				ForEachObjectInFrustum(*vis.scene, shcam.frustum, [&](uint32_t i, bool inside) {
 					const AABB& aabb = vis.scene->aabb_objects[i];
-					if ((aabb.layerMask & vis.layerMask) && shcam.frustum.CheckBoxFast(aabb))
+					if ((aabb.layerMask & vis.layerMask) && (inside ? aabb.IsValid() : shcam.frustum.CheckBoxFast(aabb)))
 					{
 						const ObjectComponent& object = vis.scene->objects[i];
 						if (object.IsRenderable() && object.IsCastingShadow())
 						{
-							renderQueue.add(object.mesh_index, uint32_t(i), 0, object.sort_bits);
+							renderQueue.add(object.mesh_index, i, 0, object.sort_bits);
 
 							const uint32_t filterMask = object.GetFilterMask();
 							if (filterMask & FILTER_TRANSPARENT || filterMask & FILTER_WATER)
@@ -5731,7 +5909,7 @@ void DrawShadowmaps(
 							}
 						}
 					}
-				}
+				});
 				if (!renderQueue.empty())
 				{
 					if (predicationRequest && light.occlusionquery >= 0)
@@ -5840,8 +6018,7 @@ void DrawShadowmaps(
 
 				renderQueue.init();
 				bool transparentShadowsRequested = false;
-				for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-				{
+				auto add_object = [&](uint32_t i) {
 					const AABB& aabb = vis.scene->aabb_objects[i];
 					if ((aabb.layerMask & vis.layerMask) && boundingsphere.intersects(aabb))
 					{
@@ -5858,9 +6035,9 @@ void DrawShadowmaps(
 								}
 							}
 							if (camera_mask == 0)
-								continue;
+								return;
 
-							renderQueue.add(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask);
+							renderQueue.add(object.mesh_index, i, 0, object.sort_bits, camera_mask);
 
 							const uint32_t filterMask = object.GetFilterMask();
 							if (filterMask & FILTER_TRANSPARENT || filterMask & FILTER_WATER)
@@ -5869,6 +6046,17 @@ void DrawShadowmaps(
 							}
 						}
 					}
+				};
+				if (IsHierarchicalCullingUsable(*vis.scene))
+				{
+					vis.scene->object_bvh.IntersectsWide(boundingsphere, add_object);
+				}
+				else
+				{
+					for (uint32_t i = 0; i < (uint32_t)vis.scene->aabb_objects.size(); ++i)
+					{
+						add_object(i);
+					}
 				}
 				if (!renderQueue.empty())
 				{
@@ -16520,6 +16708,12 @@ void AddDeferredBlockCompression(const wi::graphics::Texture& texture_src, const
 	deferredBCQueue.push_back(std::make_pair(texture_src, texture_bc));
 	deferredMIPGenLock.unlock();
 }
+void AddDeferredTextureReadback(const wi::graphics::Texture& texture, const std::function<void(const wi::vector<uint8_t>& texturedata, const wi::graphics::TextureDesc& desc)>& callback)
+{
+	deferredMIPGenLock.lock();
+	deferredReadbacks.push_back(std::make_pair(texture, callback));
+	deferredMIPGenLock.unlock();
+}
 
 
 
@@ -16558,6 +16752,12 @@ void SetOcclusionCullingEnabled(bool value)
 	occlusionCulling = value;
 }
 bool GetOcclusionCullingEnabled() { return occlusionCulling; }
+void SetHierarchicalCullingEnabled(bool value) { hierarchicalCulling = value; }
+bool GetHierarchicalCullingEnabled() { return hierarchicalCulling; }
+void SetSoftwareOcclusionCullingEnabled(bool value) { softwareOcclusionCulling = value; }
+bool GetSoftwareOcclusionCullingEnabled() { return softwareOcclusionCulling; }
+void SetTextureStreamingEnabled(bool value) { textureStreaming = value; }
+bool GetTextureStreamingEnabled() { return textureStreaming; }
 void SetTemporalAAEnabled(bool enabled) { temporalAA = enabled; }
 bool GetTemporalAAEnabled() { return temporalAA; }
 void SetTemporalAADebugEnabled(bool enabled) { temporalAADEBUG = enabled; }
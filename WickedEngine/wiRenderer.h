@@ -5,6 +5,7 @@
 #include "wiScene.h"
 #include "wiECS.h"
 #include "wiPrimitive.h"
+#include "wiOcclusionBuffer.h"
 #include "wiCanvas.h"
 #include "wiMath.h"
 #include "shaders/ShaderInterop_Renderer.h"
@@ -110,6 +111,7 @@ namespace wi::renderer
 			ALLOW_HAIRS = 1 << 5,
 			ALLOW_REQUEST_REFLECTION = 1 << 6,
 			ALLOW_OCCLUSION_CULLING = 1 << 7,
+			ALLOW_SOFTWARE_OCCLUSION_CULLING = 1 << 8,
 
 			ALLOW_EVERYTHING = ~0u
 		};
@@ -124,6 +126,20 @@ namespace wi::renderer
 		wi::vector<uint32_t> visibleHairs;
 		wi::vector<uint32_t> visibleLights;
 
+		// Ranges of the object BVH leaves that were found by hierarchical culling, reused between frames:
+		struct CullingRange
+		{
+			uint32_t offset;
+			uint32_t count;
+			bool inside;
+		};
+		wi::vector<CullingRange> culling_ranges;
+
+		// Software occlusion culling state, reused between frames:
+		wi::OcclusionBuffer occlusion_buffer;
+		wi::vector<uint32_t> occluders; // indices into visibleObjects
+		wi::vector<uint8_t> software_occluded;
+
 		std::atomic<uint32_t> object_counter;
 		std::atomic<uint32_t> light_counter;
 		std::atomic<uint32_t> decal_counter;
@@ -1005,6 +1021,16 @@ namespace wi::renderer
 	bool GetVariableRateShadingClassificationDebug();
 	void SetOcclusionCullingEnabled(bool enabled);
 	bool GetOcclusionCullingEnabled();
+	// Hierarchical culling descends the object BVH of large scenes for main, reflection and shadow views instead of testing every object:
+	void SetHierarchicalCullingEnabled(bool enabled);
+	bool GetHierarchicalCullingEnabled();
+	// Software occlusion culling rasterizes large occluders on the CPU and removes the hidden objects from the main camera visibility:
+	void SetSoftwareOcclusionCullingEnabled(bool enabled);
+	bool GetSoftwareOcclusionCullingEnabled();
+	// Texture streaming loads material textures with wi::resourcemanager::Flags::STREAMING, so only their tail mips are resident at first (default: disabled)
+	//	It affects materials whose textures are loaded after it was changed
+	void SetTextureStreamingEnabled(bool enabled);
+	bool GetTextureStreamingEnabled();
 	void SetTemporalAAEnabled(bool enabled);
 	bool GetTemporalAAEnabled();
 	void SetTemporalAADebugEnabled(bool enabled);
@@ -1134,6 +1160,10 @@ namespace wi::renderer
 	// Add a texture that should be mipmapped whenever it is feasible to do so
 	void AddDeferredMIPGen(const wi::graphics::Texture& texture, bool preserve_coverage = false);
 	void AddDeferredBlockCompression(const wi::graphics::Texture& texture_src, const wi::graphics::Texture& texture_bc);
+	// Add a texture that should be downloaded to CPU memory after the deferred MIPGen and block compression requests are done
+	//	The copy is recorded in ProcessDeferredTextureRequests() and the GPU is never waited on,
+	//	the callback will be called later from a job system thread with the data in the layout of wi::helper::saveTextureToMemory()
+	void AddDeferredTextureReadback(const wi::graphics::Texture& texture, const std::function<void(const wi::vector<uint8_t>& texturedata, const wi::graphics::TextureDesc& desc)>& callback);
 
 	struct CustomShader
 	{
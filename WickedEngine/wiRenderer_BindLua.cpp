@@ -153,6 +153,19 @@ namespace wi::lua::renderer
 		}
 		return 0;
 	}
+	int SetSoftwareOcclusionCullingEnabled(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			wi::renderer::SetSoftwareOcclusionCullingEnabled(wi::lua::SGetBool(L, 1));
+		}
+		else
+		{
+			wi::lua::SError(L, "SetSoftwareOcclusionCullingEnabled(bool enabled) not enough arguments!");
+		}
+		return 0;
+	}
 
 	int DrawLine(lua_State* L)
 	{
@@ -425,6 +438,7 @@ namespace wi::lua::renderer
 			wi::lua::RegisterFunc("SetResolution", SetResolution);
 			wi::lua::RegisterFunc("SetDebugLightCulling", SetDebugLightCulling);
 			wi::lua::RegisterFunc("SetOcclusionCullingEnabled", SetOcclusionCullingEnabled);
+			wi::lua::RegisterFunc("SetSoftwareOcclusionCullingEnabled", SetSoftwareOcclusionCullingEnabled);
 
 			wi::lua::RegisterFunc("DrawLine", DrawLine);
 			wi::lua::RegisterFunc("DrawPoint", DrawPoint);
@@ -9,8 +9,11 @@
 #include "Utility/stb_image.h"
 #include "Utility/tinyddsloader.h"
 #include "Utility/basis_universal/transcoder/basisu_transcoder.h"
+#include "Utility/basis_universal/zstd/zstd.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <filesystem>
 #include <mutex>
 #include <unordered_map>
 
@@ -20,6 +23,17 @@ namespace wi
 {
 	struct ResourceInternal
 	{
+		enum class State
+		{
+			LOADED,
+			LOADING,
+			FAILED,
+			ALIASED, // the name was redirected to an other resource with the same content, this one is discarded
+		};
+		std::atomic<State> state{ State::LOADED }; // other loads of the same resource wait while it's LOADING
+		std::mutex state_locker;
+		std::condition_variable state_changed; // notified when the state leaves LOADING
+		uint64_t content_hash = 0; // identifies the file data and the import options
 		resourcemanager::Flags flags = resourcemanager::Flags::NONE;
 		wi::graphics::Texture texture;
 		int srgb_subresource = -1;
@@ -28,6 +42,62 @@ namespace wi
 		wi::video::Video video;
 		wi::vector<uint8_t> filedata;
 		int font_style = -1;
+		size_t font_style_size = 0; // the font style keeps a copy of the file data
+
+		// Memory accounting state:
+		resourcemanager::DataType type = resourcemanager::DataType::COUNT; // COUNT if unknown
+		std::atomic<uint64_t> load_order{ 0 }; // the retain cache releases the least recently loaded resources first
+		std::atomic_bool retained{ false }; // true if it's in the retain cache
+		std::atomic<size_t> memory_bytes{ 0 }; // CPU and GPU memory that is counted in total_memory_bytes
+		static inline std::atomic<size_t> total_memory_bytes{ 0 }; // sum of memory_bytes of all resources, so the budget can be checked without iterating them
+
+		// Texture streaming state:
+		enum class StreamingState
+		{
+			IDLE,
+			WORKING, // a background job is creating streaming_texture
+			READY, // streaming_texture can be swapped in
+		};
+		std::atomic<StreamingState> streaming_state{ StreamingState::IDLE };
+		std::atomic<uint32_t> streaming_resolution{ 0 }; // highest resolution requested since the last streaming update
+		bool from_file = false; // the file data was read by name (from a file or package), so it can be read again
+		wi::vector<uint8_t> streaming_filedata; // source kept for streaming when it can't be read again by name, until the full resolution is resident
+		bool streaming_source_released = false; // streaming_filedata was released, the texture stays at full resolution
+		wi::graphics::TextureDesc streaming_desc; // full resolution texture description
+		uint32_t streaming_tail_mip = 0; // 0 if the texture is not streaming
+		uint32_t streaming_resident_mip = 0; // first mip of the current texture
+		uint32_t streaming_requested_resolution = 0;
+		uint64_t streaming_last_request_frame = 0;
+		bool streaming_registered = false;
+		wi::graphics::Texture streaming_texture;
+		int streaming_srgb_subresource = -1;
+		uint32_t streaming_texture_mip = 0; // first mip of streaming_texture
+		uint32_t streaming_texture_end_mip = 0; // the mips from this are copied from the current texture when streaming_texture is swapped in
+
+		~ResourceInternal()
+		{
+			total_memory_bytes.fetch_sub(memory_bytes.load());
+		}
+
+		// Recomputes memory_bytes after the contents were changed
+		void UpdateMemoryBytes();
+
+		// Ends the LOADING state and wakes up the threads that wait for it
+		void FinishLoading(State value)
+		{
+			state_locker.lock();
+			state.store(value);
+			state_locker.unlock();
+			state_changed.notify_all();
+		}
+		// Blocks while an other thread is loading this resource
+		void WaitLoading()
+		{
+			if (state.load() != State::LOADING)
+				return;
+			std::unique_lock<std::mutex> lock(state_locker);
+			state_changed.wait(lock, [this] { return state.load() != State::LOADING; });
+		}
 	};
 
 	const wi::vector<uint8_t>& Resource::GetFileData() const
@@ -74,6 +144,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->filedata = data;
+		resourceinternal->UpdateMemoryBytes();
 	}
 	void Resource::SetFileData(wi::vector<uint8_t>&& data)
 	{
@@ -83,6 +154,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->filedata = data;
+		resourceinternal->UpdateMemoryBytes();
 	}
 	void Resource::SetTexture(const wi::graphics::Texture& texture, int srgb_subresource)
 	{
@@ -93,6 +165,7 @@ namespace wi
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->texture = texture;
 		resourceinternal->srgb_subresource = srgb_subresource;
+		resourceinternal->UpdateMemoryBytes();
 	}
 	void Resource::SetSound(const wi::audio::Sound& sound)
 	{
@@ -102,6 +175,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->sound = sound;
+		resourceinternal->UpdateMemoryBytes();
 	}
 	void Resource::SetScript(const std::string& script)
 	{
@@ -111,6 +185,7 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->script = script;
+		resourceinternal->UpdateMemoryBytes();
 	}
 	void Resource::SetVideo(const wi::video::Video& video)
 	{
@@ -120,6 +195,16 @@ namespace wi
 		}
 		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
 		resourceinternal->video = video;
+		resourceinternal->UpdateMemoryBytes();
+	}
+
+	void Resource::StreamingRequestResolution(uint32_t resolution) const
+	{
+		ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
+		if (resourceinternal == nullptr || resourceinternal->streaming_tail_mip == 0)
+			return;
+		uint32_t current = resourceinternal->streaming_resolution.load();
+		while (current < resolution && !resourceinternal->streaming_resolution.compare_exchange_weak(current, resolution));
 	}
 
 	void Resource::SetOutdated()
@@ -134,8 +219,19 @@ namespace wi
 
 	namespace resourcemanager
 	{
-		static std::mutex locker;
-		static std::unordered_map<std::string, std::weak_ptr<ResourceInternal>> resources;
+		// The resource table is split into shards by name hash, so that loads of different resources rarely contend on the same lock
+		//	The locks only protect the table lookups, loading itself is synchronized per resource by ResourceInternal::state
+		struct ResourceShard
+		{
+			std::mutex locker;
+			std::unordered_map<std::string, std::weak_ptr<ResourceInternal>> resources;
+		};
+		static constexpr size_t resource_shard_count = 64;
+		static ResourceShard resource_shards[resource_shard_count];
+		static ResourceShard& GetShard(const std::string& name)
+		{
+			return resource_shards[std::hash<std::string>()(name) % resource_shard_count];
+		}
 		static Mode mode = Mode::DISCARD_FILEDATA_AFTER_LOAD;
 
 		void SetMode(Mode param)
@@ -147,14 +243,6 @@ namespace wi
 			return mode;
 		}
 
-		enum class DataType
-		{
-			IMAGE,
-			SOUND,
-			SCRIPT,
-			VIDEO,
-			FONTSTYLE,
-		};
 		static const wi::unordered_map<std::string, DataType> types = {
 			{"BASIS", DataType::IMAGE},
 			{"KTX2", DataType::IMAGE},
@@ -233,335 +321,896 @@ namespace wi
 			return ret;
 		}
 
-		Resource Load(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		// Creates a texture from DDS file data
+		//	from_cache : the DDS was written by the texture cache, single channel formats get the same swizzle as when they are imported from images
+		//	max_resolution : if not 0, the mips that are larger than this will be left out (only for 2D textures)
+		//	full_desc : optional, receives the description of the texture with all mips
+		//	end_mip : the mips starting from this will be left out (only together with max_resolution)
+		static bool LoadTextureDDS(const std::string& name, const uint8_t* filedata, size_t filesize, Texture& texture, int& srgb_subresource, bool from_cache = false, uint32_t max_resolution = 0, TextureDesc* full_desc = nullptr, uint32_t end_mip = ~0u)
 		{
-			if (mode == Mode::DISCARD_FILEDATA_AFTER_LOAD)
-			{
-				flags &= ~Flags::IMPORT_RETAIN_FILEDATA;
-			}
+			GraphicsDevice* device = wi::graphics::GetDevice();
+			bool success = false;
 
-			locker.lock();
-			std::weak_ptr<ResourceInternal>& weak_resource = resources[name];
-			std::shared_ptr<ResourceInternal> resource = weak_resource.lock();
+			tinyddsloader::DDSFile dds;
+			auto result = dds.Load(filedata, filesize);
 
-			static bool basis_init = false; // within lock!
-			if (!basis_init)
+			if (result == tinyddsloader::Result::Success)
 			{
-				basis_init = true;
-				basist::basisu_transcoder_init();
-			}
+				TextureDesc desc;
+				desc.array_size = 1;
+				desc.bind_flags = BindFlag::SHADER_RESOURCE;
+				desc.width = dds.GetWidth();
+				desc.height = dds.GetHeight();
+				desc.depth = dds.GetDepth();
+				desc.mip_levels = dds.GetMipCount();
+				desc.array_size = dds.GetArraySize();
+				desc.format = Format::R8G8B8A8_UNORM;
+				desc.layout = ResourceState::SHADER_RESOURCE;
+				desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
+
+				if (dds.IsCubemap())
+				{
+					desc.misc_flags |= ResourceMiscFlag::TEXTURECUBE;
+				}
 
-			if (resource == nullptr)
-			{
-				resource = std::make_shared<ResourceInternal>();
-				resources[name] = resource;
-			}
-			else
-			{
-				if (!has_flag(flags, Flags::IMPORT_DELAY) && has_flag(resource->flags, Flags::IMPORT_DELAY))
+				auto ddsFormat = dds.GetFormat();
+
+				switch (ddsFormat)
 				{
-					// If this is not an IMPORT_DELAY load, but this resource load was incomplete, using IMPORT_DELAY,
-					//	then continue loading it as normal from existing file data and remove IMPORT_DELAY flag from it
-					resource->flags &= ~Flags::IMPORT_DELAY;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_Float: desc.format = Format::R32G32B32A32_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_UInt: desc.format = Format::R32G32B32A32_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_SInt: desc.format = Format::R32G32B32A32_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_Float: desc.format = Format::R32G32B32_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_UInt: desc.format = Format::R32G32B32_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_SInt: desc.format = Format::R32G32B32_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_Float: desc.format = Format::R16G16B16A16_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UNorm: desc.format = Format::R16G16B16A16_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UInt: desc.format = Format::R16G16B16A16_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SNorm: desc.format = Format::R16G16B16A16_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SInt: desc.format = Format::R16G16B16A16_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32_Float: desc.format = Format::R32G32_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32_UInt: desc.format = Format::R32G32_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32G32_SInt: desc.format = Format::R32G32_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UNorm: desc.format = Format::R10G10B10A2_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UInt: desc.format = Format::R10G10B10A2_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R11G11B10_Float: desc.format = Format::R11G11B10_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R9G9B9E5_SHAREDEXP: desc.format = Format::R9G9B9E5_SHAREDEXP; break;
+				case tinyddsloader::DDSFile::DXGIFormat::B8G8R8X8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB: desc.format = Format::B8G8R8A8_UNORM_SRGB; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm: desc.format = Format::R8G8B8A8_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB: desc.format = Format::R8G8B8A8_UNORM_SRGB; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UInt: desc.format = Format::R8G8B8A8_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SNorm: desc.format = Format::R8G8B8A8_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SInt: desc.format = Format::R8G8B8A8_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16_Float: desc.format = Format::R16G16_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16_UNorm: desc.format = Format::R16G16_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16_UInt: desc.format = Format::R16G16_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16_SNorm: desc.format = Format::R16G16_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16G16_SInt: desc.format = Format::R16G16_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::D32_Float: desc.format = Format::D32_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32_Float: desc.format = Format::R32_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32_UInt: desc.format = Format::R32_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R32_SInt: desc.format = Format::R32_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8_UNorm: desc.format = Format::R8G8_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8_UInt: desc.format = Format::R8G8_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8_SNorm: desc.format = Format::R8G8_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8G8_SInt: desc.format = Format::R8G8_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16_Float: desc.format = Format::R16_FLOAT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::D16_UNorm: desc.format = Format::D16_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16_UNorm: desc.format = Format::R16_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16_UInt: desc.format = Format::R16_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16_SNorm: desc.format = Format::R16_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R16_SInt: desc.format = Format::R16_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8_UNorm: desc.format = Format::R8_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8_UInt: desc.format = Format::R8_UINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8_SNorm: desc.format = Format::R8_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::R8_SInt: desc.format = Format::R8_SINT; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm: desc.format = Format::BC1_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm_SRGB: desc.format = Format::BC1_UNORM_SRGB; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm: desc.format = Format::BC2_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm_SRGB: desc.format = Format::BC2_UNORM_SRGB; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm: desc.format = Format::BC3_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm_SRGB: desc.format = Format::BC3_UNORM_SRGB; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC4_UNorm: desc.format = Format::BC4_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC4_SNorm: desc.format = Format::BC4_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC5_UNorm: desc.format = Format::BC5_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC5_SNorm: desc.format = Format::BC5_SNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC6H_SF16: desc.format = Format::BC6H_SF16; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC6H_UF16: desc.format = Format::BC6H_UF16; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm: desc.format = Format::BC7_UNORM; break;
+				case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm_SRGB: desc.format = Format::BC7_UNORM_SRGB; break;
+				default:
+					assert(0); // incoming format is not supported 
+					break;
 				}
-				else
+
+				if (desc.format == Format::BC5_UNORM)
 				{
-					Resource retVal;
-					retVal.internal_state = resource;
-					locker.unlock();
-					return retVal;
+					desc.swizzle.r = ComponentSwizzle::R;
+					desc.swizzle.g = ComponentSwizzle::G;
+					desc.swizzle.b = ComponentSwizzle::ONE;
+					desc.swizzle.a = ComponentSwizzle::ONE;
+				}
+				if (from_cache)
+				{
+					switch (desc.format)
+					{
+					case Format::R8_UNORM:
+					case Format::R16_UNORM:
+					case Format::BC4_UNORM:
+						desc.swizzle = { ComponentSwizzle::R, ComponentSwizzle::R, ComponentSwizzle::R, ComponentSwizzle::ONE };
+						break;
+					case Format::R8G8_UNORM:
+					case Format::R16G16_UNORM:
+						desc.swizzle = { ComponentSwizzle::R, ComponentSwizzle::G, ComponentSwizzle::ONE, ComponentSwizzle::ONE };
+						break;
+					default:
+						break;
+					}
 				}
-			}
-			locker.unlock();
 
-			if (filedata == nullptr || filesize == 0)
-			{
-				if (resource->filedata.empty() && !wi::helper::FileRead(name, resource->filedata))
+				uint32_t first_mip = 0;
+				uint32_t mip_count = desc.mip_levels;
+				if (max_resolution > 0 && dds.GetTextureDimension() == tinyddsloader::DDSFile::TextureDimension::Texture2D && desc.array_size == 1 && !dds.IsCubemap())
 				{
-					resource.reset();
-					return Resource();
+					first_mip = ComputeStreamingTailMip(desc, max_resolution);
+					mip_count = std::max(first_mip + 1, std::min(mip_count, end_mip)) - first_mip;
+				}
+
+				wi::vector<SubresourceData> InitData;
+				for (uint32_t arrayIndex = 0; arrayIndex < desc.array_size; ++arrayIndex)
+				{
+					for (uint32_t mip = first_mip; mip < first_mip + mip_count; ++mip)
+					{
+						auto imageData = dds.GetImageData(mip, arrayIndex);
+						SubresourceData subresourceData;
+						subresourceData.data_ptr = imageData->m_mem;
+						subresourceData.row_pitch = imageData->m_memPitch;
+						subresourceData.slice_pitch = imageData->m_memSlicePitch;
+						InitData.push_back(subresourceData);
+					}
+				}
+
+				auto dim = dds.GetTextureDimension();
+				switch (dim)
+				{
+				case tinyddsloader::DDSFile::TextureDimension::Texture1D:
+				{
+					desc.type = TextureDesc::Type::TEXTURE_1D;
+				}
+				break;
+				case tinyddsloader::DDSFile::TextureDimension::Texture2D:
+				{
+					desc.type = TextureDesc::Type::TEXTURE_2D;
+				}
+				break;
+				case tinyddsloader::DDSFile::TextureDimension::Texture3D:
+				{
+					desc.type = TextureDesc::Type::TEXTURE_3D;
+				}
+				break;
+				default:
+					assert(0);
+					break;
+				}
+
+				if (IsFormatBlockCompressed(desc.format))
+				{
+					desc.width = AlignTo(desc.width, GetFormatBlockSize(desc.format));
+					desc.height = AlignTo(desc.height, GetFormatBlockSize(desc.format));
+				}
+
+				if (full_desc != nullptr)
+				{
+					*full_desc = desc;
+				}
+				if (first_mip > 0 || mip_count < desc.mip_levels)
+				{
+					desc.width = std::max(1u, desc.width >> first_mip);
+					desc.height = std::max(1u, desc.height >> first_mip);
+					desc.mip_levels = mip_count;
+					if (IsFormatBlockCompressed(desc.format))
+					{
+						desc.width = AlignTo(desc.width, GetFormatBlockSize(desc.format));
+						desc.height = AlignTo(desc.height, GetFormatBlockSize(desc.format));
+					}
+				}
+
+				success = device->CreateTexture(&desc, InitData.data(), &texture);
+				device->SetName(&texture, name.c_str());
+
+				Format srgb_format = GetFormatSRGB(desc.format);
+				if (srgb_format != Format::UNKNOWN && srgb_format != desc.format)
+				{
+					srgb_subresource = device->CreateSubresource(
+						&texture,
+						SubresourceType::SRV,
+						0, -1,
+						0, -1,
+						&srgb_format
+					);
 				}
-				filedata = resource->filedata.data();
-				filesize = resource->filedata.size();
 			}
 
-			bool success = false;
+			return success;
+		}
 
-			if (has_flag(flags, Flags::IMPORT_DELAY))
+		// Basis Universal subresources are transcoded independently from each other, into precomputed ranges of one allocation
+		struct TranscodeTask
+		{
+			uint32_t mip = 0;
+			uint32_t layer = 0;
+			uint32_t face = 0;
+			size_t offset = 0;
+			uint32_t pixel_or_block_count = 0;
+			uint32_t row_pitch = 0;
+			uint32_t slice_pitch = 0;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t blocks_x = 0;
+			uint32_t blocks_y = 0;
+		};
+		// UASTC blocks don't depend on each other, so large UASTC subresources are further split into bands of block rows
+		static constexpr uint32_t uastc_band_block_rows = 64;
+		static constexpr uint32_t uastc_block_size = 16;
+		struct TranscodeBand
+		{
+			uint32_t task = 0;
+			uint32_t first_block_row = 0;
+			uint32_t block_rows = 0;
+		};
+		// Runs the transcoding jobs on the job system if it is available, returns false if any of them failed
+		template<typename T>
+		static bool TranscodeJobs(uint32_t job_count, const T& job)
+		{
+			if (job_count > 1 && wi::jobsystem::GetThreadCount() > 1)
 			{
-				success = true;
+				std::atomic_bool success{ true };
+				wi::jobsystem::context ctx;
+				wi::jobsystem::Dispatch(ctx, job_count, 1, [&](wi::jobsystem::JobArgs args) {
+					if (!job(args.jobIndex))
+					{
+						success.store(false);
+					}
+				});
+				wi::jobsystem::Wait(ctx);
+				return success.load();
 			}
-			else
+			bool success = true;
+			for (uint32_t i = 0; i < job_count; ++i)
 			{
-				std::string ext = wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name));
-				DataType type;
+				success &= job(i);
+			}
+			return success;
+		}
 
-				// dynamic type selection:
+		// Creates a texture from KTX2 file data
+		//	max_resolution : if not 0, the mips that are larger than this will be left out (only for 2D textures)
+		//	full_desc : optional, receives the description of the texture with all mips
+		//	end_mip : the mips starting from this will be left out (only together with max_resolution), they are not transcoded
+		static bool LoadTextureKTX2(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize, Texture& texture, int& srgb_subresource, uint32_t max_resolution = 0, TextureDesc* full_desc = nullptr, uint32_t end_mip = ~0u)
+		{
+			GraphicsDevice* device = wi::graphics::GetDevice();
+			bool success = false;
+
+			basist::ktx2_transcoder transcoder;
+			if (transcoder.init(filedata, (uint32_t)filesize))
+			{
+				TextureDesc desc;
+				desc.bind_flags = BindFlag::SHADER_RESOURCE;
+				desc.width = transcoder.get_width();
+				desc.height = transcoder.get_height();
+				desc.array_size = std::max(desc.array_size, transcoder.get_layers() * transcoder.get_faces());
+				desc.mip_levels = transcoder.get_levels();
+				desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
+				if (transcoder.get_faces() == 6)
 				{
-					auto it = types.find(ext);
-					if (it != types.end())
-					{
-						type = it->second;
-					}
-					else
+					desc.misc_flags |= ResourceMiscFlag::TEXTURECUBE;
+				}
+
+				basist::transcoder_texture_format fmt = basist::transcoder_texture_format::cTFRGBA32;
+				desc.format = Format::R8G8B8A8_UNORM;
+
+				bool import_compressed = has_flag(flags, Flags::IMPORT_BLOCK_COMPRESSED);
+				if (import_compressed)
+				{
+					// BC5 is disabled because it's missing green channel!
+					//if (has_flag(flags, Flags::IMPORT_NORMALMAP))
+					//{
+					//	fmt = basist::transcoder_texture_format::cTFBC5_RG;
+					//	desc.format = Format::BC5_UNORM;
+					//	desc.swizzle.r = ComponentSwizzle::R;
+					//	desc.swizzle.g = ComponentSwizzle::G;
+					//	desc.swizzle.b = ComponentSwizzle::ONE;
+					//	desc.swizzle.a = ComponentSwizzle::ONE;
+					//}
+					//else
 					{
-						return Resource();
+						if (transcoder.get_has_alpha())
+						{
+							fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
+							desc.format = Format::BC3_UNORM;
+						}
+						else
+						{
+							fmt = basist::transcoder_texture_format::cTFBC1_RGB;
+							desc.format = Format::BC1_UNORM;
+						}
 					}
 				}
+				uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
 
-				switch (type)
+				if (full_desc != nullptr)
 				{
-				case DataType::IMAGE:
+					*full_desc = desc;
+				}
+				uint32_t first_mip = 0;
+				uint32_t levels = transcoder.get_levels();
+				if (max_resolution > 0 && transcoder.get_layers() <= 1 && transcoder.get_faces() == 1)
 				{
-					GraphicsDevice* device = wi::graphics::GetDevice();
-					if (!ext.compare("KTX2"))
+					first_mip = ComputeStreamingTailMip(desc, max_resolution);
+					levels = std::max(first_mip + 1, std::min(levels, end_mip));
+					desc.width = std::max(1u, desc.width >> first_mip);
+					desc.height = std::max(1u, desc.height >> first_mip);
+					desc.mip_levels = levels - first_mip;
+				}
+
+				if (transcoder.start_transcoding())
+				{
+					// all subresources will use one allocation for transcoder destination, so compute combined size and offsets:
+					wi::vector<TranscodeTask> tasks;
+					size_t transcoded_data_size = 0;
+					bool valid = true;
+					const uint32_t layers = std::max(1u, transcoder.get_layers());
+					const uint32_t faces = transcoder.get_faces();
+					for (uint32_t layer = 0; layer < layers; ++layer)
 					{
-						basist::ktx2_transcoder transcoder;
-						if (transcoder.init(filedata, (uint32_t)filesize))
+						for (uint32_t face = 0; face < faces; ++face)
 						{
-							TextureDesc desc;
-							desc.bind_flags = BindFlag::SHADER_RESOURCE;
-							desc.width = transcoder.get_width();
-							desc.height = transcoder.get_height();
-							desc.array_size = std::max(desc.array_size, transcoder.get_layers() * transcoder.get_faces());
-							desc.mip_levels = transcoder.get_levels();
-							desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
-							if (transcoder.get_faces() == 6)
-							{
-								desc.misc_flags |= ResourceMiscFlag::TEXTURECUBE;
-							}
-
-							basist::transcoder_texture_format fmt = basist::transcoder_texture_format::cTFRGBA32;
-							desc.format = Format::R8G8B8A8_UNORM;
-
-							bool import_compressed = has_flag(flags, Flags::IMPORT_BLOCK_COMPRESSED);
-							if (import_compressed)
-							{
-								// BC5 is disabled because it's missing green channel!
-								//if (has_flag(flags, Flags::IMPORT_NORMALMAP))
-								//{
-								//	fmt = basist::transcoder_texture_format::cTFBC5_RG;
-								//	desc.format = Format::BC5_UNORM;
-								//	desc.swizzle.r = ComponentSwizzle::R;
-								//	desc.swizzle.g = ComponentSwizzle::G;
-								//	desc.swizzle.b = ComponentSwizzle::ONE;
-								//	desc.swizzle.a = ComponentSwizzle::ONE;
-								//}
-								//else
-								{
-									if (transcoder.get_has_alpha())
-									{
-										fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
-										desc.format = Format::BC3_UNORM;
-									}
-									else
-									{
-										fmt = basist::transcoder_texture_format::cTFBC1_RGB;
-										desc.format = Format::BC1_UNORM;
-									}
-								}
-							}
-							uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
-
-							if (transcoder.start_transcoding())
+							for (uint32_t mip = first_mip; mip < levels; ++mip)
 							{
-								// all subresources will use one allocation for transcoder destination, so compute combined size:
-								size_t transcoded_data_size = 0;
-								const uint32_t layers = std::max(1u, transcoder.get_layers());
-								const uint32_t faces = transcoder.get_faces();
-								const uint32_t levels = transcoder.get_levels();
-								for (uint32_t layer = 0; layer < layers; ++layer)
+								basist::ktx2_image_level_info level_info;
+								if (transcoder.get_image_level_info(level_info, mip, layer, face))
 								{
-									for (uint32_t face = 0; face < faces; ++face)
-									{
-										for (uint32_t mip = 0; mip < levels; ++mip)
-										{
-											basist::ktx2_image_level_info level_info;
-											if (transcoder.get_image_level_info(level_info, mip, layer, face))
-											{
-												uint32_t pixel_or_block_count = (import_compressed
-													? level_info.m_total_blocks
-													: (level_info.m_orig_width * level_info.m_orig_height));
-												transcoded_data_size += bytes_per_block * pixel_or_block_count;
-											}
-										}
-									}
+									TranscodeTask& task = tasks.emplace_back();
+									task.mip = mip;
+									task.layer = layer;
+									task.face = face;
+									task.offset = transcoded_data_size;
+									task.width = level_info.m_orig_width;
+									task.height = level_info.m_orig_height;
+									task.blocks_x = level_info.m_num_blocks_x;
+									task.blocks_y = level_info.m_num_blocks_y;
+									task.pixel_or_block_count = (import_compressed
+										? level_info.m_total_blocks
+										: (level_info.m_orig_width * level_info.m_orig_height));
+									task.row_pitch = (import_compressed ? level_info.m_num_blocks_x : level_info.m_orig_width) * bytes_per_block;
+									task.slice_pitch = task.row_pitch * (import_compressed ? level_info.m_num_blocks_y : level_info.m_orig_height);
+									transcoded_data_size += bytes_per_block * task.pixel_or_block_count;
 								}
-								wi::vector<uint8_t> transcoded_data(transcoded_data_size);
-								
-								wi::vector<SubresourceData> InitData;
-								size_t transcoded_data_offset = 0;
-								for (uint32_t layer = 0; layer < layers; ++layer)
+								else
 								{
-									for (uint32_t face = 0; face < faces; ++face)
-									{
-										for (uint32_t mip = 0; mip < levels; ++mip)
-										{
-											basist::ktx2_image_level_info level_info;
-											if (transcoder.get_image_level_info(level_info, mip, layer, face))
-											{
-												void* data_ptr = transcoded_data.data() + transcoded_data_offset;
-												uint32_t pixel_or_block_count = (import_compressed
-													? level_info.m_total_blocks
-													: (level_info.m_orig_width * level_info.m_orig_height));
-												transcoded_data_offset += bytes_per_block * pixel_or_block_count;
-												if (transcoder.transcode_image_level(
-													mip,
-													layer,
-													face,
-													data_ptr,
-													pixel_or_block_count,
-													fmt
-												))
-												{
-													SubresourceData subresourceData;
-													subresourceData.data_ptr = data_ptr;
-													subresourceData.row_pitch = (import_compressed ? level_info.m_num_blocks_x : level_info.m_orig_width) * bytes_per_block;
-													subresourceData.slice_pitch = subresourceData.row_pitch * (import_compressed ? level_info.m_num_blocks_y : level_info.m_orig_height);
-													InitData.push_back(subresourceData);
-												}
-												else
-												{
-													wi::backlog::post("KTX2 transcoding error while loading image!", wi::backlog::LogLevel::Error);
-													assert(0);
-												}
-											}
-											else
-											{
-												wi::backlog::post("KTX2 transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
-												assert(0);
-											}
-										}
-									}
+									wi::backlog::post("KTX2 transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
+									valid = false;
 								}
+							}
+						}
+					}
+					wi::vector<uint8_t> transcoded_data(transcoded_data_size);
 
-								if (!InitData.empty())
-								{
-									success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
-									device->SetName(&resource->texture, name.c_str());
+					const uint32_t supercompression = transcoder.get_header().m_supercompression_scheme;
+					if (valid && transcoder.is_uastc() && (supercompression == basist::KTX2_SS_NONE || supercompression == basist::KTX2_SS_ZSTANDARD))
+					{
+						// Zstandard supercompression is applied to whole mip levels, they are decompressed once in parallel:
+						const auto& level_index = transcoder.get_level_index();
+						wi::vector<wi::vector<uint8_t>> levels_data;
+						if (supercompression == basist::KTX2_SS_ZSTANDARD)
+						{
+							levels_data.resize(levels);
+							valid = TranscodeJobs(levels - first_mip, [&](uint32_t job_index) {
+								const uint32_t mip = first_mip + job_index;
+								const basist::ktx2_level_index& level = level_index[mip];
+								levels_data[mip].resize((size_t)level.m_uncompressed_byte_length);
+								const size_t result = ZSTD_decompress(levels_data[mip].data(), levels_data[mip].size(), transcoder.get_data() + level.m_byte_offset, (size_t)level.m_byte_length);
+								return !ZSTD_isError(result) && result == levels_data[mip].size();
+							});
+						}
 
-									Format srgb_format = GetFormatSRGB(desc.format);
-									if (srgb_format != Format::UNKNOWN && srgb_format != desc.format)
-									{
-										resource->srgb_subresource = device->CreateSubresource(
-											&resource->texture,
-											SubresourceType::SRV,
-											0, -1,
-											0, -1,
-											&srgb_format
-										);
-									}
-								}
+						wi::vector<TranscodeBand> bands;
+						for (uint32_t i = 0; i < (uint32_t)tasks.size(); ++i)
+						{
+							for (uint32_t y = 0; y < tasks[i].blocks_y; y += uastc_band_block_rows)
+							{
+								TranscodeBand& band = bands.emplace_back();
+								band.task = i;
+								band.first_block_row = y;
+								band.block_rows = std::min(uastc_band_block_rows, tasks[i].blocks_y - y);
 							}
-							transcoder.clear();
 						}
+
+						// Every band is transcoded by a separate job, with a low level transcoder that doesn't have state:
+						valid = valid && TranscodeJobs((uint32_t)bands.size(), [&](uint32_t job_index) {
+							const TranscodeBand& band = bands[job_index];
+							const TranscodeTask& task = tasks[band.task];
+							const size_t slice_size = size_t(task.blocks_x) * task.blocks_y * uastc_block_size;
+							const size_t slice_offset = size_t(task.layer * faces + task.face) * slice_size;
+							const uint8_t* level_data = levels_data.empty() ? transcoder.get_data() + level_index[task.mip].m_byte_offset : levels_data[task.mip].data();
+							const size_t level_size = levels_data.empty() ? (size_t)level_index[task.mip].m_byte_length : levels_data[task.mip].size();
+							if (slice_offset + slice_size > level_size)
+								return false;
+
+							const uint32_t band_size = band.block_rows * task.blocks_x * uastc_block_size;
+							const uint32_t band_height = std::min(band.block_rows * 4, task.height - band.first_block_row * 4);
+							const uint8_t* src = level_data + slice_offset + size_t(band.first_block_row) * task.blocks_x * uastc_block_size;
+							uint8_t* dst = transcoded_data.data() + task.offset + size_t(band.first_block_row) * (import_compressed ? task.row_pitch : task.row_pitch * 4);
+							basist::basisu_lowlevel_uastc_transcoder uastc_transcoder;
+							return uastc_transcoder.transcode_image(
+								fmt,
+								dst,
+								import_compressed ? (band.block_rows * task.blocks_x) : (band_height * task.width),
+								src,
+								band_size,
+								task.blocks_x,
+								band.block_rows,
+								task.width,
+								band_height,
+								task.mip,
+								0,
+								band_size,
+								0,
+								transcoder.get_has_alpha(),
+								transcoder.is_video()
+							);
+						});
 					}
-					else if (!ext.compare("BASIS"))
+					else if (valid)
 					{
-						basist::basisu_transcoder transcoder;
-						if (transcoder.validate_header(filedata, (uint32_t)filesize))
+						// Every subresource is transcoded by a separate job with its own transcoder state, the transcoder itself is only read:
+						valid = TranscodeJobs((uint32_t)tasks.size(), [&](uint32_t job_index) {
+							const TranscodeTask& task = tasks[job_index];
+							basist::ktx2_transcoder_state state;
+							state.clear();
+							return transcoder.transcode_image_level(
+								task.mip,
+								task.layer,
+								task.face,
+								transcoded_data.data() + task.offset,
+								task.pixel_or_block_count,
+								fmt,
+								0, 0, 0, -1, -1,
+								&state
+							);
+						});
+					}
+					if (!valid)
+					{
+						wi::backlog::post("KTX2 transcoding error while loading image!", wi::backlog::LogLevel::Error);
+						assert(0);
+					}
+
+					wi::vector<SubresourceData> InitData;
+					if (valid)
+					{
+						for (const TranscodeTask& task : tasks)
 						{
-							basist::basisu_file_info fileInfo;
-							if (transcoder.get_file_info(filedata, (uint32_t)filesize, fileInfo))
-							{
-								uint32_t image_index = 0;
-								basist::basisu_image_info info;
-								if (transcoder.get_image_info(filedata, (uint32_t)filesize, info, image_index))
-								{
-									TextureDesc desc;
-									desc.bind_flags = BindFlag::SHADER_RESOURCE;
-									desc.width = info.m_width;
-									desc.height = info.m_height;
-									desc.mip_levels = info.m_total_levels;
-									desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
+							SubresourceData& subresourceData = InitData.emplace_back();
+							subresourceData.data_ptr = transcoded_data.data() + task.offset;
+							subresourceData.row_pitch = task.row_pitch;
+							subresourceData.slice_pitch = task.slice_pitch;
+						}
+					}
 
-									basist::transcoder_texture_format fmt = basist::transcoder_texture_format::cTFRGBA32;
-									desc.format = Format::R8G8B8A8_UNORM;
+					if (!InitData.empty())
+					{
+						success = device->CreateTexture(&desc, InitData.data(), &texture);
+						device->SetName(&texture, name.c_str());
 
-									bool import_compressed = has_flag(flags, Flags::IMPORT_BLOCK_COMPRESSED);
-									if (import_compressed)
-									{
-										// BC5 is disabled because it's missing green channel!
-										//if (has_flag(flags, Flags::IMPORT_NORMALMAP))
-										//{
-										//	fmt = basist::transcoder_texture_format::cTFBC5_RG;
-										//	desc.format = Format::BC5_UNORM;
-										//	desc.swizzle.r = ComponentSwizzle::R;
-										//	desc.swizzle.g = ComponentSwizzle::G;
-										//	desc.swizzle.b = ComponentSwizzle::ONE;
-										//	desc.swizzle.a = ComponentSwizzle::ONE;
-										//}
-										//else
-										{
-											if (info.m_alpha_flag)
-											{
-												fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
-												desc.format = Format::BC3_UNORM;
-											}
-											else
-											{
-												fmt = basist::transcoder_texture_format::cTFBC1_RGB;
-												desc.format = Format::BC1_UNORM;
-											}
-										}
-									}
-									uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
+						Format srgb_format = GetFormatSRGB(desc.format);
+						if (srgb_format != Format::UNKNOWN && srgb_format != desc.format)
+						{
+							srgb_subresource = device->CreateSubresource(
+								&texture,
+								SubresourceType::SRV,
+								0, -1,
+								0, -1,
+								&srgb_format
+							);
+						}
+					}
+				}
+				transcoder.clear();
+			}
 
-									if (transcoder.start_transcoding(filedata, (uint32_t)filesize))
-									{
-										// all subresources will use one allocation for transcoder destination, so compute combined size:
-										size_t transcoded_data_size = 0;
-										for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
-										{
-											basist::basisu_image_level_info level_info;
-											if (transcoder.get_image_level_info(filedata, (uint32_t)filesize, level_info, image_index, mip))
-											{
-												uint32_t pixel_or_block_count = (import_compressed
-													? level_info.m_total_blocks
-													: (level_info.m_orig_width * level_info.m_orig_height));
-												transcoded_data_size += bytes_per_block * pixel_or_block_count;
-											}
-										}
-										wi::vector<uint8_t> transcoded_data(transcoded_data_size);
+			return success;
+		}
 
-										wi::vector<SubresourceData> InitData;
-										size_t transcoded_data_offset = 0;
-										for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+		// Texture streaming:
+		static std::atomic<size_t> streaming_budget{ 1024ull * 1024ull * 1024ull };
+		static std::atomic<size_t> streaming_usage{ 0 };
+		static std::atomic<uint32_t> streaming_tail_resolution{ 128 };
+		struct StreamingEntry
+		{
+			std::string name;
+			std::weak_ptr<ResourceInternal> resource;
+		};
+		static std::mutex streaming_locker;
+		static wi::vector<StreamingEntry> streaming_entries;
+		static uint64_t streaming_frame = 0;
+		static std::atomic<uint32_t> streaming_jobs{ 0 };
+		static wi::jobsystem::context streaming_ctx;
+
+		void SetStreamingMemoryBudget(size_t bytes)
+		{
+			streaming_budget.store(bytes);
+		}
+		size_t GetStreamingMemoryBudget()
+		{
+			return streaming_budget.load();
+		}
+		size_t GetStreamingMemoryUsage()
+		{
+			return streaming_usage.load();
+		}
+		void SetStreamingTailResolution(uint32_t resolution)
+		{
+			streaming_tail_resolution.store(std::max(1u, resolution));
+		}
+		uint32_t GetStreamingTailResolution()
+		{
+			return streaming_tail_resolution.load();
+		}
+
+		size_t ComputeStreamingMemory(const TextureDesc& desc, uint32_t first_mip)
+		{
+			const uint32_t block_size = GetFormatBlockSize(desc.format);
+			const uint32_t stride = GetFormatStride(desc.format);
+			size_t size = 0;
+			for (uint32_t mip = first_mip; mip < desc.mip_levels; ++mip)
+			{
+				const uint32_t width = std::max(1u, desc.width >> mip);
+				const uint32_t height = std::max(1u, desc.height >> mip);
+				const uint32_t depth = std::max(1u, desc.depth >> mip);
+				const size_t blocks_x = (width + block_size - 1) / block_size;
+				const size_t blocks_y = (height + block_size - 1) / block_size;
+				size += blocks_x * blocks_y * depth * stride;
+			}
+			return size * desc.array_size;
+		}
+		uint32_t ComputeStreamingTailMip(const TextureDesc& desc, uint32_t resolution)
+		{
+			uint32_t mip = 0;
+			while (mip + 1 < desc.mip_levels && std::max(desc.width >> mip, desc.height >> mip) > resolution)
+			{
+				mip++;
+			}
+			return mip;
+		}
+		uint32_t ComputeStreamingRequestedMip(const StreamingTexture& texture)
+		{
+			if (texture.requested_resolution == 0)
+				return texture.tail_mip;
+			uint32_t mip = 0;
+			while (mip < texture.tail_mip && std::max(texture.desc.width >> (mip + 1), texture.desc.height >> (mip + 1)) >= texture.requested_resolution)
+			{
+				mip++;
+			}
+			return mip;
+		}
+		size_t ComputeStreamingTargets(const StreamingTexture* textures, size_t count, size_t budget, uint32_t* target_mips)
+		{
+			size_t total = 0;
+			wi::vector<uint32_t> order(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				order[i] = uint32_t(i);
+				target_mips[i] = textures[i].tail_mip;
+				total += ComputeStreamingMemory(textures[i].desc, textures[i].tail_mip);
+			}
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				if (textures[a].last_request_frame != textures[b].last_request_frame)
+					return textures[a].last_request_frame > textures[b].last_request_frame;
+				return a < b;
+			});
+			for (uint32_t i : order)
+			{
+				const StreamingTexture& texture = textures[i];
+				const size_t tail_memory = ComputeStreamingMemory(texture.desc, texture.tail_mip);
+				for (uint32_t mip = ComputeStreamingRequestedMip(texture); mip < texture.tail_mip; ++mip)
+				{
+					const size_t memory = ComputeStreamingMemory(texture.desc, mip);
+					if (total + memory - tail_memory <= budget)
+					{
+						total += memory - tail_memory;
+						target_mips[i] = mip;
+						break;
+					}
+				}
+			}
+			return total;
+		}
+
+		// Sets up streaming after the initial texture load, if it has less mips than the full resolution texture
+		static void InitStreaming(ResourceInternal* resource)
+		{
+			if (resource->streaming_desc.mip_levels > resource->texture.desc.mip_levels)
+			{
+				resource->streaming_tail_mip = resource->streaming_desc.mip_levels - resource->texture.desc.mip_levels;
+				resource->streaming_resident_mip = resource->streaming_tail_mip;
+			}
+		}
+
+		// Texture cache stores the final GPU texture of imported images, so decoding, mipmap generation and block compression can be skipped next time
+		//	The cache file name is the hash of the source file data and import flags, so it is invalidated by any change of those
+		static std::atomic_bool texture_cache_enabled{ true };
+		static constexpr uint64_t texture_cache_version = 1; // increment if the texture import output changes
+		static std::string GetTextureCacheFileName(const std::string& ext, Flags flags, const uint8_t* filedata, size_t filesize)
+		{
+			if (!texture_cache_enabled.load())
+				return "";
+			if (!ext.compare("KTX2") || !ext.compare("BASIS") || !ext.compare("DDS") || !ext.compare("HDR"))
+				return ""; // these are not decoded with the image importer
+			if (has_flag(flags, Flags::IMPORT_COLORGRADINGLUT))
+				return "";
+			const std::string directory = wi::helper::GetCacheDirectoryPath();
+			if (directory.empty())
+				return "";
+
+			const Flags key_flags = flags & (Flags::IMPORT_BLOCK_COMPRESSED | Flags::IMPORT_NORMALMAP);
+			uint64_t hash = wi::helper::data_hash(filedata, filesize, texture_cache_version);
+			hash = wi::helper::data_hash(&key_flags, sizeof(key_flags), hash);
+
+			char hash_string[17] = {};
+			snprintf(hash_string, sizeof(hash_string), "%016llx", (unsigned long long)hash);
+			return directory + "/WickedEngine/texturecache/" + hash_string + ".dds";
+		}
+		// Writes the texture into the texture cache when its deferred GPU processing is finished
+		static void WriteTextureCache(const Texture& texture, const std::string& cache_filename)
+		{
+			wi::renderer::AddDeferredTextureReadback(texture, [cache_filename](const wi::vector<uint8_t>& texturedata, const TextureDesc& desc) {
+				wi::vector<uint8_t> filedata;
+				if (wi::helper::saveTextureToMemoryFile(texturedata, desc, "dds", filedata))
+				{
+					wi::helper::DirectoryCreate(wi::helper::GetDirectoryFromPath(cache_filename));
+					// Written to a temporary file first, so that a partially written file is never read:
+					const std::string tmp_filename = cache_filename + ".tmp";
+					if (wi::helper::FileWrite(tmp_filename, filedata.data(), filedata.size()))
+					{
+						std::error_code ec;
+						std::filesystem::rename(tmp_filename, cache_filename, ec);
+					}
+				}
+			});
+		}
+		void SetTextureCacheEnabled(bool value)
+		{
+			texture_cache_enabled.store(value);
+		}
+		bool IsTextureCacheEnabled()
+		{
+			return texture_cache_enabled.load();
+		}
+
+
+		// If file data was not provided, it will be read from file
+		static bool ReadFileData(ResourceInternal* resource, const std::string& name, const uint8_t*& filedata, size_t& filesize)
+		{
+			if (filedata != nullptr && filesize > 0)
+			{
+				return true;
+			}
+			filedata = nullptr;
+			if (resource->filedata.empty())
+			{
+				// Files that are stored uncompressed in a mounted package are used from the package memory without copying:
+				if (!wi::helper::PackageFileView(name, filedata, filesize) && !wi::helper::FileRead(name, resource->filedata))
+				{
+					return false;
+				}
+				resource->from_file = true;
+			}
+			if (filedata == nullptr)
+			{
+				filedata = resource->filedata.data();
+				filesize = resource->filedata.size();
+			}
+			return true;
+		}
+
+		// Resources are also identified by content, so that the same file loaded with different names is only created once
+		//	The names whose content matches an existing resource become aliases of it
+		static std::mutex content_locker;
+		static std::unordered_map<uint64_t, std::weak_ptr<ResourceInternal>> content_resources;
+		static uint64_t ComputeContentHash(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		{
+			// The extension selects the importer and the flags modify it, so they are part of the identity, except IMPORT_DELAY:
+			const std::string ext = wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name));
+			const uint64_t identity_flags = uint64_t(flags & ~Flags::IMPORT_DELAY);
+			const uint64_t seed = wi::helper::data_hash(ext.c_str(), ext.length(), identity_flags);
+			return wi::helper::data_hash(filedata, filesize, seed);
+		}
+		// Registers the resource by its content, or returns the existing resource which has the same content
+		static std::shared_ptr<ResourceInternal> RegisterContent(const std::shared_ptr<ResourceInternal>& resource)
+		{
+			std::scoped_lock lock(content_locker);
+			std::weak_ptr<ResourceInternal>& weak_resource = content_resources[resource->content_hash];
+			std::shared_ptr<ResourceInternal> existing = weak_resource.lock();
+			if (existing != nullptr && existing->state.load() != ResourceInternal::State::FAILED)
+			{
+				return existing;
+			}
+			weak_resource = resource;
+			return nullptr;
+		}
+
+		// Creates the resource contents from file data, this is called by only one thread per resource at a time
+		static bool LoadResourceInternal(ResourceInternal* resource, const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		{
+			static const bool basis_init = [] {
+				basist::basisu_transcoder_init();
+				return true;
+			}();
+			(void)basis_init;
+
+			if (!ReadFileData(resource, name, filedata, filesize))
+			{
+				return false;
+			}
+
+			bool success = false;
+
+			std::string ext = wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name));
+			auto type_it = types.find(ext);
+			if (type_it != types.end())
+			{
+				resource->type = type_it->second;
+			}
+
+			if (has_flag(flags, Flags::IMPORT_DELAY))
+			{
+				success = true;
+			}
+			else
+			{
+				// dynamic type selection:
+				if (type_it == types.end())
+				{
+					return false;
+				}
+				const DataType type = type_it->second;
+
+				switch (type)
+				{
+				case DataType::IMAGE:
+				{
+					GraphicsDevice* device = wi::graphics::GetDevice();
+					const std::string cache_filename = GetTextureCacheFileName(ext, flags, filedata, filesize);
+					wi::vector<uint8_t> cache_filedata;
+					if (!cache_filename.empty() && wi::helper::FileRead(cache_filename, cache_filedata) && LoadTextureDDS(name, cache_filedata.data(), cache_filedata.size(), resource->texture, resource->srgb_subresource, true))
+					{
+						// Loaded the final texture from the texture cache
+						success = true;
+					}
+					else if (!ext.compare("KTX2"))
+					{
+						const uint32_t max_resolution = has_flag(flags, Flags::STREAMING) ? streaming_tail_resolution.load() : 0;
+						success = LoadTextureKTX2(name, flags, filedata, filesize, resource->texture, resource->srgb_subresource, max_resolution, &resource->streaming_desc);
+						if (success && max_resolution > 0)
+						{
+							InitStreaming(resource);
+						}
+					}
+					else if (!ext.compare("BASIS"))
+					{
+						basist::basisu_transcoder transcoder;
+						if (transcoder.validate_header(filedata, (uint32_t)filesize))
+						{
+							basist::basisu_file_info fileInfo;
+							if (transcoder.get_file_info(filedata, (uint32_t)filesize, fileInfo))
+							{
+								uint32_t image_index = 0;
+								basist::basisu_image_info info;
+								if (transcoder.get_image_info(filedata, (uint32_t)filesize, info, image_index))
+								{
+									TextureDesc desc;
+									desc.bind_flags = BindFlag::SHADER_RESOURCE;
+									desc.width = info.m_width;
+									desc.height = info.m_height;
+									desc.mip_levels = info.m_total_levels;
+									desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
+
+									basist::transcoder_texture_format fmt = basist::transcoder_texture_format::cTFRGBA32;
+									desc.format = Format::R8G8B8A8_UNORM;
+
+									bool import_compressed = has_flag(flags, Flags::IMPORT_BLOCK_COMPRESSED);
+									if (import_compressed)
+									{
+										// BC5 is disabled because it's missing green channel!
+										//if (has_flag(flags, Flags::IMPORT_NORMALMAP))
+										//{
+										//	fmt = basist::transcoder_texture_format::cTFBC5_RG;
+										//	desc.format = Format::BC5_UNORM;
+										//	desc.swizzle.r = ComponentSwizzle::R;
+										//	desc.swizzle.g = ComponentSwizzle::G;
+										//	desc.swizzle.b = ComponentSwizzle::ONE;
+										//	desc.swizzle.a = ComponentSwizzle::ONE;
+										//}
+										//else
+										{
+											if (info.m_alpha_flag)
+											{
+												fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
+												desc.format = Format::BC3_UNORM;
+											}
+											else
+											{
+												fmt = basist::transcoder_texture_format::cTFBC1_RGB;
+												desc.format = Format::BC1_UNORM;
+											}
+										}
+									}
+									uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
+
+									if (transcoder.start_transcoding(filedata, (uint32_t)filesize))
+									{
+										// all subresources will use one allocation for transcoder destination, so compute combined size and offsets:
+										wi::vector<TranscodeTask> tasks;
+										size_t transcoded_data_size = 0;
+										bool valid = true;
+										for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
 										{
 											basist::basisu_image_level_info level_info;
-											if (transcoder.get_image_level_info(filedata, (uint32_t)filesize, level_info, 0, mip))
+											if (transcoder.get_image_level_info(filedata, (uint32_t)filesize, level_info, image_index, mip))
 											{
-												void* data_ptr = transcoded_data.data() + transcoded_data_offset;
-												uint32_t pixel_or_block_count = (import_compressed
+												TranscodeTask& task = tasks.emplace_back();
+												task.mip = mip;
+												task.offset = transcoded_data_size;
+												task.pixel_or_block_count = (import_compressed
 													? level_info.m_total_blocks
 													: (level_info.m_orig_width * level_info.m_orig_height));
-												transcoded_data_offset += pixel_or_block_count * bytes_per_block;
-												if (transcoder.transcode_image_level(
-													filedata,
-													(uint32_t)filesize,
-													image_index,
-													mip,
-													data_ptr,
-													pixel_or_block_count,
-													fmt
-												))
-												{
-													SubresourceData subresourceData;
-													subresourceData.data_ptr = data_ptr;
-													subresourceData.row_pitch = (import_compressed ? level_info.m_num_blocks_x : level_info.m_orig_width) * bytes_per_block;
-													subresourceData.slice_pitch = subresourceData.row_pitch * (import_compressed ? level_info.m_num_blocks_y : level_info.m_orig_height);
-													InitData.push_back(subresourceData);
-												}
-												else
-												{
-													wi::backlog::post("BASIS transcoding error while loading image!", wi::backlog::LogLevel::Error);
-													assert(0);
-												}
+												task.row_pitch = (import_compressed ? level_info.m_num_blocks_x : level_info.m_orig_width) * bytes_per_block;
+												task.slice_pitch = task.row_pitch * (import_compressed ? level_info.m_num_blocks_y : level_info.m_orig_height);
+												transcoded_data_size += bytes_per_block * task.pixel_or_block_count;
 											}
 											else
 											{
 												wi::backlog::post("BASIS transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
-												assert(0);
+												valid = false;
+											}
+										}
+										wi::vector<uint8_t> transcoded_data(transcoded_data_size);
+
+										// Every mip is transcoded by a separate job with its own transcoder state, the transcoder itself is only read:
+										valid = valid && TranscodeJobs((uint32_t)tasks.size(), [&](uint32_t job_index) {
+											const TranscodeTask& task = tasks[job_index];
+											basist::basisu_transcoder_state state;
+											return transcoder.transcode_image_level(
+												filedata,
+												(uint32_t)filesize,
+												image_index,
+												task.mip,
+												transcoded_data.data() + task.offset,
+												task.pixel_or_block_count,
+												fmt,
+												0, 0,
+												&state
+											);
+										});
+										if (!valid)
+										{
+											wi::backlog::post("BASIS transcoding error while loading image!", wi::backlog::LogLevel::Error);
+											assert(0);
+										}
+
+										wi::vector<SubresourceData> InitData;
+										if (valid)
+										{
+											for (const TranscodeTask& task : tasks)
+											{
+												SubresourceData& subresourceData = InitData.emplace_back();
+												subresourceData.data_ptr = transcoded_data.data() + task.offset;
+												subresourceData.row_pitch = task.row_pitch;
+												subresourceData.slice_pitch = task.slice_pitch;
 											}
 										}
 
@@ -590,169 +1239,13 @@ namespace wi
 					else if (!ext.compare("DDS"))
 					{
 						// Load dds
-
-						tinyddsloader::DDSFile dds;
-						auto result = dds.Load(filedata, filesize);
-
-						if (result == tinyddsloader::Result::Success)
+						const uint32_t max_resolution = has_flag(flags, Flags::STREAMING) ? streaming_tail_resolution.load() : 0;
+						success = LoadTextureDDS(name, filedata, filesize, resource->texture, resource->srgb_subresource, false, max_resolution, &resource->streaming_desc);
+						assert(success); // failed to load DDS
+						if (success && max_resolution > 0)
 						{
-							TextureDesc desc;
-							desc.array_size = 1;
-							desc.bind_flags = BindFlag::SHADER_RESOURCE;
-							desc.width = dds.GetWidth();
-							desc.height = dds.GetHeight();
-							desc.depth = dds.GetDepth();
-							desc.mip_levels = dds.GetMipCount();
-							desc.array_size = dds.GetArraySize();
-							desc.format = Format::R8G8B8A8_UNORM;
-							desc.layout = ResourceState::SHADER_RESOURCE;
-							desc.misc_flags = ResourceMiscFlag::TYPED_FORMAT_CASTING;
-
-							if (dds.IsCubemap())
-							{
-								desc.misc_flags |= ResourceMiscFlag::TEXTURECUBE;
-							}
-
-							auto ddsFormat = dds.GetFormat();
-
-							switch (ddsFormat)
-							{
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_Float: desc.format = Format::R32G32B32A32_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_UInt: desc.format = Format::R32G32B32A32_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_SInt: desc.format = Format::R32G32B32A32_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_Float: desc.format = Format::R32G32B32_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_UInt: desc.format = Format::R32G32B32_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_SInt: desc.format = Format::R32G32B32_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_Float: desc.format = Format::R16G16B16A16_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UNorm: desc.format = Format::R16G16B16A16_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UInt: desc.format = Format::R16G16B16A16_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SNorm: desc.format = Format::R16G16B16A16_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SInt: desc.format = Format::R16G16B16A16_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32_Float: desc.format = Format::R32G32_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32_UInt: desc.format = Format::R32G32_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32G32_SInt: desc.format = Format::R32G32_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UNorm: desc.format = Format::R10G10B10A2_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UInt: desc.format = Format::R10G10B10A2_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R11G11B10_Float: desc.format = Format::R11G11B10_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R9G9B9E5_SHAREDEXP: desc.format = Format::R9G9B9E5_SHAREDEXP; break;
-							case tinyddsloader::DDSFile::DXGIFormat::B8G8R8X8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB: desc.format = Format::B8G8R8A8_UNORM_SRGB; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm: desc.format = Format::R8G8B8A8_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB: desc.format = Format::R8G8B8A8_UNORM_SRGB; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UInt: desc.format = Format::R8G8B8A8_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SNorm: desc.format = Format::R8G8B8A8_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SInt: desc.format = Format::R8G8B8A8_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16_Float: desc.format = Format::R16G16_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16_UNorm: desc.format = Format::R16G16_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16_UInt: desc.format = Format::R16G16_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16_SNorm: desc.format = Format::R16G16_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16G16_SInt: desc.format = Format::R16G16_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::D32_Float: desc.format = Format::D32_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32_Float: desc.format = Format::R32_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32_UInt: desc.format = Format::R32_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R32_SInt: desc.format = Format::R32_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8_UNorm: desc.format = Format::R8G8_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8_UInt: desc.format = Format::R8G8_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8_SNorm: desc.format = Format::R8G8_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8G8_SInt: desc.format = Format::R8G8_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16_Float: desc.format = Format::R16_FLOAT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::D16_UNorm: desc.format = Format::D16_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16_UNorm: desc.format = Format::R16_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16_UInt: desc.format = Format::R16_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16_SNorm: desc.format = Format::R16_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R16_SInt: desc.format = Format::R16_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8_UNorm: desc.format = Format::R8_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8_UInt: desc.format = Format::R8_UINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8_SNorm: desc.format = Format::R8_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::R8_SInt: desc.format = Format::R8_SINT; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm: desc.format = Format::BC1_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm_SRGB: desc.format = Format::BC1_UNORM_SRGB; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm: desc.format = Format::BC2_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm_SRGB: desc.format = Format::BC2_UNORM_SRGB; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm: desc.format = Format::BC3_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm_SRGB: desc.format = Format::BC3_UNORM_SRGB; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC4_UNorm: desc.format = Format::BC4_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC4_SNorm: desc.format = Format::BC4_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC5_UNorm: desc.format = Format::BC5_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC5_SNorm: desc.format = Format::BC5_SNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC6H_SF16: desc.format = Format::BC6H_SF16; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC6H_UF16: desc.format = Format::BC6H_UF16; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm: desc.format = Format::BC7_UNORM; break;
-							case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm_SRGB: desc.format = Format::BC7_UNORM_SRGB; break;
-							default:
-								assert(0); // incoming format is not supported 
-								break;
-							}
-
-							if (desc.format == Format::BC5_UNORM)
-							{
-								desc.swizzle.r = ComponentSwizzle::R;
-								desc.swizzle.g = ComponentSwizzle::G;
-								desc.swizzle.b = ComponentSwizzle::ONE;
-								desc.swizzle.a = ComponentSwizzle::ONE;
-							}
-
-							wi::vector<SubresourceData> InitData;
-							for (uint32_t arrayIndex = 0; arrayIndex < desc.array_size; ++arrayIndex)
-							{
-								for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
-								{
-									auto imageData = dds.GetImageData(mip, arrayIndex);
-									SubresourceData subresourceData;
-									subresourceData.data_ptr = imageData->m_mem;
-									subresourceData.row_pitch = imageData->m_memPitch;
-									subresourceData.slice_pitch = imageData->m_memSlicePitch;
-									InitData.push_back(subresourceData);
-								}
-							}
-
-							auto dim = dds.GetTextureDimension();
-							switch (dim)
-							{
-							case tinyddsloader::DDSFile::TextureDimension::Texture1D:
-							{
-								desc.type = TextureDesc::Type::TEXTURE_1D;
-							}
-							break;
-							case tinyddsloader::DDSFile::TextureDimension::Texture2D:
-							{
-								desc.type = TextureDesc::Type::TEXTURE_2D;
-							}
-							break;
-							case tinyddsloader::DDSFile::TextureDimension::Texture3D:
-							{
-								desc.type = TextureDesc::Type::TEXTURE_3D;
-							}
-							break;
-							default:
-								assert(0);
-								break;
-							}
-
-							if (IsFormatBlockCompressed(desc.format))
-							{
-								desc.width = AlignTo(desc.width, GetFormatBlockSize(desc.format));
-								desc.height = AlignTo(desc.height, GetFormatBlockSize(desc.format));
-							}
-
-							success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
-							device->SetName(&resource->texture, name.c_str());
-
-							Format srgb_format = GetFormatSRGB(desc.format);
-							if (srgb_format != Format::UNKNOWN && srgb_format != desc.format)
-							{
-								resource->srgb_subresource = device->CreateSubresource(
-									&resource->texture,
-									SubresourceType::SRV,
-									0, -1,
-									0, -1,
-									&srgb_format
-								);
-							}
+							InitStreaming(resource);
 						}
-						else assert(0); // failed to load DDS
-
 					}
 					else if (!ext.compare("HDR"))
 					{
@@ -1089,6 +1582,11 @@ namespace wi
 
 									wi::renderer::AddDeferredBlockCompression(uncompressed_src, resource->texture);
 								}
+
+								if (success && !cache_filename.empty())
+								{
+									WriteTextureCache(resource->texture, cache_filename);
+								}
 							}
 						}
 						free(rgba);
@@ -1119,10 +1617,14 @@ namespace wi
 				case DataType::FONTSTYLE:
 				{
 					resource->font_style = wi::font::AddFontStyle(name, filedata, filesize, true);
+					resource->font_style_size = filesize;
 					success = resource->font_style >= 0;
 				}
 				break;
 
+				case DataType::COUNT:
+					break;
+
 				};
 			}
 
@@ -1130,6 +1632,21 @@ namespace wi
 			{
 				resource->flags = flags;
 
+				if (resource->streaming_tail_mip > 0 && !has_flag(flags, Flags::IMPORT_RETAIN_FILEDATA) && !resource->from_file)
+				{
+					// The source is needed for streaming, but it is not retained for serialization and it can't be read again by name:
+					if (resource->filedata.empty())
+					{
+						resource->streaming_filedata.resize(filesize);
+						std::memcpy(resource->streaming_filedata.data(), filedata, filesize);
+					}
+					else
+					{
+						resource->streaming_filedata = std::move(resource->filedata);
+						resource->filedata.clear();
+					}
+				}
+
 				if (resource->filedata.empty() && (has_flag(flags, Flags::IMPORT_RETAIN_FILEDATA) || has_flag(flags, Flags::IMPORT_DELAY)))
 				{
 					// resource was loaded with external filedata, and we want to retain filedata
@@ -1142,40 +1659,819 @@ namespace wi
 					// resource was loaded using file name, and we want to discard filedata
 					resource->filedata.clear();
 				}
-
-				Resource retVal;
-				retVal.internal_state = resource;
-				return retVal;
 			}
 
-			return Resource();
+			resource->UpdateMemoryBytes();
+
+			return success;
 		}
 
-		bool Contains(const std::string& name)
+		static std::atomic<size_t> memory_budget{ 2048ull * 1024ull * 1024ull };
+		static std::atomic_bool retain_cache_enabled{ false };
+		static std::mutex retain_locker;
+		static wi::vector<std::shared_ptr<ResourceInternal>> retain_cache;
+		static std::atomic<uint64_t> retain_load_counter{ 0 };
+		static bool memory_budget_exceeded = false;
+
+		// Marks the resource as recently loaded, and puts it into the retain cache if that's enabled
+		//	Only Load() calls this, using the resource afterwards doesn't change the order
+		static void TouchResource(const std::shared_ptr<ResourceInternal>& resource)
 		{
-			bool result = false;
-			locker.lock();
-			auto it = resources.find(name);
-			if (it != resources.end())
+			resource->load_order.store(retain_load_counter.fetch_add(1) + 1);
+			if (retain_cache_enabled.load() && !resource->retained.load())
 			{
-				auto resource = it->second.lock();
-				result = resource != nullptr;
+				std::scoped_lock lock(retain_locker);
+				// The enabled state is checked again in the lock, so the resource can't be added after the cache was disabled and cleared:
+				if (retain_cache_enabled.load() && !resource->retained.exchange(true))
+				{
+					retain_cache.push_back(resource);
+				}
 			}
-			locker.unlock();
-			return result;
 		}
 
-		void Clear()
+		Resource Load(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
 		{
-			locker.lock();
-			resources.clear();
-			locker.unlock();
-		}
+			if (mode == Mode::DISCARD_FILEDATA_AFTER_LOAD)
+			{
+				flags &= ~Flags::IMPORT_RETAIN_FILEDATA;
+			}
 
+			ResourceShard& shard = GetShard(name);
+			std::shared_ptr<ResourceInternal> resource;
+			std::shared_ptr<ResourceInternal> alias; // keeps the file data alive that was read by the discarded resource
+			bool created = false;
+			while (true)
+			{
+				shard.locker.lock();
+				std::weak_ptr<ResourceInternal>& weak_resource = shard.resources[name];
+				resource = weak_resource.lock();
+				if (resource == nullptr || resource->state.load() == ResourceInternal::State::FAILED)
+				{
+					resource = std::make_shared<ResourceInternal>();
+					resource->state.store(ResourceInternal::State::LOADING);
+					weak_resource = resource;
+					created = true;
+				}
+				shard.locker.unlock();
+
+				if (created)
+				{
+					if (!ReadFileData(resource.get(), name, filedata, filesize))
+					{
+						resource->FinishLoading(ResourceInternal::State::FAILED);
+						return Resource();
+					}
+					resource->content_hash = ComputeContentHash(name, flags, filedata, filesize);
+					std::shared_ptr<ResourceInternal> existing = RegisterContent(resource);
+					if (existing == nullptr)
+						break;
+
+					// The same content was already loaded with an other name, redirect this name to it:
+					shard.locker.lock();
+					std::weak_ptr<ResourceInternal>& weak_alias = shard.resources[name];
+					if (weak_alias.lock() == resource)
+					{
+						weak_alias = existing;
+					}
+					shard.locker.unlock();
+					resource->FinishLoading(ResourceInternal::State::ALIASED);
+					alias = std::move(resource);
+					resource = std::move(existing);
+					created = false;
+				}
+
+				// Another thread might be loading the same resource, then wait only for that one:
+				resource->WaitLoading();
+				if (resource->state.load() == ResourceInternal::State::ALIASED)
+				{
+					continue; // look up the name again, it will refer to the resource that has the same content
+				}
+				if (resource->state.load() == ResourceInternal::State::FAILED)
+				{
+					return Resource();
+				}
+
+				if (!has_flag(flags, Flags::IMPORT_DELAY) && has_flag(resource->flags, Flags::IMPORT_DELAY))
+				{
+					// If this is not an IMPORT_DELAY load, but this resource load was incomplete, using IMPORT_DELAY,
+					//	then continue loading it as normal from existing file data and remove IMPORT_DELAY flag from it
+					ResourceInternal::State expected = ResourceInternal::State::LOADED;
+					if (resource->state.compare_exchange_strong(expected, ResourceInternal::State::LOADING))
+					{
+						resource->flags &= ~Flags::IMPORT_DELAY;
+						break;
+					}
+					continue; // someone else started loading it in the meantime, wait for it
+				}
+
+				TouchResource(resource);
+				Resource retVal;
+				retVal.internal_state = resource;
+				return retVal;
+			}
+
+			if (LoadResourceInternal(resource.get(), name, flags, filedata, filesize))
+			{
+				if (resource->streaming_tail_mip > 0 && !resource->streaming_registered)
+				{
+					resource->streaming_registered = true;
+					std::scoped_lock lock(streaming_locker);
+					streaming_entries.push_back({ name, resource });
+				}
+				resource->FinishLoading(ResourceInternal::State::LOADED);
+				TouchResource(resource);
+				Resource retVal;
+				retVal.internal_state = resource;
+				return retVal;
+			}
+
+			// A newly created resource is dropped on failure, but an existing one (that was delay loaded) is kept:
+			resource->FinishLoading(created ? ResourceInternal::State::FAILED : ResourceInternal::State::LOADED);
+			return Resource();
+		}
+
+		bool Contains(const std::string& name)
+		{
+			bool result = false;
+			ResourceShard& shard = GetShard(name);
+			shard.locker.lock();
+			auto it = shard.resources.find(name);
+			if (it != shard.resources.end())
+			{
+				auto resource = it->second.lock();
+				result = resource != nullptr && resource->state.load() != ResourceInternal::State::FAILED;
+			}
+			shard.locker.unlock();
+			return result;
+		}
+
+		void Clear()
+		{
+			for (ResourceShard& shard : resource_shards)
+			{
+				shard.locker.lock();
+				shard.resources.clear();
+				shard.locker.unlock();
+			}
+			content_locker.lock();
+			content_resources.clear();
+			content_locker.unlock();
+			ClearRetainCache();
+		}
+
+		static MemoryStats ComputeMemoryStats(const ResourceInternal& resource)
+		{
+			MemoryStats stats;
+			stats.count = 1;
+			stats.filedata_bytes = resource.filedata.size() + resource.streaming_filedata.size();
+			stats.cpu_bytes = stats.filedata_bytes;
+			stats.cpu_bytes += resource.script.size();
+			stats.cpu_bytes += resource.font_style_size;
+			if (resource.texture.IsValid())
+			{
+				stats.gpu_bytes += ComputeTextureMemorySizeInBytes(resource.texture.desc);
+			}
+			if (resource.streaming_state.load() == ResourceInternal::StreamingState::READY && resource.streaming_texture.IsValid())
+			{
+				stats.gpu_bytes += ComputeTextureMemorySizeInBytes(resource.streaming_texture.desc);
+			}
+			if (resource.sound.IsValid())
+			{
+				const wi::audio::SampleInfo info = wi::audio::GetSampleInfo(&resource.sound);
+				stats.cpu_bytes += info.sample_count * info.channel_count * sizeof(short);
+			}
+			if (resource.video.IsValid())
+			{
+				stats.cpu_bytes += resource.video.sps_datas.size() + resource.video.pps_datas.size() + resource.video.slice_header_datas.size();
+				stats.gpu_bytes += resource.video.data_stream.desc.size;
+			}
+			return stats;
+		}
+		static void AddMemoryStats(MemoryStats& dst, const MemoryStats& src)
+		{
+			dst.count += src.count;
+			dst.cpu_bytes += src.cpu_bytes;
+			dst.filedata_bytes += src.filedata_bytes;
+			dst.gpu_bytes += src.gpu_bytes;
+		}
+
+		MemoryUsage GetMemoryUsage()
+		{
+			wi::vector<std::shared_ptr<ResourceInternal>> resources;
+			for (ResourceShard& shard : resource_shards)
+			{
+				shard.locker.lock();
+				for (auto& it : shard.resources)
+				{
+					std::shared_ptr<ResourceInternal> resource = it.second.lock();
+					if (resource != nullptr && resource->state.load() == ResourceInternal::State::LOADED)
+					{
+						resources.push_back(std::move(resource));
+					}
+				}
+				shard.locker.unlock();
+			}
+			// Aliases refer to the same resource, it is only counted once:
+			std::sort(resources.begin(), resources.end());
+			resources.erase(std::unique(resources.begin(), resources.end()), resources.end());
+
+			MemoryUsage usage;
+			for (auto& resource : resources)
+			{
+				const MemoryStats stats = ComputeMemoryStats(*resource);
+				AddMemoryStats(usage.total, stats);
+				if (resource->type != DataType::COUNT)
+				{
+					AddMemoryStats(usage.types[size_t(resource->type)], stats);
+				}
+				// Only the retain cache and the local list hold it:
+				if (resource->retained.load() && resource.use_count() == 2)
+				{
+					AddMemoryStats(usage.retained, stats);
+				}
+			}
+			return usage;
+		}
+
+		void SetMemoryBudget(size_t bytes)
+		{
+			memory_budget.store(bytes);
+		}
+		size_t GetMemoryBudget()
+		{
+			return memory_budget.load();
+		}
+
+		void SetRetainCacheEnabled(bool value)
+		{
+			retain_locker.lock();
+			retain_cache_enabled.store(value);
+			retain_locker.unlock();
+			if (!value)
+			{
+				ClearRetainCache();
+			}
+		}
+		bool IsRetainCacheEnabled()
+		{
+			return retain_cache_enabled.load();
+		}
+
+		void ClearRetainCache()
+		{
+			wi::vector<std::shared_ptr<ResourceInternal>> released;
+			{
+				std::scoped_lock lock(retain_locker);
+				for (auto& resource : retain_cache)
+				{
+					resource->retained.store(false);
+				}
+				released = std::move(retain_cache);
+				retain_cache.clear();
+			}
+			// The resources are destroyed here, outside the lock
+		}
+
+		void UpdateRetainCache()
+		{
+			const size_t budget = memory_budget.load();
+			size_t total = ResourceInternal::total_memory_bytes.load();
+
+			wi::vector<std::shared_ptr<ResourceInternal>> released; // destroyed at the end, outside the lock
+			if (total > budget && retain_cache_enabled.load())
+			{
+				std::scoped_lock lock(retain_locker);
+
+				// Resources that are only referenced by the retain cache can be released, least recently loaded first:
+				wi::vector<size_t> candidates;
+				for (size_t i = 0; i < retain_cache.size(); ++i)
+				{
+					if (retain_cache[i].use_count() == 1)
+					{
+						candidates.push_back(i);
+					}
+				}
+				std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) {
+					return retain_cache[a]->load_order.load() < retain_cache[b]->load_order.load();
+				});
+
+				wi::vector<bool> release(retain_cache.size());
+				for (size_t i : candidates)
+				{
+					if (total <= budget)
+						break;
+					total -= std::min(total, retain_cache[i]->memory_bytes.load());
+					release[i] = true;
+				}
+				for (size_t i = retain_cache.size(); i > 0; --i)
+				{
+					if (release[i - 1])
+					{
+						retain_cache[i - 1]->retained.store(false);
+						released.push_back(std::move(retain_cache[i - 1]));
+						retain_cache[i - 1] = std::move(retain_cache.back());
+						retain_cache.pop_back();
+					}
+				}
+			}
+
+			// Notify when the budget is exceeded by the resources that are in use:
+			if (total > budget)
+			{
+				if (!memory_budget_exceeded)
+				{
+					memory_budget_exceeded = true;
+					wi::backlog::post("Resource memory budget exceeded: " + std::to_string(total >> 20) + " MB used, budget: " + std::to_string(budget >> 20) + " MB", wi::backlog::LogLevel::Warning);
+				}
+			}
+			else
+			{
+				memory_budget_exceeded = false;
+			}
+		}
+
+		// Returns true if the mips starting from the specified one have the same size in every texture that starts from a lower mip
+		//	Then streaming can copy these mips between textures on the GPU, instead of creating them from the source again
+		static bool IsStreamingMipCopyable(const TextureDesc& desc, uint32_t mip)
+		{
+			const uint32_t alignment = GetFormatBlockSize(desc.format) << mip;
+			return (desc.width % alignment) == 0 && (desc.height % alignment) == 0;
+		}
+		// Range of the full mip chain that is contained in a texture
+		struct StreamingMipSource
+		{
+			const Texture* texture = nullptr;
+			uint32_t first_mip = 0; // the full mip chain index of the first mip of the texture
+			uint32_t end_mip = 0; // mips from this are not copied from the texture
+		};
+		// Replaces the resource texture with one that has the mips starting from first_mip, which are copied from the sources on the GPU
+		//	cmd : the command list is begun at the first copy
+		static bool CopyStreamingTexture(ResourceInternal* resource, const std::string& name, uint32_t first_mip, const StreamingMipSource* sources, size_t source_count, CommandList& cmd)
+		{
+			GraphicsDevice* device = wi::graphics::GetDevice();
+			TextureDesc desc = resource->streaming_desc;
+			desc.width = std::max(1u, desc.width >> first_mip);
+			desc.height = std::max(1u, desc.height >> first_mip);
+			desc.mip_levels -= first_mip;
+			if (IsFormatBlockCompressed(desc.format))
+			{
+				desc.width = AlignTo(desc.width, GetFormatBlockSize(desc.format));
+				desc.height = AlignTo(desc.height, GetFormatBlockSize(desc.format));
+			}
+			Texture texture;
+			if (!device->CreateTexture(&desc, nullptr, &texture))
+				return false;
+			device->SetName(&texture, name.c_str());
+
+			if (!cmd.IsValid())
+			{
+				cmd = device->BeginCommandList();
+			}
+			wi::vector<GPUBarrier> barriers;
+			barriers.push_back(GPUBarrier::Image(&texture, desc.layout, ResourceState::COPY_DST));
+			for (size_t i = 0; i < source_count; ++i)
+			{
+				barriers.push_back(GPUBarrier::Image(sources[i].texture, sources[i].texture->desc.layout, ResourceState::COPY_SRC));
+			}
+			device->Barrier(barriers.data(), (uint32_t)barriers.size(), cmd);
+			for (size_t i = 0; i < source_count; ++i)
+			{
+				const StreamingMipSource& source = sources[i];
+				for (uint32_t mip = std::max(first_mip, source.first_mip); mip < source.end_mip; ++mip)
+				{
+					device->CopyTexture(&texture, 0, 0, 0, mip - first_mip, 0, source.texture, mip - source.first_mip, 0, cmd);
+				}
+			}
+			for (auto& barrier : barriers)
+			{
+				std::swap(barrier.image.layout_before, barrier.image.layout_after);
+			}
+			device->Barrier(barriers.data(), (uint32_t)barriers.size(), cmd);
+
+			resource->texture = std::move(texture);
+			resource->srgb_subresource = -1;
+			Format srgb_format = GetFormatSRGB(desc.format);
+			if (srgb_format != Format::UNKNOWN && srgb_format != desc.format)
+			{
+				resource->srgb_subresource = device->CreateSubresource(
+					&resource->texture,
+					SubresourceType::SRV,
+					0, -1,
+					0, -1,
+					&srgb_format
+				);
+			}
+			resource->streaming_resident_mip = first_mip;
+			return true;
+		}
+
+		void UpdateStreamingResources()
+		{
+			std::scoped_lock lock(streaming_locker);
+			streaming_frame++;
+
+			CommandList cmd; // begun for the first GPU mip copy of this update
+
+			wi::vector<std::shared_ptr<ResourceInternal>> resources;
+			wi::vector<StreamingTexture> textures;
+			resources.reserve(streaming_entries.size());
+			textures.reserve(streaming_entries.size());
+			size_t usage = 0;
+			for (size_t i = 0; i < streaming_entries.size();)
+			{
+				std::shared_ptr<ResourceInternal> resource = streaming_entries[i].resource.lock();
+				if (resource == nullptr || resource->streaming_tail_mip == 0)
+				{
+					// The resource was destroyed, remove it from streaming:
+					streaming_entries[i] = std::move(streaming_entries.back());
+					streaming_entries.pop_back();
+					continue;
+				}
+
+				if (resource->streaming_state.load() == ResourceInternal::StreamingState::READY)
+				{
+					// Swap in the texture that was created in the background:
+					if (resource->streaming_texture_end_mip < resource->streaming_desc.mip_levels)
+					{
+						// Only the new mips were created, the others are copied from the current texture:
+						const StreamingMipSource sources[] = {
+							{ &resource->streaming_texture, resource->streaming_texture_mip, resource->streaming_texture_end_mip },
+							{ &resource->texture, resource->streaming_resident_mip, resource->streaming_desc.mip_levels },
+						};
+						CopyStreamingTexture(resource.get(), streaming_entries[i].name, resource->streaming_texture_mip, sources, arraysize(sources), cmd);
+					}
+					else
+					{
+						resource->texture = std::move(resource->streaming_texture);
+						resource->srgb_subresource = resource->streaming_srgb_subresource;
+						resource->streaming_resident_mip = resource->streaming_texture_mip;
+					}
+					resource->streaming_texture = {};
+					resource->streaming_state.store(ResourceInternal::StreamingState::IDLE);
+
+					if (resource->streaming_resident_mip == 0 && !resource->streaming_filedata.empty())
+					{
+						// The source that can't be read again is released when the full resolution is resident, so the texture stays at full resolution:
+						resource->streaming_filedata = {};
+						resource->streaming_source_released = true;
+					}
+					resource->UpdateMemoryBytes();
+				}
+
+				const uint32_t requested_resolution = resource->streaming_resolution.exchange(0);
+				if (requested_resolution > 0)
+				{
+					resource->streaming_requested_resolution = requested_resolution;
+					resource->streaming_last_request_frame = streaming_frame;
+				}
+
+				StreamingTexture& texture = textures.emplace_back();
+				texture.desc = resource->streaming_desc;
+				texture.tail_mip = resource->streaming_source_released ? 0 : resource->streaming_tail_mip;
+				texture.requested_resolution = resource->streaming_requested_resolution;
+				texture.last_request_frame = resource->streaming_last_request_frame;
+				usage += ComputeStreamingMemory(texture.desc, resource->streaming_resident_mip);
+				resources.push_back(std::move(resource));
+				i++;
+			}
+			streaming_usage.store(usage);
+
+			wi::vector<uint32_t> target_mips(textures.size());
+			ComputeStreamingTargets(textures.data(), textures.size(), streaming_budget.load(), target_mips.data());
+
+			const uint32_t max_jobs = std::max(1u, wi::jobsystem::GetThreadCount() / 2);
+			for (size_t i = 0; i < resources.size(); ++i)
+			{
+				const std::shared_ptr<ResourceInternal>& resource = resources[i];
+				const uint32_t target_mip = target_mips[i];
+				const uint32_t resident_mip = resource->streaming_resident_mip;
+				if (target_mip == resident_mip || resource->streaming_state.load() != ResourceInternal::StreamingState::IDLE)
+					continue;
+
+				const TextureDesc& desc = resource->streaming_desc;
+				if (target_mip > resident_mip && IsStreamingMipCopyable(desc, target_mip))
+				{
+					// Reducing the resolution doesn't need the source, the remaining mips are copied from the current texture:
+					const StreamingMipSource source = { &resource->texture, resident_mip, desc.mip_levels };
+					CopyStreamingTexture(resource.get(), streaming_entries[i].name, target_mip, &source, 1, cmd);
+					resource->UpdateMemoryBytes();
+					continue;
+				}
+				if (streaming_jobs.load() >= max_jobs)
+					continue;
+
+				// When the resolution is increased, only the new mips are created from the source if the others can be copied:
+				const uint32_t end_mip = target_mip < resident_mip && IsStreamingMipCopyable(desc, resident_mip) ? resident_mip : desc.mip_levels;
+
+				resource->streaming_state.store(ResourceInternal::StreamingState::WORKING);
+				streaming_jobs.fetch_add(1);
+				auto task = [resource, target_mip, end_mip, name = streaming_entries[i].name](wi::jobsystem::JobArgs args) {
+					// The source is read again from the file or package, unless it's kept in memory:
+					const uint8_t* filedata = nullptr;
+					size_t filesize = 0;
+					wi::vector<uint8_t> file;
+					const wi::vector<uint8_t>& kept = resource->filedata.empty() ? resource->streaming_filedata : resource->filedata;
+					if (!kept.empty())
+					{
+						filedata = kept.data();
+						filesize = kept.size();
+					}
+					else if (!wi::helper::PackageFileView(name, filedata, filesize))
+					{
+						filedata = nullptr;
+						if (wi::helper::FileRead(name, file))
+						{
+							filedata = file.data();
+							filesize = file.size();
+						}
+					}
+
+					const TextureDesc& desc = resource->streaming_desc;
+					const uint32_t max_resolution = std::max(1u, std::max(desc.width >> target_mip, desc.height >> target_mip));
+					const std::string ext = wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name));
+					bool success = false;
+					if (filedata == nullptr)
+					{
+						wi::backlog::post("Texture streaming couldn't read the source of " + name, wi::backlog::LogLevel::Warning);
+					}
+					else if (!ext.compare("KTX2"))
+					{
+						success = LoadTextureKTX2(name, resource->flags, filedata, filesize, resource->streaming_texture, resource->streaming_srgb_subresource, max_resolution, nullptr, end_mip);
+					}
+					else
+					{
+						success = LoadTextureDDS(name, filedata, filesize, resource->streaming_texture, resource->streaming_srgb_subresource, false, max_resolution, nullptr, end_mip);
+					}
+					resource->streaming_texture_mip = target_mip;
+					resource->streaming_texture_end_mip = end_mip;
+					resource->streaming_state.store(success ? ResourceInternal::StreamingState::READY : ResourceInternal::StreamingState::IDLE);
+					streaming_jobs.fetch_sub(1);
+				};
+				if (wi::jobsystem::GetThreadCount() > 0)
+				{
+					wi::jobsystem::Execute(streaming_ctx, task);
+				}
+				else
+				{
+					task({});
+				}
+			}
+		}
+
+		// Returns the loaded resource by name, or nullptr if it's not loaded
+		static std::shared_ptr<ResourceInternal> Find(const std::string& name)
+		{
+			std::shared_ptr<ResourceInternal> resource;
+			ResourceShard& shard = GetShard(name);
+			shard.locker.lock();
+			auto it = shard.resources.find(name);
+			if (it != shard.resources.end())
+			{
+				resource = it->second.lock();
+			}
+			shard.locker.unlock();
+			if (resource != nullptr && resource->state.load() != ResourceInternal::State::LOADED)
+			{
+				return nullptr;
+			}
+			return resource;
+		}
+
+		struct AsyncLoadRequest;
+		struct AsyncLoadInternal
+		{
+			std::shared_ptr<AsyncLoadRequest> request;
+			std::function<void(Resource)> callback;
+			bool cancelled = false; // within async_locker
+		};
+		struct AsyncLoadRequest
+		{
+			std::string name;
+			Flags flags = Flags::NONE;
+			LoadPriority priority = LoadPriority::NORMAL; // within async_locker
+			std::atomic<LoadState> state{ LoadState::PENDING };
+			Resource resource; // valid after state is FINISHED
+			wi::vector<std::shared_ptr<AsyncLoadInternal>> handles; // within async_locker, cleared when the request completes
+			uint32_t interest = 0; // number of not cancelled handles, within async_locker
+		};
+		static std::mutex async_locker;
+		static std::condition_variable async_finished; // notified within async_locker when a request completes
+		static wi::unordered_map<std::string, std::shared_ptr<AsyncLoadRequest>> async_requests; // queued or loading requests
+		static wi::vector<std::shared_ptr<AsyncLoadRequest>> async_queue; // pending requests in submission order
+		static uint32_t async_workers = 0; // number of running queue processing jobs, within async_locker
+		static wi::jobsystem::context async_ctx;
+
+		// Removes the request from the pending queue, must be called within async_locker
+		static void async_queue_remove(const AsyncLoadRequest* request)
+		{
+			for (size_t i = 0; i < async_queue.size(); ++i)
+			{
+				if (async_queue[i].get() == request)
+				{
+					async_queue.erase(async_queue.begin() + i);
+					return;
+				}
+			}
+		}
+
+		// Loads the resource of a request that was taken from the queue and notifies the handles
+		static void async_execute(const std::shared_ptr<AsyncLoadRequest>& request)
+		{
+			Resource resource = Load(request->name, request->flags);
+
+			// The callbacks are selected within the lock, after this the handles can no longer be cancelled:
+			wi::vector<std::function<void(Resource)>> callbacks;
+			async_locker.lock();
+			request->resource = resource;
+			request->state.store(resource.IsValid() ? LoadState::FINISHED : LoadState::FAILED);
+			for (auto& handle : request->handles)
+			{
+				if (!handle->cancelled && handle->callback)
+				{
+					callbacks.push_back(handle->callback);
+				}
+			}
+			request->handles.clear();
+			async_requests.erase(request->name);
+			async_locker.unlock();
+			async_finished.notify_all();
+
+			for (auto& callback : callbacks)
+			{
+				callback(resource);
+			}
+		}
+
+		// Processes the pending queue in priority order until it becomes empty
+		static void async_process_queue()
+		{
+			while (true)
+			{
+				async_locker.lock();
+				size_t best = async_queue.size();
+				for (size_t i = 0; i < async_queue.size(); ++i)
+				{
+					if (best == async_queue.size() || async_queue[i]->priority > async_queue[best]->priority)
+					{
+						best = i;
+					}
+				}
+				if (best == async_queue.size())
+				{
+					async_workers--;
+					async_locker.unlock();
+					return;
+				}
+				std::shared_ptr<AsyncLoadRequest> request = async_queue[best];
+				async_queue.erase(async_queue.begin() + best);
+				request->state.store(LoadState::LOADING);
+				async_locker.unlock();
+
+				async_execute(request);
+			}
+		}
+
+		LoadState AsyncLoad::GetState() const
+		{
+			const AsyncLoadInternal* handle = (const AsyncLoadInternal*)internal_state.get();
+			std::scoped_lock lock(async_locker);
+			if (handle->cancelled)
+				return LoadState::CANCELLED;
+			return handle->request->state.load();
+		}
+		bool AsyncLoad::IsFinished() const
+		{
+			LoadState state = GetState();
+			return state != LoadState::PENDING && state != LoadState::LOADING;
+		}
+		Resource AsyncLoad::GetResource() const
+		{
+			if (GetState() != LoadState::FINISHED)
+				return Resource();
+			const AsyncLoadInternal* handle = (const AsyncLoadInternal*)internal_state.get();
+			return handle->request->resource;
+		}
+		void AsyncLoad::SetPriority(LoadPriority priority)
+		{
+			AsyncLoadInternal* handle = (AsyncLoadInternal*)internal_state.get();
+			std::scoped_lock lock(async_locker);
+			handle->request->priority = priority;
+		}
+		void AsyncLoad::Cancel()
+		{
+			AsyncLoadInternal* handle = (AsyncLoadInternal*)internal_state.get();
+			std::scoped_lock lock(async_locker);
+			if (handle->cancelled)
+				return;
+			AsyncLoadRequest* request = handle->request.get();
+			if (request->state.load() != LoadState::PENDING && request->state.load() != LoadState::LOADING)
+				return; // already completed, nothing to cancel
+			handle->cancelled = true;
+			request->interest--;
+			if (request->interest == 0 && request->state.load() == LoadState::PENDING)
+			{
+				// Nobody is waiting for this anymore, so it can be removed before it starts:
+				request->state.store(LoadState::CANCELLED);
+				request->handles.clear();
+				async_queue_remove(request);
+				async_requests.erase(request->name);
+			}
+		}
+		void AsyncLoad::Wait() const
+		{
+			const AsyncLoadInternal* handle = (const AsyncLoadInternal*)internal_state.get();
+			std::shared_ptr<AsyncLoadRequest> request = handle->request;
+
+			std::unique_lock<std::mutex> lock(async_locker);
+			if (request->state.load() == LoadState::PENDING)
+			{
+				// Not started yet, load it on this thread instead of waiting for the queue:
+				async_queue_remove(request.get());
+				request->state.store(LoadState::LOADING);
+				lock.unlock();
+				async_execute(request);
+				return;
+			}
+
+			// Loading on an other thread, sleep until it completes:
+			async_finished.wait(lock, [&] { return request->state.load() != LoadState::LOADING; });
+		}
+
+		AsyncLoad LoadAsync(const std::string& name, Flags flags, LoadPriority priority, const std::function<void(Resource)>& callback)
+		{
+			std::shared_ptr<AsyncLoadInternal> handle = std::make_shared<AsyncLoadInternal>();
+			handle->callback = callback;
+
+			bool start_worker = false;
+			async_locker.lock();
+			std::shared_ptr<AsyncLoadRequest>& request = async_requests[name];
+			if (request == nullptr)
+			{
+				request = std::make_shared<AsyncLoadRequest>();
+				request->name = name;
+				request->flags = flags;
+				request->priority = priority;
+				async_queue.push_back(request);
+
+				// Only a part of the job system threads are allowed to process loads:
+				const uint32_t max_workers = std::max(1u, wi::jobsystem::GetThreadCount() / 2);
+				if (async_workers < max_workers)
+				{
+					async_workers++;
+					start_worker = true;
+				}
+			}
+			else
+			{
+				// Already queued or loading, the load is shared, but a more urgent request raises its priority:
+				request->priority = std::max(request->priority, priority);
+			}
+			request->interest++;
+			request->handles.push_back(handle);
+			handle->request = request;
+			async_locker.unlock();
+
+			if (start_worker)
+			{
+				if (wi::jobsystem::GetThreadCount() > 0)
+				{
+					wi::jobsystem::Execute(async_ctx, [](wi::jobsystem::JobArgs args) {
+						async_process_queue();
+					});
+				}
+				else
+				{
+					async_process_queue();
+				}
+			}
+
+			AsyncLoad retVal;
+			retVal.internal_state = handle;
+			return retVal;
+		}
+
+
+		void Serialize_READ(wi::Archive& archive, ResourceSerializer& seri)
+		{
+			assert(archive.IsReadMode());
+
+			// From version 91, the file data is stored once per unique content, and the resource names refer to it by hash:
+			wi::vector<wi::vector<uint8_t>> payloads;
+			wi::unordered_map<uint64_t, size_t> payload_lookup;
+			if (archive.GetVersion() >= 91)
+			{
+				size_t payload_count = 0;
+				archive >> payload_count;
+				payloads.resize(payload_count);
+				for (size_t i = 0; i < payload_count; ++i)
+				{
+					uint64_t hash = 0;
+					archive >> hash;
+					archive >> payloads[i];
+					payload_lookup[hash] = i;
+				}
+			}
 
-		void Serialize_READ(wi::Archive& archive, ResourceSerializer& seri)
-		{
-			assert(archive.IsReadMode());
 			size_t serializable_count = 0;
 			archive >> serializable_count;
 
@@ -1184,6 +2480,7 @@ namespace wi
 				std::string name;
 				Flags flags = Flags::NONE;
 				wi::vector<uint8_t> filedata;
+				const wi::vector<uint8_t>* payload = nullptr;
 			};
 			wi::vector<TempResource> temp_resources;
 			temp_resources.resize(serializable_count);
@@ -1198,15 +2495,37 @@ namespace wi
 				uint32_t flags_temp;
 				archive >> flags_temp;
 				resource.flags = (Flags)flags_temp;
-				archive >> resource.filedata;
+				if (archive.GetVersion() >= 91)
+				{
+					uint64_t hash = 0;
+					archive >> hash;
+					auto it = payload_lookup.find(hash);
+					if (it == payload_lookup.end())
+					{
+						// Corrupted archive, the resource will be loaded from its file instead of the embedded data:
+						wi::backlog::post("Resource serialization: embedded data of " + resource.name + " is missing, it will be loaded from file instead", wi::backlog::LogLevel::Error);
+					}
+					else
+					{
+						resource.payload = &payloads[it->second];
+					}
+				}
+				else
+				{
+					archive >> resource.filedata;
+					resource.payload = &resource.filedata;
+				}
 
 				resource.name = archive.GetSourceDirectory() + resource.name;
 				resource.flags |= Flags::IMPORT_DELAY; // delay resource creation, to be able to receive additional flags (this way only file data is loaded)
 
 				// "Loading" the resource can happen asynchronously to serialization of file data, to improve performance
+				//	Names that share the same payload will be loaded as aliases of the same resource
 				wi::jobsystem::Execute(ctx, [i, &temp_resources, &seri_locker, &seri](wi::jobsystem::JobArgs args) {
 					auto& tmp_resource = temp_resources[i];
-					auto res = Load(tmp_resource.name, tmp_resource.flags, tmp_resource.filedata.data(), tmp_resource.filedata.size());
+					auto res = tmp_resource.payload == nullptr ?
+						Load(tmp_resource.name, tmp_resource.flags) :
+						Load(tmp_resource.name, tmp_resource.flags, tmp_resource.payload->data(), tmp_resource.payload->size());
 					seri_locker.lock();
 					seri.resources.push_back(res);
 					seri_locker.unlock();
@@ -1215,57 +2534,91 @@ namespace wi
 
 			wi::jobsystem::Wait(ctx);
 		}
-		void Serialize_WRITE(wi::Archive& archive, const wi::unordered_set<std::string>& resource_names)
+		void Serialize_WRITE(wi::Archive& archive, const wi::unordered_set<std::string>& resource_names, Mode mode)
 		{
 			assert(!archive.IsReadMode());
 
-			locker.lock();
 			size_t serializable_count = 0;
 
 			if (mode == Mode::ALLOW_RETAIN_FILEDATA_BUT_DISABLE_EMBEDDING)
 			{
 				// Simply not serialize any embedded resources
+				size_t payload_count = 0;
+				archive << payload_count;
 				serializable_count = 0;
 				archive << serializable_count;
 			}
 			else
 			{
-				// Count embedded resources:
+				// Gather embedded resources, they are kept alive until written:
+				wi::vector<std::pair<std::string, std::shared_ptr<ResourceInternal>>> serializables;
 				for (auto& name : resource_names)
 				{
-					auto it = resources.find(name);
-					if (it == resources.end())
-						continue;
-					std::shared_ptr<ResourceInternal> resource = it->second.lock();
+					std::shared_ptr<ResourceInternal> resource = Find(name);
 					if (resource != nullptr && !resource->filedata.empty())
 					{
-						serializable_count++;
+						serializables.push_back(std::make_pair(name, std::move(resource)));
 					}
 				}
+				serializable_count = serializables.size();
 
-				// Write all embedded resources:
-				archive << serializable_count;
-				for (auto& name : resource_names)
+				// The file data is written only once for each unique content, even if it was loaded with multiple names:
+				wi::vector<uint64_t> hashes(serializable_count);
+				wi::vector<size_t> payloads;
+				wi::unordered_set<uint64_t> payload_hashes;
+				for (size_t i = 0; i < serializable_count; ++i)
 				{
-					auto it = resources.find(name);
-					if (it == resources.end())
-						continue;
-					std::shared_ptr<ResourceInternal> resource = it->second.lock();
-
-					if (resource != nullptr && !resource->filedata.empty())
+					const wi::vector<uint8_t>& filedata = serializables[i].second->filedata;
+					hashes[i] = wi::helper::data_hash(filedata.data(), filedata.size());
+					if (payload_hashes.insert(hashes[i]).second)
 					{
-						std::string name = it->first;
-						wi::helper::MakePathRelative(archive.GetSourceDirectory(), name);
-
-						archive << name;
-						archive << (uint32_t)resource->flags;
-						archive << resource->filedata;
+						payloads.push_back(i);
 					}
 				}
+				archive << payloads.size();
+				for (size_t i : payloads)
+				{
+					archive << hashes[i];
+					archive << serializables[i].second->filedata;
+				}
+
+				// Write the name table of all embedded resources:
+				archive << serializable_count;
+				for (size_t i = 0; i < serializable_count; ++i)
+				{
+					std::string name = serializables[i].first;
+					wi::helper::MakePathRelative(archive.GetSourceDirectory(), name);
+
+					archive << name;
+					archive << (uint32_t)serializables[i].second->flags;
+					archive << hashes[i];
+				}
 			}
-			locker.unlock();
 		}
 
 	}
 
+	size_t Resource::GetCPUMemoryUsage() const
+	{
+		const ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
+		if (resourceinternal == nullptr)
+			return 0;
+		return resourcemanager::ComputeMemoryStats(*resourceinternal).cpu_bytes;
+	}
+	size_t Resource::GetGPUMemoryUsage() const
+	{
+		const ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
+		if (resourceinternal == nullptr)
+			return 0;
+		return resourcemanager::ComputeMemoryStats(*resourceinternal).gpu_bytes;
+	}
+
+	void ResourceInternal::UpdateMemoryBytes()
+	{
+		const resourcemanager::MemoryStats stats = resourcemanager::ComputeMemoryStats(*this);
+		const size_t bytes = stats.cpu_bytes + stats.gpu_bytes;
+		total_memory_bytes.fetch_add(bytes);
+		total_memory_bytes.fetch_sub(memory_bytes.exchange(bytes));
+	}
+
 }
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <string>
+#include <functional>
 
 namespace wi
 {
@@ -40,6 +41,15 @@ namespace wi
 		// Resource marked for recreate on resourcemanager::Load()
 		//	It keeps embedded file data if exists
 		void SetOutdated();
+
+		// Request a texture resolution for streaming textures, the highest request within a frame will be used
+		//	This is thread safe, and it has no effect if the resource is not a streaming texture
+		void StreamingRequestResolution(uint32_t resolution) const;
+
+		// Returns the CPU memory used by the resource in bytes, including the file data that is kept
+		size_t GetCPUMemoryUsage() const;
+		// Returns the approximate GPU memory used by the resource in bytes
+		size_t GetGPUMemoryUsage() const;
 	};
 
 	namespace resourcemanager
@@ -52,6 +62,19 @@ namespace wi
 		};
 		void SetMode(Mode param);
 		Mode GetMode();
+		enum class DataType
+		{
+			IMAGE,
+			SOUND,
+			SCRIPT,
+			VIDEO,
+			FONTSTYLE,
+			COUNT
+		};
+		// The texture cache stores imported images (PNG, JPG, TGA, etc.) in their final GPU format with mipmaps in the GetCacheDirectoryPath()
+		//	Loading them again will skip image decoding, mipmap generation and block compression. Enabled by default.
+		void SetTextureCacheEnabled(bool value);
+		bool IsTextureCacheEnabled();
 		wi::vector<std::string> GetSupportedImageExtensions();
 		wi::vector<std::string> GetSupportedSoundExtensions();
 		wi::vector<std::string> GetSupportedVideoExtensions();
@@ -67,6 +90,7 @@ namespace wi
 			IMPORT_NORMALMAP = 1 << 2, // image import will try to use optimal normal map encoding
 			IMPORT_BLOCK_COMPRESSED = 1 << 3, // image import will request block compression for uncompressed or transcodable formats
 			IMPORT_DELAY = 1 << 4, // delay importing resource until later, for example when proper flags can be determined
+			STREAMING = 1 << 5, // DDS and KTX2 2D textures will be streamed, only the lowest resolution mips are loaded initially
 		};
 
 		// Load a resource
@@ -80,11 +104,128 @@ namespace wi
 			const uint8_t* filedata = nullptr,
 			size_t filesize = 0
 		);
+
+		enum class LoadPriority
+		{
+			LOW,
+			NORMAL,
+			HIGH,
+		};
+		enum class LoadState
+		{
+			PENDING,	// waiting in the queue
+			LOADING,	// file read, decode and GPU upload is in progress
+			FINISHED,	// the resource was loaded successfully
+			FAILED,		// the resource could not be loaded
+			CANCELLED,	// the request was cancelled through this handle
+		};
+		// Handle to an asynchronous resource load, returned by LoadAsync()
+		struct AsyncLoad
+		{
+			std::shared_ptr<void> internal_state;
+			inline bool IsValid() const { return internal_state.get() != nullptr; }
+
+			LoadState GetState() const;
+			// Returns true if the load is no longer pending or in progress (finished, failed or cancelled)
+			bool IsFinished() const;
+			// Returns the loaded resource, or an invalid resource if the load is not FINISHED
+			Resource GetResource() const;
+			// Changes the priority of the request, this only has effect while it is pending
+			void SetPriority(LoadPriority priority);
+			// Cancels the request for this handle
+			//	The load is only removed from the queue if no other handles are waiting for the same resource
+			//	If the load is already in progress, it will complete, but the callback of this handle won't be called
+			void Cancel();
+			// Blocks until the load is finished
+			//	If it's still pending, it will be loaded on the calling thread
+			void Wait() const;
+		};
+
+		// Load a resource asynchronously, the handle is returned immediately
+		//	Loads are executed in priority order on a limited number of job system threads, so they don't take over all the workers
+		//	Requests for a resource name that is already queued or loading will share the same load (the flags of the first request are used)
+		//	name : file name of resource
+		//	flags : specify flags that modify behaviour (optional)
+		//	priority : requests with higher priority are started first (optional)
+		//	callback : called from a job system thread when the load completes, with the result (it will be invalid on failure) (optional)
+		AsyncLoad LoadAsync(
+			const std::string& name,
+			Flags flags = Flags::NONE,
+			LoadPriority priority = LoadPriority::NORMAL,
+			const std::function<void(Resource)>& callback = nullptr
+		);
 		// Check if a resource is currently loaded
 		bool Contains(const std::string& name);
 		// Invalidate all resources
 		void Clear();
 
+		// Memory accounting of loaded resources:
+		struct MemoryStats
+		{
+			uint32_t count = 0;			// number of resources
+			size_t cpu_bytes = 0;		// CPU memory, including file data
+			size_t filedata_bytes = 0;	// file data that is kept in CPU memory (for serialization, delayed import or streaming), it is included in cpu_bytes
+			size_t gpu_bytes = 0;		// approximate GPU memory
+		};
+		struct MemoryUsage
+		{
+			MemoryStats types[size_t(DataType::COUNT)];	// per DataType
+			MemoryStats total;							// all resources
+			MemoryStats retained;						// resources that are only kept alive by the retain cache, they are also included in the above
+		};
+		// Returns the memory usage of all loaded resources, it should be called on the main thread
+		MemoryUsage GetMemoryUsage();
+		// The memory budget of resources, which is the sum of their CPU and GPU memory usage (default: 2 GB)
+		//	A warning is posted to the backlog when the resources that are in use exceed it
+		void SetMemoryBudget(size_t bytes);
+		size_t GetMemoryBudget();
+		// The retain cache keeps recently released resources alive while they fit into the memory budget, so loading them again won't decode them again
+		//	When the budget is exceeded, the least recently loaded resources are released first. Disabled by default.
+		void SetRetainCacheEnabled(bool value);
+		bool IsRetainCacheEnabled();
+		// Releases the resources that are only kept alive by the retain cache
+		void ClearRetainCache();
+		// Releases resources from the retain cache while the memory budget is exceeded, it must be called on the main thread
+		//	wi::Application calls this at the start of the frame
+		void UpdateRetainCache();
+
+		// Texture streaming:
+		//	Textures that are loaded with the STREAMING flag will only have their tail mips resident at first
+		//	The required resolution is requested with Resource::StreamingRequestResolution(), and higher resolution mips are created on background jobs
+		//	Only the mips that are added are created from the source, which is read again from the file or package, the resident mips are copied on the GPU
+		//	If the source was given as memory, it is kept until the full resolution is resident, then the texture stays at full resolution
+		//	All streaming textures share a memory budget, the least recently requested ones are reduced first when it would be exceeded
+		void SetStreamingMemoryBudget(size_t bytes);
+		size_t GetStreamingMemoryBudget();
+		// Returns the memory used by the resident mips of streaming textures
+		size_t GetStreamingMemoryUsage();
+		// Sets the resolution under which mips are always resident
+		void SetStreamingTailResolution(uint32_t resolution);
+		uint32_t GetStreamingTailResolution();
+		// Updates streaming textures, it must be called once per frame on the main thread while textures are not in use by rendering
+		//	wi::Application calls this at the start of the frame
+		void UpdateStreamingResources();
+
+		// CPU side texture streaming decisions, these don't use the graphics device
+		struct StreamingTexture
+		{
+			wi::graphics::TextureDesc desc; // full resolution texture description (with all mips)
+			uint32_t tail_mip = 0; // mips starting from this are always resident
+			uint32_t requested_resolution = 0; // the latest requested resolution
+			uint64_t last_request_frame = 0; // frame of the latest request, used as LRU order
+		};
+		// Returns the memory size of the mips starting from first_mip
+		size_t ComputeStreamingMemory(const wi::graphics::TextureDesc& desc, uint32_t first_mip);
+		// Returns the first mip whose size is not larger than the resolution
+		uint32_t ComputeStreamingTailMip(const wi::graphics::TextureDesc& desc, uint32_t resolution);
+		// Returns the first mip that must be resident for the requested resolution
+		uint32_t ComputeStreamingRequestedMip(const StreamingTexture& texture);
+		// Computes the first resident mip for every texture into target_mips, so that their total memory fits into the budget
+		//	Textures are served in order of most recent request, so when the budget is exceeded, the least recently requested ones are reduced
+		//	Tail mips are always resident, even if they exceed the budget
+		//	Returns the total memory size of the result
+		size_t ComputeStreamingTargets(const StreamingTexture* textures, size_t count, size_t budget, uint32_t* target_mips);
+
 		struct ResourceSerializer
 		{
 			wi::vector<Resource> resources;
@@ -93,7 +234,8 @@ namespace wi
 		// Serializes all resources that are compatible
 		//	Compatible resources are those whose file data is kept around using the IMPORT_RETAIN_FILEDATA flag when loading.
 		void Serialize_READ(wi::Archive& archive, ResourceSerializer& resources);
-		void Serialize_WRITE(wi::Archive& archive, const wi::unordered_set<std::string>& resource_names);
+		//	mode : decides whether the file data is embedded (default: the current mode)
+		void Serialize_WRITE(wi::Archive& archive, const wi::unordered_set<std::string>& resource_names, Mode mode = GetMode());
 	}
 
 }
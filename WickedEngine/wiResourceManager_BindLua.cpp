@@ -0,0 +1,100 @@
+#include "wiResourceManager_BindLua.h"
+#include "wiResourceManager.h"
+#include "wiLua.h"
+
+namespace wi::lua::resourcemanager
+{
+	int resourcemanager_getmemoryusage(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+
+		const wi::resourcemanager::MemoryUsage usage = wi::resourcemanager::GetMemoryUsage();
+		wi::resourcemanager::MemoryStats stats = usage.total;
+		if (argc > 0)
+		{
+			int type = wi::lua::SGetInt(L, 1);
+			if (type < 0 || type >= int(wi::resourcemanager::DataType::COUNT))
+			{
+				wi::lua::SError(L, "resourcemanager_getmemoryusage(opt int type) invalid type!");
+				return 0;
+			}
+			stats = usage.types[type];
+		}
+
+		wi::lua::SSetLongLong(L, (long long)stats.cpu_bytes);
+		wi::lua::SSetLongLong(L, (long long)stats.gpu_bytes);
+		wi::lua::SSetLongLong(L, (long long)stats.filedata_bytes);
+		wi::lua::SSetInt(L, (int)stats.count);
+		return 4;
+	}
+	int resourcemanager_getretainedmemoryusage(lua_State* L)
+	{
+		const wi::resourcemanager::MemoryStats stats = wi::resourcemanager::GetMemoryUsage().retained;
+		wi::lua::SSetLongLong(L, (long long)stats.cpu_bytes);
+		wi::lua::SSetLongLong(L, (long long)stats.gpu_bytes);
+		wi::lua::SSetLongLong(L, (long long)stats.filedata_bytes);
+		wi::lua::SSetInt(L, (int)stats.count);
+		return 4;
+	}
+	int resourcemanager_setmemorybudget(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			wi::resourcemanager::SetMemoryBudget((size_t)wi::lua::SGetLongLong(L, 1));
+		}
+		else
+			wi::lua::SError(L, "resourcemanager_setmemorybudget(int bytes) not enough arguments!");
+		return 0;
+	}
+	int resourcemanager_getmemorybudget(lua_State* L)
+	{
+		wi::lua::SSetLongLong(L, (long long)wi::resourcemanager::GetMemoryBudget());
+		return 1;
+	}
+	int resourcemanager_setretaincacheenabled(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			wi::resourcemanager::SetRetainCacheEnabled(wi::lua::SGetBool(L, 1));
+		}
+		else
+			wi::lua::SError(L, "resourcemanager_setretaincacheenabled(bool value) not enough arguments!");
+		return 0;
+	}
+	int resourcemanager_isretaincacheenabled(lua_State* L)
+	{
+		wi::lua::SSetBool(L, wi::resourcemanager::IsRetainCacheEnabled());
+		return 1;
+	}
+	int resourcemanager_clearretaincache(lua_State* L)
+	{
+		wi::resourcemanager::ClearRetainCache();
+		return 0;
+	}
+
+	void Bind()
+	{
+		static bool initialized = false;
+		if (!initialized)
+		{
+			initialized = true;
+			wi::lua::RegisterFunc("resourcemanager_getmemoryusage", resourcemanager_getmemoryusage);
+			wi::lua::RegisterFunc("resourcemanager_getretainedmemoryusage", resourcemanager_getretainedmemoryusage);
+			wi::lua::RegisterFunc("resourcemanager_setmemorybudget", resourcemanager_setmemorybudget);
+			wi::lua::RegisterFunc("resourcemanager_getmemorybudget", resourcemanager_getmemorybudget);
+			wi::lua::RegisterFunc("resourcemanager_setretaincacheenabled", resourcemanager_setretaincacheenabled);
+			wi::lua::RegisterFunc("resourcemanager_isretaincacheenabled", resourcemanager_isretaincacheenabled);
+			wi::lua::RegisterFunc("resourcemanager_clearretaincache", resourcemanager_clearretaincache);
+
+			wi::lua::RunText(R"(
+RESOURCE_TYPE_IMAGE = 0
+RESOURCE_TYPE_SOUND = 1
+RESOURCE_TYPE_SCRIPT = 2
+RESOURCE_TYPE_VIDEO = 3
+RESOURCE_TYPE_FONTSTYLE = 4
+)");
+		}
+	}
+}
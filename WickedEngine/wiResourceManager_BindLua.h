@@ -0,0 +1,6 @@
+#pragma once
+
+namespace wi::lua::resourcemanager
+{
+	void Bind();
+};
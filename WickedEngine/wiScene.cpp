@@ -33,14 +33,27 @@ namespace wi::scene
 
 		wi::jobsystem::context ctx;
 
-		// Script system runs first, because it could create new entities and components
-		//	So GPU persistent resources need to be created accordingly for them too:
-		RunScriptUpdateSystem(ctx);
+		// With fixed rate simulation, the simulation steps run first and the rest of the systems work on their results:
+		const bool fixed_simulation = simulation_frame_rate > 0;
+		if (fixed_simulation)
+		{
+			RunFixedSimulation(dt);
+			this->dt = dt;
+		}
+		else
+		{
+			// Script system runs first, because it could create new entities and components
+			//	So GPU persistent resources need to be created accordingly for them too:
+			RunScriptUpdateSystem(ctx);
 
-		ScanAnimationDependencies();
+			ScanAnimationDependencies();
+		}
+
+		GraphicsDevice* device = wi::graphics::GetDevice();
 
 		// Terrains updates kick off:
-		if (dt > 0)
+		//	Terrain generation also creates GPU resources (virtual textures), so it is not used without graphics device
+		if (dt > 0 && device != nullptr)
 		{
 			// Because this also spawns render tasks, this must not be during dt == 0 (eg. background loading)
 			for (size_t i = 0; i < terrains.GetCount(); ++i)
@@ -52,8 +65,6 @@ namespace wi::scene
 			}
 		}
 
-		GraphicsDevice* device = wi::graphics::GetDevice();
-
 		instanceArraySize = objects.GetCount() + hairs.GetCount() + emitters.GetCount();
 		if (impostors.GetCount() > 0)
 		{
@@ -65,7 +76,7 @@ namespace wi::scene
 			rainInstanceOffset = uint32_t(instanceArraySize);
 			instanceArraySize += 1;
 		}
-		if (instanceUploadBuffer[0].desc.size < (instanceArraySize * sizeof(ShaderMeshInstance)))
+		if (device != nullptr && instanceUploadBuffer[0].desc.size < (instanceArraySize * sizeof(ShaderMeshInstance)))
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderMeshInstance);
@@ -90,7 +101,7 @@ namespace wi::scene
 				device->SetName(&instanceUploadBuffer[i], "Scene::instanceUploadBuffer");
 			}
 		}
-		instanceArrayMapped = (ShaderMeshInstance*)instanceUploadBuffer[device->GetBufferIndex()].mapped_data;
+		instanceArrayMapped = device == nullptr ? nullptr : (ShaderMeshInstance*)instanceUploadBuffer[device->GetBufferIndex()].mapped_data;
 
 		materialArraySize = materials.GetCount();
 		if (impostors.GetCount() > 0)
@@ -103,7 +114,7 @@ namespace wi::scene
 			rainMaterialOffset = uint32_t(materialArraySize);
 			materialArraySize += 1;
 		}
-		if (materialUploadBuffer[0].desc.size < (materialArraySize * sizeof(ShaderMaterial)))
+		if (device != nullptr && materialUploadBuffer[0].desc.size < (materialArraySize * sizeof(ShaderMaterial)))
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderMaterial);
@@ -128,10 +139,10 @@ namespace wi::scene
 				device->SetName(&materialUploadBuffer[i], "Scene::materialUploadBuffer");
 			}
 		}
-		materialArrayMapped = (ShaderMaterial*)materialUploadBuffer[device->GetBufferIndex()].mapped_data;
+		materialArrayMapped = device == nullptr ? nullptr : (ShaderMaterial*)materialUploadBuffer[device->GetBufferIndex()].mapped_data;
 
 		// Occlusion culling read:
-		if(wi::renderer::GetOcclusionCullingEnabled() && !wi::renderer::GetFreezeCullingCameraEnabled())
+		if(device != nullptr && wi::renderer::GetOcclusionCullingEnabled() && !wi::renderer::GetFreezeCullingCameraEnabled())
 		{
 			uint32_t minQueryCount = uint32_t(objects.GetCount() + lights.GetCount() + 1); // +1: ocean (don't know for sure if it exists yet before weather update)
 			if (queryHeap.desc.query_count < minQueryCount)
@@ -197,26 +208,32 @@ namespace wi::scene
 				skinningAllocator.fetch_add(uint32_t(armature.boneCollection.size() * sizeof(ShaderTransform)));
 			});
 
-			wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-				// Must not keep inactive instances, so init them for safety:
-				ShaderMeshInstance inst;
-				inst.init();
-				for (uint32_t i = 0; i < instanceArraySize; ++i)
-				{
-					std::memcpy(instanceArrayMapped + i, &inst, sizeof(inst));
-				}
-			});
+			if (instanceArrayMapped != nullptr)
+			{
+				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+					// Must not keep inactive instances, so init them for safety:
+					ShaderMeshInstance inst;
+					inst.init();
+					for (uint32_t i = 0; i < instanceArraySize; ++i)
+					{
+						std::memcpy(instanceArrayMapped + i, &inst, sizeof(inst));
+					}
+				});
+			}
 		}
 
-		RunAnimationUpdateSystem(ctx);
+		if (!fixed_simulation)
+		{
+			RunAnimationUpdateSystem(ctx);
 
-		wi::physics::RunPhysicsUpdateSystem(ctx, *this, dt);
+			wi::physics::RunPhysicsUpdateSystem(ctx, *this, dt);
 
-		RunTransformUpdateSystem(ctx);
+			RunTransformUpdateSystem(ctx);
 
-		wi::jobsystem::Wait(ctx); // dependencies
+			wi::jobsystem::Wait(ctx); // dependencies
 
-		RunHierarchyUpdateSystem(ctx);
+			RunHierarchyUpdateSystem(ctx);
+		}
 
 		// Lightmap requests are determined at this point, so we know if we need TLAS or not:
 		if (lightmap_request_allocator.load() > 0)
@@ -226,7 +243,7 @@ namespace wi::scene
 
 		// This must be after lightmap requests were determined:
 		TLAS_instancesMapped = nullptr;
-		if (IsAccelerationStructureUpdateRequested() && device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
+		if (device != nullptr && IsAccelerationStructureUpdateRequested() && device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
 		{
 			GPUBufferDesc desc;
 			desc.stride = (uint32_t)device->GetTopLevelAccelerationStructureInstanceSize();
@@ -262,7 +279,7 @@ namespace wi::scene
 			rainGeometryOffset = uint32_t(geometryArraySize);
 			geometryArraySize += 1;
 		}
-		if (geometryUploadBuffer[0].desc.size < (geometryArraySize * sizeof(ShaderGeometry)))
+		if (device != nullptr && geometryUploadBuffer[0].desc.size < (geometryArraySize * sizeof(ShaderGeometry)))
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderGeometry);
@@ -287,12 +304,12 @@ namespace wi::scene
 				device->SetName(&geometryUploadBuffer[i], "Scene::geometryUploadBuffer");
 			}
 		}
-		geometryArrayMapped = (ShaderGeometry*)geometryUploadBuffer[device->GetBufferIndex()].mapped_data;
+		geometryArrayMapped = device == nullptr ? nullptr : (ShaderGeometry*)geometryUploadBuffer[device->GetBufferIndex()].mapped_data;
 
 		// Skinning data size is ready at this point:
 		skinningDataSize = skinningAllocator.load();
 		skinningAllocator.store(0);
-		if (skinningUploadBuffer[0].desc.size < skinningDataSize)
+		if (device != nullptr && skinningUploadBuffer[0].desc.size < skinningDataSize)
 		{
 			GPUBufferDesc desc;
 			desc.size = skinningDataSize * 2; // *2 to grow fast
@@ -316,9 +333,12 @@ namespace wi::scene
 				device->SetName(&skinningUploadBuffer[i], "Scene::skinningUploadBuffer");
 			}
 		}
-		skinningDataMapped = skinningUploadBuffer[device->GetBufferIndex()].mapped_data;
+		skinningDataMapped = device == nullptr ? nullptr : skinningUploadBuffer[device->GetBufferIndex()].mapped_data;
 
-		RunExpressionUpdateSystem(ctx);
+		if (!fixed_simulation)
+		{
+			RunExpressionUpdateSystem(ctx);
+		}
 
 		RunMeshUpdateSystem(ctx);
 
@@ -326,7 +346,10 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // dependencies
 
-		RunProceduralAnimationUpdateSystem(ctx);
+		if (!fixed_simulation)
+		{
+			RunProceduralAnimationUpdateSystem(ctx);
+		}
 
 		RunArmatureUpdateSystem(ctx);
 
@@ -334,6 +357,21 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // dependencies
 
+		// Armatures are updated, so the skinning cache is invalidated (depends on armature update system):
+		skinning_cache_version++;
+		for (auto it = skinning_cache.begin(); it != skinning_cache.end();)
+		{
+			const MeshComponent* mesh = meshes.GetComponent(it->first);
+			if (mesh == nullptr || !mesh->IsSkinned())
+			{
+				it = skinning_cache.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+
 		RunObjectUpdateSystem(ctx);
 
 		RunCameraUpdateSystem(ctx);
@@ -367,6 +405,49 @@ namespace wi::scene
 			bounds = AABB::Merge(bounds, group_bound);
 		}
 
+		// Object BVH for CPU intersection queries and hierarchical culling (depends on object update system):
+		if (object_bvh.leaf_count != (uint32_t)aabb_objects.size() || !object_bvh.IsValid())
+		{
+			object_bvh.Build(aabb_objects.data(), (uint32_t)aabb_objects.size());
+			object_bvh.BuildWide();
+		}
+		else
+		{
+			object_bvh.Refit(aabb_objects.data());
+			if (object_bvh.IsRebuildRecommended())
+			{
+				object_bvh.Build(aabb_objects.data(), (uint32_t)aabb_objects.size());
+				object_bvh.BuildWide();
+			}
+		}
+
+		// The small culling streams are copied to SoA layout in bulk (the objects were written by the object update system):
+		aabb_lights_soa.set(aabb_lights.data(), aabb_lights.size());
+		aabb_probes_soa.set(aabb_probes.data(), aabb_probes.size());
+		aabb_decals_soa.set(aabb_decals.data(), aabb_decals.size());
+
+		// Spatial hash rehashes the entities that moved into different cells (depends on object, light and procedural animation systems):
+		spatial_hash.Commit();
+
+		// Update water ripples:
+		for (size_t i = 0; i < waterRipples.size(); ++i)
+		{
+			auto& ripple = waterRipples[i];
+			ripple.Update(dt * 60);
+
+			// Remove inactive ripples:
+			if (ripple.params.opacity <= 0 + FLT_EPSILON || ripple.params.fade >= 1 - FLT_EPSILON)
+			{
+				ripple = waterRipples.back();
+				waterRipples.pop_back();
+				i--;
+			}
+		}
+
+		// Headless mode: everything below only creates GPU resources and fills shader data
+		if (device == nullptr)
+			return;
+
 		// Meshlet buffer:
 		uint32_t meshletCount = meshletAllocator.load();
 		if(meshletBuffer.desc.size < meshletCount * sizeof(ShaderMeshlet))
@@ -411,21 +492,6 @@ namespace wi::scene
 			}
 		}
 
-		// Update water ripples:
-		for (size_t i = 0; i < waterRipples.size(); ++i)
-		{
-			auto& ripple = waterRipples[i];
-			ripple.Update(dt * 60);
-
-			// Remove inactive ripples:
-			if (ripple.params.opacity <= 0 + FLT_EPSILON || ripple.params.fade >= 1 - FLT_EPSILON)
-			{
-				ripple = waterRipples.back();
-				waterRipples.pop_back();
-				i--;
-			}
-		}
-
 		if (wi::renderer::GetSurfelGIEnabled())
 		{
 			if (!surfelBuffer.IsValid())
@@ -885,6 +951,9 @@ namespace wi::scene
 
 		TLAS = RaytracingAccelerationStructure();
 		BVH.Clear();
+		object_bvh = {};
+		spatial_hash.Clear();
+		skinning_cache.clear();
 		waterRipples.clear();
 
 		surfelBuffer = {};
@@ -897,6 +966,12 @@ namespace wi::scene
 		surfelCellBuffer = {};
 
 		ddgi = {};
+
+		simulation_accumulator = 0;
+		simulation_interpolation = 1;
+		simulation_step_count = 0;
+		simulation_state_prev = {};
+		simulation_state_current = {};
 	}
 	void Scene::Merge(Scene& other)
 	{
@@ -2335,6 +2410,131 @@ namespace wi::scene
 
 		wi::profiler::EndRange(range);
 	}
+	void Scene::StoreSimulationState(SimulationState& state) const
+	{
+		const size_t count = transforms.GetCount();
+		state.entities.resize(count);
+		state.world.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			state.entities[i] = transforms.GetEntity(i);
+			state.world[i] = transforms[i].world;
+		}
+	}
+	void Scene::RunSimulationStep(float step_dt)
+	{
+		this->dt = step_dt;
+
+		wi::jobsystem::context ctx;
+
+		if (scripts.GetCount() > 0)
+		{
+			wi::lua::SetDeltaTime(double(step_dt));
+		}
+		RunScriptUpdateSystem(ctx);
+
+		ScanAnimationDependencies();
+
+		RunAnimationUpdateSystem(ctx);
+
+		wi::physics::RunPhysicsUpdateSystem(ctx, *this, step_dt);
+
+		RunTransformUpdateSystem(ctx);
+
+		wi::jobsystem::Wait(ctx); // dependencies
+
+		RunHierarchyUpdateSystem(ctx);
+
+		RunExpressionUpdateSystem(ctx);
+
+		wi::jobsystem::Wait(ctx); // dependencies
+
+		RunProceduralAnimationUpdateSystem(ctx);
+
+		wi::jobsystem::Wait(ctx);
+	}
+	void Scene::RunFixedSimulation(float dt)
+	{
+		const float step_dt = 1.0f / simulation_frame_rate;
+
+		// The world matrices were overwritten by interpolation in the previous Update(), so they are restored to the simulation state first:
+		const size_t transform_count = transforms.GetCount();
+		for (size_t i = 0; i < std::min(transform_count, simulation_state_current.entities.size()); ++i)
+		{
+			if (transforms.GetEntity(i) == simulation_state_current.entities[i])
+			{
+				transforms[i].world = simulation_state_current.world[i];
+			}
+		}
+
+		simulation_accumulator += dt;
+		uint32_t steps = uint32_t(simulation_accumulator / step_dt);
+		if (steps > simulation_max_steps)
+		{
+			// The simulation can't keep up, the remaining time is dropped instead of spiraling into more and more steps:
+			steps = simulation_max_steps;
+			simulation_accumulator = steps * step_dt;
+		}
+		simulation_step_count = steps;
+
+		// Scripts see the simulation step as their delta time while stepping, the frame delta time is restored after the steps:
+		const bool scripts_active = scripts.GetCount() > 0;
+		const double frame_script_dt = scripts_active ? wi::lua::GetDeltaTime() : 0;
+
+		for (uint32_t step = 0; step < steps; ++step)
+		{
+			if (step == steps - 1)
+			{
+				StoreSimulationState(simulation_state_prev);
+			}
+			RunSimulationStep(step_dt);
+			simulation_accumulator -= step_dt;
+		}
+
+		if (steps > 0)
+		{
+			StoreSimulationState(simulation_state_current);
+		}
+		else if (dt == 0 || simulation_state_current.entities.size() != transforms.GetCount())
+		{
+			// Paused, or the scene was modified in between: the state is refreshed without advancing time
+			RunSimulationStep(0);
+			StoreSimulationState(simulation_state_current);
+			simulation_state_prev = simulation_state_current;
+		}
+
+		if (scripts_active)
+		{
+			wi::lua::SetDeltaTime(frame_script_dt);
+		}
+
+		simulation_interpolation = wi::math::saturate(simulation_accumulator / step_dt);
+
+		// Rendering is one simulation step behind, world matrices are interpolated between the previous and current simulation steps:
+		const SimulationState& prev = simulation_state_prev;
+		const SimulationState& current = simulation_state_current;
+		const uint32_t count = (uint32_t)std::min(std::min(prev.entities.size(), current.entities.size()), transform_count);
+		const float t = simulation_interpolation;
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t i = args.jobIndex;
+			const Entity entity = current.entities[i];
+			if (entity != prev.entities[i] || entity != transforms.GetEntity(i))
+				return;
+			if (std::memcmp(&prev.world[i], &current.world[i], sizeof(XMFLOAT4X4)) == 0)
+				return;
+
+			XMVECTOR S_a, R_a, T_a;
+			XMVECTOR S_b, R_b, T_b;
+			XMMatrixDecompose(&S_a, &R_a, &T_a, XMLoadFloat4x4(&prev.world[i]));
+			XMMatrixDecompose(&S_b, &R_b, &T_b, XMLoadFloat4x4(&current.world[i]));
+			XMVECTOR S = XMVectorLerp(S_a, S_b, t);
+			XMVECTOR R = XMQuaternionSlerp(R_a, R_b, t);
+			XMVECTOR T = XMVectorLerp(T_a, T_b, t);
+			XMStoreFloat4x4(&transforms[i].world, XMMatrixScalingFromVector(S) * XMMatrixRotationQuaternion(R) * XMMatrixTranslationFromVector(T));
+		});
+		wi::jobsystem::Wait(ctx);
+	}
 	void Scene::RunTransformUpdateSystem(wi::jobsystem::context& ctx)
 	{
 		wi::jobsystem::Dispatch(ctx, (uint32_t)transforms.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
@@ -3034,7 +3234,6 @@ namespace wi::scene
 		}
 
 		// Colliders:
-		collider_allocator_cpu.store(0u);
 		collider_allocator_gpu.store(0u);
 		collider_deinterleaved_data.reserve(
 			sizeof(wi::primitive::AABB) * colliders.GetCount() +
@@ -3049,6 +3248,7 @@ namespace wi::scene
 
 			ColliderComponent& collider = colliders[args.jobIndex];
 			Entity entity = colliders.GetEntity(args.jobIndex);
+			aabb_colliders_cpu[args.jobIndex] = AABB(); // invalid AABB marks that it's not a CPU collider
 			const TransformComponent* transform = transforms.GetComponent(entity);
 			if (transform == nullptr)
 				return;
@@ -3109,9 +3309,7 @@ namespace wi::scene
 
 			if (collider.IsCPUEnabled())
 			{
-				uint32_t index = collider_allocator_cpu.fetch_add(1u);
-				colliders_cpu[index] = collider;
-				aabb_colliders_cpu[index] = aabb;
+				aabb_colliders_cpu[args.jobIndex] = aabb;
 			}
 			if (collider.IsGPUEnabled())
 			{
@@ -3122,9 +3320,36 @@ namespace wi::scene
 		});
 
 		wi::jobsystem::Wait(ctx);
-		collider_count_cpu = collider_allocator_cpu.load();
 		collider_count_gpu = collider_allocator_gpu.load();
-		collider_bvh.Build(aabb_colliders_cpu, collider_count_cpu);
+
+		// CPU colliders are compacted in component order, so the collider BVH leaves are stable between frames and it can be refitted:
+		const uint32_t collider_count_cpu_prev = collider_count_cpu;
+		collider_count_cpu = 0;
+		spatial_hash.Resize(SPATIAL_HASH_COLLIDERS, colliders.GetCount());
+		for (size_t i = 0; i < colliders.GetCount(); ++i)
+		{
+			if (!aabb_colliders_cpu[i].IsValid())
+				continue;
+			aabb_colliders_cpu[collider_count_cpu] = aabb_colliders_cpu[i];
+			colliders_cpu[collider_count_cpu] = colliders[i];
+			spatial_hash.Set(SPATIAL_HASH_COLLIDERS, collider_count_cpu, colliders.GetEntity(i), aabb_colliders_cpu[i]);
+			collider_count_cpu++;
+		}
+		spatial_hash.Resize(SPATIAL_HASH_COLLIDERS, collider_count_cpu);
+		if (collider_count_cpu != collider_count_cpu_prev || !collider_bvh.IsValid())
+		{
+			collider_bvh.Build(aabb_colliders_cpu, collider_count_cpu);
+			collider_bvh.BuildWide();
+		}
+		else
+		{
+			collider_bvh.Refit(aabb_colliders_cpu);
+			if (collider_bvh.IsRebuildRecommended())
+			{
+				collider_bvh.Build(aabb_colliders_cpu, collider_count_cpu);
+				collider_bvh.BuildWide();
+			}
+		}
 
 		// Springs:
 		const XMVECTOR windDir = XMLoadFloat3(&weather.windDirection);
@@ -3253,7 +3478,7 @@ namespace wi::scene
 
 			if (colliders_cpu != nullptr)
 			{
-				collider_bvh.Intersects(tail_sphere, 0, [&](uint32_t collider_index) {
+				collider_bvh.IntersectsWide(tail_sphere, [&](uint32_t collider_index) {
 					const ColliderComponent& collider = colliders_cpu[collider_index];
 
 					float dist = 0;
@@ -3589,6 +3814,9 @@ namespace wi::scene
 				material.SetDirty(false);
 			}
 
+			if (materialArrayMapped == nullptr)
+				return;
+
 			material.WriteShaderMaterial(materialArrayMapped + args.jobIndex);
 
 			VideoComponent* video = videos.GetComponent(entity);
@@ -3607,6 +3835,10 @@ namespace wi::scene
 		if (dt == 0)
 			return;
 
+		// Impostors are only used for rendering, nothing to do without graphics device:
+		if (wi::graphics::GetDevice() == nullptr)
+			return;
+
 		if (impostors.GetCount() > 0 && !impostorArray.IsValid())
 		{
 			GraphicsDevice* device = wi::graphics::GetDevice();
@@ -3759,6 +3991,7 @@ namespace wi::scene
 		aabb_objects.resize(objects.GetCount());
 		matrix_objects.resize(objects.GetCount());
 		matrix_objects_prev.resize(objects.GetCount());
+		matrix_objects_inverse.resize(objects.GetCount());
 		occlusion_results_objects.resize(objects.GetCount());
 
 		meshletAllocator.store(0u);
@@ -3766,6 +3999,9 @@ namespace wi::scene
 		parallel_bounds.clear();
 		parallel_bounds.resize((size_t)wi::jobsystem::DispatchGroupCount((uint32_t)objects.GetCount(), small_subtask_groupsize));
 		
+		aabb_objects_soa.resize(objects.GetCount());
+		spatial_hash.Resize(SPATIAL_HASH_OBJECTS, objects.GetCount());
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			Entity entity = objects.GetEntity(args.jobIndex);
@@ -3904,6 +4140,17 @@ namespace wi::scene
 				sort_bits.bits.doublesided = mesh.IsDoubleSided();
 				sort_bits.bits.sort_priority = object.sort_priority;
 
+				// Texture streaming request: the texture resolution should match the object's projected size on the screen
+				uint32_t streaming_resolution = 0;
+				{
+					const float dist = std::max(wi::math::Distance(camera.Eye, object.center), object.radius);
+					const float tan_half_fov = std::tan(camera.fov * 0.5f);
+					if (dist > 0 && tan_half_fov > 0)
+					{
+						streaming_resolution = uint32_t(std::min(65536.0f, object.radius * camera.height / (dist * tan_half_fov)));
+					}
+				}
+
 				uint32_t first_subset = 0;
 				uint32_t last_subset = 0;
 				mesh.GetLODSubsetRange(object.lod, first_subset, last_subset);
@@ -3916,6 +4163,14 @@ namespace wi::scene
 					{
 						object.filterMask |= material->GetFilterMask();
 
+						if (streaming_resolution > 0)
+						{
+							for (auto& texture : material->textures)
+							{
+								texture.resource.StreamingRequestResolution(streaming_resolution);
+							}
+						}
+
 						if (material->HasPlanarReflection())
 						{
 							object.SetRequestPlanarReflection(true);
@@ -3937,7 +4192,9 @@ namespace wi::scene
 				object.sort_bits = sort_bits.value;
 
 				// Correction matrix for mesh normals with non-uniform object scaling:
-				XMMATRIX worldMatrixInverseTranspose = XMMatrixTranspose(XMMatrixInverse(nullptr, W));
+				XMMATRIX worldMatrixInverse = XMMatrixInverse(nullptr, W);
+				XMStoreFloat4x4(matrix_objects_inverse.data() + args.jobIndex, worldMatrixInverse);
+				XMMATRIX worldMatrixInverseTranspose = XMMatrixTranspose(worldMatrixInverse);
 				XMFLOAT4X4 transformIT;
 				XMStoreFloat4x4(&transformIT, worldMatrixInverseTranspose);
 
@@ -3979,7 +4236,10 @@ namespace wi::scene
 				inst.radius = object.radius;
 				inst.SetUserStencilRef(object.userStencilRef);
 
-				std::memcpy(instanceArrayMapped + args.jobIndex, &inst, sizeof(inst)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
+				if (instanceArrayMapped != nullptr)
+				{
+					std::memcpy(instanceArrayMapped + args.jobIndex, &inst, sizeof(inst)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
+				}
 
 				if (TLAS_instancesMapped != nullptr)
 				{
@@ -4027,7 +4287,7 @@ namespace wi::scene
 				}
 
 				// lightmap things:
-				if (object.IsLightmapRenderRequested() && dt > 0)
+				if (object.IsLightmapRenderRequested() && dt > 0 && device != nullptr)
 				{
 					if (!object.lightmap.IsValid())
 					{
@@ -4049,7 +4309,7 @@ namespace wi::scene
 					}
 				}
 
-				if (!object.lightmapTextureData.empty() && !object.lightmap.IsValid())
+				if (!object.lightmapTextureData.empty() && !object.lightmap.IsValid() && device != nullptr)
 				{
 					// Create a GPU-side per object lightmap if there is none yet, but the data exists already:
 					const size_t lightmap_size = object.lightmapTextureData.size();
@@ -4091,6 +4351,9 @@ namespace wi::scene
 				}
 			}
 
+			aabb_objects_soa.set(args.jobIndex, aabb);
+			spatial_hash.Set(SPATIAL_HASH_OBJECTS, args.jobIndex, entity, aabb);
+
 		}, sizeof(AABB));
 	}
 	void Scene::RunCameraUpdateSystem(wi::jobsystem::context& ctx)
@@ -4203,10 +4466,13 @@ namespace wi::scene
 				probe.render_dirty = true;
 			}
 
-			probe.CreateRenderData();
+			if (wi::graphics::GetDevice() != nullptr)
+			{
+				probe.CreateRenderData();
+			}
 		}
 
-		if (probes.GetCount() == 0)
+		if (probes.GetCount() == 0 && wi::graphics::GetDevice() != nullptr)
 		{
 			global_dynamic_probe.SetRealTime(true);
 			global_dynamic_probe.resolution = 64;
@@ -4235,13 +4501,17 @@ namespace wi::scene
 	void Scene::RunLightUpdateSystem(wi::jobsystem::context& ctx)
 	{
 		aabb_lights.resize(lights.GetCount());
+		spatial_hash.Resize(SPATIAL_HASH_LIGHTS, lights.GetCount());
 
 		wi::jobsystem::Dispatch(ctx, (uint32_t)lights.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			LightComponent& light = lights[args.jobIndex];
 			Entity entity = lights.GetEntity(args.jobIndex);
 			if (!transforms.Contains(entity))
+			{
+				spatial_hash.Set(SPATIAL_HASH_LIGHTS, args.jobIndex, entity, AABB());
 				return;
+			}
 			const TransformComponent& transform = *transforms.GetComponent(entity);
 			AABB& aabb = aabb_lights[args.jobIndex];
 
@@ -4295,6 +4565,8 @@ namespace wi::scene
 				break;
 			}
 
+			spatial_hash.Set(SPATIAL_HASH_LIGHTS, args.jobIndex, entity, aabb);
+
 		});
 	}
 	void Scene::RunParticleUpdateSystem(wi::jobsystem::context& ctx)
@@ -4324,6 +4596,9 @@ namespace wi::scene
 				}
 			}
 
+			if (geometryArrayMapped == nullptr)
+				return;
+
 			GraphicsDevice* device = wi::graphics::GetDevice();
 
 			uint32_t indexCount = hair.GetParticleCount() * 6;
@@ -4435,6 +4710,9 @@ namespace wi::scene
 			const TransformComponent& transform = *transforms.GetComponent(entity);
 			emitter.UpdateCPU(transform, dt);
 
+			if (geometryArrayMapped == nullptr)
+				return;
+
 			GraphicsDevice* device = wi::graphics::GetDevice();
 
 			ShaderGeometry geometry;
@@ -4501,7 +4779,7 @@ namespace wi::scene
 			weather = weathers[0];
 			weather.most_important_light_index = ~0;
 
-			if (weather.IsOceanEnabled() && !ocean.IsValid())
+			if (weather.IsOceanEnabled() && !ocean.IsValid() && wi::graphics::GetDevice() != nullptr)
 			{
 				OceanRegenerate();
 			}
@@ -4528,7 +4806,7 @@ namespace wi::scene
 		}
 
 		rain_blocker_dummy_light.shadow_rect = {};
-		if (weather.rain_amount > 0)
+		if (weather.rain_amount > 0 && materialArrayMapped != nullptr)
 		{
 			GraphicsDevice* device = wi::graphics::GetDevice();
 			rainEmitter._flags |= wi::EmittedParticleSystem::FLAG_USE_RAIN_BLOCKER;
@@ -4785,7 +5063,7 @@ namespace wi::scene
 
 		if ((filterMask & FILTER_COLLIDER) && collider_bvh.IsValid())
 		{
-			collider_bvh.Intersects(ray, 0, [&](uint32_t collider_index) {
+			collider_bvh.IntersectsWide(ray, [&](uint32_t collider_index) {
 				const ColliderComponent& collider = colliders_cpu[collider_index];
 
 				if ((collider.layerMask & layerMask) == 0)
@@ -4830,30 +5108,31 @@ namespace wi::scene
 
 		if (filterMask & FILTER_OBJECT_ALL)
 		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
-			{
+			auto intersect_object = [&](uint32_t objectIndex) {
 				const AABB& aabb = aabb_objects[objectIndex];
 				if (!ray.intersects(aabb) || (layerMask & aabb.layerMask) == 0)
-					continue;
+					return;
 
 				const ObjectComponent& object = objects[objectIndex];
 				if (object.meshID == INVALID_ENTITY)
-					continue;
+					return;
 				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
+					return;
 
 				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
 				if (mesh == nullptr)
-					continue;
+					return;
 
 				const Entity entity = objects.GetEntity(objectIndex);
 				const SoftBodyPhysicsComponent* softbody = softbodies.GetComponent(object.meshID);
 				const XMMATRIX objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
 				const XMMATRIX objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				const XMMATRIX objectMat_Inverse = XMMatrixInverse(nullptr, objectMat);
+				const XMMATRIX objectMat_Inverse = XMLoadFloat4x4(&matrix_objects_inverse[objectIndex]);
 				const XMVECTOR rayOrigin_local = XMVector3Transform(rayOrigin, objectMat_Inverse);
 				const XMVECTOR rayDirection_local = XMVector3Normalize(XMVector3TransformNormal(rayDirection, objectMat_Inverse));
-				const ArmatureComponent* armature = mesh->IsSkinned() ? armatures.GetComponent(mesh->armatureID) : nullptr;
+				const SkinningCache* skinning = softbody != nullptr && softbody->HasVertices() ? nullptr : GetSkinningCache(object.meshID);
+				const wi::BVH& bvh = skinning != nullptr ? skinning->bvh : mesh->bvh;
+				const wi::vector<AABB>& bvh_leaf_aabbs = skinning != nullptr ? skinning->bvh_leaf_aabbs : mesh->bvh_leaf_aabbs;
 				const XMVECTOR aabb_min = XMLoadFloat3(&mesh->aabb._min);
 				const XMVECTOR aabb_max = XMLoadFloat3(&mesh->aabb._max);
 
@@ -4876,7 +5155,7 @@ namespace wi::scene
 					}
 					else
 					{
-						if (armature == nullptr || armature->boneData.empty())
+						if (skinning == nullptr)
 						{
 							p0 = XMLoadFloat3(&mesh->vertex_positions[i0]);
 							p1 = XMLoadFloat3(&mesh->vertex_positions[i1]);
@@ -4884,9 +5163,9 @@ namespace wi::scene
 						}
 						else
 						{
-							p0 = SkinVertex(*mesh, *armature, i0);
-							p1 = SkinVertex(*mesh, *armature, i1);
-							p2 = SkinVertex(*mesh, *armature, i2);
+							p0 = XMLoadFloat3(&skinning->vertex_positions[i0]);
+							p1 = XMLoadFloat3(&skinning->vertex_positions[i1]);
+							p2 = XMLoadFloat3(&skinning->vertex_positions[i2]);
 						}
 					}
 
@@ -4933,12 +5212,13 @@ namespace wi::scene
 					}
 				};
 
-				if (mesh->bvh.IsValid())
+				// The skinned BVH only contains LOD0, other LODs of skinned meshes are tested triangle by triangle:
+				if (bvh.IsValid() && (skinning == nullptr || lod == 0))
 				{
 					Ray ray_local = Ray(rayOrigin_local, rayDirection_local);
 
-					mesh->bvh.Intersects(ray_local, 0, [&](uint32_t index) {
-						const uint32_t userdata = mesh->bvh_leaf_aabbs[index].userdata;
+					bvh.IntersectsWide(ray_local, [&](uint32_t index) {
+						const uint32_t userdata = bvh_leaf_aabbs[index].userdata;
 						const uint32_t triangleIndex = userdata & 0xFFFFFF;
 						const uint32_t subsetIndex = userdata >> 24u;
 						const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
@@ -4969,6 +5249,19 @@ namespace wi::scene
 					}
 				}
 
+			};
+
+			// The BVH is only valid after Update(), otherwise (for example after loading or creating objects) every object is tested:
+			if (object_bvh.IsValid() && object_bvh.leaf_count == (uint32_t)aabb_objects.size())
+			{
+				object_bvh.IntersectsWide(ray, intersect_object);
+			}
+			else
+			{
+				for (uint32_t objectIndex = 0; objectIndex < (uint32_t)aabb_objects.size(); ++objectIndex)
+				{
+					intersect_object(objectIndex);
+				}
 			}
 		}
 
@@ -4986,7 +5279,7 @@ namespace wi::scene
 
 		if ((filterMask & FILTER_COLLIDER) && collider_bvh.IsValid())
 		{
-			collider_bvh.Intersects(sphere, 0, [&](uint32_t collider_index) {
+			collider_bvh.IntersectsWide(sphere, [&](uint32_t collider_index) {
 				const ColliderComponent& collider = colliders_cpu[collider_index];
 
 				if ((collider.layerMask & layerMask) == 0)
@@ -5028,28 +5321,29 @@ namespace wi::scene
 
 		if (filterMask & FILTER_OBJECT_ALL)
 		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
-			{
+			auto intersect_object = [&](uint32_t objectIndex) {
 				const AABB& aabb = aabb_objects[objectIndex];
 				if (!sphere.intersects(aabb) || (layerMask & aabb.layerMask) == 0)
-					continue;
+					return;
 
 				const ObjectComponent& object = objects[objectIndex];
 				if (object.meshID == INVALID_ENTITY)
-					continue;
+					return;
 				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
+					return;
 
 				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
 				if (mesh == nullptr)
-					continue;
+					return;
 
 				const Entity entity = objects.GetEntity(objectIndex);
 				const SoftBodyPhysicsComponent* softbody = softbodies.GetComponent(object.meshID);
 				const XMMATRIX objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
 				const XMMATRIX objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				const XMMATRIX objectMatInverse = XMMatrixInverse(nullptr, objectMat);
-				const ArmatureComponent* armature = mesh->IsSkinned() ? armatures.GetComponent(mesh->armatureID) : nullptr;
+				const XMMATRIX objectMatInverse = XMLoadFloat4x4(&matrix_objects_inverse[objectIndex]);
+				const SkinningCache* skinning = softbody != nullptr && softbody->HasVertices() ? nullptr : GetSkinningCache(object.meshID);
+				const wi::BVH& bvh = skinning != nullptr ? skinning->bvh : mesh->bvh;
+				const wi::vector<AABB>& bvh_leaf_aabbs = skinning != nullptr ? skinning->bvh_leaf_aabbs : mesh->bvh_leaf_aabbs;
 				const XMVECTOR aabb_min = XMLoadFloat3(&mesh->aabb._min);
 				const XMVECTOR aabb_max = XMLoadFloat3(&mesh->aabb._max);
 
@@ -5072,7 +5366,7 @@ namespace wi::scene
 					}
 					else
 					{
-						if (armature == nullptr || armature->boneData.empty())
+						if (skinning == nullptr)
 						{
 							p0 = XMLoadFloat3(&mesh->vertex_positions[i0]);
 							p1 = XMLoadFloat3(&mesh->vertex_positions[i1]);
@@ -5080,9 +5374,9 @@ namespace wi::scene
 						}
 						else
 						{
-							p0 = SkinVertex(*mesh, *armature, i0);
-							p1 = SkinVertex(*mesh, *armature, i1);
-							p2 = SkinVertex(*mesh, *armature, i2);
+							p0 = XMLoadFloat3(&skinning->vertex_positions[i0]);
+							p1 = XMLoadFloat3(&skinning->vertex_positions[i1]);
+							p2 = XMLoadFloat3(&skinning->vertex_positions[i2]);
 						}
 					}
 
@@ -5206,7 +5500,8 @@ namespace wi::scene
 					}
 				};
 
-				if (mesh->bvh.IsValid())
+				// The skinned BVH only contains LOD0, other LODs of skinned meshes are tested triangle by triangle:
+				if (bvh.IsValid() && (skinning == nullptr || lod == 0))
 				{
 					XMFLOAT3 center_local;
 					float radius_local;
@@ -5214,8 +5509,8 @@ namespace wi::scene
 					XMStoreFloat(&radius_local, XMVector3Length(XMVector3TransformNormal(XMLoadFloat(&sphere.radius), objectMatInverse)));
 					Sphere sphere_local = Sphere(center_local, radius_local);
 
-					mesh->bvh.Intersects(sphere_local, 0, [&](uint32_t index) {
-						const uint32_t userdata = mesh->bvh_leaf_aabbs[index].userdata;
+					bvh.IntersectsWide(sphere_local, [&](uint32_t index) {
+						const uint32_t userdata = bvh_leaf_aabbs[index].userdata;
 						const uint32_t triangleIndex = userdata & 0xFFFFFF;
 						const uint32_t subsetIndex = userdata >> 24u;
 						const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
@@ -5246,6 +5541,18 @@ namespace wi::scene
 					}
 				}
 
+			};
+
+			if (object_bvh.IsValid() && object_bvh.leaf_count == (uint32_t)aabb_objects.size())
+			{
+				object_bvh.IntersectsWide(sphere, intersect_object);
+			}
+			else
+			{
+				for (uint32_t objectIndex = 0; objectIndex < (uint32_t)aabb_objects.size(); ++objectIndex)
+				{
+					intersect_object(objectIndex);
+				}
 			}
 		}
 
@@ -5269,7 +5576,7 @@ namespace wi::scene
 
 		if ((filterMask & FILTER_COLLIDER) && collider_bvh.IsValid())
 		{
-			collider_bvh.Intersects(capsule_aabb, 0, [&](uint32_t collider_index) {
+			collider_bvh.IntersectsWide(capsule_aabb, [&](uint32_t collider_index) {
 				const ColliderComponent& collider = colliders_cpu[collider_index];
 
 				if ((collider.layerMask & layerMask) == 0)
@@ -5311,29 +5618,30 @@ namespace wi::scene
 
 		if (filterMask & FILTER_OBJECT_ALL)
 		{
-			for (size_t objectIndex = 0; objectIndex < aabb_objects.size(); ++objectIndex)
-			{
+			auto intersect_object = [&](uint32_t objectIndex) {
 				const AABB& aabb = aabb_objects[objectIndex];
 				if (capsule_aabb.intersects(aabb) == AABB::INTERSECTION_TYPE::OUTSIDE || (layerMask & aabb.layerMask) == 0)
-					continue;
+					return;
 
 				const ObjectComponent& object = objects[objectIndex];
 
 				if (object.meshID == INVALID_ENTITY)
-					continue;
+					return;
 				if ((filterMask & object.GetFilterMask()) == 0)
-					continue;
+					return;
 
 				const MeshComponent* mesh = meshes.GetComponent(object.meshID);
 				if (mesh == nullptr)
-					continue;
+					return;
 
 				const Entity entity = objects.GetEntity(objectIndex);
 				const SoftBodyPhysicsComponent* softbody = softbodies.GetComponent(object.meshID);
 				const XMMATRIX objectMat = XMLoadFloat4x4(&matrix_objects[objectIndex]);
 				const XMMATRIX objectMatPrev = XMLoadFloat4x4(&matrix_objects_prev[objectIndex]);
-				const ArmatureComponent* armature = mesh->IsSkinned() ? armatures.GetComponent(mesh->armatureID) : nullptr;
-				const XMMATRIX objectMat_Inverse = XMMatrixInverse(nullptr, objectMat);
+				const SkinningCache* skinning = softbody != nullptr && softbody->HasVertices() ? nullptr : GetSkinningCache(object.meshID);
+				const wi::BVH& bvh = skinning != nullptr ? skinning->bvh : mesh->bvh;
+				const wi::vector<AABB>& bvh_leaf_aabbs = skinning != nullptr ? skinning->bvh_leaf_aabbs : mesh->bvh_leaf_aabbs;
+				const XMMATRIX objectMat_Inverse = XMLoadFloat4x4(&matrix_objects_inverse[objectIndex]);
 				const XMVECTOR aabb_min = XMLoadFloat3(&mesh->aabb._min);
 				const XMVECTOR aabb_max = XMLoadFloat3(&mesh->aabb._max);
 				
@@ -5356,7 +5664,7 @@ namespace wi::scene
 					}
 					else
 					{
-						if (armature == nullptr || armature->boneData.empty())
+						if (skinning == nullptr)
 						{
 							p0 = XMLoadFloat3(&mesh->vertex_positions[i0]);
 							p1 = XMLoadFloat3(&mesh->vertex_positions[i1]);
@@ -5364,9 +5672,9 @@ namespace wi::scene
 						}
 						else
 						{
-							p0 = SkinVertex(*mesh, *armature, i0);
-							p1 = SkinVertex(*mesh, *armature, i1);
-							p2 = SkinVertex(*mesh, *armature, i2);
+							p0 = XMLoadFloat3(&skinning->vertex_positions[i0]);
+							p1 = XMLoadFloat3(&skinning->vertex_positions[i1]);
+							p2 = XMLoadFloat3(&skinning->vertex_positions[i2]);
 						}
 					}
 
@@ -5602,7 +5910,8 @@ namespace wi::scene
 					}
 				};
 
-				if (mesh->bvh.IsValid())
+				// The skinned BVH only contains LOD0, other LODs of skinned meshes are tested triangle by triangle:
+				if (bvh.IsValid() && (skinning == nullptr || lod == 0))
 				{
 					XMFLOAT3 base_local;
 					XMFLOAT3 tip_local;
@@ -5612,8 +5921,8 @@ namespace wi::scene
 					XMStoreFloat(&radius_local, XMVector3Length(XMVector3TransformNormal(XMLoadFloat(&capsule.radius), objectMat_Inverse)));
 					AABB capsule_local_aabb = Capsule(base_local, tip_local, radius_local).getAABB();
 
-					mesh->bvh.Intersects(capsule_local_aabb, 0, [&](uint32_t index){
-						const uint32_t userdata = mesh->bvh_leaf_aabbs[index].userdata;
+					bvh.IntersectsWide(capsule_local_aabb, [&](uint32_t index){
+						const uint32_t userdata = bvh_leaf_aabbs[index].userdata;
 						const uint32_t triangleIndex = userdata & 0xFFFFFF;
 						const uint32_t subsetIndex = userdata >> 24u;
 						const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
@@ -5644,6 +5953,18 @@ namespace wi::scene
 					}
 				}
 
+			};
+
+			if (object_bvh.IsValid() && object_bvh.leaf_count == (uint32_t)aabb_objects.size())
+			{
+				object_bvh.IntersectsWide(capsule_aabb, intersect_object);
+			}
+			else
+			{
+				for (uint32_t objectIndex = 0; objectIndex < (uint32_t)aabb_objects.size(); ++objectIndex)
+				{
+					intersect_object(objectIndex);
+				}
 			}
 		}
 
@@ -5652,6 +5973,77 @@ namespace wi::scene
 		return result;
 	}
 
+	// Sort key position and direction class for the batched queries:
+	inline XMFLOAT3 GetBatchQueryPosition(const Ray& ray) { return ray.origin; }
+	inline XMFLOAT3 GetBatchQueryPosition(const Sphere& sphere) { return sphere.center; }
+	inline XMFLOAT3 GetBatchQueryPosition(const Capsule& capsule) { return wi::math::Lerp(capsule.base, capsule.tip, 0.5f); }
+	inline uint32_t GetBatchQueryOctant(const Ray& ray) { return (ray.direction.x < 0 ? 1u : 0u) | (ray.direction.y < 0 ? 2u : 0u) | (ray.direction.z < 0 ? 4u : 0u); }
+	inline uint32_t GetBatchQueryOctant(const Sphere&) { return 0; }
+	inline uint32_t GetBatchQueryOctant(const Capsule&) { return 0; }
+
+	template<typename T, typename R>
+	void IntersectsBatch_Impl(const Scene& scene, const T* queries, R* results, size_t count, uint32_t filterMask, uint32_t layerMask, uint32_t lod)
+	{
+		if (count == 0)
+			return;
+		assert(count <= 0x7FFFFFFF);
+
+		// Queries are ordered by ray direction octant, then by morton code of their position inside the batch bounds,
+		//	so the queries processed together by one job will likely visit the same BVH nodes and meshes:
+		XMFLOAT3 bounds_min = GetBatchQueryPosition(queries[0]);
+		XMFLOAT3 bounds_max = bounds_min;
+		for (size_t i = 1; i < count; ++i)
+		{
+			const XMFLOAT3 position = GetBatchQueryPosition(queries[i]);
+			bounds_min = wi::math::Min(bounds_min, position);
+			bounds_max = wi::math::Max(bounds_max, position);
+		}
+		const XMVECTOR MIN = XMLoadFloat3(&bounds_min);
+		const XMVECTOR SCALE = XMVectorReciprocal(XMVectorMax(XMLoadFloat3(&bounds_max) - MIN, XMVectorReplicate(std::numeric_limits<float>::epsilon())));
+		wi::vector<uint64_t> order(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3 position = GetBatchQueryPosition(queries[i]);
+			XMFLOAT3 uvw;
+			XMStoreFloat3(&uvw, (XMLoadFloat3(&position) - MIN) * SCALE);
+			const uint64_t key = (uint64_t(GetBatchQueryOctant(queries[i])) << 30ull) | uint64_t(wi::math::morton3D(uvw));
+			order[i] = (key << 31ull) | uint64_t(i); // 33 bit key, 31 bit index
+		}
+		std::sort(order.begin(), order.end());
+
+		auto process = [&](size_t i) {
+			const size_t index = size_t(order[i] & 0x7FFFFFFF);
+			results[index] = scene.Intersects(queries[index], filterMask, layerMask, lod);
+		};
+		if (wi::jobsystem::GetThreadCount() > 1 && count > small_subtask_groupsize)
+		{
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+				process(args.jobIndex);
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				process(i);
+			}
+		}
+	}
+	void Scene::IntersectsBatch(const Ray* rays, RayIntersectionResult* results, size_t count, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
+	{
+		IntersectsBatch_Impl(*this, rays, results, count, filterMask, layerMask, lod);
+	}
+	void Scene::IntersectsBatch(const Sphere* spheres, SphereIntersectionResult* results, size_t count, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
+	{
+		IntersectsBatch_Impl(*this, spheres, results, count, filterMask, layerMask, lod);
+	}
+	void Scene::IntersectsBatch(const Capsule* capsules, CapsuleIntersectionResult* results, size_t count, uint32_t filterMask, uint32_t layerMask, uint32_t lod) const
+	{
+		IntersectsBatch_Impl(*this, capsules, results, count, filterMask, layerMask, lod);
+	}
+
 
 	void Scene::PutWaterRipple(const std::string& image, const XMFLOAT3& pos)
 	{
@@ -5685,6 +6077,106 @@ namespace wi::scene
 		waterRipples.push_back(img);
 	}
 
+	const Scene::SkinningCache* Scene::GetSkinningCache(Entity meshID) const
+	{
+		const MeshComponent* mesh = meshes.GetComponent(meshID);
+		if (mesh == nullptr || !mesh->IsSkinned() || mesh->vertex_boneindices.size() != mesh->vertex_positions.size() || mesh->vertex_boneweights.size() != mesh->vertex_positions.size())
+			return nullptr;
+		const ArmatureComponent* armature = armatures.GetComponent(mesh->armatureID);
+		if (armature == nullptr || armature->boneData.empty())
+			return nullptr;
+
+		std::shared_ptr<SkinningCache> cache;
+		skinning_cache_locker.lock();
+		{
+			std::shared_ptr<SkinningCache>& entry = skinning_cache[meshID];
+			if (entry == nullptr)
+			{
+				entry = std::make_shared<SkinningCache>();
+			}
+			cache = entry;
+		}
+		skinning_cache_locker.unlock();
+
+		if (cache->version.load() == skinning_cache_version)
+			return cache.get();
+
+		std::scoped_lock lock(cache->locker);
+		if (cache->version.load() == skinning_cache_version)
+			return cache.get(); // an other thread filled it while we were waiting
+
+		// Skin the whole mesh once, all queries in this frame will reuse it:
+		cache->bone_matrices.resize(armature->boneData.size());
+		for (size_t i = 0; i < armature->boneData.size(); ++i)
+		{
+			const XMFLOAT4X4 mat = armature->boneData[i].GetMatrix();
+			cache->bone_matrices[i] = XMMatrixTranspose(XMLoadFloat4x4(&mat));
+		}
+		const uint32_t bone_count = (uint32_t)cache->bone_matrices.size();
+		cache->vertex_positions.resize(mesh->vertex_positions.size());
+		for (size_t i = 0; i < mesh->vertex_positions.size(); ++i)
+		{
+			const XMVECTOR P = XMLoadFloat3(&mesh->vertex_positions[i]);
+			const XMUINT4& ind = mesh->vertex_boneindices[i];
+			const XMFLOAT4& wei = mesh->vertex_boneweights[i];
+			XMVECTOR skinned = XMVectorZero();
+			if (wei.x > 0 && ind.x < bone_count) skinned = XMVectorMultiplyAdd(XMVector3Transform(P, cache->bone_matrices[ind.x]), XMVectorReplicate(wei.x), skinned);
+			if (wei.y > 0 && ind.y < bone_count) skinned = XMVectorMultiplyAdd(XMVector3Transform(P, cache->bone_matrices[ind.y]), XMVectorReplicate(wei.y), skinned);
+			if (wei.z > 0 && ind.z < bone_count) skinned = XMVectorMultiplyAdd(XMVector3Transform(P, cache->bone_matrices[ind.z]), XMVectorReplicate(wei.z), skinned);
+			if (wei.w > 0 && ind.w < bone_count) skinned = XMVectorMultiplyAdd(XMVector3Transform(P, cache->bone_matrices[ind.w]), XMVectorReplicate(wei.w), skinned);
+			XMStoreFloat3(&cache->vertex_positions[i], skinned);
+		}
+
+		if (!mesh->IsBVHEnabled())
+		{
+			// Like the mesh BVH, the skinned BVH is only created if BVH_ENABLED is set, otherwise queries test the triangles one by one:
+			cache->bvh = {};
+			cache->bvh_leaf_aabbs.clear();
+			cache->version.store(skinning_cache_version);
+			return cache.get();
+		}
+
+		// Triangle BVH of LOD0 in the skinned pose, it is refitted every frame and only rebuilt when it degrades too much:
+		const size_t prev_leaf_count = cache->bvh_leaf_aabbs.size();
+		cache->bvh_leaf_aabbs.clear();
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		mesh->GetLODSubsetRange(0, first_subset, last_subset);
+		for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+		{
+			const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
+			if (subset.indexCount == 0)
+				continue;
+			const uint32_t triangleCount = subset.indexCount / 3;
+			for (uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+			{
+				const XMFLOAT3& p0 = cache->vertex_positions[mesh->indices[subset.indexOffset + triangleIndex * 3 + 0]];
+				const XMFLOAT3& p1 = cache->vertex_positions[mesh->indices[subset.indexOffset + triangleIndex * 3 + 1]];
+				const XMFLOAT3& p2 = cache->vertex_positions[mesh->indices[subset.indexOffset + triangleIndex * 3 + 2]];
+				AABB aabb = AABB(wi::math::Min(p0, wi::math::Min(p1, p2)), wi::math::Max(p0, wi::math::Max(p1, p2)));
+				aabb.userdata = (triangleIndex & 0xFFFFFF) | ((subsetIndex & 0xFF) << 24u);
+				cache->bvh_leaf_aabbs.push_back(aabb);
+			}
+		}
+		if (!cache->bvh.IsValid() || prev_leaf_count != cache->bvh_leaf_aabbs.size())
+		{
+			cache->bvh.Build(cache->bvh_leaf_aabbs.data(), (uint32_t)cache->bvh_leaf_aabbs.size());
+			cache->bvh.BuildWide();
+		}
+		else
+		{
+			cache->bvh.Refit(cache->bvh_leaf_aabbs.data());
+			if (cache->bvh.IsRebuildRecommended())
+			{
+				cache->bvh.Build(cache->bvh_leaf_aabbs.data(), (uint32_t)cache->bvh_leaf_aabbs.size());
+				cache->bvh.BuildWide();
+			}
+		}
+
+		cache->version.store(skinning_cache_version);
+		return cache.get();
+	}
+
 	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N)
 	{
 		XMVECTOR P = XMLoadFloat3(&mesh.vertex_positions[index]);
@@ -12,10 +12,12 @@
 #include "wiHairParticle.h"
 #include "wiTerrain.h"
 #include "wiBVH.h"
+#include "wiSpatialHash.h"
 #include "wiUnorderedSet.h"
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <limits>
 
 namespace wi::scene
@@ -87,10 +89,30 @@ namespace wi::scene
 		wi::vector<wi::primitive::AABB> aabb_lights;
 		wi::vector<wi::primitive::AABB> aabb_probes;
 		wi::vector<wi::primitive::AABB> aabb_decals;
+		// The same AABB culling streams in structure of arrays layout for SIMD frustum culling:
+		wi::primitive::AABBStream aabb_objects_soa;
+		wi::primitive::AABBStream aabb_lights_soa;
+		wi::primitive::AABBStream aabb_probes_soa;
+		wi::primitive::AABBStream aabb_decals_soa;
+
+		// CPU BVH over aabb_objects for Intersects() queries:
+		//	it is rebuilt when the object count changes or the refitted tree degrades, otherwise refitted in Update()
+		wi::BVH object_bvh;
+
+		// Spatial hash grid over object, collider and light AABBs for proximity queries (radius, AABB, k-nearest) that return entity lists:
+		//	it is updated incrementally in Update(), entities are only rehashed when they move into different grid cells
+		enum SPATIAL_HASH_STREAM
+		{
+			SPATIAL_HASH_OBJECTS,
+			SPATIAL_HASH_COLLIDERS,
+			SPATIAL_HASH_LIGHTS,
+		};
+		wi::SpatialHash spatial_hash;
 
 		// Separate stream of world matrices:
 		wi::vector<XMFLOAT4X4> matrix_objects;
 		wi::vector<XMFLOAT4X4> matrix_objects_prev;
+		wi::vector<XMFLOAT4X4> matrix_objects_inverse; // for transforming CPU queries into object space
 
 		// Shader visible scene parameters:
 		ShaderScene shaderscene;
@@ -184,6 +206,7 @@ namespace wi::scene
 			wi::graphics::Texture color_texture[2];
 			wi::graphics::Texture color_texture_rw[2]; // alias of color_texture
 			wi::graphics::Texture depth_texture[2];
+			wi::vector<uint8_t> serialized_data; // if not empty, Serialize() writes this instead of downloading the GPU resources (used by asynchronous scene serialization)
 
 			void Serialize(wi::Archive& archive);
 		} ddgi;
@@ -249,7 +272,6 @@ namespace wi::scene
 		wi::vector<TransformComponent> transforms_temp;
 
 		// CPU/GPU Colliders:
-		std::atomic<uint32_t> collider_allocator_cpu{ 0 };
 		std::atomic<uint32_t> collider_allocator_gpu{ 0 };
 		wi::vector<uint8_t> collider_deinterleaved_data;
 		uint32_t collider_count_cpu = 0;
@@ -259,6 +281,25 @@ namespace wi::scene
 		ColliderComponent* colliders_gpu = nullptr;
 		wi::BVH collider_bvh;
 
+		// CPU skinned vertex positions and BVH of skinned meshes for intersection queries
+		//	These are filled on demand by the first query that hits the mesh after the armatures were updated in Update()
+		//	The BVH contains LOD0, and it's only created for meshes that have MeshComponent::BVH_ENABLED
+		struct SkinningCache
+		{
+			std::mutex locker;
+			std::atomic<uint64_t> version{ ~0ull };
+			wi::vector<XMMATRIX> bone_matrices;
+			wi::vector<XMFLOAT3> vertex_positions;
+			wi::vector<wi::primitive::AABB> bvh_leaf_aabbs; // same layout as MeshComponent::bvh_leaf_aabbs
+			wi::BVH bvh;
+		};
+		mutable wi::SpinLock skinning_cache_locker;
+		mutable wi::unordered_map<wi::ecs::Entity, std::shared_ptr<SkinningCache>> skinning_cache;
+		uint64_t skinning_cache_version = 0;
+		// Returns the skinned state of the mesh for the current frame, or nullptr if the mesh is not skinned
+		//	This is thread safe, the returned cache is valid until the next Update()
+		const SkinningCache* GetSkinningCache(wi::ecs::Entity meshID) const;
+
 		// Ocean GPU state:
 		wi::Ocean ocean;
 		void OceanRegenerate() { ocean.Create(weather.oceanParameters); }
@@ -282,7 +323,41 @@ namespace wi::scene
 
 		// Update all components by a given timestep (in seconds):
 		//	This is an expensive function, prefer to call it only once per frame!
+		//	If there is no graphics device (wi::graphics::GetDevice() is nullptr), this runs in headless mode:
+		//	transforms, animations, physics, scripts and CPU-side bounds are updated, but no GPU resources are created or written
 		virtual void Update(float dt);
+
+		// Fixed rate simulation:
+		//	If the simulation frame rate is set, Update() advances scripts, animations, physics, transforms, hierarchy, expressions
+		//	and procedural animations in fixed steps, independently of the dt it receives. Other systems run once per Update().
+		//	Script components run once per step, and getDeltaTime() returns the step duration in them while stepping.
+		//	The transform world matrices are interpolated between the last two simulation steps for smooth rendering at any frame rate.
+		//	The simulation can also be ticked without rendering at all, for example headless at 30 Hz on a server.
+		//	value : simulation steps per second, 0 to disable (default)
+		void SetSimulationFrameRate(float value) { simulation_frame_rate = std::max(0.0f, value); simulation_accumulator = 0; }
+		float GetSimulationFrameRate() const { return simulation_frame_rate; }
+		// Interpolation factor of world matrices between the previous [0] and current [1] simulation step:
+		float GetSimulationInterpolation() const { return simulation_interpolation; }
+		// Number of fixed simulation steps that were performed in the last Update():
+		uint32_t GetSimulationStepCount() const { return simulation_step_count; }
+		float simulation_frame_rate = 0;
+		float simulation_accumulator = 0;
+		float simulation_interpolation = 1;
+		uint32_t simulation_step_count = 0;
+		uint32_t simulation_max_steps = 8; // upper limit of simulation steps in one Update(), the remaining time is dropped if the simulation can't keep up
+		struct SimulationState
+		{
+			wi::vector<wi::ecs::Entity> entities; // parallel to transforms
+			wi::vector<XMFLOAT4X4> world;
+		};
+		SimulationState simulation_state_prev;
+		SimulationState simulation_state_current;
+		void StoreSimulationState(SimulationState& state) const;
+		// Runs one fixed simulation step, this is used by Update() when the simulation frame rate is set:
+		void RunSimulationStep(float step_dt);
+		// Advances the simulation by dt in fixed steps and interpolates transforms, this is used by Update() when the simulation frame rate is set:
+		void RunFixedSimulation(float dt);
+
 		// Remove everything from the scene that it owns:
 		virtual void Clear();
 		// Merge an other scene into this.
@@ -401,7 +476,56 @@ namespace wi::scene
 		// Detaches all children from an entity (if there are any):
 		void Component_DetachChildren(wi::ecs::Entity parent);
 
-		void Serialize(wi::Archive& archive);
+		// progress : optional, the serialization progress will be reported here in [0, 1] range
+		// resource_mode : decides whether the file data of resources is embedded when writing (default: the current resource manager mode)
+		void Serialize(wi::Archive& archive, std::atomic<float>* progress = nullptr, wi::resourcemanager::Mode resource_mode = wi::resourcemanager::GetMode());
+
+		// State of an asynchronous scene save, it can be polled from the calling thread
+		struct AsyncSerialization
+		{
+			wi::jobsystem::context ctx;
+			std::atomic<float> progress{ 0 }; // serialization progress in [0, 1] range
+			std::atomic_bool success{ false }; // true when the file was written successfully
+
+			bool IsFinished() const { return !wi::jobsystem::IsBusy(ctx); }
+			void Wait() { wi::jobsystem::Wait(ctx); }
+		};
+		// Saves the scene to a file on a background job
+		//	All component managers are copied on the calling thread first, which is much cheaper than serialization,
+		//	so the scene can be modified freely after this function returns. GPU data that needs to be downloaded
+		//	for serialization (DDGI probes) is also read back on the calling thread. The resource manager mode is also
+		//	taken at this point, so changing it while the save is in progress doesn't affect this file.
+		//	compressed : the file will be written with block compression (see wi::Archive::SetCompressionEnabled())
+		//	Returns the state that can be used to query progress and completion
+		std::shared_ptr<AsyncSerialization> SerializeAsync(const std::string& filename, bool compressed = false);
+
+		// Serialized state of all components, used as baseline for delta serialization
+		struct Snapshot
+		{
+			struct ComponentData
+			{
+				wi::vector<wi::ecs::Entity> entities;
+				wi::unordered_map<wi::ecs::Entity, size_t> lookup;
+				wi::vector<size_t> offsets; // start of each serialized component in data, and the end of the last one
+				wi::vector<uint8_t> data; // serialized components, starting with the archive header
+			};
+			wi::unordered_map<std::string, ComponentData> components; // per component manager name
+			wi::unordered_map<wi::ecs::Entity, uint64_t> entity_remap; // runtime entity -> session independent entity
+		};
+		// Creates a snapshot of the current state of all components
+		void CreateSnapshot(Snapshot& snapshot);
+		// Writes only the components that were changed, added or removed since the baseline snapshot
+		//	Per component manager, the changed and removed entities are stored as bitmasks, the changed
+		//	components as XOR deltas against the baseline, all compressed
+		//	Components are not tracked for modification, so by default every component that is in the baseline is serialized again
+		//	and compared, which makes this O(scene size) even if the delta is small.
+		//	changed_entities : if specified, only the components of these entities are compared, the others are considered unchanged,
+		//		added and removed components are found without serializing them (optional)
+		void SerializeDelta(const Snapshot& baseline, wi::Archive& archive, const wi::unordered_set<wi::ecs::Entity>* changed_entities = nullptr);
+		// Applies a delta that was written by SerializeDelta()
+		//	The scene must be in the state that the baseline snapshot was created from (for example after
+		//	loading the same baseline archive that the writer used). The baseline must be created from this state.
+		void ApplyDelta(const Snapshot& baseline, wi::Archive& archive);
 
 		void RunAnimationUpdateSystem(wi::jobsystem::context& ctx);
 		void RunTransformUpdateSystem(wi::jobsystem::context& ctx);
@@ -467,6 +591,13 @@ namespace wi::scene
 		using CapsuleIntersectionResult = SphereIntersectionResult;
 		CapsuleIntersectionResult Intersects(const wi::primitive::Capsule& capsule, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
 
+		// Batched versions of Intersects(), for example for many line of sight tests at once
+		//	The results are written in the same order as the queries, and they are the same as with separate Intersects() calls
+		//	The queries are distributed across job system threads, and nearby queries are grouped together for cache locality
+		void IntersectsBatch(const wi::primitive::Ray* rays, RayIntersectionResult* results, size_t count, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
+		void IntersectsBatch(const wi::primitive::Sphere* spheres, SphereIntersectionResult* results, size_t count, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
+		void IntersectsBatch(const wi::primitive::Capsule* capsules, CapsuleIntersectionResult* results, size_t count, uint32_t filterMask = wi::enums::FILTER_OPAQUE, uint32_t layerMask = ~0, uint32_t lod = 0) const;
+
 		// Goes through the hierarchy backwards and computes parent's world space matrix:
 		XMMATRIX ComputeParentMatrixRecursive(wi::ecs::Entity entity) const;
 
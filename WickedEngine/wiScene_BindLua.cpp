@@ -4726,6 +4726,7 @@ Luna<ObjectComponent_BindLua>::FunctionType ObjectComponent_BindLua::methods[] =
 	lunamethod(ObjectComponent_BindLua, IsForeground),
 	lunamethod(ObjectComponent_BindLua, IsNotVisibleInMainCamera),
 	lunamethod(ObjectComponent_BindLua, IsNotVisibleInReflections),
+	lunamethod(ObjectComponent_BindLua, IsOccluder),
 
 	lunamethod(ObjectComponent_BindLua, SetMeshID),
 	lunamethod(ObjectComponent_BindLua, SetCascadeMask),
@@ -4737,6 +4738,7 @@ Luna<ObjectComponent_BindLua>::FunctionType ObjectComponent_BindLua::methods[] =
 	lunamethod(ObjectComponent_BindLua, SetForeground),
 	lunamethod(ObjectComponent_BindLua, SetNotVisibleInMainCamera),
 	lunamethod(ObjectComponent_BindLua, SetNotVisibleInReflections),
+	lunamethod(ObjectComponent_BindLua, SetOccluder),
 	{ NULL, NULL }
 };
 Luna<ObjectComponent_BindLua>::PropertyType ObjectComponent_BindLua::properties[] = {
@@ -4804,6 +4806,11 @@ int ObjectComponent_BindLua::IsNotVisibleInReflections(lua_State* L)
 	wi::lua::SSetBool(L, component->IsNotVisibleInReflections());
 	return 1;
 }
+int ObjectComponent_BindLua::IsOccluder(lua_State* L)
+{
+	wi::lua::SSetBool(L, component->IsOccluder());
+	return 1;
+}
 
 int ObjectComponent_BindLua::SetMeshID(lua_State* L)
 {
@@ -4981,6 +4988,21 @@ int ObjectComponent_BindLua::SetNotVisibleInReflections(lua_State* L)
 
 	return 0;
 }
+int ObjectComponent_BindLua::SetOccluder(lua_State* L)
+{
+	int argc = wi::lua::SGetArgCount(L);
+	if (argc > 0)
+	{
+		bool value = wi::lua::SGetBool(L, 1);
+		component->SetOccluder(value);
+	}
+	else
+	{
+		wi::lua::SError(L, "SetOccluder(bool value) not enough arguments!");
+	}
+
+	return 0;
+}
 
 
 
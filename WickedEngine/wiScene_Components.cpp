@@ -412,6 +412,10 @@ namespace wi::scene
 	wi::resourcemanager::Flags MaterialComponent::GetTextureSlotResourceFlags(TEXTURESLOT slot)
 	{
 		wi::resourcemanager::Flags flags = wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA;
+		if (wi::renderer::GetTextureStreamingEnabled())
+		{
+			flags |= wi::resourcemanager::Flags::STREAMING;
+		}
 		if (!IsPreferUncompressedTexturesEnabled())
 		{
 			flags |= wi::resourcemanager::Flags::IMPORT_BLOCK_COMPRESSED;
@@ -579,6 +583,11 @@ namespace wi::scene
 		{
 			position_format = vertex_windweights.empty() ? Vertex_POS32::FORMAT : Vertex_POS32W::FORMAT;
 		}
+		else if (position_format_loaded)
+		{
+			// position_format was loaded with the mesh, it was determined from the same geometry
+			position_format_loaded = false;
+		}
 		else
 		{
 			// Determine minimum precision for positions:
@@ -624,26 +633,26 @@ namespace wi::scene
 					break; // since 32 bit is the max, we can bail out
 				}
 			}
+		}
 
-			if (IsFormatUnorm(position_format))
+		if (IsFormatUnorm(position_format))
+		{
+			// This is done to avoid 0 scaling on any axis of the UNORM remap matrix of the AABB
+			//	It specifically solves a problem with hardware raytracing which treats AABB with zero axis as invisible
+			if (aabb._max.x - aabb._min.x < std::numeric_limits<float>::epsilon())
 			{
-				// This is done to avoid 0 scaling on any axis of the UNORM remap matrix of the AABB
-				//	It specifically solves a problem with hardware raytracing which treats AABB with zero axis as invisible
-				if (aabb._max.x - aabb._min.x < std::numeric_limits<float>::epsilon())
-				{
-					aabb._max.x += std::numeric_limits<float>::epsilon();
-					aabb._min.x -= std::numeric_limits<float>::epsilon();
-				}
-				if (aabb._max.y - aabb._min.y < std::numeric_limits<float>::epsilon())
-				{
-					aabb._max.y += std::numeric_limits<float>::epsilon();
-					aabb._min.y -= std::numeric_limits<float>::epsilon();
-				}
-				if (aabb._max.z - aabb._min.z < std::numeric_limits<float>::epsilon())
-				{
-					aabb._max.z += std::numeric_limits<float>::epsilon();
-					aabb._min.z -= std::numeric_limits<float>::epsilon();
-				}
+				aabb._max.x += std::numeric_limits<float>::epsilon();
+				aabb._min.x -= std::numeric_limits<float>::epsilon();
+			}
+			if (aabb._max.y - aabb._min.y < std::numeric_limits<float>::epsilon())
+			{
+				aabb._max.y += std::numeric_limits<float>::epsilon();
+				aabb._min.y -= std::numeric_limits<float>::epsilon();
+			}
+			if (aabb._max.z - aabb._min.z < std::numeric_limits<float>::epsilon())
+			{
+				aabb._max.z += std::numeric_limits<float>::epsilon();
+				aabb._min.z -= std::numeric_limits<float>::epsilon();
 			}
 		}
 
@@ -664,6 +673,10 @@ namespace wi::scene
 			}
 		}
 
+		// Without graphics device only the CPU-side data is created (headless mode):
+		if (device == nullptr)
+			return;
+
 		const size_t position_stride = GetFormatStride(position_format);
 
 		GPUBufferDesc bd;
@@ -1028,6 +1041,8 @@ namespace wi::scene
 	void MeshComponent::CreateStreamoutRenderData()
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
+		if (device == nullptr)
+			return;
 
 		GPUBufferDesc desc;
 		desc.usage = Usage::DEFAULT;
@@ -1094,7 +1109,7 @@ namespace wi::scene
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
 
-		if (!device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
+		if (device == nullptr || !device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
 			return;
 
 		BLAS_state = MeshComponent::BLAS_STATE_NEEDS_REBUILD;
@@ -1178,6 +1193,20 @@ namespace wi::scene
 			}
 		}
 		bvh.Build(bvh_leaf_aabbs.data(), (uint32_t)bvh_leaf_aabbs.size());
+		bvh.BuildWide();
+	}
+	uint64_t MeshComponent::ComputeGeometryHash() const
+	{
+		uint64_t hash = wi::helper::data_hash(vertex_positions.data(), vertex_positions.size() * sizeof(XMFLOAT3));
+		hash = wi::helper::data_hash(indices.data(), indices.size() * sizeof(uint32_t), hash);
+		hash = wi::helper::data_hash(vertex_windweights.data(), vertex_windweights.size() * sizeof(uint8_t), hash);
+		for (const MeshSubset& subset : subsets)
+		{
+			hash = wi::helper::data_hash(&subset.indexOffset, sizeof(subset.indexOffset), hash);
+			hash = wi::helper::data_hash(&subset.indexCount, sizeof(subset.indexCount), hash);
+		}
+		hash = wi::helper::data_hash(&subsets_per_lod, sizeof(subsets_per_lod), hash);
+		return hash;
 	}
 	void MeshComponent::ComputeNormals(COMPUTE_NORMALS compute)
 	{
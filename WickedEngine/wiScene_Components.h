@@ -340,6 +340,7 @@ namespace wi::scene
 			DOUBLE_SIDED_SHADOW = 1 << 7,
 			BVH_ENABLED = 1 << 8,
 			QUANTIZED_POSITIONS_DISABLED = 1 << 9,
+			DERIVED_DATA_SERIALIZED = 1 << 10,
 		};
 		uint32_t _flags = RENDERABLE;
 
@@ -434,6 +435,7 @@ namespace wi::scene
 
 		wi::vector<wi::primitive::AABB> bvh_leaf_aabbs;
 		wi::BVH bvh;
+		bool position_format_loaded = false; // position_format was loaded by Serialize(), CreateRenderData() doesn't need to determine it
 
 		inline void SetRenderable(bool value) { if (value) { _flags |= RENDERABLE; } else { _flags &= ~RENDERABLE; } }
 		inline void SetDoubleSided(bool value) { if (value) { _flags |= DOUBLE_SIDED; } else { _flags &= ~DOUBLE_SIDED; } }
@@ -449,12 +451,17 @@ namespace wi::scene
 		//	This should be enabled for connecting meshes like terrain chunks if their AABB is not consistent with each other
 		inline void SetQuantizedPositionsDisabled(bool value) { if (value) { _flags |= QUANTIZED_POSITIONS_DISABLED; } else { _flags &= ~QUANTIZED_POSITIONS_DISABLED; } }
 
+		// Enable saving of data that is otherwise recomputed at load time: the BVH and the position format
+		//	The saved data is validated against a hash of the geometry when loading, it is recomputed if the geometry was changed
+		inline void SetDerivedDataSerialized(bool value) { if (value) { _flags |= DERIVED_DATA_SERIALIZED; } else { _flags &= ~DERIVED_DATA_SERIALIZED; } }
+
 		inline bool IsRenderable() const { return _flags & RENDERABLE; }
 		inline bool IsDoubleSided() const { return _flags & DOUBLE_SIDED; }
 		inline bool IsDoubleSidedShadow() const { return _flags & DOUBLE_SIDED_SHADOW; }
 		inline bool IsDynamic() const { return _flags & DYNAMIC; }
 		inline bool IsBVHEnabled() const { return _flags & BVH_ENABLED; }
 		inline bool IsQuantizedPositionsDisabled() const { return _flags & QUANTIZED_POSITIONS_DISABLED; }
+		inline bool IsDerivedDataSerialized() const { return _flags & DERIVED_DATA_SERIALIZED; }
 
 		inline float GetTessellationFactor() const { return tessellationFactor; }
 		inline wi::graphics::IndexBufferFormat GetIndexFormat() const { return wi::graphics::GetIndexBufferFormat((uint32_t)vertex_positions.size()); }
@@ -484,6 +491,9 @@ namespace wi::scene
 		// Rebuilds CPU-side BVH acceleration structure
 		void BuildBVH();
 
+		// Hash of the geometry that the BVH and position format are computed from
+		uint64_t ComputeGeometryHash() const;
+
 		size_t GetMemoryUsageCPU() const;
 		size_t GetMemoryUsageGPU() const;
 		size_t GetMemoryUsageBVH() const;
@@ -794,6 +804,7 @@ namespace wi::scene
 			FOREGROUND = 1 << 7,
 			NOT_VISIBLE_IN_MAIN_CAMERA = 1 << 8,
 			NOT_VISIBLE_IN_REFLECTIONS = 1 << 9,
+			OCCLUDER = 1 << 10,
 		};
 		uint32_t _flags = RENDERABLE | CAST_SHADOW;
 
@@ -838,6 +849,8 @@ namespace wi::scene
 		inline void SetNotVisibleInMainCamera(bool value) { if (value) { _flags |= NOT_VISIBLE_IN_MAIN_CAMERA; } else { _flags &= ~NOT_VISIBLE_IN_MAIN_CAMERA; } }
 		// With this you can disable object rendering for reflections
 		inline void SetNotVisibleInReflections(bool value) { if (value) { _flags |= NOT_VISIBLE_IN_REFLECTIONS; } else { _flags &= ~NOT_VISIBLE_IN_REFLECTIONS; } }
+		// Occluders are always rasterized for software occlusion culling, otherwise only objects that are large on screen are selected automatically
+		inline void SetOccluder(bool value) { if (value) { _flags |= OCCLUDER; } else { _flags &= ~OCCLUDER; } }
 
 		inline bool IsRenderable() const { return (_flags & RENDERABLE) && (GetTransparency() < 0.99f); }
 		inline bool IsCastingShadow() const { return _flags & CAST_SHADOW; }
@@ -848,6 +861,7 @@ namespace wi::scene
 		inline bool IsForeground() const { return _flags & FOREGROUND; }
 		inline bool IsNotVisibleInMainCamera() const { return _flags & NOT_VISIBLE_IN_MAIN_CAMERA; }
 		inline bool IsNotVisibleInReflections() const { return _flags & NOT_VISIBLE_IN_REFLECTIONS; }
+		inline bool IsOccluder() const { return _flags & OCCLUDER; }
 
 		inline float GetTransparency() const { return 1 - color.w; }
 		inline uint32_t GetFilterMask() const { return filterMask | filterMaskDynamic; }
@@ -451,10 +451,47 @@ namespace wi::scene
 				archive >> subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 92 && IsDerivedDataSerialized())
+			{
+				uint64_t jump_pos = 0;
+				archive >> jump_pos;
+				uint64_t geometry_hash = 0;
+				archive >> geometry_hash;
+				// If the geometry doesn't match the derived data, it is skipped and recomputed:
+				if (geometry_hash == ComputeGeometryHash())
+				{
+					bool has_position_format = false;
+					archive >> has_position_format;
+					if (has_position_format)
+					{
+						uint32_t format = 0;
+						archive >> format;
+						position_format = (wi::graphics::Format)format;
+						position_format_loaded = true;
+					}
+
+					bool has_bvh = false;
+					archive >> has_bvh;
+					if (has_bvh)
+					{
+						size_t leaf_count = 0;
+						archive >> leaf_count;
+						bvh_leaf_aabbs.resize(leaf_count);
+						archive.ReadRaw(bvh_leaf_aabbs.data(), sizeof(wi::primitive::AABB) * leaf_count);
+						bvh.Serialize(archive);
+						if (bvh.leaf_count != leaf_count)
+						{
+							bvh = {};
+						}
+					}
+				}
+				archive.Jump(jump_pos);
+			}
+
 			wi::jobsystem::Execute(seri.ctx, [&](wi::jobsystem::JobArgs args) {
 				CreateRenderData();
 
-				if (IsBVHEnabled())
+				if (IsBVHEnabled() && !bvh.IsValid())
 				{
 					BuildBVH();
 				}
@@ -533,6 +570,30 @@ namespace wi::scene
 				archive << subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 92 && IsDerivedDataSerialized())
+			{
+				const size_t jump_pos = archive.WriteUnknownJumpPosition();
+				archive << ComputeGeometryHash();
+
+				// The position format is only known if CreateRenderData() was called:
+				const bool has_position_format = vb_pos_wind.IsValid() && !IsQuantizedPositionsDisabled();
+				archive << has_position_format;
+				if (has_position_format)
+				{
+					archive << (uint32_t)position_format;
+				}
+
+				const bool has_bvh = IsBVHEnabled() && bvh.IsValid();
+				archive << has_bvh;
+				if (has_bvh)
+				{
+					archive << bvh_leaf_aabbs.size();
+					archive.WriteRaw(bvh_leaf_aabbs.data(), sizeof(wi::primitive::AABB) * bvh_leaf_aabbs.size());
+					bvh.Serialize(archive);
+				}
+				archive.PatchUnknownJumpPosition(jump_pos);
+			}
+
 		}
 	}
 	void ImpostorComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
@@ -1975,7 +2036,7 @@ namespace wi::scene
 		}
 	}
 
-	void Scene::Serialize(wi::Archive& archive)
+	void Scene::Serialize(wi::Archive& archive, std::atomic<float>* progress, wi::resourcemanager::Mode resource_mode)
 	{
 		wi::Timer timer;
 
@@ -2024,6 +2085,7 @@ namespace wi::scene
 
 		// With this we will ensure that serialized entities are unique and persistent across the scene:
 		EntitySerializer seri;
+		seri.progress = progress;
 
 		if(archive.GetVersion() >= 84)
 		{
@@ -2137,14 +2199,92 @@ namespace wi::scene
 			else
 			{
 				archive.PatchUnknownJumpPosition(jump_before);
-				wi::resourcemanager::Serialize_WRITE(archive, seri.resource_registration);
+				wi::resourcemanager::Serialize_WRITE(archive, seri.resource_registration, resource_mode);
 				archive.PatchUnknownJumpPosition(jump_after);
 			}
 		}
 
+		if (progress != nullptr)
+		{
+			progress->store(1);
+		}
+
 		wi::backlog::post("Scene serialize took " + std::to_string(timer.elapsed_seconds()) + " sec");
 	}
 
+	std::shared_ptr<Scene::AsyncSerialization> Scene::SerializeAsync(const std::string& filename, bool compressed)
+	{
+		wi::Timer timer;
+		std::shared_ptr<AsyncSerialization> state = std::make_shared<AsyncSerialization>();
+
+		// Copy all component managers, custom registered ones are cloned:
+		std::shared_ptr<Scene> clone = std::make_shared<Scene>();
+		for (auto& it : componentLibrary.entries)
+		{
+			auto& entry = clone->componentLibrary.entries[it.first];
+			if (entry.component_manager == nullptr)
+			{
+				entry.component_manager = it.second.component_manager->Clone();
+			}
+			else
+			{
+				entry.component_manager->Copy(*it.second.component_manager);
+			}
+			entry.version = it.second.version;
+		}
+
+		// Terrains refer to the generator and modifiers of this scene, the clone must not share them with the background job:
+		for (size_t i = 0; i < clone->terrains.GetCount(); ++i)
+		{
+			wi::terrain::Terrain& terrain = clone->terrains[i];
+			terrain.scene = clone.get();
+			terrain.generator = nullptr; // the clone doesn't generate, and it won't cancel the generation of this scene when it's destroyed
+			terrain.modifiers_to_remove.clear();
+			for (auto& modifier : terrain.modifiers)
+			{
+				switch (modifier->type)
+				{
+				default:
+				case wi::terrain::Modifier::Type::Perlin:
+					modifier = std::make_shared<wi::terrain::PerlinModifier>(*(wi::terrain::PerlinModifier*)modifier.get());
+					break;
+				case wi::terrain::Modifier::Type::Voronoi:
+					modifier = std::make_shared<wi::terrain::VoronoiModifier>(*(wi::terrain::VoronoiModifier*)modifier.get());
+					break;
+				case wi::terrain::Modifier::Type::Heightmap:
+					modifier = std::make_shared<wi::terrain::HeightmapModifier>(*(wi::terrain::HeightmapModifier*)modifier.get());
+					break;
+				}
+			}
+		}
+
+		// The DDGI GPU readback must happen on this thread, the background job will only write the downloaded data:
+		{
+			wi::Archive ddgi_archive;
+			ddgi.Serialize(ddgi_archive);
+			const size_t header_size = sizeof(uint64_t); // archive version
+			clone->ddgi.serialized_data.resize(ddgi_archive.GetPos() - header_size);
+			std::memcpy(clone->ddgi.serialized_data.data(), ddgi_archive.GetData() + header_size, clone->ddgi.serialized_data.size());
+		}
+
+		wi::backlog::post("Scene async serialize copy took " + std::to_string(timer.elapsed_seconds()) + " sec");
+
+		const wi::resourcemanager::Mode resource_mode = wi::resourcemanager::GetMode();
+
+		wi::jobsystem::Execute(state->ctx, [=](wi::jobsystem::JobArgs args) {
+			wi::Archive archive;
+			archive.SetCompressionEnabled(compressed);
+			clone->Serialize(archive, &state->progress, resource_mode);
+			state->success.store(archive.SaveFile(filename));
+			if (!state->success.load())
+			{
+				wi::backlog::post("Scene async serialize failed to write file: " + filename, wi::backlog::LogLevel::Error);
+			}
+		});
+
+		return state;
+	}
+
 	void Scene::DDGI::Serialize(wi::Archive& archive)
 	{
 		using namespace wi::graphics;
@@ -2222,6 +2362,10 @@ namespace wi::scene
 				device->SetName(&offset_buffer, "ddgi.offset_buffer[serialized]");
 			}
 		}
+		else if (!serialized_data.empty())
+		{
+			archive.WriteRaw(serialized_data.data(), serialized_data.size());
+		}
 		else
 		{
 			archive << frame_index;
@@ -3074,4 +3218,328 @@ namespace wi::scene
 		return ret;
 	}
 
+
+	// Component managers are processed in name order, so the session independent entity values are deterministic:
+	static wi::vector<std::pair<const std::string*, ComponentLibrary::LibraryEntry*>> GetSortedLibraryEntries(ComponentLibrary& library)
+	{
+		wi::vector<std::pair<const std::string*, ComponentLibrary::LibraryEntry*>> sorted;
+		sorted.reserve(library.entries.size());
+		for (auto& it : library.entries)
+		{
+			sorted.push_back(std::make_pair(&it.first, &it.second));
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+			return *a.first < *b.first;
+		});
+		return sorted;
+	}
+
+	void Scene::CreateSnapshot(Snapshot& snapshot)
+	{
+		snapshot.components.clear();
+		snapshot.entity_remap.clear();
+
+		auto sorted = GetSortedLibraryEntries(componentLibrary);
+
+		EntitySerializer seri;
+		seri.allow_write_remap = true;
+		for (auto& it : sorted)
+		{
+			for (Entity entity : it.second->component_manager->GetEntityArray())
+			{
+				if (seri.write_remap.find(entity) == seri.write_remap.end())
+				{
+					const uint64_t mem = seri.write_remap.size() + 1;
+					seri.write_remap[entity] = mem;
+				}
+			}
+		}
+
+		for (auto& it : sorted)
+		{
+			ComponentManager_Interface& manager = *it.second->component_manager;
+			Snapshot::ComponentData& data = snapshot.components[*it.first];
+			data.entities = manager.GetEntityArray();
+			data.offsets.resize(data.entities.size() + 1);
+			data.lookup.reserve(data.entities.size());
+			seri.version = it.second->version;
+
+			wi::Archive archive;
+			for (size_t i = 0; i < data.entities.size(); ++i)
+			{
+				const Entity entity = data.entities[i];
+				data.lookup[entity] = i;
+				data.offsets[i] = archive.GetPos();
+				manager.Component_Serialize(entity, archive, seri);
+			}
+			data.offsets.back() = archive.GetPos();
+			archive.WriteData(data.data);
+		}
+
+		snapshot.entity_remap = std::move(seri.write_remap);
+	}
+
+	void Scene::SerializeDelta(const Snapshot& baseline, wi::Archive& archive, const wi::unordered_set<Entity>* changed_entities)
+	{
+		assert(!archive.IsReadMode());
+
+		EntitySerializer seri;
+		seri.allow_write_remap = true;
+		seri.write_remap = baseline.entity_remap;
+
+		const Snapshot::ComponentData empty;
+		wi::Archive component_archive;
+		wi::vector<uint8_t> delta;
+		wi::vector<uint8_t> compressed;
+		wi::vector<Entity> added;
+
+		auto append = [&](const void* src, size_t size) {
+			const size_t offset = delta.size();
+			delta.resize(offset + size);
+			std::memcpy(delta.data() + offset, src, size);
+		};
+
+		for (auto& it : GetSortedLibraryEntries(componentLibrary))
+		{
+			ComponentManager_Interface& manager = *it.second->component_manager;
+			auto baseline_it = baseline.components.find(*it.first);
+			const Snapshot::ComponentData& base = baseline_it == baseline.components.end() ? empty : baseline_it->second;
+			seri.version = it.second->version;
+
+			// Bitmasks of the changed and removed components, indexed by the baseline component order:
+			const size_t mask_words = (base.entities.size() + 63) / 64;
+			delta.clear();
+			delta.resize(mask_words * 2 * sizeof(uint64_t));
+			added.clear();
+			bool any_change = false;
+
+			auto serialize_component = [&](Entity entity, const uint8_t*& component_data, uint64_t& component_size) {
+				component_archive.SetReadModeAndResetPos(false);
+				const size_t start = component_archive.GetPos();
+				manager.Component_Serialize(entity, component_archive, seri);
+				component_data = component_archive.GetData() + start;
+				component_size = component_archive.GetPos() - start;
+			};
+
+			// The changed components are written as XOR against the baseline, in baseline order:
+			for (size_t i = 0; i < base.entities.size(); ++i)
+			{
+				const Entity entity = base.entities[i];
+				if (!manager.Contains(entity))
+				{
+					((uint64_t*)delta.data())[mask_words + i / 64] |= 1ull << (i % 64);
+					any_change = true;
+					continue;
+				}
+				if (changed_entities != nullptr && changed_entities->find(entity) == changed_entities->end())
+					continue;
+
+				const uint8_t* component_data = nullptr;
+				uint64_t component_size = 0;
+				serialize_component(entity, component_data, component_size);
+
+				const uint8_t* base_data = base.data.data() + base.offsets[i];
+				const uint64_t base_size = base.offsets[i + 1] - base.offsets[i];
+				if (component_size == base_size && std::memcmp(component_data, base_data, component_size) == 0)
+					continue;
+
+				((uint64_t*)delta.data())[i / 64] |= 1ull << (i % 64);
+				append(&component_size, sizeof(component_size));
+				const size_t offset = delta.size();
+				delta.resize(offset + component_size);
+				for (uint64_t j = 0; j < component_size; ++j)
+				{
+					delta[offset + j] = component_data[j] ^ (j < base_size ? base_data[j] : 0);
+				}
+				any_change = true;
+			}
+
+			// The added components are written as they are:
+			for (Entity entity : manager.GetEntityArray())
+			{
+				if (base.lookup.find(entity) != base.lookup.end())
+					continue;
+				const uint8_t* component_data = nullptr;
+				uint64_t component_size = 0;
+				serialize_component(entity, component_data, component_size);
+				append(&component_size, sizeof(component_size));
+				append(component_data, component_size);
+				added.push_back(entity);
+				any_change = true;
+			}
+
+			if (!any_change)
+				continue;
+
+			wi::helper::Compress(delta.data(), delta.size(), compressed); // zero runs of unchanged bytes compress well
+
+			archive << true;
+			archive << *it.first; // name
+			size_t offset = archive.WriteUnknownJumpPosition(); // to skip if this component manager is not registered when reading
+			archive << it.second->version;
+			archive << base.entities.size();
+			archive << added.size();
+			for (Entity entity : added)
+			{
+				SerializeEntity(archive, entity, seri);
+			}
+			archive << delta.size();
+			archive << compressed;
+			archive.PatchUnknownJumpPosition(offset);
+		}
+		archive << false;
+	}
+
+	void Scene::ApplyDelta(const Snapshot& baseline, wi::Archive& archive)
+	{
+		assert(archive.IsReadMode());
+
+		// Baseline entities are referenced by their session independent values, new entities will be created:
+		EntitySerializer seri;
+		for (auto& it : baseline.entity_remap)
+		{
+			seri.remap[it.second] = it.first;
+		}
+
+		const Snapshot::ComponentData empty;
+		wi::vector<Entity> added;
+		wi::vector<uint8_t> compressed;
+		wi::vector<uint8_t> delta;
+		wi::vector<uint8_t> component_data;
+
+		// Deserializes one component from raw component data:
+		auto apply = [&](ComponentManager_Interface& manager, Entity entity, const uint8_t* data, uint64_t size, const uint8_t* base_data, uint64_t base_size) {
+			const uint64_t version = archive.GetVersion();
+			component_data.resize(sizeof(version) + size);
+			std::memcpy(component_data.data(), &version, sizeof(version));
+			for (uint64_t i = 0; i < size; ++i)
+			{
+				component_data[sizeof(version) + i] = data[i] ^ (i < base_size ? base_data[i] : 0);
+			}
+			wi::Archive component_archive(component_data.data(), component_data.size());
+			manager.Component_Serialize(entity, component_archive, seri);
+			wi::jobsystem::Wait(seri.ctx); // component data buffer is reused, and component arrays could be resized by the next one
+		};
+
+		bool has_next = false;
+		do
+		{
+			archive >> has_next;
+			if (!has_next)
+				break;
+
+			std::string name;
+			archive >> name;
+			uint64_t jump_size = 0;
+			archive >> jump_size;
+			auto it = componentLibrary.entries.find(name);
+			if (it == componentLibrary.entries.end())
+			{
+				archive.Jump(jump_size);
+				continue;
+			}
+			ComponentManager_Interface& manager = *it->second.component_manager;
+			archive >> seri.version;
+
+			auto baseline_it = baseline.components.find(name);
+			const Snapshot::ComponentData& base = baseline_it == baseline.components.end() ? empty : baseline_it->second;
+			size_t base_count = 0;
+			archive >> base_count;
+			if (base_count != base.entities.size())
+			{
+				wi::backlog::post("Scene::ApplyDelta: baseline mismatch for " + name + ", it will be skipped!", wi::backlog::LogLevel::Error);
+				archive.Jump(jump_size);
+				continue;
+			}
+
+			size_t added_count = 0;
+			archive >> added_count;
+			added.resize(added_count);
+			for (size_t i = 0; i < added_count; ++i)
+			{
+				SerializeEntity(archive, added[i], seri);
+			}
+
+			size_t delta_size = 0;
+			archive >> delta_size;
+			archive >> compressed;
+			delta.resize(delta_size);
+			if (!wi::helper::Decompress(compressed.data(), compressed.size(), delta.data(), delta.size()))
+			{
+				wi::backlog::post("Scene::ApplyDelta: corrupted data for " + name + ", it will be skipped!", wi::backlog::LogLevel::Error);
+				continue;
+			}
+
+			// The whole delta is validated before anything is applied, because it could be truncated or built against a different baseline:
+			const size_t mask_words = (base.entities.size() + 63) / 64;
+			bool valid = delta.size() >= mask_words * 2 * sizeof(uint64_t);
+			const uint64_t* changed_mask = (const uint64_t*)delta.data();
+			const uint64_t* removed_mask = changed_mask + mask_words;
+			const uint8_t* data_begin = delta.data() + mask_words * 2 * sizeof(uint64_t);
+			const uint8_t* data_end = delta.data() + delta.size();
+			auto validate_component = [&](const uint8_t*& ptr) {
+				uint64_t size = 0;
+				if (size_t(data_end - ptr) < sizeof(size))
+					return false;
+				std::memcpy(&size, ptr, sizeof(size));
+				ptr += sizeof(size);
+				if (size_t(data_end - ptr) < size)
+					return false;
+				ptr += size;
+				return true;
+			};
+			if (valid)
+			{
+				const uint8_t* ptr = data_begin;
+				for (size_t i = 0; valid && i < base.entities.size(); ++i)
+				{
+					if (changed_mask[i / 64] & (1ull << (i % 64)))
+					{
+						valid = validate_component(ptr);
+					}
+				}
+				for (size_t i = 0; valid && i < added.size(); ++i)
+				{
+					valid = validate_component(ptr);
+				}
+				valid = valid && ptr == data_end;
+			}
+			if (!valid)
+			{
+				wi::backlog::post("Scene::ApplyDelta: corrupted data for " + name + ", it will be skipped!", wi::backlog::LogLevel::Error);
+				continue;
+			}
+			const uint8_t* ptr = data_begin;
+
+			for (size_t i = 0; i < base.entities.size(); ++i)
+			{
+				if (removed_mask[i / 64] & (1ull << (i % 64)))
+				{
+					manager.Remove(base.entities[i]);
+				}
+			}
+			for (size_t i = 0; i < base.entities.size(); ++i)
+			{
+				if (changed_mask[i / 64] & (1ull << (i % 64)))
+				{
+					uint64_t size = 0;
+					std::memcpy(&size, ptr, sizeof(size));
+					ptr += sizeof(size);
+					const uint8_t* base_data = base.data.data() + base.offsets[i];
+					const uint64_t base_size = base.offsets[i + 1] - base.offsets[i];
+					apply(manager, base.entities[i], ptr, size, base_data, base_size);
+					ptr += size;
+				}
+			}
+			for (Entity entity : added)
+			{
+				uint64_t size = 0;
+				std::memcpy(&size, ptr, sizeof(size));
+				ptr += sizeof(size);
+				apply(manager, entity, ptr, size, nullptr, 0);
+				ptr += size;
+			}
+		} while (has_next);
+	}
+
 }
@@ -0,0 +1,330 @@
+#include "wiSpatialHash.h"
+#include "wiUnorderedSet.h"
+#include "wiMath.h"
+
+#include <algorithm>
+
+using namespace wi::primitive;
+
+namespace wi
+{
+	void SpatialHash::Clear()
+	{
+		for (auto& stream : streams)
+		{
+			stream.items.clear();
+			stream.dirty_list.clear();
+			stream.dirty_count.store(0);
+		}
+		cells.clear();
+		oversized.clear();
+		occupied = {};
+	}
+	void SpatialHash::SetCellSize(float value)
+	{
+		assert(value > 0);
+		cell_size = value;
+		cell_size_rcp = 1.0f / value;
+
+		// Every item is rehashed with the new cell size:
+		cells.clear();
+		oversized.clear();
+		occupied = {};
+		for (uint32_t s = 0; s < STREAM_COUNT; ++s)
+		{
+			Stream& stream = streams[s];
+			for (size_t i = 0; i < stream.items.size(); ++i)
+			{
+				Item& item = stream.items[i];
+				item.registered = {};
+				item.range = item.aabb.IsValid() ? ComputeCellRange(item.aabb) : CellRange();
+				Register(MakeID(s, (uint32_t)i), item.range);
+				item.registered = item.range;
+				item.dirty = false;
+			}
+			stream.dirty_count.store(0);
+		}
+	}
+
+	void SpatialHash::Resize(uint32_t stream_index, size_t count)
+	{
+		assert(stream_index < STREAM_COUNT);
+		assert(count <= GetIndex(~0u));
+		Stream& stream = streams[stream_index];
+		for (size_t i = count; i < stream.items.size(); ++i)
+		{
+			Unregister(MakeID(stream_index, (uint32_t)i), stream.items[i].registered);
+		}
+		if (count < stream.items.size())
+		{
+			// Removed items are also removed from the dirty list, so an index is never in the list twice:
+			uint32_t dirty_count = 0;
+			for (uint32_t i = 0; i < stream.dirty_count.load(); ++i)
+			{
+				if (stream.dirty_list[i] < count)
+				{
+					stream.dirty_list[dirty_count++] = stream.dirty_list[i];
+				}
+			}
+			stream.dirty_count.store(dirty_count);
+		}
+		stream.items.resize(count);
+		stream.dirty_list.resize(count);
+	}
+	void SpatialHash::Set(uint32_t stream_index, size_t index, wi::ecs::Entity entity, const AABB& aabb)
+	{
+		Stream& stream = streams[stream_index];
+		Item& item = stream.items[index];
+		item.aabb = aabb;
+		item.entity = entity;
+		item.range = aabb.IsValid() ? ComputeCellRange(aabb) : CellRange();
+		if (!item.dirty && item.range != item.registered)
+		{
+			item.dirty = true;
+			stream.dirty_list[stream.dirty_count.fetch_add(1u)] = (uint32_t)index;
+		}
+	}
+	void SpatialHash::Commit()
+	{
+		for (uint32_t s = 0; s < STREAM_COUNT; ++s)
+		{
+			Stream& stream = streams[s];
+			const uint32_t dirty_count = stream.dirty_count.exchange(0);
+			for (uint32_t i = 0; i < dirty_count; ++i)
+			{
+				const uint32_t index = stream.dirty_list[i];
+				Item& item = stream.items[index];
+				if (!item.dirty)
+					continue;
+				const uint32_t id = MakeID(s, index);
+				Unregister(id, item.registered);
+				Register(id, item.range);
+				item.registered = item.range;
+				item.dirty = false;
+			}
+		}
+	}
+
+	SpatialHash::CellRange SpatialHash::ComputeCellRange(const AABB& aabb) const
+	{
+		CellRange range;
+		range.min_x = ComputeCellCoord(aabb._min.x);
+		range.min_y = ComputeCellCoord(aabb._min.y);
+		range.min_z = ComputeCellCoord(aabb._min.z);
+		range.max_x = ComputeCellCoord(aabb._max.x);
+		range.max_y = ComputeCellCoord(aabb._max.y);
+		range.max_z = ComputeCellCoord(aabb._max.z);
+		return range;
+	}
+	void SpatialHash::Register(uint32_t id, const CellRange& range)
+	{
+		if (range.IsEmpty())
+			return;
+		if (range.GetCellCount() > MAX_CELLS_PER_ITEM)
+		{
+			oversized.push_back(id);
+			return;
+		}
+		for (int32_t x = range.min_x; x <= range.max_x; ++x)
+		{
+			for (int32_t y = range.min_y; y <= range.max_y; ++y)
+			{
+				for (int32_t z = range.min_z; z <= range.max_z; ++z)
+				{
+					cells[MakeKey(x, y, z)].push_back(id);
+				}
+			}
+		}
+		if (occupied.IsEmpty())
+		{
+			occupied = range;
+		}
+		else
+		{
+			occupied.min_x = std::min(occupied.min_x, range.min_x);
+			occupied.min_y = std::min(occupied.min_y, range.min_y);
+			occupied.min_z = std::min(occupied.min_z, range.min_z);
+			occupied.max_x = std::max(occupied.max_x, range.max_x);
+			occupied.max_y = std::max(occupied.max_y, range.max_y);
+			occupied.max_z = std::max(occupied.max_z, range.max_z);
+		}
+	}
+	void SpatialHash::Unregister(uint32_t id, const CellRange& range)
+	{
+		if (range.IsEmpty())
+			return;
+		auto remove = [id](wi::vector<uint32_t>& ids) {
+			for (size_t i = 0; i < ids.size(); ++i)
+			{
+				if (ids[i] == id)
+				{
+					ids[i] = ids.back();
+					ids.pop_back();
+					return;
+				}
+			}
+		};
+		if (range.GetCellCount() > MAX_CELLS_PER_ITEM)
+		{
+			remove(oversized);
+			return;
+		}
+		for (int32_t x = range.min_x; x <= range.max_x; ++x)
+		{
+			for (int32_t y = range.min_y; y <= range.max_y; ++y)
+			{
+				for (int32_t z = range.min_z; z <= range.max_z; ++z)
+				{
+					auto it = cells.find(MakeKey(x, y, z));
+					if (it == cells.end())
+						continue;
+					remove(it->second);
+					if (it->second.empty())
+					{
+						cells.erase(it);
+					}
+				}
+			}
+		}
+	}
+
+	void SpatialHash::Query(const AABB& aabb, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask, uint32_t layerMask) const
+	{
+		ForEachCandidate(aabb, stream_mask, [&](uint32_t, uint32_t, const Item& item) {
+			if ((item.aabb.layerMask & layerMask) && item.aabb.intersects(aabb) != AABB::OUTSIDE)
+			{
+				result.push_back(item.entity);
+			}
+		});
+	}
+	void SpatialHash::Query(const Sphere& sphere, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask, uint32_t layerMask) const
+	{
+		AABB aabb;
+		aabb.createFromHalfWidth(sphere.center, XMFLOAT3(sphere.radius, sphere.radius, sphere.radius));
+		ForEachCandidate(aabb, stream_mask, [&](uint32_t, uint32_t, const Item& item) {
+			if ((item.aabb.layerMask & layerMask) && sphere.intersects(item.aabb))
+			{
+				result.push_back(item.entity);
+			}
+		});
+	}
+	void SpatialHash::QueryNearest(const XMFLOAT3& position, uint32_t k, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask, uint32_t layerMask, float max_distance) const
+	{
+		if (k == 0)
+			return;
+
+		struct Candidate
+		{
+			float distancesq;
+			wi::ecs::Entity entity;
+			constexpr bool operator<(const Candidate& other) const { return distancesq < other.distancesq; }
+		};
+		wi::vector<Candidate> candidates;
+		wi::unordered_set<uint32_t> visited;
+		const float max_distancesq = max_distance < std::numeric_limits<float>::max() ? max_distance * max_distance : std::numeric_limits<float>::max();
+
+		auto consider = [&](uint32_t id, const Item& item) {
+			if ((stream_mask & (1u << GetStream(id))) == 0)
+				return;
+			if ((item.aabb.layerMask & layerMask) == 0 || !item.aabb.IsValid())
+				return;
+			const XMFLOAT3 closest = wi::math::Clamp(position, item.aabb._min, item.aabb._max);
+			const float distancesq = wi::math::DistanceSquared(position, closest);
+			if (distancesq <= max_distancesq)
+			{
+				candidates.push_back({ distancesq, item.entity });
+			}
+		};
+
+		for (uint32_t id : oversized)
+		{
+			consider(id, streams[GetStream(id)].items[GetIndex(id)]);
+		}
+
+		// Cells are searched in expanding shells around the cell of the position
+		//	After shell r is finished, every unvisited item is at least r * cell_size away
+		//	so the search can stop when k candidates are already closer than that
+		if (!cells.empty() && !occupied.IsEmpty())
+		{
+			const int32_t cx = ComputeCellCoord(position.x);
+			const int32_t cy = ComputeCellCoord(position.y);
+			const int32_t cz = ComputeCellCoord(position.z);
+			const int32_t max_radius = std::max({
+				std::abs(cx - occupied.min_x), std::abs(occupied.max_x - cx),
+				std::abs(cy - occupied.min_y), std::abs(occupied.max_y - cy),
+				std::abs(cz - occupied.min_z), std::abs(occupied.max_z - cz),
+			});
+			auto visit = [&](int32_t x, int32_t y, int32_t z) {
+				if (x < occupied.min_x || x > occupied.max_x || y < occupied.min_y || y > occupied.max_y || z < occupied.min_z || z > occupied.max_z)
+					return;
+				auto it = cells.find(MakeKey(x, y, z));
+				if (it == cells.end())
+					return;
+				for (uint32_t id : it->second)
+				{
+					if (visited.insert(id).second)
+					{
+						consider(id, streams[GetStream(id)].items[GetIndex(id)]);
+					}
+				}
+			};
+			for (int32_t r = 0; r <= max_radius; ++r)
+			{
+				const uint64_t shell_cell_count = r == 0 ? 1 : uint64_t(2 * r + 1) * uint64_t(2 * r + 1) * uint64_t(2 * r + 1) - uint64_t(2 * r - 1) * uint64_t(2 * r - 1) * uint64_t(2 * r - 1);
+				if (shell_cell_count > (uint64_t)cells.size())
+				{
+					// The shells became larger than the whole grid, the remaining cells are visited directly and the search is finished:
+					for (auto& it : cells)
+					{
+						for (uint32_t id : it.second)
+						{
+							if (visited.insert(id).second)
+							{
+								consider(id, streams[GetStream(id)].items[GetIndex(id)]);
+							}
+						}
+					}
+					break;
+				}
+				for (int32_t x = cx - r; x <= cx + r; ++x)
+				{
+					for (int32_t y = cy - r; y <= cy + r; ++y)
+					{
+						if (std::abs(x - cx) == r || std::abs(y - cy) == r)
+						{
+							for (int32_t z = cz - r; z <= cz + r; ++z)
+							{
+								visit(x, y, z);
+							}
+						}
+						else
+						{
+							visit(x, y, cz - r);
+							if (r > 0)
+							{
+								visit(x, y, cz + r);
+							}
+						}
+					}
+				}
+
+				const float searched_distance = r * cell_size;
+				if (searched_distance * searched_distance >= max_distancesq)
+					break;
+				if (candidates.size() >= k)
+				{
+					std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+					if (candidates[k - 1].distancesq <= searched_distance * searched_distance)
+						break;
+				}
+			}
+		}
+
+		const size_t count = std::min(candidates.size(), (size_t)k);
+		std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+		for (size_t i = 0; i < count; ++i)
+		{
+			result.push_back(candidates[i].entity);
+		}
+	}
+}
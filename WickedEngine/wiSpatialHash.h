@@ -0,0 +1,166 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiPrimitive.h"
+#include "wiECS.h"
+#include "wiVector.h"
+#include "wiUnorderedMap.h"
+
+#include <atomic>
+#include <limits>
+
+namespace wi
+{
+	// Uniform spatial hash grid for proximity queries of many moving bounding boxes
+	//	Items are organized into streams (for example objects, colliders, lights), an item is identified by its index in the stream
+	//	Set() can be called in parallel for different items, it only records which items moved into different grid cells
+	//	Commit() rehashes only the recorded items, so it is cheap when most items stay within their cells
+	//	Queries are const and can run in parallel with each other, but not together with Set() or Commit()
+	struct SpatialHash
+	{
+		static constexpr uint32_t STREAM_COUNT = 4;
+		static constexpr uint32_t MAX_CELLS_PER_ITEM = 64; // items overlapping more cells are stored in a separate list that every query tests
+		static constexpr int32_t CELL_LIMIT = (1 << 20) - 1; // cell coordinates are clamped to 21 bits per axis
+
+		struct CellRange
+		{
+			int32_t min_x = 0, min_y = 0, min_z = 0;
+			int32_t max_x = -1, max_y = -1, max_z = -1;
+			constexpr bool IsEmpty() const { return max_x < min_x || max_y < min_y || max_z < min_z; }
+			constexpr uint64_t GetCellCount() const { return IsEmpty() ? 0 : uint64_t(max_x - min_x + 1) * uint64_t(max_y - min_y + 1) * uint64_t(max_z - min_z + 1); }
+			constexpr bool operator==(const CellRange& other) const
+			{
+				return
+					min_x == other.min_x && min_y == other.min_y && min_z == other.min_z &&
+					max_x == other.max_x && max_y == other.max_y && max_z == other.max_z;
+			}
+			constexpr bool operator!=(const CellRange& other) const { return !(*this == other); }
+		};
+		struct Item
+		{
+			wi::primitive::AABB aabb;
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			CellRange range; // the cells that the item needs to be in according to the last Set()
+			CellRange registered; // the cells that the item is currently in
+			bool dirty = false;
+		};
+		struct Stream
+		{
+			wi::vector<Item> items;
+			wi::vector<uint32_t> dirty_list;
+			std::atomic<uint32_t> dirty_count{ 0 };
+		};
+		Stream streams[STREAM_COUNT];
+		wi::unordered_map<uint64_t, wi::vector<uint32_t>> cells; // cell key -> item ids
+		wi::vector<uint32_t> oversized; // item ids that are not hashed into cells
+		CellRange occupied; // conservative range of cells that were ever occupied, this bounds the k-nearest search
+		float cell_size = 4;
+		float cell_size_rcp = 1.0f / 4.0f;
+
+		// Removes every item:
+		void Clear();
+		// Sets the size of grid cells in world units, this rehashes every item:
+		//	Good values are close to the typical item size or query radius
+		void SetCellSize(float value);
+		float GetCellSize() const { return cell_size; }
+
+		// Sets the number of items in a stream, items above count are removed from the grid
+		void Resize(uint32_t stream, size_t count);
+		size_t GetCount(uint32_t stream) const { return streams[stream].items.size(); }
+		// Sets the bounds of an item, it is thread safe for different items:
+		//	the item is removed from the grid if aabb is not valid
+		void Set(uint32_t stream, size_t index, wi::ecs::Entity entity, const wi::primitive::AABB& aabb);
+		// Rehashes the items that moved into different cells since the last Commit():
+		void Commit();
+
+		// Query functions append entities to the result vector (it is not cleared)
+		//	stream_mask	: only items from streams that have their bit set are returned (bit 0 = stream 0, ...)
+		//	layerMask	: only items whose AABB::layerMask matches this are returned
+		//	An entity is returned once for each stream that it is in
+		void Query(const wi::primitive::AABB& aabb, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask = ~0u, uint32_t layerMask = ~0u) const;
+		void Query(const wi::primitive::Sphere& sphere, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask = ~0u, uint32_t layerMask = ~0u) const;
+		// Finds the k nearest items to the position, sorted from nearest to farthest. Distances are measured to the item bounds:
+		//	max_distance : items farther than this are not returned
+		void QueryNearest(const XMFLOAT3& position, uint32_t k, wi::vector<wi::ecs::Entity>& result, uint32_t stream_mask = ~0u, uint32_t layerMask = ~0u, float max_distance = std::numeric_limits<float>::max()) const;
+
+		// Calls callback(uint32_t stream, uint32_t index, const Item& item) once for every item whose grid cells overlap the range of the aabb
+		//	The item bounds are not tested, only the cells, so the callback must do the exact test
+		template<typename F>
+		void ForEachCandidate(const wi::primitive::AABB& aabb, uint32_t stream_mask, F callback) const
+		{
+			const CellRange query = ComputeCellRange(aabb);
+			for (uint32_t id : oversized)
+			{
+				const uint32_t stream = GetStream(id);
+				if ((stream_mask & (1u << stream)) == 0)
+					continue;
+				const uint32_t index = GetIndex(id);
+				callback(stream, index, streams[stream].items[index]);
+			}
+			if (query.IsEmpty() || cells.empty())
+				return;
+			auto visit = [&](int32_t x, int32_t y, int32_t z, const wi::vector<uint32_t>& ids) {
+				for (uint32_t id : ids)
+				{
+					const uint32_t stream = GetStream(id);
+					if ((stream_mask & (1u << stream)) == 0)
+						continue;
+					const uint32_t index = GetIndex(id);
+					const Item& item = streams[stream].items[index];
+					// An item can be in multiple cells, it is only reported from the first cell where it overlaps the query:
+					if (x != std::max(item.registered.min_x, query.min_x) || y != std::max(item.registered.min_y, query.min_y) || z != std::max(item.registered.min_z, query.min_z))
+						continue;
+					callback(stream, index, item);
+				}
+			};
+			if (query.GetCellCount() > (uint64_t)cells.size())
+			{
+				// The query covers more cells than the grid has, so it's faster to iterate the occupied cells instead:
+				for (auto& it : cells)
+				{
+					int32_t x, y, z;
+					DecodeKey(it.first, x, y, z);
+					if (x < query.min_x || x > query.max_x || y < query.min_y || y > query.max_y || z < query.min_z || z > query.max_z)
+						continue;
+					visit(x, y, z, it.second);
+				}
+				return;
+			}
+			for (int32_t x = query.min_x; x <= query.max_x; ++x)
+			{
+				for (int32_t y = query.min_y; y <= query.max_y; ++y)
+				{
+					for (int32_t z = query.min_z; z <= query.max_z; ++z)
+					{
+						auto it = cells.find(MakeKey(x, y, z));
+						if (it != cells.end())
+						{
+							visit(x, y, z, it->second);
+						}
+					}
+				}
+			}
+		}
+
+		int32_t ComputeCellCoord(float value) const
+		{
+			return (int32_t)std::floor(std::max(-float(CELL_LIMIT), std::min(float(CELL_LIMIT), value * cell_size_rcp)));
+		}
+		CellRange ComputeCellRange(const wi::primitive::AABB& aabb) const;
+		static constexpr uint64_t MakeKey(int32_t x, int32_t y, int32_t z)
+		{
+			return (uint64_t(x + CELL_LIMIT + 1) << 42ull) | (uint64_t(y + CELL_LIMIT + 1) << 21ull) | uint64_t(z + CELL_LIMIT + 1);
+		}
+		static constexpr void DecodeKey(uint64_t key, int32_t& x, int32_t& y, int32_t& z)
+		{
+			x = int32_t((key >> 42ull) & 0x1FFFFF) - CELL_LIMIT - 1;
+			y = int32_t((key >> 21ull) & 0x1FFFFF) - CELL_LIMIT - 1;
+			z = int32_t(key & 0x1FFFFF) - CELL_LIMIT - 1;
+		}
+		static constexpr uint32_t MakeID(uint32_t stream, uint32_t index) { return (stream << 28u) | index; }
+		static constexpr uint32_t GetStream(uint32_t id) { return id >> 28u; }
+		static constexpr uint32_t GetIndex(uint32_t id) { return id & 0x0FFFFFFF; }
+
+		void Register(uint32_t id, const CellRange& range);
+		void Unregister(uint32_t id, const CellRange& range);
+	};
+}
@@ -0,0 +1,1176 @@
+#include "wiTextureBaker.h"
+#include "wiJobSystem.h"
+#include "wiBacklog.h"
+#include "wiMath.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace wi::graphics;
+
+namespace wi::texturebaker
+{
+	namespace
+	{
+		// Runs task(index) for every index in [0, count), spread over the job system threads if it is initialized
+		template<typename T>
+		void ParallelFor(uint32_t count, uint32_t groupSize, const T& task)
+		{
+			if (wi::jobsystem::GetThreadCount() > 1 && count > groupSize)
+			{
+				wi::jobsystem::context ctx;
+				wi::jobsystem::Dispatch(ctx, count, groupSize, [&](wi::jobsystem::JobArgs args) {
+					task(args.jobIndex);
+				});
+				wi::jobsystem::Wait(ctx);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					task(i);
+				}
+			}
+		}
+
+		bool IsSourceFormatSupported(Format format)
+		{
+			return format == Format::R8G8B8A8_UNORM || format == Format::R8G8B8A8_UNORM_SRGB;
+		}
+
+		// Byte size of one array slice with all its mips, for R8G8B8A8 format
+		size_t GetSliceSize(uint32_t width, uint32_t height, uint32_t mip_levels)
+		{
+			size_t size = 0;
+			for (uint32_t mip = 0; mip < mip_levels; ++mip)
+			{
+				size += size_t(std::max(1u, width >> mip)) * size_t(std::max(1u, height >> mip)) * sizeof(uint32_t);
+			}
+			return size;
+		}
+
+		const float* GetSRGBToLinearTable()
+		{
+			static const struct Table
+			{
+				float values[256];
+				Table()
+				{
+					for (int i = 0; i < 256; ++i)
+					{
+						const float x = i / 255.0f;
+						values[i] = x <= 0.04045f ? x / 12.92f : std::pow((x + 0.055f) / 1.055f, 2.4f);
+					}
+				}
+			} table;
+			return table.values;
+		}
+		inline float LinearToSRGB(float x)
+		{
+			x = wi::math::saturate(x);
+			return x <= 0.0031308f ? x * 12.92f : 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+		}
+		inline uint8_t ToUNORM8(float x)
+		{
+			return uint8_t(wi::math::saturate(x) * 255.0f + 0.5f);
+		}
+
+		enum class ImageEncoding
+		{
+			LINEAR,
+			SRGB,
+			NORMALMAP,
+		};
+
+		// Floating point RGBA image, the filtering is done in this representation
+		struct FloatImage
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			wi::vector<XMFLOAT4> pixels;
+		};
+
+		void DecodeImage(const uint8_t* rgba, uint32_t width, uint32_t height, ImageEncoding encoding, FloatImage& image)
+		{
+			image.width = width;
+			image.height = height;
+			image.pixels.resize(size_t(width) * size_t(height));
+			const float* srgb_to_linear = GetSRGBToLinearTable();
+			ParallelFor(height, 16, [&](uint32_t y) {
+				const uint8_t* src = rgba + size_t(y) * width * 4;
+				XMFLOAT4* dst = image.pixels.data() + size_t(y) * width;
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint8_t* p = src + x * 4;
+					switch (encoding)
+					{
+					default:
+					case ImageEncoding::LINEAR:
+						dst[x] = XMFLOAT4(p[0] / 255.0f, p[1] / 255.0f, p[2] / 255.0f, p[3] / 255.0f);
+						break;
+					case ImageEncoding::SRGB:
+						dst[x] = XMFLOAT4(srgb_to_linear[p[0]], srgb_to_linear[p[1]], srgb_to_linear[p[2]], p[3] / 255.0f);
+						break;
+					case ImageEncoding::NORMALMAP:
+						dst[x] = XMFLOAT4(p[0] / 255.0f * 2 - 1, p[1] / 255.0f * 2 - 1, p[2] / 255.0f * 2 - 1, p[3] / 255.0f);
+						break;
+					}
+				}
+			});
+		}
+
+		void EncodeImage(const FloatImage& image, ImageEncoding encoding, uint8_t* rgba)
+		{
+			ParallelFor(image.height, 16, [&](uint32_t y) {
+				const XMFLOAT4* src = image.pixels.data() + size_t(y) * image.width;
+				uint8_t* dst = rgba + size_t(y) * image.width * 4;
+				for (uint32_t x = 0; x < image.width; ++x)
+				{
+					const XMFLOAT4& p = src[x];
+					uint8_t* d = dst + x * 4;
+					switch (encoding)
+					{
+					default:
+					case ImageEncoding::LINEAR:
+						d[0] = ToUNORM8(p.x);
+						d[1] = ToUNORM8(p.y);
+						d[2] = ToUNORM8(p.z);
+						break;
+					case ImageEncoding::SRGB:
+						d[0] = ToUNORM8(LinearToSRGB(p.x));
+						d[1] = ToUNORM8(LinearToSRGB(p.y));
+						d[2] = ToUNORM8(LinearToSRGB(p.z));
+						break;
+					case ImageEncoding::NORMALMAP:
+						d[0] = ToUNORM8(p.x * 0.5f + 0.5f);
+						d[1] = ToUNORM8(p.y * 0.5f + 0.5f);
+						d[2] = ToUNORM8(p.z * 0.5f + 0.5f);
+						break;
+					}
+					d[3] = ToUNORM8(p.w);
+				}
+			});
+		}
+
+		// Zeroth order modified Bessel function of the first kind
+		float BesselI0(float x)
+		{
+			float sum = 1;
+			float term = 1;
+			const float half_x_sq = x * x * 0.25f;
+			for (int k = 1; k < 32; ++k)
+			{
+				term *= half_x_sq / float(k * k);
+				sum += term;
+				if (term < sum * 1e-8f)
+					break;
+			}
+			return sum;
+		}
+
+		// Weights of source texels for every destination texel along one axis
+		struct FilterKernel
+		{
+			struct Entry
+			{
+				int first = 0;		// first source texel
+				uint32_t count = 0;	// number of source texels
+				uint32_t offset = 0;	// offset into weights
+			};
+			wi::vector<Entry> entries;
+			wi::vector<float> weights;
+
+			void Create(uint32_t src_size, uint32_t dst_size, MipFilter filter)
+			{
+				entries.resize(dst_size);
+				weights.clear();
+				const float scale = float(src_size) / float(dst_size);
+				const int last = int(src_size) - 1;
+				wi::vector<float> taps;
+				for (uint32_t i = 0; i < dst_size; ++i)
+				{
+					taps.clear();
+					int first = 0;
+					switch (filter)
+					{
+					default:
+					case MipFilter::BOX:
+					{
+						// Coverage of source texels inside the destination texel's footprint:
+						const float begin = i * scale;
+						const float end = begin + scale;
+						first = int(std::floor(begin));
+						for (int j = first; float(j) < end; ++j)
+						{
+							taps.push_back(std::max(0.0f, std::min(end, float(j + 1)) - std::max(begin, float(j))));
+						}
+					}
+					break;
+					case MipFilter::KAISER:
+					{
+						// Kaiser windowed sinc with 3 lobes, evaluated in destination texel units:
+						const float radius = 3;
+						const float alpha = 4;
+						const float window_norm = 1.0f / BesselI0(alpha);
+						const float center = (i + 0.5f) * scale;
+						first = int(std::floor(center - radius * scale));
+						const int end = int(std::ceil(center + radius * scale));
+						for (int j = first; j < end; ++j)
+						{
+							const float t = (j + 0.5f - center) / scale;
+							float weight = 0;
+							if (std::abs(t) < radius)
+							{
+								const float sinc = t == 0 ? 1.0f : std::sin(XM_PI * t) / (XM_PI * t);
+								const float w = t / radius;
+								weight = sinc * BesselI0(alpha * std::sqrt(1 - w * w)) * window_norm;
+							}
+							taps.push_back(weight);
+						}
+					}
+					break;
+					}
+
+					// Clamp taps to the texture edges by folding the outside weights onto the edge texels:
+					const int clamped_first = std::max(0, first);
+					const int clamped_last = std::min(last, first + int(taps.size()) - 1);
+					Entry& entry = entries[i];
+					entry.first = clamped_first;
+					entry.count = uint32_t(clamped_last - clamped_first + 1);
+					entry.offset = uint32_t(weights.size());
+					weights.resize(weights.size() + entry.count);
+					float* entry_weights = weights.data() + entry.offset;
+					std::fill(entry_weights, entry_weights + entry.count, 0.0f);
+					float sum = 0;
+					for (size_t tap = 0; tap < taps.size(); ++tap)
+					{
+						const int j = std::max(clamped_first, std::min(clamped_last, first + int(tap)));
+						entry_weights[j - clamped_first] += taps[tap];
+						sum += taps[tap];
+					}
+					if (sum != 0)
+					{
+						for (uint32_t j = 0; j < entry.count; ++j)
+						{
+							entry_weights[j] /= sum;
+						}
+					}
+				}
+			}
+		};
+
+		// Separable downsample of src into dst dimensions
+		void Downsample(const FloatImage& src, FloatImage& dst, uint32_t width, uint32_t height, MipFilter filter, bool normalmap)
+		{
+			FilterKernel kernel_x;
+			FilterKernel kernel_y;
+			kernel_x.Create(src.width, width, filter);
+			kernel_y.Create(src.height, height, filter);
+
+			// Horizontal pass:
+			FloatImage tmp;
+			tmp.width = width;
+			tmp.height = src.height;
+			tmp.pixels.resize(size_t(width) * size_t(src.height));
+			ParallelFor(src.height, 8, [&](uint32_t y) {
+				const XMFLOAT4* src_row = src.pixels.data() + size_t(y) * src.width;
+				XMFLOAT4* dst_row = tmp.pixels.data() + size_t(y) * width;
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const FilterKernel::Entry& entry = kernel_x.entries[x];
+					const float* weights = kernel_x.weights.data() + entry.offset;
+					XMVECTOR sum = XMVectorZero();
+					for (uint32_t i = 0; i < entry.count; ++i)
+					{
+						sum = XMVectorMultiplyAdd(XMLoadFloat4(src_row + entry.first + i), XMVectorReplicate(weights[i]), sum);
+					}
+					XMStoreFloat4(dst_row + x, sum);
+				}
+			});
+
+			// Vertical pass:
+			dst.width = width;
+			dst.height = height;
+			dst.pixels.resize(size_t(width) * size_t(height));
+			ParallelFor(height, 8, [&](uint32_t y) {
+				const FilterKernel::Entry& entry = kernel_y.entries[y];
+				const float* weights = kernel_y.weights.data() + entry.offset;
+				XMFLOAT4* dst_row = dst.pixels.data() + size_t(y) * width;
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					XMVECTOR sum = XMVectorZero();
+					for (uint32_t i = 0; i < entry.count; ++i)
+					{
+						sum = XMVectorMultiplyAdd(XMLoadFloat4(tmp.pixels.data() + size_t(entry.first + i) * width + x), XMVectorReplicate(weights[i]), sum);
+					}
+					if (normalmap)
+					{
+						// Renormalize the xyz vector, keep alpha:
+						XMVECTOR length = XMVector3Length(sum);
+						XMVECTOR normal = XMVectorGreater(length, XMVectorReplicate(1e-6f));
+						XMVECTOR renormalized = XMVectorSelect(XMVectorSet(0, 0, 1, 0), XMVectorDivide(sum, length), normal);
+						sum = XMVectorSelect(sum, renormalized, g_XMSelect1110);
+					}
+					XMStoreFloat4(dst_row + x, sum);
+				}
+			});
+		}
+
+		inline int Clamp255(float x)
+		{
+			return std::max(0, std::min(255, int(x + 0.5f)));
+		}
+
+		// Block texels in structure of arrays layout, every vector holds one channel of 4 texels
+		struct BlockChannels
+		{
+			XMVECTOR v[4][4]; // [channel][group of 4 texels]
+		};
+		void LoadBlockTexels(const uint8_t* rgba, XMVECTOR texels[16], BlockChannels& channels)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				texels[i] = XMVectorSet(float(rgba[i * 4 + 0]), float(rgba[i * 4 + 1]), float(rgba[i * 4 + 2]), float(rgba[i * 4 + 3]));
+			}
+			for (int g = 0; g < 4; ++g)
+			{
+				const XMMATRIX transposed = XMMatrixTranspose(XMMATRIX(texels[g * 4 + 0], texels[g * 4 + 1], texels[g * 4 + 2], texels[g * 4 + 3]));
+				for (int c = 0; c < 4; ++c)
+				{
+					channels.v[c][g] = transposed.r[c];
+				}
+			}
+		}
+		inline float HorizontalMin(FXMVECTOR v)
+		{
+			const XMVECTOR m = XMVectorMin(v, XMVectorSwizzle<1, 0, 3, 2>(v));
+			return XMVectorGetX(XMVectorMin(m, XMVectorSwizzle<2, 3, 0, 1>(m)));
+		}
+		inline float HorizontalMax(FXMVECTOR v)
+		{
+			const XMVECTOR m = XMVectorMax(v, XMVectorSwizzle<1, 0, 3, 2>(v));
+			return XMVectorGetX(XMVectorMax(m, XMVectorSwizzle<2, 3, 0, 1>(m)));
+		}
+		inline float HorizontalSum(FXMVECTOR v)
+		{
+			return XMVectorGetX(XMVectorSum(v));
+		}
+		inline void SplatChannels(FXMVECTOR v, XMVECTOR splats[4])
+		{
+			splats[0] = XMVectorSplatX(v);
+			splats[1] = XMVectorSplatY(v);
+			splats[2] = XMVectorSplatZ(v);
+			splats[3] = XMVectorSplatW(v);
+		}
+
+		// Principal axis of the block texels by power iteration on the covariance matrix
+		//	channel_mask : selects the channels that are used, the others will be zero in mean and axis
+		void ComputePrincipalAxis(const XMVECTOR texels[16], FXMVECTOR channel_mask, XMVECTOR& mean, XMVECTOR& axis)
+		{
+			XMVECTOR sum = XMVectorZero();
+			XMVECTOR minimum = XMVectorReplicate(255);
+			XMVECTOR maximum = XMVectorZero();
+			for (int i = 0; i < 16; ++i)
+			{
+				sum = XMVectorAdd(sum, texels[i]);
+				minimum = XMVectorMin(minimum, texels[i]);
+				maximum = XMVectorMax(maximum, texels[i]);
+			}
+			mean = XMVectorAndInt(XMVectorScale(sum, 1.0f / 16.0f), channel_mask);
+
+			// Every vector is a row of the symmetric covariance matrix:
+			XMVECTOR covariance[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+			for (int i = 0; i < 16; ++i)
+			{
+				const XMVECTOR d = XMVectorAndInt(XMVectorSubtract(texels[i], mean), channel_mask);
+				covariance[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), covariance[0]);
+				covariance[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), covariance[1]);
+				covariance[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), covariance[2]);
+				covariance[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), covariance[3]);
+			}
+
+			// The covariance row of the channel with the largest variance is a good starting direction
+			//	The bounding box diagonal is not, because it is orthogonal to the principal axis when channels are anti-correlated
+			axis = XMVectorAndInt(XMVectorSubtract(maximum, minimum), channel_mask);
+			float max_variance = 0;
+			for (int c = 0; c < 4; ++c)
+			{
+				const float variance = XMVectorGetByIndex(covariance[c], c);
+				if (variance > max_variance)
+				{
+					max_variance = variance;
+					axis = covariance[c];
+				}
+			}
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				XMVECTOR next = XMVectorMultiply(covariance[0], XMVectorSplatX(axis));
+				next = XMVectorMultiplyAdd(covariance[1], XMVectorSplatY(axis), next);
+				next = XMVectorMultiplyAdd(covariance[2], XMVectorSplatZ(axis), next);
+				next = XMVectorMultiplyAdd(covariance[3], XMVectorSplatW(axis), next);
+				const float length_sq = XMVectorGetX(XMVector4LengthSq(next));
+				if (length_sq < 1e-12f)
+					break;
+				axis = XMVectorScale(next, 1.0f / std::sqrt(length_sq));
+			}
+		}
+
+		// Range of the texel projections onto the axis through the mean, the range always contains 0
+		void ComputeProjectionRange(const BlockChannels& channels, int channel_count, FXMVECTOR mean, FXMVECTOR axis, float& min_projection, float& max_projection)
+		{
+			XMVECTOR mean_splats[4];
+			XMVECTOR axis_splats[4];
+			SplatChannels(mean, mean_splats);
+			SplatChannels(axis, axis_splats);
+			XMVECTOR minimum = XMVectorZero();
+			XMVECTOR maximum = XMVectorZero();
+			for (int g = 0; g < 4; ++g)
+			{
+				XMVECTOR projection = XMVectorZero();
+				for (int c = 0; c < channel_count; ++c)
+				{
+					projection = XMVectorMultiplyAdd(XMVectorSubtract(channels.v[c][g], mean_splats[c]), axis_splats[c], projection);
+				}
+				minimum = XMVectorMin(minimum, projection);
+				maximum = XMVectorMax(maximum, projection);
+			}
+			min_projection = HorizontalMin(minimum);
+			max_projection = HorizontalMax(maximum);
+		}
+
+		// Chooses the nearest palette entry for every texel, returns the squared error
+		//	The palette entries are integers, so the errors are exact in floating point
+		template<int channel_count>
+		int SelectPaletteIndices(const BlockChannels& channels, const int (*palette)[channel_count], int palette_size, uint8_t indices[16])
+		{
+			XMVECTOR best_error[4];
+			XMVECTOR best_index[4];
+			for (int g = 0; g < 4; ++g)
+			{
+				best_error[g] = XMVectorReplicate(FLT_MAX);
+				best_index[g] = XMVectorZero();
+			}
+			for (int p = 0; p < palette_size; ++p)
+			{
+				XMVECTOR entry[channel_count];
+				for (int c = 0; c < channel_count; ++c)
+				{
+					entry[c] = XMVectorReplicate(float(palette[p][c]));
+				}
+				const XMVECTOR index = XMVectorReplicate(float(p));
+				for (int g = 0; g < 4; ++g)
+				{
+					XMVECTOR error = XMVectorZero();
+					for (int c = 0; c < channel_count; ++c)
+					{
+						const XMVECTOR d = XMVectorSubtract(channels.v[c][g], entry[c]);
+						error = XMVectorMultiplyAdd(d, d, error);
+					}
+					const XMVECTOR closer = XMVectorLess(error, best_error[g]);
+					best_error[g] = XMVectorSelect(best_error[g], error, closer);
+					best_index[g] = XMVectorSelect(best_index[g], index, closer);
+				}
+			}
+			XMVECTOR error = XMVectorZero();
+			for (int g = 0; g < 4; ++g)
+			{
+				error = XMVectorAdd(error, best_error[g]);
+				XMFLOAT4A values;
+				XMStoreFloat4A(&values, best_index[g]);
+				indices[g * 4 + 0] = uint8_t(values.x);
+				indices[g * 4 + 1] = uint8_t(values.y);
+				indices[g * 4 + 2] = uint8_t(values.z);
+				indices[g * 4 + 3] = uint8_t(values.w);
+			}
+			return int(HorizontalSum(error));
+		}
+
+		// Accumulates the least squares system of two endpoints for the interpolation weights of the texels
+		//	weights : weight of the first endpoint for every texel
+		template<int channel_count>
+		void AccumulateLeastSquares(const BlockChannels& channels, const float weights[16], float& aa, float& ab, float& bb, float ax[channel_count], float bx[channel_count])
+		{
+			XMVECTOR aa_sum = XMVectorZero();
+			XMVECTOR ab_sum = XMVectorZero();
+			XMVECTOR bb_sum = XMVectorZero();
+			XMVECTOR ax_sum[channel_count];
+			XMVECTOR bx_sum[channel_count];
+			for (int c = 0; c < channel_count; ++c)
+			{
+				ax_sum[c] = XMVectorZero();
+				bx_sum[c] = XMVectorZero();
+			}
+			for (int g = 0; g < 4; ++g)
+			{
+				const XMVECTOR a = XMLoadFloat4((const XMFLOAT4*)(weights + g * 4));
+				const XMVECTOR b = XMVectorSubtract(XMVectorSplatOne(), a);
+				aa_sum = XMVectorMultiplyAdd(a, a, aa_sum);
+				ab_sum = XMVectorMultiplyAdd(a, b, ab_sum);
+				bb_sum = XMVectorMultiplyAdd(b, b, bb_sum);
+				for (int c = 0; c < channel_count; ++c)
+				{
+					ax_sum[c] = XMVectorMultiplyAdd(a, channels.v[c][g], ax_sum[c]);
+					bx_sum[c] = XMVectorMultiplyAdd(b, channels.v[c][g], bx_sum[c]);
+				}
+			}
+			aa = HorizontalSum(aa_sum);
+			ab = HorizontalSum(ab_sum);
+			bb = HorizontalSum(bb_sum);
+			for (int c = 0; c < channel_count; ++c)
+			{
+				ax[c] = HorizontalSum(ax_sum[c]);
+				bx[c] = HorizontalSum(bx_sum[c]);
+			}
+		}
+
+		inline uint16_t PackRGB565(const float color[3])
+		{
+			const int r = std::max(0, std::min(31, int(color[0] * 31.0f / 255.0f + 0.5f)));
+			const int g = std::max(0, std::min(63, int(color[1] * 63.0f / 255.0f + 0.5f)));
+			const int b = std::max(0, std::min(31, int(color[2] * 31.0f / 255.0f + 0.5f)));
+			return uint16_t((r << 11) | (g << 5) | b);
+		}
+		inline void UnpackRGB565(uint16_t packed, int color[3])
+		{
+			const int r = (packed >> 11) & 31;
+			const int g = (packed >> 5) & 63;
+			const int b = packed & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		// Chooses the nearest palette entry of the 4-color BC1 palette for every texel, returns the squared error
+		int SelectColorIndices(const BlockChannels& channels, uint16_t c0, uint16_t c1, uint8_t indices[16])
+		{
+			int palette[4][3];
+			UnpackRGB565(c0, palette[0]);
+			UnpackRGB565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			return SelectPaletteIndices<3>(channels, palette, 4, indices);
+		}
+
+		// BC1 color block, always in 4-color mode
+		void EncodeColorBlock(const uint8_t* rgba, uint8_t* block)
+		{
+			XMVECTOR texels[16];
+			BlockChannels channels;
+			LoadBlockTexels(rgba, texels, channels);
+
+			XMVECTOR mean;
+			XMVECTOR axis;
+			ComputePrincipalAxis(texels, g_XMSelect1110, mean, axis);
+			float min_projection;
+			float max_projection;
+			ComputeProjectionRange(channels, 3, mean, axis, min_projection, max_projection);
+			XMFLOAT4 endpoint0;
+			XMFLOAT4 endpoint1;
+			XMStoreFloat4(&endpoint0, XMVectorMultiplyAdd(axis, XMVectorReplicate(max_projection), mean));
+			XMStoreFloat4(&endpoint1, XMVectorMultiplyAdd(axis, XMVectorReplicate(min_projection), mean));
+			float endpoints[2][3] = {
+				{ endpoint0.x, endpoint0.y, endpoint0.z },
+				{ endpoint1.x, endpoint1.y, endpoint1.z },
+			};
+
+			uint16_t c0 = PackRGB565(endpoints[0]);
+			uint16_t c1 = PackRGB565(endpoints[1]);
+			uint8_t indices[16];
+			int error = SelectColorIndices(channels, c0, c1, indices);
+
+			// Least squares refinement of the endpoints for the selected indices:
+			static constexpr float palette_weights[4] = { 1, 0, 2.0f / 3.0f, 1.0f / 3.0f };
+			for (int iteration = 0; iteration < 2 && error > 0; ++iteration)
+			{
+				alignas(16) float weights[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					weights[i] = palette_weights[indices[i]];
+				}
+				float aa, ab, bb;
+				float ax[3];
+				float bx[3];
+				AccumulateLeastSquares<3>(channels, weights, aa, ab, bb, ax, bx);
+				const float det = aa * bb - ab * ab;
+				if (std::abs(det) < 1e-6f)
+					break;
+				const float inv_det = 1.0f / det;
+				for (int c = 0; c < 3; ++c)
+				{
+					endpoints[0][c] = (ax[c] * bb - bx[c] * ab) * inv_det;
+					endpoints[1][c] = (bx[c] * aa - ax[c] * ab) * inv_det;
+				}
+				const uint16_t refined_c0 = PackRGB565(endpoints[0]);
+				const uint16_t refined_c1 = PackRGB565(endpoints[1]);
+				if (refined_c0 == c0 && refined_c1 == c1)
+					break;
+				uint8_t refined_indices[16];
+				const int refined_error = SelectColorIndices(channels, refined_c0, refined_c1, refined_indices);
+				if (refined_error >= error)
+					break;
+				c0 = refined_c0;
+				c1 = refined_c1;
+				error = refined_error;
+				std::memcpy(indices, refined_indices, sizeof(indices));
+			}
+
+			// 4-color mode requires c0 > c1:
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+				for (int i = 0; i < 16; ++i)
+				{
+					indices[i] ^= 1;
+				}
+			}
+			else if (c0 == c1)
+			{
+				std::fill(indices, indices + 16, uint8_t(0));
+			}
+
+			uint32_t packed_indices = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				packed_indices |= uint32_t(indices[i]) << (i * 2);
+			}
+			std::memcpy(block + 0, &c0, sizeof(c0));
+			std::memcpy(block + 2, &c1, sizeof(c1));
+			std::memcpy(block + 4, &packed_indices, sizeof(packed_indices));
+		}
+
+		// Builds the BC4 palette for the two endpoints, the mode is selected by endpoint order
+		void BuildAlphaPalette(int e0, int e1, int palette[8][1])
+		{
+			palette[0][0] = e0;
+			palette[1][0] = e1;
+			if (e0 > e1)
+			{
+				for (int i = 1; i < 7; ++i)
+				{
+					palette[i + 1][0] = ((7 - i) * e0 + i * e1 + 3) / 7;
+				}
+			}
+			else
+			{
+				for (int i = 1; i < 5; ++i)
+				{
+					palette[i + 1][0] = ((5 - i) * e0 + i * e1 + 2) / 5;
+				}
+				palette[6][0] = 0;
+				palette[7][0] = 255;
+			}
+		}
+		int SelectAlphaIndices(const BlockChannels& channels, int e0, int e1, uint8_t indices[16])
+		{
+			int palette[8][1];
+			BuildAlphaPalette(e0, e1, palette);
+			return SelectPaletteIndices<1>(channels, palette, 8, indices);
+		}
+
+		// BC4 single channel block
+		void EncodeAlphaBlock(const uint8_t values[16], uint8_t* block)
+		{
+			BlockChannels channels;
+			XMVECTOR minimum = XMVectorReplicate(255);
+			XMVECTOR maximum = XMVectorZero();
+			XMVECTOR inner_minimum = XMVectorReplicate(255); // without 0 and 255
+			XMVECTOR inner_maximum = XMVectorZero();
+			for (int g = 0; g < 4; ++g)
+			{
+				const XMVECTOR v = XMVectorSet(float(values[g * 4 + 0]), float(values[g * 4 + 1]), float(values[g * 4 + 2]), float(values[g * 4 + 3]));
+				channels.v[0][g] = v;
+				minimum = XMVectorMin(minimum, v);
+				maximum = XMVectorMax(maximum, v);
+				const XMVECTOR inner = XMVectorAndInt(XMVectorGreater(v, XMVectorZero()), XMVectorLess(v, XMVectorReplicate(255)));
+				inner_minimum = XMVectorMin(inner_minimum, XMVectorSelect(XMVectorReplicate(255), v, inner));
+				inner_maximum = XMVectorMax(inner_maximum, XMVectorSelect(XMVectorZero(), v, inner));
+			}
+			const int min_value = int(HorizontalMin(minimum));
+			const int max_value = int(HorizontalMax(maximum));
+			const int inner_min_value = int(HorizontalMin(inner_minimum));
+			const int inner_max_value = int(HorizontalMax(inner_maximum));
+
+			// 8-value mode between min and max:
+			int e0 = max_value;
+			int e1 = min_value;
+			uint8_t indices[16] = {};
+			int error = max_value == min_value ? 0 : SelectAlphaIndices(channels, e0, e1, indices);
+
+			// 6-value mode with explicit 0 and 255 might fit better if the block contains those:
+			if (error > 0 && (min_value == 0 || max_value == 255))
+			{
+				const int e0_6 = inner_min_value <= inner_max_value ? inner_min_value : 0;
+				const int e1_6 = inner_min_value <= inner_max_value ? inner_max_value : 255;
+				uint8_t indices_6[16];
+				const int error_6 = SelectAlphaIndices(channels, e0_6, e1_6, indices_6);
+				if (error_6 < error)
+				{
+					e0 = e0_6;
+					e1 = e1_6;
+					error = error_6;
+					std::memcpy(indices, indices_6, sizeof(indices));
+				}
+			}
+
+			block[0] = uint8_t(e0);
+			block[1] = uint8_t(e1);
+			uint64_t packed_indices = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				packed_indices |= uint64_t(indices[i]) << (i * 3);
+			}
+			for (int i = 0; i < 6; ++i)
+			{
+				block[2 + i] = uint8_t(packed_indices >> (i * 8));
+			}
+		}
+
+		// BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with unique p-bit, 4-bit indices
+		static constexpr int bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		struct BC7Endpoint
+		{
+			int quantized[4]; // 7 bits
+			int pbit;
+			int expanded[4]; // 8 bits
+		};
+		BC7Endpoint QuantizeBC7Endpoint(const float color[4])
+		{
+			BC7Endpoint best = {};
+			float best_error = FLT_MAX;
+			for (int pbit = 0; pbit < 2; ++pbit)
+			{
+				BC7Endpoint endpoint;
+				endpoint.pbit = pbit;
+				float error = 0;
+				for (int c = 0; c < 4; ++c)
+				{
+					endpoint.quantized[c] = std::max(0, std::min(127, int((color[c] - pbit) * 0.5f + 0.5f)));
+					endpoint.expanded[c] = (endpoint.quantized[c] << 1) | pbit;
+					const float d = endpoint.expanded[c] - color[c];
+					error += d * d;
+				}
+				if (error < best_error)
+				{
+					best_error = error;
+					best = endpoint;
+				}
+			}
+			return best;
+		}
+		int SelectBC7Indices(const BlockChannels& channels, const BC7Endpoint& e0, const BC7Endpoint& e1, uint8_t indices[16])
+		{
+			int palette[16][4];
+			for (int p = 0; p < 16; ++p)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					palette[p][c] = ((64 - bc7_weights4[p]) * e0.expanded[c] + bc7_weights4[p] * e1.expanded[c] + 32) >> 6;
+				}
+			}
+			return SelectPaletteIndices<4>(channels, palette, 16, indices);
+		}
+
+		struct BitWriter
+		{
+			uint8_t* data = nullptr;
+			uint32_t position = 0;
+			void Write(uint32_t value, uint32_t bits)
+			{
+				for (uint32_t i = 0; i < bits; ++i, ++position)
+				{
+					if ((value >> i) & 1)
+					{
+						data[position >> 3] |= uint8_t(1u << (position & 7));
+					}
+				}
+			}
+		};
+
+		// Texels of one block with edge clamping, in R8G8B8A8 format
+		void LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t texels[64])
+		{
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				const uint32_t src_y = std::min(height - 1, block_y * 4 + y);
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					const uint32_t src_x = std::min(width - 1, block_x * 4 + x);
+					std::memcpy(texels + (y * 4 + x) * 4, rgba + (size_t(src_y) * width + src_x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	void EncodeBC1(const uint8_t* rgba, uint8_t* block)
+	{
+		EncodeColorBlock(rgba, block);
+	}
+
+	void EncodeBC3(const uint8_t* rgba, uint8_t* block)
+	{
+		uint8_t alpha[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			alpha[i] = rgba[i * 4 + 3];
+		}
+		EncodeAlphaBlock(alpha, block);
+		EncodeColorBlock(rgba, block + 8);
+	}
+
+	void EncodeBC4(const uint8_t* rgba, uint8_t* block)
+	{
+		uint8_t red[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			red[i] = rgba[i * 4 + 0];
+		}
+		EncodeAlphaBlock(red, block);
+	}
+
+	void EncodeBC5(const uint8_t* rgba, uint8_t* block)
+	{
+		uint8_t red[16];
+		uint8_t green[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			red[i] = rgba[i * 4 + 0];
+			green[i] = rgba[i * 4 + 1];
+		}
+		EncodeAlphaBlock(red, block);
+		EncodeAlphaBlock(green, block + 8);
+	}
+
+	void EncodeBC7(const uint8_t* rgba, uint8_t* block)
+	{
+		XMVECTOR texels[16];
+		BlockChannels channels;
+		LoadBlockTexels(rgba, texels, channels);
+
+		XMVECTOR mean;
+		XMVECTOR axis;
+		ComputePrincipalAxis(texels, XMVectorTrueInt(), mean, axis);
+		float min_projection;
+		float max_projection;
+		ComputeProjectionRange(channels, 4, mean, axis, min_projection, max_projection);
+		float endpoints[2][4];
+		XMStoreFloat4((XMFLOAT4*)endpoints[0], XMVectorMultiplyAdd(axis, XMVectorReplicate(min_projection), mean));
+		XMStoreFloat4((XMFLOAT4*)endpoints[1], XMVectorMultiplyAdd(axis, XMVectorReplicate(max_projection), mean));
+
+		BC7Endpoint e0 = QuantizeBC7Endpoint(endpoints[0]);
+		BC7Endpoint e1 = QuantizeBC7Endpoint(endpoints[1]);
+		uint8_t indices[16];
+		int error = SelectBC7Indices(channels, e0, e1, indices);
+
+		// Least squares refinement of the endpoints for the selected indices:
+		for (int iteration = 0; iteration < 2 && error > 0; ++iteration)
+		{
+			alignas(16) float weights[16];
+			for (int i = 0; i < 16; ++i)
+			{
+				weights[i] = 1 - bc7_weights4[indices[i]] / 64.0f;
+			}
+			float aa, ab, bb;
+			float ax[4];
+			float bx[4];
+			AccumulateLeastSquares<4>(channels, weights, aa, ab, bb, ax, bx);
+			const float det = aa * bb - ab * ab;
+			if (std::abs(det) < 1e-6f)
+				break;
+			const float inv_det = 1.0f / det;
+			for (int c = 0; c < 4; ++c)
+			{
+				endpoints[0][c] = wi::math::Clamp((ax[c] * bb - bx[c] * ab) * inv_det, 0, 255);
+				endpoints[1][c] = wi::math::Clamp((bx[c] * aa - ax[c] * ab) * inv_det, 0, 255);
+			}
+			const BC7Endpoint refined_e0 = QuantizeBC7Endpoint(endpoints[0]);
+			const BC7Endpoint refined_e1 = QuantizeBC7Endpoint(endpoints[1]);
+			uint8_t refined_indices[16];
+			const int refined_error = SelectBC7Indices(channels, refined_e0, refined_e1, refined_indices);
+			if (refined_error >= error)
+				break;
+			e0 = refined_e0;
+			e1 = refined_e1;
+			error = refined_error;
+			std::memcpy(indices, refined_indices, sizeof(indices));
+		}
+
+		// The anchor index (first texel) has an implicit zero most significant bit:
+		if (indices[0] >= 8)
+		{
+			std::swap(e0, e1);
+			for (int i = 0; i < 16; ++i)
+			{
+				indices[i] = uint8_t(15 - indices[i]);
+			}
+		}
+
+		std::memset(block, 0, 16);
+		BitWriter writer;
+		writer.data = block;
+		writer.Write(1u << 6, 7); // mode 6
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(uint32_t(e0.quantized[c]), 7);
+			writer.Write(uint32_t(e1.quantized[c]), 7);
+		}
+		writer.Write(uint32_t(e0.pbit), 1);
+		writer.Write(uint32_t(e1.pbit), 1);
+		writer.Write(indices[0], 3);
+		for (int i = 1; i < 16; ++i)
+		{
+			writer.Write(indices[i], 4);
+		}
+		assert(writer.position == 128);
+	}
+
+	bool GenerateMips(
+		const wi::vector<uint8_t>& src,
+		const TextureDesc& src_desc,
+		wi::vector<uint8_t>& dst,
+		TextureDesc& dst_desc,
+		const MipGenParams& params
+	)
+	{
+		if (!IsSourceFormatSupported(src_desc.format) || src_desc.type != TextureDesc::Type::TEXTURE_2D)
+		{
+			wi::backlog::post("wi::texturebaker::GenerateMips: only R8G8B8A8 2D textures are supported!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+		const uint32_t src_mip_levels = std::max(1u, src_desc.mip_levels);
+		const size_t src_slice_size = GetSliceSize(src_desc.width, src_desc.height, src_mip_levels);
+		if (src.size() < src_slice_size * src_desc.array_size)
+		{
+			wi::backlog::post("wi::texturebaker::GenerateMips: source data is smaller than expected!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		const uint32_t min_dimension = std::max(1u, params.min_dimension);
+		// GetMipCount() would clamp the mip dimensions to min_dimension, but the mips are always half size:
+		uint32_t max_mip_levels = 1;
+		for (uint32_t width = src_desc.width, height = src_desc.height; width > 1 || height > 1; ++max_mip_levels)
+		{
+			width = std::max(1u, width >> 1u);
+			height = std::max(1u, height >> 1u);
+			if (width < min_dimension || height < min_dimension || (width % min_dimension) != 0 || (height % min_dimension) != 0)
+				break;
+		}
+		dst_desc = src_desc;
+		dst_desc.mip_levels = params.mip_levels == 0 ? max_mip_levels : std::min(params.mip_levels, max_mip_levels);
+
+		ImageEncoding encoding = ImageEncoding::LINEAR;
+		if (params.normalmap)
+		{
+			encoding = ImageEncoding::NORMALMAP;
+		}
+		else if (params.srgb || IsFormatSRGB(src_desc.format))
+		{
+			encoding = ImageEncoding::SRGB;
+		}
+
+		const size_t dst_slice_size = GetSliceSize(dst_desc.width, dst_desc.height, dst_desc.mip_levels);
+		dst.resize(dst_slice_size * dst_desc.array_size);
+
+		for (uint32_t slice = 0; slice < dst_desc.array_size; ++slice)
+		{
+			const uint8_t* src_data = src.data() + src_slice_size * slice;
+			uint8_t* dst_data = dst.data() + dst_slice_size * slice;
+
+			// First mip is copied as is:
+			const size_t mip0_size = size_t(dst_desc.width) * size_t(dst_desc.height) * sizeof(uint32_t);
+			std::memcpy(dst_data, src_data, mip0_size);
+			dst_data += mip0_size;
+
+			// Every mip is filtered from the previous one in floating point to avoid accumulating quantization errors:
+			FloatImage image;
+			FloatImage next;
+			DecodeImage(src_data, dst_desc.width, dst_desc.height, encoding, image);
+			for (uint32_t mip = 1; mip < dst_desc.mip_levels; ++mip)
+			{
+				const uint32_t width = std::max(1u, dst_desc.width >> mip);
+				const uint32_t height = std::max(1u, dst_desc.height >> mip);
+				Downsample(image, next, width, height, params.filter, encoding == ImageEncoding::NORMALMAP);
+				EncodeImage(next, encoding, dst_data);
+				dst_data += size_t(width) * size_t(height) * sizeof(uint32_t);
+				std::swap(image, next);
+			}
+		}
+
+		return true;
+	}
+
+	bool BlockCompress(
+		const wi::vector<uint8_t>& src,
+		const TextureDesc& src_desc,
+		Format dst_format,
+		wi::vector<uint8_t>& dst,
+		TextureDesc& dst_desc
+	)
+	{
+		if (!IsSourceFormatSupported(src_desc.format) || src_desc.type != TextureDesc::Type::TEXTURE_2D)
+		{
+			wi::backlog::post("wi::texturebaker::BlockCompress: only R8G8B8A8 2D textures are supported!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+		if ((src_desc.width % 4) != 0 || (src_desc.height % 4) != 0)
+		{
+			wi::backlog::post("wi::texturebaker::BlockCompress: texture size must be multiple of 4!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		void(*encoder)(const uint8_t*, uint8_t*) = nullptr;
+		switch (dst_format)
+		{
+		case Format::BC1_UNORM:
+		case Format::BC1_UNORM_SRGB:
+			encoder = EncodeBC1;
+			break;
+		case Format::BC3_UNORM:
+		case Format::BC3_UNORM_SRGB:
+			encoder = EncodeBC3;
+			break;
+		case Format::BC4_UNORM:
+			encoder = EncodeBC4;
+			break;
+		case Format::BC5_UNORM:
+			encoder = EncodeBC5;
+			break;
+		case Format::BC7_UNORM:
+		case Format::BC7_UNORM_SRGB:
+			encoder = EncodeBC7;
+			break;
+		default:
+			wi::backlog::post("wi::texturebaker::BlockCompress: unsupported destination format!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		const uint32_t mip_levels = std::max(1u, src_desc.mip_levels);
+		const size_t src_slice_size = GetSliceSize(src_desc.width, src_desc.height, mip_levels);
+		if (src.size() < src_slice_size * src_desc.array_size)
+		{
+			wi::backlog::post("wi::texturebaker::BlockCompress: source data is smaller than expected!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		dst_desc = src_desc;
+		dst_desc.mip_levels = mip_levels;
+		dst_desc.format = dst_format;
+		if (IsFormatSRGB(src_desc.format))
+		{
+			const Format srgb_format = GetFormatSRGB(dst_format);
+			if (srgb_format != Format::UNKNOWN)
+			{
+				dst_desc.format = srgb_format;
+			}
+		}
+		dst.resize(ComputeTextureMemorySizeInBytes(dst_desc));
+
+		const uint32_t block_bytes = GetFormatStride(dst_format);
+		const uint32_t num_blocks_x = src_desc.width / 4;
+		const uint32_t num_blocks_y = src_desc.height / 4;
+		const uint8_t* src_data = src.data();
+		uint8_t* dst_data = dst.data();
+		for (uint32_t slice = 0; slice < src_desc.array_size; ++slice)
+		{
+			for (uint32_t mip = 0; mip < mip_levels; ++mip)
+			{
+				const uint32_t width = std::max(1u, src_desc.width >> mip);
+				const uint32_t height = std::max(1u, src_desc.height >> mip);
+				const uint32_t mip_blocks_x = std::max(1u, num_blocks_x >> mip);
+				const uint32_t mip_blocks_y = std::max(1u, num_blocks_y >> mip);
+
+				ParallelFor(mip_blocks_y, 4, [&](uint32_t block_y) {
+					uint8_t texels[64];
+					for (uint32_t block_x = 0; block_x < mip_blocks_x; ++block_x)
+					{
+						LoadBlock(src_data, width, height, block_x, block_y, texels);
+						encoder(texels, dst_data + (size_t(block_y) * mip_blocks_x + block_x) * block_bytes);
+					}
+				});
+
+				src_data += size_t(width) * size_t(height) * sizeof(uint32_t);
+				dst_data += size_t(mip_blocks_x) * size_t(mip_blocks_y) * block_bytes;
+			}
+		}
+		assert(dst_data == dst.data() + dst.size());
+
+		return true;
+	}
+
+	bool Bake(
+		const wi::vector<uint8_t>& src,
+		const TextureDesc& src_desc,
+		wi::vector<uint8_t>& dst,
+		TextureDesc& dst_desc,
+		const BakeParams& params
+	)
+	{
+		if (!IsSourceFormatSupported(src_desc.format) || src_desc.type != TextureDesc::Type::TEXTURE_2D)
+		{
+			wi::backlog::post("wi::texturebaker::Bake: only R8G8B8A8 2D textures are supported!", wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		const bool compress = IsFormatBlockCompressed(params.format);
+		const wi::vector<uint8_t>* data = &src;
+		TextureDesc desc = src_desc;
+
+		wi::vector<uint8_t> padded;
+		if (compress && ((desc.width % 4) != 0 || (desc.height % 4) != 0))
+		{
+			// Pad the first mip to block size alignment, the other mips are regenerated or dropped:
+			const size_t src_slice_size = GetSliceSize(src_desc.width, src_desc.height, std::max(1u, src_desc.mip_levels));
+			if (src.size() < src_slice_size * src_desc.array_size)
+			{
+				wi::backlog::post("wi::texturebaker::Bake: source data is smaller than expected!", wi::backlog::LogLevel::Error);
+				return false;
+			}
+			desc.width = AlignTo(desc.width, 4u);
+			desc.height = AlignTo(desc.height, 4u);
+			desc.mip_levels = 1;
+			padded.resize(size_t(desc.width) * size_t(desc.height) * sizeof(uint32_t) * desc.array_size);
+			for (uint32_t slice = 0; slice < desc.array_size; ++slice)
+			{
+				const uint32_t* src_texels = (const uint32_t*)(src.data() + src_slice_size * slice);
+				uint32_t* dst_texels = (uint32_t*)padded.data() + size_t(desc.width) * size_t(desc.height) * slice;
+				for (uint32_t y = 0; y < desc.height; ++y)
+				{
+					const uint32_t src_y = std::min(y, src_desc.height - 1);
+					for (uint32_t x = 0; x < desc.width; ++x)
+					{
+						dst_texels[size_t(y) * desc.width + x] = src_texels[size_t(src_y) * src_desc.width + std::min(x, src_desc.width - 1)];
+					}
+				}
+			}
+			data = &padded;
+		}
+
+		wi::vector<uint8_t> mipchain;
+		if (params.generate_mips)
+		{
+			MipGenParams mipgen = params.mipgen;
+			if (compress)
+			{
+				mipgen.min_dimension = std::max(mipgen.min_dimension, 4u);
+			}
+			TextureDesc mipchain_desc;
+			if (!GenerateMips(*data, desc, mipchain, mipchain_desc, mipgen))
+				return false;
+			desc = mipchain_desc;
+			data = &mipchain;
+		}
+
+		if (compress)
+		{
+			return BlockCompress(*data, desc, params.format, dst, dst_desc);
+		}
+
+		dst = *data;
+		dst_desc = desc;
+		return true;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiGraphics.h"
+#include "wiVector.h"
+
+// CPU texture processing for offline and headless asset baking, this doesn't require a graphics device
+//	The data layout of textures is the same as with wi::helper::saveTextureToMemory()
+//	The work is parallelized with the job system if it is initialized
+namespace wi::texturebaker
+{
+	enum class MipFilter
+	{
+		BOX,	// average of the source texels covered by the destination texel
+		KAISER,	// Kaiser windowed sinc, sharper result than box
+	};
+
+	struct MipGenParams
+	{
+		MipFilter filter = MipFilter::BOX;
+		bool srgb = false;			// color channels are filtered in linear space. This is always enabled for sRGB source formats
+		bool normalmap = false;		// RGB is filtered as a [-1, 1] vector and renormalized for every mip
+		uint32_t mip_levels = 0;	// 0: full mip chain
+		uint32_t min_dimension = 1;	// the mip chain stops when a dimension would go below this or become unaligned to it (block compression needs 4)
+	};
+
+	// Generates mip chain for R8G8B8A8 2D textures (texture arrays and cubemaps are supported)
+	//	Only the first mip of every array slice is read from the source data, the others will be generated
+	bool GenerateMips(
+		const wi::vector<uint8_t>& src,
+		const wi::graphics::TextureDesc& src_desc,
+		wi::vector<uint8_t>& dst,
+		wi::graphics::TextureDesc& dst_desc,
+		const MipGenParams& params = {}
+	);
+
+	// Compresses R8G8B8A8 2D textures to BC1, BC3, BC4, BC5 or BC7 format, every mip and array slice is compressed
+	//	The width and height of the source texture must be multiple of 4
+	//	BC4 compresses the red channel, BC5 compresses the red and green channels
+	//	sRGB source will be compressed to the sRGB variant of the destination format where it exists
+	bool BlockCompress(
+		const wi::vector<uint8_t>& src,
+		const wi::graphics::TextureDesc& src_desc,
+		wi::graphics::Format dst_format,
+		wi::vector<uint8_t>& dst,
+		wi::graphics::TextureDesc& dst_desc
+	);
+
+	// Block encoders, they take 4x4 R8G8B8A8 texels (64 bytes) and write one compressed block
+	void EncodeBC1(const uint8_t* rgba, uint8_t* block);	// 8 bytes output
+	void EncodeBC3(const uint8_t* rgba, uint8_t* block);	// 16 bytes output
+	void EncodeBC4(const uint8_t* rgba, uint8_t* block);	// 8 bytes output
+	void EncodeBC5(const uint8_t* rgba, uint8_t* block);	// 16 bytes output
+	void EncodeBC7(const uint8_t* rgba, uint8_t* block);	// 16 bytes output, mode 6 (single subset RGBA)
+
+	struct BakeParams
+	{
+		bool generate_mips = true;
+		MipGenParams mipgen;
+		wi::graphics::Format format = wi::graphics::Format::UNKNOWN; // block compressed format, or UNKNOWN to keep R8G8B8A8
+	};
+
+	// Mip generation and block compression in one step
+	//	Block compressed textures that are not multiple of 4 in size will be padded by repeating the edge texels
+	bool Bake(
+		const wi::vector<uint8_t>& src,
+		const wi::graphics::TextureDesc& src_desc,
+		wi::vector<uint8_t>& dst,
+		wi::graphics::TextureDesc& dst_desc,
+		const BakeParams& params
+	);
+}